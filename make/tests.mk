@@ -35,6 +35,10 @@ system_tools:=$(filter-out %Gtest, $(system_tools))
 tools_programs: $(system_tools:%=$(TEST_BUILD_DIR)/%)
 all: tools_programs
 
+# the example program of the embedded aligner, see the README
+.PHONY: api-example
+api-example: $(TEST_BUILD_DIR)/api-example
+
 define SYSTEM_TOOL
 
 system_tool := $(1)
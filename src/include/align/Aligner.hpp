@@ -17,9 +17,13 @@
 
 #include "align/AlignmentGenerator.hpp"
 #include "align/AlignmentRescue.hpp"
+#include "align/MateChainIndex.hpp"
+#include "align/MethylationCaller.hpp"
+#include "align/MismatchMask.hpp"
 #include "align/PairBuilder.hpp"
 #include "reference/Hashtable.hpp"
 #include "reference/ReferenceDir.hpp"
+#include "reference/TargetIndex.hpp"
 #include "sequences/Read.hpp"
 #include "sequences/ReadPair.hpp"
 
@@ -47,7 +51,37 @@ public:
       const int                           aln_cfg_mapq_min_len,
       const uint32_t                      alignerUnpairedPen,
       const double                        aln_cfg_filter_len_ratio,
-      const bool                          vectorizedSW);
+      const bool                          vectorizedSW,
+      const std::size_t                   hotSeedCacheSize       = 0,
+      const unsigned                      hotSeedCacheMinBuckets = 2,
+      const bool                          sparseSeeding          = false,
+      const reference::TargetIndex*       targetIndex            = nullptr,
+      const MethylationCaller*            methylationCaller      = nullptr);
+  /// reads mapped through Mapper::getSparsePositionChain and confirmed by isPerfectAlignment
+  struct SparseSeedingStatistics {
+    uint64_t reads_    = 0;
+    uint64_t fastPath_ = 0;
+    void     add(const SparseSeedingStatistics& that)
+    {
+      reads_ += that.reads_;
+      fastPath_ += that.fastPath_;
+    }
+  };
+  /// fragments classified by the target index, and the time spent on them by the thread
+  struct TargetedMappingStatistics {
+    uint64_t fragments_           = 0;
+    uint64_t onTarget_            = 0;
+    uint64_t classifyNanoseconds_ = 0;
+    /// full alignment of the fragments on target
+    uint64_t alignNanoseconds_ = 0;
+    void     add(const TargetedMappingStatistics& that)
+    {
+      fragments_ += that.fragments_;
+      onTarget_ += that.onTarget_;
+      classifyNanoseconds_ += that.classifyNanoseconds_;
+      alignNanoseconds_ += that.alignNanoseconds_;
+    }
+  };
   typedef sequences::Read     Read;
   typedef sequences::ReadPair ReadPair;
   typedef align::Alignment    Alignment;
@@ -62,6 +96,9 @@ public:
       const InsertSizeParameters& insertSizeParameters,
       const PairBuilder&          pairBuilder);
   Alignments& unpaired(std::size_t readPosition) { return unpairedAlignments_.at(readPosition); }
+  const map::Mapper& getMapper() const { return mapper_; }
+  const SparseSeedingStatistics& getSparseSeedingStatistics() const { return sparseSeedingStatistics_; }
+  const TargetedMappingStatistics& getTargetedMappingStatistics() const { return targetedMappingStatistics_; }
   /// generate ungapped alignments from the seed chains
   void generateUngappedAlignments(const Read& read, map::ChainBuilder& chainBuilder, Alignments& alignments);
   void runSmithWatermanAll(
@@ -95,15 +132,24 @@ public:
    ** \param queryEnd
    ** \param databaseBegin
    ** \param databaseEnd
+   ** \param mismatchMask reusable comparison of the query against the database
    ** \param alignment output parameter where the appropriate alignment information is stored
    ** \return false if Smith-Waterman is required, true otherwise.
    **/
   static bool isPerfectAlignment(
-      const char* queryBegin,
-      const char* queryEnd,
-      const char* databaseBegin,
-      const char* databaseEnd,
-      Alignment&  alignment);
+      const char*   queryBegin,
+      const char*   queryEnd,
+      const char*   databaseBegin,
+      const char*   databaseEnd,
+      MismatchMask& mismatchMask,
+      Alignment&    alignment);
+  /// score of the perfect alignment as defined for isPerfectAlignment, 0 if there is none. No cigar is built
+  static int getPerfectAlignmentScore(
+      const char*   queryBegin,
+      const char*   queryEnd,
+      const char*   databaseBegin,
+      const char*   databaseEnd,
+      MismatchMask& mismatchMask);
   /// calculate the ungapped alignment score and potential score for the given read at the specified
   /// orientation and position
   int initializeUngappedAlignmentScores(
@@ -130,6 +176,12 @@ private:
   const bool                          mapOnly_;
   const int                           swAll_;
   const bool                          vectorizedSW_;
+  /// try the sparse seeds before the full seeding of each read
+  const bool                          sparseSeeding_;
+  /// fragments without any k-mer of the targets are left unmapped, when not null
+  const reference::TargetIndex* const targetIndex_;
+  /// seed chains on the strands that a directional bisulfite library can't produce are removed, when not null
+  const MethylationCaller* const methylationCaller_;
   /// read the hashtable config data and throw on error
   //std::vector<char> getHashtableConfigData(const boost::filesystem::path referenceDir) const;
   /// maps hashtable data and throw on error
@@ -150,8 +202,31 @@ private:
   VectorSmithWaterman       vectorSmithWaterman_;
   std::array<Alignments, 2> unpairedAlignments_;
   AlignmentGenerator        alignmentGenerator_;
+  /// reusable comparison of the read against the reference for the ungapped alignments
+  MismatchMask mismatchMask_;
+  /// reusable cigar operations for the ungapped alignments
+  std::string ungappedOperations_;
 
   std::array<map::ChainBuilder, 2> chainBuilders_;
+  /// seed chains of the second read indexed for the pair enumeration
+  MateChainIndex mateChainIndex_;
+  /// reusable list of the chains of the second read to combine with a chain of the first read
+  std::vector<unsigned> mateCandidates_;
+
+  SparseSeedingStatistics sparseSeedingStatistics_;
+  /// reusable reference bases for the confirmation of the sparse seed chains
+  std::vector<unsigned char> sparseSeedingReference_;
+
+  TargetedMappingStatistics targetedMappingStatistics_;
+
+  /// true if the target index is enabled and none of the reads has any k-mer of the targets
+  bool isOffTarget(const Read& read, const Read* mate);
+  /// seed chains of the read, through the sparse seeding fast path when enabled
+  void getPositionChains(const Read& read, map::ChainBuilder& chainBuilder);
+  /// remove the seed chains that are not directional for the methylation caller. True if any was removed
+  bool removeNonDirectionalChains(const Read& read, map::ChainBuilder& chainBuilder) const;
+  /// true if the ungapped alignment of the read along the seed chain is perfect
+  bool isPerfectSparseChain(const Read& read, const map::SeedChain& seedChain);
 
   /// generate all the ungapped allignments for the seed chains
   void buildUngappedAlignments(map::ChainBuilder& chainBuilder, const Read& read, Alignments& alignments);
@@ -195,6 +270,9 @@ private:
       Alignment&                        alignment);
 };
 
+std::ostream& operator<<(std::ostream& os, const Aligner::SparseSeedingStatistics& statistics);
+std::ostream& operator<<(std::ostream& os, const Aligner::TargetedMappingStatistics& statistics);
+
 }  // namespace align
 }  // namespace dragenos
 
@@ -312,92 +312,6 @@ private:
   }
 };
 
-struct SerializedSaTag {
-  struct Header {
-    short    reference_ = 0;
-    int      position_  = 0;
-    bool     reverse_   = 0;
-    MapqType mapq_      = 0;
-    short    nm_        = 0;
-  } header_;
-
-  SerializedCigar cigar_;
-
-  void operator<<(const Alignment& alignment)
-  {
-    header_.reference_ = alignment.getReference();
-    header_.position_  = alignment.getPosition();
-    header_.reverse_   = alignment.isReverseComplement();
-    header_.mapq_      = alignment.getMapq();
-    header_.nm_        = alignment.getMismatchCount();
-    cigar_ << alignment.getCigar();
-  }
-
-  static std::size_t getByteSize(const Alignment& alignment)
-  {
-    return sizeof(SerializedSaTag) + SerializedCigar::getByteSize(alignment.getCigar()) -
-           sizeof(SerializedCigar);
-  }
-
-  std::size_t getByteSize() const { return sizeof(*this) + cigar_.getByteSize() - sizeof(cigar_); }
-
-  short                  getReference() const { return header_.reference_; }
-  int                    getPosition() const { return header_.position_; }
-  bool                   reverse() const { return header_.reverse_; }
-  MapqType               getMapq() const { return header_.mapq_; }
-  short                  getNm() const { return header_.nm_; }
-  const SerializedCigar& getCigar() const { return cigar_; }
-};
-
-class SerializedAlignment : public AlignmentHeader {
-  static const std::size_t MAX_SA_TAG_LENGTH_ = 1024;
-  bool                     hasSa_             = false;
-  SerializedCigar          cigar_;
-
-public:
-  const SerializedCigar& getCigar() const { return cigar_; }
-
-  void operator<<(const Alignment& alignment)
-  {
-    header() = alignment.header();
-    cigar_ << alignment.getCigar();
-    if (alignment.getSa()) {
-      hasSa_ = true;
-      sa() << *alignment.getSa();
-    } else {
-      hasSa_ = false;
-    }
-  }
-
-  std::size_t getByteSize() const
-  {
-    return sizeof(SerializedAlignment) + cigar_.getByteSize() - sizeof(SerializedCigar) +
-           (getSa() ? getSa()->getByteSize() : 0);
-  }
-
-  static std::size_t getByteSize(const Alignment& alignment)
-  {
-    return sizeof(SerializedAlignment) + SerializedCigar::getByteSize(alignment.getCigar()) -
-           sizeof(SerializedCigar) +
-           (alignment.getSa() ? SerializedSaTag::getByteSize(*alignment.getSa()) : 0);
-  }
-
-  AlignmentHeader&       header() { return *this; }
-  const AlignmentHeader& header() const { return *this; }
-
-  const SerializedSaTag* getSa() const
-  {
-    return hasSa_ ? (SerializedSaTag*)((const char*)&cigar_ + cigar_.getByteSize()) : 0;
-  }
-
-  SerializedSaTag& sa() { return *(SerializedSaTag*)((const char*)&cigar_ + cigar_.getByteSize()); }
-
-  friend std::ostream& operator<<(std::ostream& os, const SerializedAlignment& a)
-  {
-    return os << "SerializedAlignment(" << a.header() << ")";
-  }
-};
-
 class AlignmentPair {
   typedef std::array<Alignment*, 2>            Alignments;
   typedef std::array<const map::SeedChain*, 2> SeedChains;
@@ -58,6 +58,8 @@ private:
   SmithWaterman&                      smithWaterman_;
   VectorSmithWaterman&                vectorSmithWaterman_;
   const bool                          vectorizedSW_;
+  /// cigar operations produced by the smith-waterman, reused across alignments
+  std::string operations_;
   void updateFetchChain(const Read& read, map::SeedChain& seedChain, Alignment& alignment);
 };  // class AlignmentGenerator
 
@@ -20,6 +20,7 @@
 #include <deque>
 #include "align/Alignment.hpp"
 #include "align/InsertSizeParameters.hpp"
+#include "common/Arena.hpp"
 #include "map/ChainBuilder.hpp"
 #include "reference/ReferenceSequence.hpp"
 #include "sequences/Read.hpp"
@@ -80,6 +81,8 @@ public:
   typedef Read_and_chain_c::iterator            iterator;
   typedef align::InsertSizeParameters           InsertSizeParameters;
   typedef InsertSizeParameters::Orientation     Orientation;
+  /// reference interval to scan, allocated from the per-fragment arena
+  typedef common::ArenaVector<unsigned char>    ReferenceBases;
   typedef decltype(Orientation::pe_orient_fr_c) PairedEndOrientation;
 
 private:
@@ -171,16 +174,16 @@ public:
       const SeedChain&                    anchoredChain,
       const int                           rescuedReadLength,
       const reference::ReferenceSequence& reference,
-      std::vector<unsigned char>&         referenceBases,
+      ReferenceBases&                     referenceBases,
       const bool                          second = false) const;
 
   /**
    ** \brief find a rescue chain for the given rean in the given reference seauence if any
    **/
   bool findRescueChain(
-      const Read&                       rescuedRead,
-      const std::vector<unsigned char>& referenceBases,
-      SeedChain&                        rescuedChain) const;
+      const Read&           rescuedRead,
+      const ReferenceBases& referenceBases,
+      SeedChain&            rescuedChain) const;
 
   typedef std::array<unsigned char, 32> RescueKmer;
   /**
@@ -194,13 +197,41 @@ public:
 
   __m128i loadRescueKmer(AlignmentRescue::RescueKmer rescueKmer) const;
 
-  __m128i loadRefKmer(std::vector<unsigned char>::const_iterator refIter, size_t size) const;
+  __m128i loadRefKmer(ReferenceBases::const_iterator refIter, size_t size) const;
 
   /**
    ** \brief count mismatches between the kmer and the reference
    **/
-  int countMismatches(
-      const RescueKmer& rescueKmer, const std::vector<unsigned char>::const_iterator position) const;
+  int countMismatches(const RescueKmer& rescueKmer, const ReferenceBases::const_iterator position) const;
+
+  /// number of consecutive reference offsets processed by scanMismatchesBlock
+  static constexpr int SCAN_BLOCK = 32;
+  /**
+   ** \brief count the mismatches of the rescue kmer at each of the offsets [0, count) of the reference
+   **
+   ** Reference implementation using the 128 bits packed kmers, sliding the reference window one base
+   ** at a time. Ns on the reference never match.
+   **
+   ** \param refIter reference base aligned with the first base of the kmer for offset 0
+   ** \param count number of offsets to scan
+   ** \param mismatchCounts output, one count per offset
+   **/
+  void scanMismatches(
+      const RescueKmer&              rescueKmer,
+      ReferenceBases::const_iterator refIter,
+      int                            count,
+      int*                           mismatchCounts) const;
+  /**
+   ** \brief same as scanMismatches for SCAN_BLOCK consecutive offsets at once
+   **
+   ** With AVX2, each base of the kmer is compared against SCAN_BLOCK shifted reference bases in a
+   ** single vector and the matches are counted with a nibble popcount lookup. Requires the reference
+   ** to be readable up to refIter + SCAN_BLOCK + kmer size - 1.
+   **/
+  void scanMismatchesBlock(
+      const RescueKmer&              rescueKmer,
+      ReferenceBases::const_iterator refIter,
+      int*                           mismatchCounts) const;
 
   /**
    **
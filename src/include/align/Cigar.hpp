@@ -22,6 +22,7 @@
 #include <boost/format.hpp>
 #include <boost/range/iterator_range.hpp>
 
+#include "common/Arena.hpp"
 #include "common/Debug.hpp"
 
 namespace dragenos {
@@ -56,9 +57,12 @@ public:
     bool operator!=(const Operation& that) const { return that.first != first || that.second != second; }
     bool operator==(const Operation& that) const { return that.first == first && that.second == second; }
   };
-  typedef std::vector<Operation> Operations;
+  /// allocated from the per-fragment arena of the thread, if any
+  typedef common::ArenaVector<Operation> Operations;
 
   const Operation* getOperations() const { return operations_.data(); }
+  const Operation* begin() const { return operations_.data(); }
+  const Operation* end() const { return operations_.data() + operations_.size(); }
   /// set the cigar operations from the individual operations in operations sequence string
   uint32_t setOperationSequence(const std::string& operationsSequence, int softClipStart = 0);
   unsigned getNumberOfOperations() const { return operations_.size(); }
@@ -100,51 +104,6 @@ private:
   Operations operations_;
 };
 
-class SerializedCigar {
-  unsigned short   cigarLength_;
-  Cigar::Operation operations_[];
-
-public:
-  void operator<<(const Cigar& cigar)
-  {
-    cigarLength_ = cigar.getNumberOfOperations();
-    std::copy(cigar.getOperations(), cigar.getOperations() + cigarLength_, operations_);
-  }
-
-  const Cigar::Operation* begin() const { return operations_; }
-  const Cigar::Operation* end() const { return operations_ + cigarLength_; }
-
-  friend std::ostream& operator<<(std::ostream& os, const SerializedCigar& cig)
-  {
-    for (const auto& operation : boost::make_iterator_range(cig.begin(), cig.end())) {
-      os << operation.second << Cigar::getOperationName(operation.first);
-    }
-    return os;
-  }
-
-  std::size_t getByteSize() const { return sizeof(SerializedCigar) + cigarLength_ * sizeof(*operations_); }
-
-  static std::size_t getByteSize(const Cigar& cig)
-  {
-    return sizeof(SerializedCigar) + cig.getNumberOfOperations() * sizeof(*operations_);
-  }
-
-  uint32_t getReferenceLength() const;
-
-  int countStartClips()  // includes hard and soft clips
-      const;
-  int countStartHardClips() const;
-
-  int countEndClips()  // includes hard and soft clips
-      const;
-  int countEndHardClips() const;
-
-  int getReferenceLengthPlusEndClips()  // includes hard and soft clips
-      const;
-
-  bool empty() const { return !cigarLength_; }
-};
-
 }  // namespace align
 }  // namespace dragenos
 #endif  // #ifndef ALIGN_CIGAR_HPP
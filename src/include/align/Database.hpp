@@ -17,19 +17,23 @@
 
 #include <vector>
 
+#include "common/Arena.hpp"
+
 namespace dragenos {
 namespace align {
 
 /**
  ** \brief Proxy for the reference for the Smith-waterman algorithm
+ **
+ ** The bases are allocated from the per-fragment arena of the thread, if any.
  **/
-class Database : public std::vector<unsigned char> {
-  typedef std::vector<unsigned char> BaseT;
+class Database : public common::ArenaVector<unsigned char> {
+  typedef common::ArenaVector<unsigned char> BaseT;
 
 public:
   // conveniently forward all valid costructors from std::vector<char>
   template <typename... Args>
-  Database(Args... args) : std::vector<unsigned char>(std::forward<Args>(args)...)
+  Database(Args... args) : BaseT(std::forward<Args>(args)...)
   {
   }
   //
@@ -16,6 +16,7 @@
 #define ALIGN_INSERT_SIZE_DISTRIBUTION_HPP
 
 #include "align/InsertSizeParameters.hpp"
+#include "align/RecordSummary.hpp"
 
 #include "host/dragen_api/sampling/readgroup_insert_stats.hpp"
 
@@ -28,7 +29,9 @@ class InsertSizeDistribution {
   StatsInterval        fixedStats_;
 
 public:
+  // readGroupIndex goes to the RG column of the insert stats log
   InsertSizeDistribution(
+      uint16_t      readGroupIndex,
       bool          samplingEnabled,
       int           alignerPeq25,
       int           alignerPeq50,
@@ -51,10 +54,17 @@ public:
       std::ostream& logStream);
   //  const InsertSizeParameters& getInsertSizeParameters() const { return insertSizeParameters_; }
   InsertSizeParameters getInsertSizeParameters(std::size_t r1ReadLen);
-  void add(const align::SerializedAlignment& aln, const dragenos::sequences::SerializedRead& read);
+  void add(const RecordSummary& record);
   bool notGoingToBlock() { return !dragenInsertStats_.justSentAllInitRecords(); }
   void forceInitDoneSending();
 
+  /// true when the insert size parameters of the remaining reads no longer depend on the alignments
+  bool isFixed() const { return !samplingEnabled_ || dragenInsertStats_.hasFixedStats(); }
+  /// saves the state of a fixed distribution on one line
+  void saveFixed(std::ostream& os) const;
+  /// restores the state saved by saveFixed into a new distribution. False if it can't be read
+  bool restoreFixed(std::istream& is);
+
   friend std::ostream& operator<<(std::ostream& os, InsertSizeDistribution& d)
   {
     if (d.samplingEnabled_) {
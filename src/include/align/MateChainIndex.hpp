@@ -0,0 +1,93 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef ALIGN_MATE_CHAIN_INDEX_HPP
+#define ALIGN_MATE_CHAIN_INDEX_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "align/InsertSizeParameters.hpp"
+#include "align/Pairs.hpp"
+#include "map/ChainBuilder.hpp"
+#include "sequences/ReadPair.hpp"
+
+namespace dragenos {
+namespace align {
+
+/**
+ ** \brief Index of the seed chains of the second read by orientation and effective begin
+ **
+ ** Used to enumerate the pairs of seed chains without testing pairMatch for all the
+ ** combinations. Only the chains with the expected orientation and an effective begin in the
+ ** begin interval of the PairMatchWindow, or close enough to the end interval to have their
+ ** effective end in it, are checked against the window. The effective positions are
+ ** computed exactly as in pairMatch, so the candidates are exactly the chains that pairMatch.
+ **
+ ** With few chains, all the chains are candidates as the index would not pay off. The same goes
+ ** when the chains can move during the enumeration, as the effective positions are computed once.
+ **
+ ** The instance is meant to be reused across fragments to avoid memory allocations.
+ **/
+class MateChainIndex {
+public:
+  /// below this number of chains all the chains are candidates
+  static constexpr std::size_t MIN_INDEXED_CHAINS = 16;
+
+  /// index the first count chains of the second read. If exhaustive, all of them are candidates
+  void build(
+      const sequences::ReadPair& readPair,
+      const map::ChainBuilder&   chains,
+      std::size_t                count,
+      bool                       exhaustive = false);
+  /**
+   ** \brief append the indexes of the chains of the second read that pair with first
+   **
+   ** The indexes are appended in no particular order and without duplicates. When the
+   ** chains are not indexed, all of them are appended.
+   **/
+  void getCandidates(
+      const InsertSizeParameters& insertSizeParameters,
+      const sequences::ReadPair&  readPair,
+      const map::SeedChain&       first,
+      std::vector<unsigned>&      candidates) const;
+
+private:
+  struct Entry {
+    int      effBeg_;
+    int      effEnd_;
+    unsigned chain_;
+    bool     operator<(const Entry& that) const { return effBeg_ < that.effBeg_; }
+  };
+  std::size_t count_   = 0;
+  bool        indexed_ = false;
+  /// forward and reverse complement chains, sorted by effective begin
+  std::array<std::vector<Entry>, 2> entries_;
+  /// largest effective end minus effective begin for each orientation
+  std::array<int64_t, 2> maxEndOffset_;
+
+  /// append the chains with an effective begin in [minBeg, maxBeg] that are in the window
+  static void appendRange(
+      const std::vector<Entry>& entries,
+      const PairMatchWindow&    window,
+      int64_t                   minBeg,
+      int64_t                   maxBeg,
+      std::vector<unsigned>&    candidates);
+};
+
+}  // namespace align
+}  // namespace dragenos
+
+#endif  // #ifndef ALIGN_MATE_CHAIN_INDEX_HPP
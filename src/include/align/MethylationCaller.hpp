@@ -0,0 +1,111 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef ALIGN_METHYLATION_CALLER_HPP
+#define ALIGN_METHYLATION_CALLER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "align/Alignment.hpp"
+#include "reference/HashtableConfig.hpp"
+#include "reference/ReferenceSequence.hpp"
+#include "sequences/Read.hpp"
+
+namespace dragenos {
+namespace align {
+
+/**
+ ** \brief methylation calls of the bisulfite converted reads aligned against a methylated hashtable
+ **
+ ** The hashtable built with --ht-methylated holds two copies of each sequence of the reference: the
+ ** C->T converted one, named with the "_CT_converted" suffix, followed by the G->A converted one, named
+ ** with the "_GA_converted" suffix. The reads, converted the same way, are aligned against both at once:
+ ** a read from the original top strand aligns to the C->T copy and a read from the original bottom
+ ** strand to the G->A copy, with the usual scores as the unconverted bases can't mismatch.
+ **
+ ** The original reference base at each position is the G->A converted base where the C->T converted
+ ** one is a T, and the C->T converted base otherwise. Each C of the strand of the alignment is then
+ ** called from the sequenced base, in its CpG, CHG or CHH context, with the XM, XR and XG tags of
+ ** Bismark:
+ **   * XM: one character for each base of the SEQ field: z/Z, x/X, h/H for an unmethylated/methylated C
+ **     in a CpG, CHG or CHH context, u/U for an unknown context, '.' for anything else
+ **   * XR: conversion of the read, CT or GA
+ **   * XG: conversion of the reference sequence of the alignment, CT or GA
+ **/
+class MethylationCaller {
+public:
+  static const std::string CT_CONVERTED_SUFFIX;
+  static const std::string GA_CONVERTED_SUFFIX;
+
+  /// \throw common::InvalidParameterException if the hashtable is not a methylated one
+  MethylationCaller(
+      const reference::HashtableConfig& hashtableConfig, const reference::ReferenceSequence& referenceSequence);
+
+  /// name of a sequence of the methylated hashtable without its conversion suffix
+  static std::string getOriginalName(const std::string& sequenceName);
+  /// true for the G->A converted sequences, which are not listed in the SAM header
+  static bool isGaConverted(const std::string& sequenceName);
+
+  /// upper bound of the number of characters of the tags of a read
+  static std::size_t getMaxTagsLength(const std::size_t readLength) { return readLength + 32; }
+  /**
+   ** \brief append the XM, XR and XG tags of a mapped alignment of the read, each preceded by a tab
+   **
+   ** Instantiated for char*, at most getMaxTagsLength characters, and for std::ostreambuf_iterator<char>.
+   ** Returns the end of the tags.
+   **/
+  template <typename OutputIt>
+  OutputIt appendTags(OutputIt out, const sequences::Read& read, const Alignment& alignment) const;
+  /**
+   ** \brief true if a directional library can produce the alignment of the read on that strand and sequence
+   **
+   ** Only the original top and bottom strands are sequenced: the C->T converted reads align forward on the
+   ** C->T copy or reverse on the G->A copy, and the G->A converted reads the other way around. The other
+   ** combinations come from the complementary strands, which are not in the library.
+   **/
+  bool isDirectional(sequences::Read::Conversion conversion, bool reverseComplement, std::size_t reference) const
+  {
+    return (reverseComplement != sequences_.at(reference).gaConverted_) == (sequences::Read::G_TO_A == conversion);
+  }
+
+private:
+  /// location of the bases of a sequence and of its other conversion in reference.bin
+  struct ConvertedSequence {
+    bool gaConverted_;
+    /// [begin, end) of the positions with bases in the sequence, without the trimmed Ns
+    int64_t begin_;
+    int64_t end_;
+    /// position in reference.bin of the position 0 of the C->T and G->A converted sequences
+    std::array<uint64_t, 2> origins_;
+  };
+
+  const reference::ReferenceSequence& referenceSequence_;
+  /// by offset in the hashtable config, as the reference of the alignments
+  std::vector<ConvertedSequence> sequences_;
+
+  /// 4 bits encoded base of the original reference, N outside of the sequence
+  unsigned char getOriginalBase(const ConvertedSequence& sequence, int64_t position) const;
+  /// call of a base of the read, aligned at the given position
+  char call(const ConvertedSequence& sequence, int64_t position, char readBase) const;
+};
+
+}  // namespace align
+}  // namespace dragenos
+
+#endif  // #ifndef ALIGN_METHYLATION_CALLER_HPP
@@ -0,0 +1,105 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef ALIGN_MISMATCH_MASK_HPP
+#define ALIGN_MISMATCH_MASK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "reference/ReferenceSequence.hpp"
+
+namespace dragenos {
+namespace align {
+
+/**
+ ** \brief Base by base comparison of a query against a reference, stored as bitmasks
+ **
+ ** Bit i of the mismatch mask is set when query and reference differ at position i
+ ** and neither of them is an N. Bit i of the N mask is set when either the query or
+ ** the reference has an N (0x0 or 0xF in the 4 bits encoding) at position i. This is
+ ** consistent with SimilarityScores where Ns have their own score.
+ **
+ ** The comparison against the reference works directly on the 4 bits packed
+ ** "reference.bin" data, without expanding the reference into a separate buffer.
+ ** With AVX2, 32 bases are compared at once. A 2 bits packed reference is first
+ ** extracted into an internal buffer.
+ **
+ ** The instance is meant to be reused across reads to avoid memory allocations.
+ **/
+class MismatchMask {
+public:
+  typedef uint64_t          Word;
+  static constexpr unsigned WORD_BITS = 64;
+
+  MismatchMask() : length_(0), mismatchCount_(0), nCount_(0) {}
+
+  /// compare the query with the reference bases [referencePosition, referencePosition + length)
+  void compare(
+      const unsigned char*                query,
+      size_t                              length,
+      const reference::ReferenceSequence& reference,
+      size_t                              referencePosition);
+  /// compare two sequences of identical length, both encoded with one base per byte
+  void compare(const unsigned char* query, const unsigned char* database, size_t length);
+
+  size_t   size() const { return length_; }
+  unsigned getMismatchCount() const { return mismatchCount_; }
+  unsigned getNCount() const { return nCount_; }
+  /// true if there are no mismatches and no Ns
+  bool isClean() const { return (0 == mismatchCount_) && (0 == nCount_); }
+  bool isMismatch(size_t i) const { return (mismatches_[i / WORD_BITS] >> (i % WORD_BITS)) & 1; }
+  bool isN(size_t i) const { return (ns_[i / WORD_BITS] >> (i % WORD_BITS)) & 1; }
+  const std::vector<Word>& getMismatches() const { return mismatches_; }
+  const std::vector<Word>& getNs() const { return ns_; }
+  /// number of mismatches in the range [begin, end)
+  unsigned countMismatches(size_t begin, size_t end) const;
+  /// total score for the given match, mismatch and N scores
+  int getScore(int match, int mismatch, int nScore) const
+  {
+    const int matchCount = length_ - mismatchCount_ - nCount_;
+    return matchCount * match + int(mismatchCount_) * mismatch + int(nCount_) * nScore;
+  }
+  /**
+   ** \brief detect bursts of SNPs
+   **
+   ** A burst is detected at position i when the number of mismatches in the window
+   ** (i - window, i] plus the number of Ns in [0, i] reaches the minimum. Ns count
+   ** as mismatches but never leave the window. This is the exact behavior of the
+   ** original base by base detection in Aligner::isPerfectAlignment.
+   **/
+  bool hasBurst(unsigned window, unsigned minimum) const;
+
+private:
+  size_t            length_;
+  unsigned          mismatchCount_;
+  unsigned          nCount_;
+  std::vector<Word> mismatches_;
+  std::vector<Word> ns_;
+
+  /// reference bases extracted from a packed reference
+  std::vector<unsigned char> referenceBases_;
+
+  void        reset(size_t length);
+  void        count();
+  void        setBase(size_t i, unsigned char queryBase, unsigned char referenceBase);
+  void        setBits(size_t i, uint32_t mismatches, uint32_t ns);
+  static bool isNBase(unsigned char base) { return (0 == base) || (0xF == base); }
+};
+
+}  // namespace align
+}  // namespace dragenos
+
+#endif  // #ifndef ALIGN_MISMATCH_MASK_HPP
@@ -24,6 +24,7 @@
 #include "align/AlignmentGenerator.hpp"
 #include "align/Alignments.hpp"
 #include "align/InsertSizeParameters.hpp"
+#include "common/Arena.hpp"
 #include "map/Mapper.hpp"
 #include "reference/Hashtable.hpp"
 #include "reference/HashtableConfig.hpp"
@@ -47,8 +48,6 @@ class PairBuilder {
   const int               aln_cfg_mapq_min_len_;
   const int               aln_cfg_sample_mapq0_;
 
-  mutable std::vector<int> reported_;
-
 public:
   typedef sequences::Read     Read;
   typedef sequences::ReadPair ReadPair;
@@ -117,8 +116,8 @@ public:
     const ScoreType scaled_max_pen = (m2a_scale * aln_cfg_sec_phred_delta_) >> 10;  //27;
     const ScoreType sec_aln_delta  = std::max(scaled_max_pen, aln_cfg_sec_score_delta_);
 
-    reported_.clear();
-    reported_.resize(unpaired.size(), false);
+    // per-fragment scratch, allocated from the arena of the thread if any
+    common::ArenaVector<int> reported(unpaired.size(), false);
     int secAligns = aln_cfg_sec_aligns_;
 
     for (auto& p : pairs) {
@@ -127,13 +126,13 @@ public:
           !best->at(readIdx).isDuplicate(p.at(readIdx)) &&
           // D0004:230:H08B1ADXX:1:1105:18508:35343          (p.at(readIdx).isUnmapped() ||
           // best->at(readIdx).isOverlap(p.at(readIdx))) &&
-          !reported_[std::distance(&unpaired.front(), &p.cat(readIdx))]) {
+          !reported[std::distance(&unpaired.front(), &p.cat(readIdx))]) {
         if (!secAligns) {
           return !aln_cfg_sec_aligns_hard_;
         }
         store(p);
         --secAligns;
-        reported_[std::distance(&unpaired.front(), &p.cat(readIdx))] = true;
+        reported[std::distance(&unpaired.front(), &p.cat(readIdx))] = true;
       }
     }
 
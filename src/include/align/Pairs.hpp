@@ -15,6 +15,7 @@
 #ifndef ALIGN_PAIRS_HPP
 #define ALIGN_PAIRS_HPP
 
+#include "align/Alignment.hpp"
 #include "align/InsertSizeParameters.hpp"
 #include "map/SeedChain.hpp"
 #include "sequences/ReadPair.hpp"
@@ -22,6 +23,31 @@
 namespace dragenos {
 namespace align {
 
+/**
+ ** \brief intervals where the effective begin or end of the mate chain must be for a pair match
+ **
+ ** Note: as in the hardware, the end interval is checked with the effective end against its minimum
+ ** and the effective begin against its maximum.
+ **/
+struct PairMatchWindow {
+  bool mateReverseComplement_;
+  int  minBeg_;
+  int  maxBeg_;
+  int  minEnd_;
+  int  maxEnd_;
+
+  bool contains(const int effBeg, const int effEnd) const
+  {
+    return ((effBeg >= minBeg_) && (effBeg <= maxBeg_)) || ((effEnd >= minEnd_) && (effBeg <= maxEnd_));
+  }
+};
+
+/// the window for the mates of the given seed chain of the first read
+PairMatchWindow getPairMatchWindow(
+    const InsertSizeParameters& insertSizeParameters,
+    const sequences::ReadPair&  readPair,
+    const map::SeedChain&       first);
+
 bool pairMatch(
     const InsertSizeParameters& insertSizeParameters,
     const sequences::ReadPair&  readPair,
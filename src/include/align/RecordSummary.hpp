@@ -0,0 +1,66 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef ALIGN_RECORD_SUMMARY_HPP
+#define ALIGN_RECORD_SUMMARY_HPP
+
+#include <cstdint>
+
+#include "align/Alignment.hpp"
+#include "sequences/Read.hpp"
+
+namespace dragenos {
+namespace align {
+
+/**
+ ** \brief the fields of an output record needed by the insert size statistics and the mapping metrics
+ **
+ ** The workflows keep one per record of each block, next to the formatted output, until the records
+ ** have been sampled for the insert size statistics. The mapping metrics also need the cigar and the
+ ** qualities, which they get from the alignment and the read themselves (see DbamHeader).
+ **/
+struct RecordSummary {
+  RecordSummary(const Alignment& alignment, const sequences::Read& read)
+    : flags_(alignment.getFlags()),
+      mapq_(alignment.getMapq()),
+      templateLength_(alignment.getTemplateLength()),
+      unclippedPosition_(
+          int64_t(alignment.getPosition()) +
+          (alignment.isReverseComplement()
+               ? int64_t(int(alignment.getCigar().getReferenceLengthPlusEndClips()) - 1)
+               : -int64_t(alignment.getCigar().countStartClips()))),
+      mateCoordinate_(alignment.getMateCoordinate()),
+      mismatches_(alignment.getMismatchCount()),
+      reference_(alignment.getReference()),
+      nextReference_(alignment.getNextReference()),
+      readLength_(read.getLength())
+  {
+  }
+
+  FlagType flags_;
+  MapqType mapq_;
+  int      templateLength_;
+  /// position of the first base of the read on the reference, including the clipped bases
+  int64_t  unclippedPosition_;
+  int32_t  mateCoordinate_;
+  int      mismatches_;
+  short    reference_;
+  short    nextReference_;
+  short    readLength_;
+};
+
+}  // namespace align
+}  // namespace dragenos
+
+#endif  // #ifndef ALIGN_RECORD_SUMMARY_HPP
@@ -0,0 +1,128 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef API_ALIGNER_CONTEXT_HPP
+#define API_ALIGNER_CONTEXT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "align/Aligner.hpp"
+#include "align/InsertSizeDistribution.hpp"
+#include "align/SinglePicker.hpp"
+#include "api/Reference.hpp"
+#include "common/Arena.hpp"
+#include "io/Fastq2ReadTransformer.hpp"
+#include "sam/SamGenerator.hpp"
+
+namespace dragenos {
+namespace api {
+
+/// read submitted to the embedded aligner, with the bases and qualities as in a FASTQ file
+struct ReadRecord {
+  std::string name_;
+  std::string bases_;
+  /// quality characters, with the fastq-offset of the options
+  std::string qualities_;
+};
+
+/**
+ ** \brief alignment of a read, with the content of a SAM record
+ **
+ ** Positions are 0-based. The references are the indexes in Reference::getSequenceNames(),
+ ** -1 where the SAM record has "*".
+ **/
+struct AlignmentRecord {
+  /// index of the read (or of the pair) in the batch
+  std::size_t read_;
+  uint16_t    flags_;
+  int         reference_;
+  int64_t     position_;
+  int         mapq_;
+  /// empty for "*"
+  std::string cigar_;
+  int         nextReference_;
+  int64_t     nextPosition_;
+  int64_t     templateLength_;
+  /// AS tag, -1 if none
+  int         score_;
+  /// NM tag, -1 if none
+  int         mismatches_;
+};
+
+/**
+ ** \brief Aligner state of one thread of the embedded aligner
+ **
+ ** Aligns batches of reads or read pairs with the alignment options of the Reference and
+ ** produces the same records as dragen-os, either as AlignmentRecord or as SAM text. Each
+ ** thread uses its own context. Contexts on different references can be used in the same
+ ** process.
+ **
+ ** The insert size statistics of dragen-os are estimated on the whole input stream, which is
+ ** not available here: the pairs are aligned with the fixed statistics given by the
+ ** Aligner.pe-stat-* options or, without them, without mate rescue.
+ **/
+class AlignerContext {
+public:
+  explicit AlignerContext(const Reference& reference);
+  AlignerContext(const AlignerContext&) = delete;
+  AlignerContext& operator=(const AlignerContext&) = delete;
+
+  /// appends the records of the single ended reads to records
+  void alignSingle(const std::vector<ReadRecord>& reads, std::vector<AlignmentRecord>& records);
+  /// appends the records of the pairs (reads1[i], reads2[i]) to records
+  void alignPairs(
+      const std::vector<ReadRecord>& reads1,
+      const std::vector<ReadRecord>& reads2,
+      std::vector<AlignmentRecord>&  records);
+  /// same as above, appending the SAM records, one per line, to sam
+  void alignSingle(const std::vector<ReadRecord>& reads, std::vector<char>& sam);
+  void alignPairs(
+      const std::vector<ReadRecord>& reads1, const std::vector<ReadRecord>& reads2, std::vector<char>& sam);
+
+private:
+  const Reference&              reference_;
+  const align::SimilarityScores similarity_;
+  align::SinglePicker           singlePicker_;
+  align::PairBuilder            pairBuilder_;
+  align::Aligner                aligner_;
+  const sam::SamGenerator       sam_;
+  io::FastqToReadTransformer    transformer_;
+  /// SAM index of the sequences, by offset in the hashtable config
+  std::vector<int> sequenceIndexes_;
+  /// per-read scratch memory of the alignments
+  common::Arena arena_;
+  /// fixed statistics given in the options, if any
+  std::unique_ptr<align::InsertSizeDistribution> insertSizeDistribution_;
+  align::InsertSizeParameters                    insertSizeParameters_;
+  std::size_t                                    insertSizeReadLength_ = 0;
+
+  align::Aligner::ReadPair   pair_;
+  align::AlignmentPairs      alignmentPairs_;
+  align::Aligner::Alignments alignments_;
+
+  template <typename StoreOp>
+  void alignSingle(const std::vector<ReadRecord>& reads, StoreOp store);
+  template <typename StoreOp>
+  void alignPairs(const std::vector<ReadRecord>& reads1, const std::vector<ReadRecord>& reads2, StoreOp store);
+  void makeRead(const ReadRecord& record, unsigned position, uint64_t index, sequences::Read& read);
+  AlignmentRecord makeRecord(const sequences::Read& read, const align::Alignment& alignment) const;
+};
+
+}  // namespace api
+}  // namespace dragenos
+
+#endif  // #ifndef API_ALIGNER_CONTEXT_HPP
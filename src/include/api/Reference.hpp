@@ -0,0 +1,76 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef API_REFERENCE_HPP
+#define API_REFERENCE_HPP
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "options/DragenOsOptions.hpp"
+#include "reference/Hashtable.hpp"
+#include "reference/ReferenceDir.hpp"
+#include "reference/TargetIndex.hpp"
+
+namespace dragenos {
+namespace api {
+
+/**
+ ** \brief Reference directory and hashtable of the embedded aligner
+ **
+ ** Loaded once and shared, read-only, by all the AlignerContext created on it. The
+ ** options are the dragen-os command line options, without the inputs and outputs,
+ ** for instance {"-r", "/data/hg38", "--Aligner.sec-aligns", "2"}, so that the
+ ** alignments are the same as the ones of dragen-os with the same options. The index of
+ ** the Mapper.target-bed regions, if any, is built once here too.
+ **
+ ** Several references can be open in the same process.
+ **/
+class Reference {
+public:
+  explicit Reference(const std::vector<std::string>& arguments);
+  Reference(const Reference&) = delete;
+  Reference& operator=(const Reference&) = delete;
+
+  const options::DragenOsOptions&   getOptions() const { return options_; }
+  const reference::ReferenceDir7&   getReferenceDir() const { return *referenceDir_; }
+  const reference::HashtableConfig& getHashtableConfig() const { return referenceDir_->getHashtableConfig(); }
+  const reference::Hashtable&       getHashtable() const { return *hashtable_; }
+  /// index of the Mapper.target-bed regions, null without them
+  const reference::TargetIndex* getTargetIndex() const { return targetIndex_.get(); }
+  /// names of the reference sequences in the order of the SAM header, indexed by AlignmentRecord::reference_
+  const std::vector<std::string>& getSequenceNames() const
+  {
+    return referenceDir_->getHashtableConfig().getSequenceNames();
+  }
+  /// SAM header matching the records of AlignerContext
+  void writeSamHeader(std::ostream& os) const;
+
+private:
+  /// the options keep pointers to the arguments
+  const std::vector<std::string>             arguments_;
+  std::vector<const char*>                   argv_;
+  options::DragenOsOptions                   options_;
+  std::unique_ptr<reference::ReferenceDir7> referenceDir_;
+  std::unique_ptr<reference::PageWarmup>     warmup_;
+  std::unique_ptr<reference::Hashtable>      hashtable_;
+  std::unique_ptr<reference::TargetIndex>    targetIndex_;
+};
+
+}  // namespace api
+}  // namespace dragenos
+
+#endif  // #ifndef API_REFERENCE_HPP
@@ -0,0 +1,38 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef COMMON_ALLOCATION_COUNTER_HPP
+#define COMMON_ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+
+namespace dragenos {
+namespace common {
+
+/**
+ ** \brief Heap allocation counters for benchmarking
+ **
+ ** The counters are only maintained when building with COUNT_ALLOCATIONS=1 (see
+ ** config.mk), which replaces the global operator new with a counting version.
+ ** Otherwise, both functions always return 0.
+ **/
+/// number of calls to the global operator new since the start of the program
+std::size_t getAllocationCount();
+/// total number of bytes requested from the global operator new since the start of the program
+std::size_t getAllocationBytes();
+
+}  // namespace common
+}  // namespace dragenos
+
+#endif  // #ifndef COMMON_ALLOCATION_COUNTER_HPP
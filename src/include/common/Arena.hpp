@@ -0,0 +1,193 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef COMMON_ARENA_HPP
+#define COMMON_ARENA_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace dragenos {
+namespace common {
+
+/**
+ ** \brief Bump allocator for short lived scratch memory
+ **
+ ** Memory is carved sequentially out of large chunks and individual deallocations
+ ** are ignored. All the memory is released at once with reset(), which keeps the
+ ** chunks for reuse: once the arena has grown to the size needed by the largest
+ ** fragment, processing a fragment does not hit the heap anymore.
+ **
+ ** Each worker thread owns its Arena and makes it the current arena of the thread
+ ** with an Arena::Scope. Containers using ArenaAllocator default to the current
+ ** arena of the thread and fall back to the heap when there is none.
+ **
+ ** The arena is not thread safe.
+ **/
+class Arena {
+public:
+  static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+  explicit Arena(std::size_t chunkSize = DEFAULT_CHUNK_SIZE)
+    : chunkSize_(chunkSize), chunk_(0), offset_(0), allocatedBytes_(0)
+  {
+    assert(0 < chunkSize_);
+  }
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /// bytes aligned on the given alignment (a power of 2). Never returns nullptr
+  void* allocate(const std::size_t bytes, const std::size_t alignment)
+  {
+    assert(0 == (alignment & (alignment - 1)));
+    // move on to the next chunk large enough, keeping the smaller ones for later fragments
+    while (chunks_.size() > chunk_) {
+      Chunk&            chunk   = chunks_[chunk_];
+      const std::size_t address = reinterpret_cast<std::size_t>(chunk.data_.get()) + offset_;
+      const std::size_t padding = (alignment - address % alignment) % alignment;
+      if (chunk.size_ >= offset_ + padding + bytes) {
+        void* ret = chunk.data_.get() + offset_ + padding;
+        offset_ += padding + bytes;
+        allocatedBytes_ += bytes;
+        return ret;
+      }
+      ++chunk_;
+      offset_ = 0;
+    }
+    const std::size_t size = std::max(chunkSize_, bytes + alignment);
+    chunks_.push_back(Chunk{std::unique_ptr<char[]>(new char[size]), size});
+    chunk_  = chunks_.size() - 1;
+    offset_ = 0;
+    return allocate(bytes, alignment);
+  }
+  /// release all the memory allocated since the last reset, keeping the chunks
+  void reset()
+  {
+    chunk_          = 0;
+    offset_         = 0;
+    allocatedBytes_ = 0;
+  }
+  std::size_t getChunkCount() const { return chunks_.size(); }
+  /// total bytes allocated since the last reset
+  std::size_t getAllocatedBytes() const { return allocatedBytes_; }
+
+  /// the arena of the current thread. nullptr if there is none
+  static Arena* current() { return current_; }
+  /// reset the arena of the current thread, if any
+  static void resetCurrent()
+  {
+    if (nullptr != current_) {
+      current_->reset();
+    }
+  }
+
+  /**
+   ** \brief makes an arena the current arena of the thread for the lifetime of the scope
+   **/
+  class Scope {
+  public:
+    explicit Scope(Arena& arena) : previous_(current_) { current_ = &arena; }
+    ~Scope() { current_ = previous_; }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Arena* const previous_;
+  };
+
+private:
+  struct Chunk {
+    std::unique_ptr<char[]> data_;
+    std::size_t             size_;
+  };
+  const std::size_t  chunkSize_;
+  std::vector<Chunk> chunks_;
+  /// index of the chunk currently used for allocation
+  std::size_t        chunk_;
+  /// offset of the first free byte in the current chunk
+  std::size_t        offset_;
+  std::size_t        allocatedBytes_;
+
+  static inline thread_local Arena* current_ = nullptr;
+};
+
+/**
+ ** \brief STL allocator carving memory out of an Arena
+ **
+ ** Default constructed allocators use the current arena of the thread, or the heap
+ ** when there is none, so that the same containers can be used outside of the
+ ** workflows. Copies of containers get an allocator for the arena of the thread doing
+ ** the copy rather than the arena of the original.
+ **
+ ** Note: containers allocating from an arena must not be used after the arena is
+ ** reset. In practice this means they must not outlive the processing of a fragment,
+ ** or they must be cleared at the beginning of the next one.
+ **/
+template <typename T>
+class ArenaAllocator {
+public:
+  typedef T               value_type;
+  typedef std::true_type  propagate_on_container_move_assignment;
+  typedef std::true_type  propagate_on_container_swap;
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::false_type is_always_equal;
+
+  ArenaAllocator() noexcept : arena_(Arena::current()) {}
+  explicit ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& that) noexcept : arena_(that.getArena())
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    return (nullptr == arena_) ? std::allocator<T>().allocate(n)
+                               : static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* p, std::size_t n)
+  {
+    if (nullptr == arena_) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  }
+
+  ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+  Arena*         getArena() const { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& that) const
+  {
+    return arena_ == that.getArena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& that) const
+  {
+    return arena_ != that.getArena();
+  }
+
+private:
+  Arena* arena_;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}  // namespace common
+}  // namespace dragenos
+
+#endif  // #ifndef COMMON_ARENA_HPP
@@ -266,6 +266,18 @@ public:
 
   void notify_all() { stateChangedCondition_.notify_all(); }
 
+  /**
+   * \brief forgets the exception of a failed execute so that the pool can be used again. Only valid once
+   *        the failed execute has returned and nothing else is executing.
+   */
+  void clearFailure()
+  {
+    lock_type lock(mutex_);
+    assert(!head_);
+    firstThreadException_ = nullptr;
+    aThreadFailed_        = false;
+  }
+
   /**
    * \brief Executes func on requested number of size() threads.
    **/
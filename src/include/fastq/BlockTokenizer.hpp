@@ -0,0 +1,59 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include "common/Debug.hpp"
+#include "fastq/Token.hpp"
+
+namespace dragenos {
+namespace fastq {
+
+/**
+ ** \brief Tokenizer over a block of complete FASTQ records already in memory
+ **
+ ** Unlike Tokenizer, the records are not copied into a buffer: the tokens point
+ ** directly into [begin, end), which must outlive them. This is the case of the
+ ** blocks read by FastqNRecordReader and of the blocks of MappedFastqReader.
+ **/
+class BlockTokenizer {
+public:
+  typedef BasicToken<const char*> Token;
+
+private:
+  const char* current_;
+  const char* const end_;
+  Token             currentToken_;
+
+public:
+  BlockTokenizer(const char* begin, const char* end) : current_(begin), end_(end) {}
+  const Token& token() const { return currentToken_; }
+
+  /// \return true if the next record is valid, false at the end of the block
+  bool next()
+  {
+    if (currentToken_.reset(current_, end_)) {
+      current_ = currentToken_.end();
+    } else if (!currentToken_.empty()) {
+      throw std::logic_error(std::string("Invalid fastq record at the end of the block token:") << currentToken_);
+    }
+    return currentToken_.valid();
+  }
+};
+
+}  // namespace fastq
+}  // namespace dragenos
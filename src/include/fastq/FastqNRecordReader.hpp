@@ -56,6 +56,27 @@ public:
   }
 
   bool eof() const { return stream_.eof(); }
+
+  /**
+   * \brief         moves the stream past the given number of bytes of records, as counted by read, which
+   *                ends the last line of the stream with a newline even when the stream doesn't
+   * \return        false if the stream is shorter
+   */
+  static bool skip(std::istream& stream, const std::size_t bytes)
+  {
+    if (0 == bytes) {
+      return true;
+    }
+    char last = '\n';
+    if (1 < bytes) {
+      stream.ignore(bytes - 2);
+      if ((bytes - 2 != std::size_t(stream.gcount())) || !stream.get(last)) {
+        return false;
+      }
+    }
+    const std::istream::int_type newLine = stream.get();
+    return ('\n' == newLine) || ((std::istream::traits_type::eof() == newLine) && ('\n' != last));
+  }
 };
 
 }  // namespace fastq
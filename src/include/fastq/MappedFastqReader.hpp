@@ -0,0 +1,69 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace dragenos {
+namespace fastq {
+
+/**
+ ** \brief Uncompressed FASTQ file mapped in memory, read in blocks of records without copy
+ **
+ ** Each block is a range of the mapping ending at a record boundary, found by
+ ** scanning for the newlines with memchr, which is meant to be tokenized in place
+ ** with BlockTokenizer. The kernel is told that the mapping is read sequentially
+ ** and asked to read ahead of the last block, so that the aligner threads rarely
+ ** fault on pages not yet in the page cache.
+ **
+ ** The blocks are valid for the lifetime of the reader.
+ **/
+class MappedFastqReader {
+public:
+  explicit MappedFastqReader(const std::string& path);
+  ~MappedFastqReader();
+  MappedFastqReader(const MappedFastqReader&) = delete;
+  MappedFastqReader& operator=(const MappedFastqReader&) = delete;
+
+  /**
+   * \brief         points [begin, end) at the next n fastq records of the file, or the remaining ones
+   * \return        number of records in the block, as FastqNRecordReader::read
+   */
+  std::size_t read(const char*& begin, const char*& end, std::size_t n);
+
+  /// moves past the given number of bytes, counted as by read or FastqNRecordReader. False if the file is shorter
+  bool skip(std::size_t bytes);
+
+  bool        eof() const { return end_ == current_; }
+  std::size_t size() const { return size_; }
+
+private:
+  /// how far ahead of the last block the pages are requested from the kernel
+  static const std::size_t READAHEAD_BYTES = 64 * 1024 * 1024;
+
+  const std::string path_;
+  std::size_t       size_;
+  const char*       data_;
+  const char*       end_;
+  const char*       current_;
+  /// end of the range already requested with MADV_WILLNEED
+  const char* advised_;
+
+  void adviseReadahead();
+};
+
+}  // namespace fastq
+}  // namespace dragenos
@@ -94,7 +94,7 @@ public:
   // skip @ at the start of name
   std::pair<IT, IT> getName(const char qnameSuffixDelim) const
   {
-    return make_pair(headerBegin_ + 1, std::find(headerBegin_ + 1, headerEnd_, qnameSuffixDelim));
+    return std::make_pair(headerBegin_ + 1, std::find(headerBegin_ + 1, headerEnd_, qnameSuffixDelim));
   }
   std::pair<IT, IT> getBases() const { return std::make_pair(baseCallsBegin_, baseCallsEnd_); }
   std::pair<IT, IT> getQscores() const { return std::make_pair(qScoresBegin_, end_); }
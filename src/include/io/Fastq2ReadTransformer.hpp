@@ -14,6 +14,9 @@
 
 #pragma once
 
+#include <utility>
+
+#include "fastq/BlockTokenizer.hpp"
 #include "fastq/Tokenizer.hpp"
 #include "sequences/Read.hpp"
 
@@ -28,6 +31,8 @@ public:
   static const char DEFAULT_Q0          = 33;
   static const char DEFAULT_QNAME_DELIM = ' ';
   char              qnameSuffixDelim_   = DEFAULT_QNAME_DELIM;
+  /// directional bisulfite library: C to T conversion of the first reads, G to A of the second ones
+  bool bisulfite_ = false;
 
   sequences::Read::Name      tmpName_;
   sequences::Read::Bases     tmpBases_;
@@ -41,8 +46,9 @@ public:
   friend DumpT& dump(DumpT& dump, const FastqToReadTransformer& transformer);
 
 public:
-  FastqToReadTransformer(const char qnameSuffixDelim = DEFAULT_QNAME_DELIM, const char q0 = DEFAULT_Q0)
-    : qnameSuffixDelim_(qnameSuffixDelim)
+  FastqToReadTransformer(
+      const char qnameSuffixDelim = DEFAULT_QNAME_DELIM, const char q0 = DEFAULT_Q0, const bool bisulfite = false)
+    : qnameSuffixDelim_(qnameSuffixDelim), bisulfite_(bisulfite)
   {
     std::fill(q0_, q0_ + (VECTOR_REGISTER_WIDTH ? VECTOR_REGISTER_WIDTH : 1), q0);
     std::fill(q2_, q2_ + (VECTOR_REGISTER_WIDTH ? VECTOR_REGISTER_WIDTH : 1), 2);
@@ -51,9 +57,38 @@ public:
   void operator()(
       const fastq::Tokenizer::Token& fastqToken, unsigned pos, uint64_t fragmentId, sequences::Read& read)
   {
-    const auto name    = fastqToken.getName(qnameSuffixDelim_);
-    const auto bases   = fastqToken.getBases();
-    const auto qscores = fastqToken.getQscores();
+    (*this)(
+        fastqToken.getName(qnameSuffixDelim_),
+        fastqToken.getBases(),
+        fastqToken.getQscores(),
+        pos,
+        fragmentId,
+        read);
+  }
+
+  /// same as above for a record tokenized in place
+  void operator()(
+      const fastq::BlockTokenizer::Token& fastqToken, unsigned pos, uint64_t fragmentId, sequences::Read& read)
+  {
+    (*this)(
+        fastqToken.getName(qnameSuffixDelim_),
+        fastqToken.getBases(),
+        fastqToken.getQscores(),
+        pos,
+        fragmentId,
+        read);
+  }
+
+  /// same as above for a read already split into its name, bases and quality characters
+  template <typename NameIt, typename BasesIt, typename QscoresIt>
+  void operator()(
+      const std::pair<NameIt, NameIt>&       name,
+      const std::pair<BasesIt, BasesIt>&     bases,
+      const std::pair<QscoresIt, QscoresIt>& qscores,
+      unsigned                               pos,
+      uint64_t                               fragmentId,
+      sequences::Read&                       read)
+  {
     tmpName_.assign(name.first, name.second);
     tmpBases_.assign(bases.first, bases.second);
     tmpQscores_.assign(qscores.first, qscores.second);
@@ -72,6 +107,9 @@ public:
 #endif  // VECTOR_REGISTER_WIDTH
 
     read.init(std::move(tmpName_), std::move(tmpBases_), std::move(tmpQscores_), fragmentId, pos);
+    if (bisulfite_) {
+      read.convert((0 == pos) ? sequences::Read::C_TO_T : sequences::Read::G_TO_A);
+    }
   }
 
 private:
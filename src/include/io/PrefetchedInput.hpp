@@ -0,0 +1,87 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef IO_PREFETCHED_INPUT_HPP
+#define IO_PREFETCHED_INPUT_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dragenos {
+namespace io {
+
+/**
+ ** \brief Input file read and decompressed by a background thread
+ **
+ ** The thread fills a bounded queue of chunks ahead of the consumer, so that the
+ ** decompression of each input runs concurrently with the alignment and with the
+ ** decompression of the other inputs, instead of in the critical section of the
+ ** block readers.
+ **
+ ** The errors of the background thread, including the gzip errors, are rethrown
+ ** from the stream, which has badbit in its exception mask.
+ **/
+class PrefetchedInput : public std::istream {
+public:
+  static constexpr std::size_t CHUNK_BYTES = 1024 * 1024;
+  static constexpr std::size_t CHUNK_COUNT = 16;
+
+  /**
+   ** \param path file to read
+   ** \param gzip true to decompress the file, which can have several gzip members (BAM)
+   **/
+  PrefetchedInput(const std::string& path, bool gzip);
+  ~PrefetchedInput();
+  PrefetchedInput(const PrefetchedInput&) = delete;
+  PrefetchedInput& operator=(const PrefetchedInput&) = delete;
+
+private:
+  class Buffer : public std::streambuf {
+  public:
+    Buffer(const std::string& path, bool gzip);
+    ~Buffer();
+
+  protected:
+    int_type underflow() override;
+
+  private:
+    std::mutex                     mutex_;
+    std::condition_variable        changed_;
+    std::deque<std::vector<char>>  full_;
+    std::vector<std::vector<char>> free_;
+    /// chunk being consumed
+    std::vector<char>  current_;
+    bool               done_ = false;
+    bool               stop_ = false;
+    std::exception_ptr exception_;
+    std::thread        thread_;
+
+    void read(const std::string& path, bool gzip);
+  };
+
+  Buffer buffer_;
+};
+
+}  // namespace io
+}  // namespace dragenos
+
+#endif  // #ifndef IO_PREFETCHED_INPUT_HPP
@@ -36,11 +36,19 @@ namespace map {
  ** into an independent class, and second enabling the client code to reuse allocated
  ** internal buffers for positions and chains.
  **
+ ** A seed position can only be accepted by the chains with the same orientation and an
+ ** initial diagonal less than SeedChain::DIAG_HALF_BIN_SIZE away from the diagonal of the
+ ** seed. The chains are indexed by orientation and initial diagonal bin so that only
+ ** the chains in the bin of the seed and in the two neighbouring bins are tested.
+ **
  **/
 class ChainBuilder {
 public:
-  ChainBuilder(double chainFilterRatio) : seedChainCount_(0), chainFilterRatio_(chainFilterRatio) {}
-  void                                   clear() { seedChainCount_ = 0; }
+  ChainBuilder(double chainFilterRatio)
+    : seedChainCount_(0), chainFilterRatio_(chainFilterRatio), diagonalIndexHeads_(DIAGONAL_INDEX_SIZE, -1)
+  {
+  }
+  void                                   clear();
   std::vector<SeedChain>::const_iterator begin() const { return seedChains_.begin(); }
   std::vector<SeedChain>::const_iterator end() const { return seedChains_.begin() + seedChainCount_; }
 
@@ -60,6 +68,34 @@ public:
   void sort(F compare)
   {
     std::sort(seedChains_.begin(), seedChains_.begin() + seedChainCount_, compare);
+    rebuildDiagonalIndex();
+  }
+  /**
+   ** \brief remove the chains matching the predicate, keeping the order of the others
+   **
+   ** As the filtering of a chain depends on the other chains, the remaining chains are filtered
+   ** again if any chain was removed. Returns the number of chains removed.
+   **/
+  template <class P>
+  std::size_t removeChains(P predicate)
+  {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; seedChainCount_ > i; ++i) {
+      if (!predicate(seedChains_[i])) {
+        // swapped to keep the buffers of the removed chains for reuse
+        std::swap(seedChains_[kept++], seedChains_[i]);
+      }
+    }
+    const std::size_t removed = seedChainCount_ - kept;
+    if (0 != removed) {
+      seedChainCount_ = kept;
+      for (std::size_t i = 0; seedChainCount_ > i; ++i) {
+        seedChains_[i].setFiltered(false);
+      }
+      rebuildDiagonalIndex();
+      filterChains();
+    }
+    return removed;
   }
 
   friend std::ostream& operator<<(std::ostream& os, const ChainBuilder& chains)
@@ -78,6 +114,28 @@ private:
   double                 chainFilterRatio_    = 2.0;
   double                 chainFilterConstant_ = 0.0;
   int                    numRandomSampleHits_ = 0;
+
+  /// number of slots in the diagonal index. Must be a power of 2
+  static constexpr std::size_t DIAGONAL_INDEX_SIZE = 256;
+  /// first chain in each slot of the diagonal index, -1 for none
+  std::vector<int> diagonalIndexHeads_;
+  /// next chain in the same slot, for each chain
+  std::vector<int> diagonalIndexNext_;
+  /// orientation and initial diagonal bin of each chain
+  std::vector<uint32_t> diagonalIndexKeys_;
+  /// false when some chains are not indexed (empty chains accept any seed)
+  bool diagonalIndexValid_ = true;
+
+  static uint32_t getDiagonalKey(uint32_t diagonalBin, bool reverseComplement)
+  {
+    return diagonalBin * 2 + reverseComplement;
+  }
+  /// add the chain at the given offset to the diagonal index
+  void indexChain(std::size_t chain);
+  void rebuildDiagonalIndex();
+  /// add the seed position to all the accepting chains in the given bin. Returns true if any
+  bool addToDiagonalBin(
+      uint32_t diagonalBin, const SeedPosition& seedPosition, bool reverseComplement, bool randomSample);
 };
 
 }  // namespace map
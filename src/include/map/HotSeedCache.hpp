@@ -0,0 +1,124 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef MAP_HOT_SEED_CACHE_HPP
+#define MAP_HOT_SEED_CACHE_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "reference/ExtendTableInterval.hpp"
+#include "reference/HashRecord.hpp"
+
+namespace dragenos {
+namespace map {
+
+/**
+ ** \brief Memoization of the hashtable lookups that needed several bucket accesses
+ **
+ ** Repetitive seeds (ALU, LINE, satellites) are looked up again and again across
+ ** reads, each time chaining or probing through the same buckets. The lookups are
+ ** deterministic functions of the query hash, so the outcome of Hashtable::getHits
+ ** (the HIT and EXTEND records and the extend table interval, if any) can be replayed
+ ** as is when the same hash is queried again.
+ **
+ ** The key is the query hash and whether it is an extended hash. Extended hashes
+ ** already encode the extension id and the wings of the seed, so the key identifies
+ ** both the primary seed and its extension state.
+ **
+ ** The cache is a direct mapped table of fixed size slots: memory is bounded and
+ ** allocated once. Only lookups that accessed at least minBucketAccesses buckets and
+ ** produced at most MAX_HITS records are stored, everything else is cheaper to look
+ ** up again than to cache.
+ **
+ ** The cache is not thread safe: each Mapper owns its own.
+ **/
+class HotSeedCache {
+public:
+  typedef reference::HashRecord          HashRecord;
+  typedef reference::ExtendTableInterval ExtendTableInterval;
+  static constexpr unsigned              MAX_HITS = 32;
+
+  /// counters reported at the end of the run
+  struct Statistics {
+    uint64_t lookups_   = 0;
+    uint64_t hits_      = 0;
+    uint64_t inserts_   = 0;
+    uint64_t evictions_ = 0;
+    void     add(const Statistics& that)
+    {
+      lookups_ += that.lookups_;
+      hits_ += that.hits_;
+      inserts_ += that.inserts_;
+      evictions_ += that.evictions_;
+    }
+  };
+
+  /**
+   ** \param slotCount number of cached lookups, rounded up to a power of 2. 0 disables the cache
+   ** \param minBucketAccesses minimum number of bucket accesses for a lookup to be cached
+   **/
+  HotSeedCache(std::size_t slotCount, unsigned minBucketAccesses);
+  bool isEnabled() const { return !slots_.empty(); }
+  /**
+   ** \brief replay the cached outcome of the lookup of the hash, if any
+   **
+   ** On success, hits is replaced with the cached records and the cached interval,
+   ** if any, is appended to extendTableIntervals, exactly as Hashtable::getHits would.
+   **/
+  bool get(
+      uint64_t                          hash,
+      bool                              isExtended,
+      std::vector<HashRecord>&          hits,
+      std::vector<ExtendTableInterval>& extendTableIntervals);
+  /**
+   ** \brief store the outcome of the lookup of the hash, if it is worth it
+   **
+   ** \param bucketAccesses number of buckets accessed by the lookup
+   ** \param interval the interval produced by the lookup. nullptr if none
+   **/
+  void put(
+      uint64_t                       hash,
+      bool                           isExtended,
+      unsigned                       bucketAccesses,
+      const std::vector<HashRecord>& hits,
+      const ExtendTableInterval*     interval);
+  const Statistics& getStatistics() const { return statistics_; }
+
+private:
+  struct Slot {
+    uint64_t                           hash_       = 0;
+    bool                               valid_      = false;
+    bool                               isExtended_ = false;
+    uint8_t                            hitCount_   = 0;
+    std::optional<ExtendTableInterval> interval_;
+    std::array<HashRecord, MAX_HITS>   hits_;
+  };
+  const unsigned    minBucketAccesses_;
+  std::vector<Slot> slots_;
+  uint64_t          slotMask_;
+  Statistics        statistics_;
+
+  Slot& getSlot(uint64_t hash, bool isExtended);
+};
+
+std::ostream& operator<<(std::ostream& os, const HotSeedCache::Statistics& statistics);
+
+}  // namespace map
+}  // namespace dragenos
+
+#endif  // #ifndef MAP_HOT_SEED_CACHE_HPP
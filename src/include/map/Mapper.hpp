@@ -21,10 +21,12 @@
 #include <boost/format.hpp>
 
 #include "BestIntervalTracker.hpp"
+#include "HotSeedCache.hpp"
 #include "common/Exceptions.hpp"
 #include "reference/HashRecord.hpp"
 #include "reference/Hashtable.hpp"
 #include "sequences/Read.hpp"
+#include "sequences/SeedEncoder.hpp"
 
 namespace dragenos {
 namespace map {
@@ -44,11 +46,19 @@ public:
   static constexpr unsigned              MAX_EXTENSION_STEP = 12;
   static constexpr unsigned EXTENSION_ID_BIN_SHIFT = HashRecord::EXTENSION_ID_BITS + 2 * MAX_EXTENSION_STEP;
   static constexpr unsigned MAX_HIFREQ_HITS        = 16;
+  /// minimum number of sparse seeds hitting the reference for getSparsePositionChain to succeed
+  static constexpr unsigned MIN_SPARSE_SEED_HITS = 3;
 
-  explicit Mapper(const Hashtable* hashtable)
+  /**
+   ** \param hotSeedCacheSize number of hashtable lookups memoized by the hot seed cache. 0 disables it
+   ** \param hotSeedCacheMinBuckets minimum number of bucket accesses for a lookup to be memoized
+   **/
+  explicit Mapper(
+      const Hashtable* hashtable, std::size_t hotSeedCacheSize = 0, unsigned hotSeedCacheMinBuckets = 2)
     : hashtable_(hashtable),
       extensionIdBinMask_(generateExtensionIdBinMask(hashtable)),
-      addressSegmentMask_(generateAddressSegmentMask(hashtable))
+      addressSegmentMask_(generateAddressSegmentMask(hashtable)),
+      hotSeedCache_(hotSeedCacheSize, hotSeedCacheMinBuckets)
   {
   }
   /**
@@ -65,6 +75,16 @@ public:
    **
    **/
   void getPositionChains(const Read& read, ChainBuilder& chainBuilder) const;
+  /**
+   ** \brief fast path for the reads coming from a unique region of the reference
+   **
+   ** Looks up only the non-overlapping primary seeds of the read. Succeeds, with a single
+   ** seed chain in the chain builder, when none of these seeds is repetitive, at least
+   ** MIN_SPARSE_SEED_HITS of them hit the reference and all the hits go to the same chain.
+   ** Otherwise the chain builder is left empty and the client code is expected to fall
+   ** back to getPositionChains.
+   **/
+  bool getSparsePositionChain(const Read& read, ChainBuilder& chainBuilder) const;
   /**
    ** \brief find all the relevant hash records for a given seed and add them to the
    ** position chains
@@ -75,9 +95,14 @@ public:
    ** associated hashtable to retrieve the relevant hash records. Finally, it will handle
    ** appropriately the different types of records and ultimately dispatch all the hit
    ** records to the chain builder.
+   **
+   ** \param seedIsReverseComplement true if the primary data of the seed is its reverse complement
+   ** \param hash the primary hash of the seed
    **/
   void addToPositionChains(
       const Seed&                       seed,
+      bool                              seedIsReverseComplement,
+      uint64_t                          hash,
       ChainBuilder&                     chainBuilder,
       std::vector<BestIntervalTracker>& globalBestIntvls,
       uint32_t&                         intvl_non_sample_longest,
@@ -132,6 +157,7 @@ public:
     return (hash & extensionIdBinMask_) << EXTENSION_ID_BIN_SHIFT;
   }
   const Hashtable* getHashtable() const { return hashtable_; }
+  const HotSeedCache::Statistics& getHotSeedCacheStatistics() const { return hotSeedCache_.getStatistics(); }
   /**
    ** \brief output the seed chains without mapping
    **
@@ -194,6 +220,24 @@ private:
   /// local vectors used in addToPositionChains, member variables for malloc optimization
   mutable std::vector<HashRecord>          hashRecords_;
   mutable std::vector<ExtendTableInterval> extendTableIntervals_;
+  mutable std::vector<ExtendTableRecord>   sampledExtendHashRecords_;
+  /// local vectors used in getPositionChains and getRandomSamplesFromMatchInterval
+  mutable std::vector<BestIntervalTracker> globalBestIntvls_;
+  mutable std::vector<uint32_t>            alreadyFetchedIntvlPos_;
+  /// seed offsets for reads of length seedOffsetsReadLength_ (none for empty reads)
+  mutable std::vector<size_t> seedOffsets_;
+  mutable std::size_t         seedOffsetsReadLength_ = 0;
+  /// subset of the seed offsets used in getSparsePositionChain
+  mutable std::vector<size_t> sparseSeedOffsets_;
+  /// primary data and hashes of all the seeds of the read in getPositionChains
+  mutable sequences::SeedEncoder seedEncoder_;
+  /// outcome of the recent lookups of repetitive seeds
+  mutable HotSeedCache hotSeedCache_;
+
+  /// seed offsets for reads of the given length, computed only when the length changes
+  const std::vector<size_t>& getSeedOffsets(unsigned readLength) const;
+  /// Hashtable::getHits into hashRecords_ and extendTableIntervals_, through the hot seed cache
+  void getHits(uint64_t hash, bool isExtended) const;
 };
 
 }  // namespace map
@@ -18,7 +18,8 @@
 #include <boost/io/ios_state.hpp>
 #include <iomanip>
 #include <limits>
-#include <map>
+#include <utility>
+#include <vector>
 
 #include "map/SeedPosition.hpp"
 
@@ -116,7 +117,14 @@ public:
    ** - Reverse chain: reference position of the seed minus (read length - seed length - seed read position -
    *1)
    **/
-  uint32_t getDiagonal(const Seed& seed, const uint32_t referencePosition) const;
+  uint32_t getDiagonal(const Seed& seed, const uint32_t referencePosition) const
+  {
+    return getDiagonal(seed, referencePosition, reverseComplement_);
+  }
+  static uint32_t getDiagonal(const Seed& seed, const uint32_t referencePosition, const bool reverseComplement)
+  {
+    return referencePosition + (reverseComplement ? seed.getReadPosition() : -seed.getReadPosition());
+  }
   uint32_t getDiagonal(const SeedPosition& seedPosition) const
   {
     return getDiagonal(seedPosition.getSeed(), seedPosition.getReferencePosition());
@@ -199,6 +207,9 @@ public:
               << chain.getReadCovLength();
   }
 
+  /// diagonal of the first seed added to the chain
+  uint32_t getInitialDiagonal() const { return initialDiagonal_; }
+
   bool isPerfect() const { return perfectAlignment_; }
   void setPerfect(bool perfect) { perfectAlignment_ = perfect; }
 
@@ -215,9 +226,10 @@ private:
   /// true if the seed chain is Reverse-Complement
   bool reverseComplement_;
   /// false if there is at least one non-random-sample in the chain
-  bool                         randomSamplesOnly_;
-  std::vector<SeedPosition>    seedPositions_;
-  std::map<uint32_t, uint32_t> diagonalTable_;  // k:diagonal v:lastSeedOffset
+  bool                      randomSamplesOnly_;
+  std::vector<SeedPosition> seedPositions_;
+  /// (diagonal, lastSeedOffset) sorted by diagonal. Only a handful of entries, kept across clear()
+  std::vector<std::pair<uint32_t, uint32_t>> diagonalTable_;
 
   uint32_t initialDiagonal_  = 0;
   bool     perfectAlignment_ = true;
@@ -19,6 +19,7 @@
 #include <boost/regex.hpp>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "common/Program.hpp"
 #include "common/hash_generation/gen_hash_table.h"
@@ -28,22 +29,41 @@ namespace options {
 
 class DragenOsOptions : public common::Options {
 public:
-  DragenOsOptions();
+  /**
+   ** \param inputRequired false when the reads are not given on the command line, as for the
+   **        embedded aligner (see api/Reference.hpp)
+   **/
+  explicit DragenOsOptions(bool inputRequired = true);
 
 private:
+  bool        inputRequired_;
   std::string usagePrefix() const { return "dragenos -r <reference> -b <base calls> [optional arguments]"; }
   void        postProcess(boost::program_options::variables_map& vm);
   void        SetBuildHashTableOptions(hashTableConfig_t* config, HashTableType hashTableType);
 
 public:
-  std::string             description_;
-  boost::filesystem::path refDir_;
-  bool                    mmapReference_ = false;
-  bool                    loadReference_ = false;
-  std::string             inputFile1_;
-  std::string             inputFile2_;
-  std::string             outputDirectory_  = "";
-  std::string             outputFilePrefix_ = "";
+  std::string              description_;
+  boost::filesystem::path  refDir_;
+  bool                     mmapReference_ = false;
+  bool                     mmapFastq_     = false;
+  bool                     loadReference_ = false;
+  bool                     packReference_ = false;
+  boost::filesystem::path  htCacheDirectory_;
+  unsigned                 refWarmupThreads_  = 0;
+  double                   refWarmupFraction_ = 1.0;
+  /// file names or glob patterns of the lanes, or the BAM file
+  std::vector<std::string> inputFiles1_;
+  std::vector<std::string> inputFiles2_;
+  std::string              fastqList_;
+  bool                     fastqListAllSamples_ = false;
+  std::string              outputDirectory_  = "";
+  std::string              outputFilePrefix_ = "";
+  /// seconds between the checkpoints of the alignment progress, 0 for none
+  unsigned                 checkpointInterval_ = 0;
+  bool                     resume_             = false;
+  std::string              daemonSocket_;
+  std::string              submitSocket_;
+  bool                     daemonShutdown_ = false;
 
   std::string rgid_ = "1";
   std::string rgsm_ = "none";
@@ -71,7 +91,17 @@ public:
   bool     peStatsContinuousUpdate_ = false;   // pe-stats-continuous-update
   bool     peStatsUpdateLogOnly_    = false;   // pe-stats-update-log-only
 
-  double mapperFilterLenRatio_ = 4.0;  // Mapper.filter-len-ratio
+  double   mapperFilterLenRatio_         = 4.0;    // Mapper.filter-len-ratio
+  uint64_t mapperHotSeedCacheSize_       = 0;      // Mapper.hot-seed-cache-size
+  unsigned mapperHotSeedCacheMinBuckets_ = 2;      // Mapper.hot-seed-cache-min-buckets
+  bool     mapperSparseSeeding_          = false;  // Mapper.sparse-seeding
+
+  std::string mapperTargetBed_;            // Mapper.target-bed
+  unsigned    mapperTargetPadding_ = 150;  // Mapper.target-padding
+
+  std::string methylationProtocol_ = "none";  // methylation-protocol
+  /// true for the alignment of bisulfite converted reads against the methylated hashtable
+  bool isMethylated() const { return "none" != methylationProtocol_; }
 
   uint32_t alignerPeOrientation_    = 0;    // Aligner.pe-orientation
   double   alignerResqueSigmas_     = 0;    //2.5;     // Aligner.rescue-sigmas
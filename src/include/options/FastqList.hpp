@@ -0,0 +1,80 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef OPTIONS_FASTQ_LIST_HPP
+#define OPTIONS_FASTQ_LIST_HPP
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace dragenos {
+namespace options {
+
+/**
+ ** \brief One read group of a FASTQ list: the inputs and the @RG fields of their records
+ **/
+struct FastqListEntry {
+  std::string readGroupId_;
+  std::string readGroupSample_  = "none";
+  std::string readGroupLibrary_ = "LB0";
+  unsigned    lane_             = 1;
+  std::string read1File_;
+  /// empty for single-ended reads
+  std::string read2File_;
+};
+
+/**
+ ** \brief parses a FASTQ list in the DRAGEN CSV format
+ **
+ ** The first line names the columns, in any order: RGID and Read1File are required,
+ ** RGSM, RGLB, Lane and Read2File are optional. Other columns are ignored. Relative
+ ** file names are relative to the given directory.
+ **/
+std::vector<FastqListEntry> parseFastqList(std::istream& is, const boost::filesystem::path& directory);
+
+/// parses the FASTQ list file, with the file names relative to its directory
+std::vector<FastqListEntry> loadFastqList(const boost::filesystem::path& path);
+
+/**
+ ** \brief position of the read group of each of the given entries of the list in the distinct read groups of
+ **        these entries, in the order of their first entry: the position of its @RG line in the SAM header
+ **/
+std::vector<std::size_t> getReadGroupPositions(
+    const std::vector<FastqListEntry>& fastqList, const std::vector<std::size_t>& indexes);
+
+/// file names matching the glob pattern, in sorted order. Names without wildcard are returned unchanged
+std::vector<std::string> expandFileNames(const std::string& pattern);
+
+/**
+ ** \brief read groups of the lanes given on the command line
+ **
+ ** The file names can be glob patterns. With several lanes, the lane number comes from the
+ ** "_L<number>_" of the Illumina file names, or from the position of the file when these are
+ ** missing or repeated, and the read group ID of each lane is "<rgid>.<lane>".
+ **
+ ** \param read2Files empty for single-ended reads, or one file for each file of read1Files
+ **/
+std::vector<FastqListEntry> makeLaneList(
+    const std::string&              rgid,
+    const std::string&              rgsm,
+    const std::vector<std::string>& read1Files,
+    const std::vector<std::string>& read2Files);
+
+}  // namespace options
+}  // namespace dragenos
+
+#endif  // #ifndef OPTIONS_FASTQ_LIST_HPP
@@ -0,0 +1,55 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef REFERENCE_BUCKET_MASKS_HPP
+#define REFERENCE_BUCKET_MASKS_HPP
+
+#include <cstdint>
+
+#include "reference/Bucket.hpp"
+#include "reference/HashRecord.hpp"
+
+namespace dragenos {
+namespace reference {
+
+/**
+ ** \brief Classification of all the hash records of a bucket, stored as bitmasks
+ **
+ ** Bit i of each mask describes the hash record i of the bucket. The record types
+ ** and the thread Id and match bits comparisons are computed for the 8 records at
+ ** once, with AVX2 when available, so that the bucket scans in the Hashtable only
+ ** have to walk the relevant bits.
+ **/
+struct BucketMasks {
+  /// HIT, HIFREQ, EXTEND and INTERVAL_* records (the records that have a thread Id and match bits)
+  uint32_t data_;
+  /// data records with the thread Id of the query
+  uint32_t thread_;
+  /// thread records with the match bits of the query
+  uint32_t match_;
+  /// records with the "Last in thread" flag set, regardless of their type
+  uint32_t lastInThread_;
+  uint32_t chainBegin_;
+  uint32_t chainCon_;
+  uint32_t empty_;
+  /// REPAIR records and unknown types
+  uint32_t invalid_;
+
+  BucketMasks(const Bucket& bucket, uint64_t matchBits, uint8_t threadId);
+};
+
+}  // namespace reference
+}  // namespace dragenos
+
+#endif  // #ifndef REFERENCE_BUCKET_MASKS_HPP
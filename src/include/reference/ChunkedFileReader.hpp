@@ -0,0 +1,73 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef REFERENCE_CHUNKED_FILE_READER_HPP
+#define REFERENCE_CHUNKED_FILE_READER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+namespace dragenos {
+namespace reference {
+
+/**
+ ** \brief Read of a whole file into memory, in chunks, on a separate thread
+ **
+ ** The beginning of the buffer can be used as soon as waitBytes returns. On read
+ ** errors, the rest of the buffer is filled with zeros to release the waiting
+ ** consumers, and the error is thrown by finish.
+ **
+ ** The whole buffer is allocated upfront: the overlap of the read with its use saves
+ ** time, not memory.
+ **/
+class ChunkedFileReader {
+public:
+  static constexpr uint64_t CHUNK_BYTES = 64 * 1024 * 1024;
+
+  explicit ChunkedFileReader(const boost::filesystem::path& path, uint64_t chunkBytes = CHUNK_BYTES);
+  ~ChunkedFileReader();
+  ChunkedFileReader(const ChunkedFileReader&) = delete;
+  ChunkedFileReader& operator=(const ChunkedFileReader&) = delete;
+
+  uint8_t* data() { return data_.get(); }
+  uint64_t size() const { return size_; }
+  /// block until the first bytes of the file are available - usable as a decompWaitBytes_t
+  static void waitBytes(void* reader, uint64_t bytes);
+  /// wait for the end of the read and throw if it failed
+  void finish();
+
+private:
+  const boost::filesystem::path path_;
+  const uint64_t                chunkBytes_;
+  const uint64_t                size_;
+  std::unique_ptr<uint8_t[]>    data_;
+  std::mutex                    mutex_;
+  std::condition_variable       availableChanged_;
+  uint64_t                      available_ = 0;
+  std::string                   error_;
+  std::thread                   thread_;
+
+  void read();
+};
+
+}  // namespace reference
+}  // namespace dragenos
+
+#endif  // #ifndef REFERENCE_CHUNKED_FILE_READER_HPP
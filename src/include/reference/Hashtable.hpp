@@ -22,6 +22,7 @@
 
 #include "common/Bits.hpp"
 #include "reference/Bucket.hpp"
+#include "reference/BucketMasks.hpp"
 #include "reference/ExtendTableInterval.hpp"
 #include "reference/ExtendTableRecord.hpp"
 #include "reference/HashRecord.hpp"
@@ -95,20 +96,37 @@ public:
   bool     followChain(const HashRecord& rec, const Hash hash) const;
 
   /**
-   ** \brief process bucket
+   ** \brief the three ways of scanning a bucket for the records of a hash
    **
-   ** This is the processing of the initial bucket, before any probing or chaining.
-   ** CHAIN_CON and subsequent records must be ignored
-   ** A CHAIN_BEG record indicate chaining and is pushed as the last element of hits.
+   ** INITIAL_BUCKET: processing of the initial bucket, before any probing or chaining.
+   ** CHAIN_CON and subsequent records must be ignored. A CHAIN_BEG record indicates chaining
+   ** and is pushed as the last element of hits. Returns the "Last in thread" status.
+   **
+   ** PROBE_BUCKET: probe a single bucket from the probing neighborhood. Returns true if a
+   ** relevant record with LF was found.
+   **
+   ** CHAIN_BUCKET: look for additional records in the specified chained bucket. Only records
+   ** after a CHAIN_CON_* record are taken into consideration. Completion of the chaining is
+   ** detected either when the "Last in thread" flag as usual, or when the MASK or FILTER of the
+   ** CHAIN_CON_* record returns 0 for the specified hash key. When the mask or filter returns
+   ** true, it means that the chain must continue to another bucket, identified by the chain
+   ** pointer in the CHAIN_CON_* record. In that case, the CHAIN_CON_* record is stored as the
+   ** last element of the hits vector. Returns true if the chaining is complete.
    **/
-  bool processInitialBucket(
-      const Bucket&                     bucket,
-      const Hash&                       hash,
-      const uint64_t                    matchBits,
-      const uint8_t                     hashThreadId,
-      std::vector<HashRecord>&          hits,
-      std::vector<ExtendTableInterval>& extenTableIntervals,
-      bool                              trace) const;
+  enum BucketScan { INITIAL_BUCKET, PROBE_BUCKET, CHAIN_BUCKET };
+  /**
+   ** \brief append to hits the records matching the hash in the bucket
+   **
+   ** All the records of the bucket are classified at once with BucketMasks and the scan
+   ** only walks the relevant bits.
+   **/
+  template <BucketScan SCAN>
+  bool scanBucket(
+      const Bucket&            bucket,
+      const Hash&              hash,
+      const uint64_t           matchBits,
+      const uint8_t            hashThreadId,
+      std::vector<HashRecord>& hits) const;
   /**
    ** \brief when the initial bucket overflows, the default strategy is to store excess hits in the neighbor
    *buckets
@@ -122,46 +140,14 @@ public:
    ** of bits from the secondary CRC).
    **
    ** \param bucketIndex the index of the initial bucket
+   ** \return the number of neighbor buckets accessed
    **/
-  void probeNeighborBuckets(
-      const uint64_t                    initialBucketIndex,
-      const uint64_t                    matchBits,
-      const uint8_t                     hashThreadId,
-      std::vector<HashRecord>&          hits,
-      std::vector<ExtendTableInterval>& extenTableIntervals,
-      bool                              trace) const;
-  /**
-   ** \brief probe a single bucket from the probing neighborhood
-   **
-   ** return true if a relevant record with LF was found. Otherwise returns false.
-   **/
-  bool probeBucket(
-      const Bucket&                     bucket,
-      const uint64_t                    matchBits,
-      const uint8_t                     hashThreadId,
-      std::vector<HashRecord>&          hits,
-      std::vector<ExtendTableInterval>& extenTableIntervals,
-      bool                              trace) const;
-  /**
-   ** \brief look for additional in the specified chained bucket
-   **
-   ** Only records after a CHAIN_CON_* record are taken into consideration.
-   ** Completion of the chaining is detected either when the "Last in thread" flag as usual, or when the
-   ** MASK or FILTER of the CHAIN_CON_* record returns 0 for the specified hash key. When the mask or filter
-   ** returns true, it means that the chain must continue to another bucket, identified by the chain pointer
-   ** in the CHAIN_CON_* record. In that case, the CHAIN_CON_* record is stored as the last element of the
-   ** hits vector.
-   **
-   ** \return true if the chaining is complete (either "Last in thread" or "Last in chain" detected
-   **/
-  bool chainBucket(
-      const Bucket&                     bucket,
-      const Hash&                       hash,
-      const uint64_t                    matchBits,
-      const uint8_t                     hashThreadId,
-      std::vector<HashRecord>&          hits,
-      std::vector<ExtendTableInterval>& extenTableIntervals,
-      bool                              trace) const;
+  unsigned probeNeighborBuckets(
+      const uint64_t           initialBucketIndex,
+      const Hash&              hash,
+      const uint64_t           matchBits,
+      const uint8_t            hashThreadId,
+      std::vector<HashRecord>& hits) const;
   /**
    ** \brief find all relevant HIT and EXTEND records for the given hash key.
    **
@@ -187,13 +173,14 @@ public:
    ** CHAIN_BEG_MASK or CHAIN_BEG_LIST record in the initial bucket that matches the query
    ** hash key. Probing is triggered when reaching the end of a bucket without finding any
    ** relevant record with the "Last in thread" flag set and without chaining.
+   **
+   ** \return the number of buckets accessed, including the initial bucket
    **/
-  void getHits(
+  unsigned getHits(
       const Hash&                       hash,
       bool                              isExtended,
       std::vector<HashRecord>&          hits,
-      std::vector<ExtendTableInterval>& extenTableIntervals,
-      bool                              trace = false) const;
+      std::vector<ExtendTableInterval>& extenTableIntervals) const;
   /**
    ** \brief calculate the thread Id of a hash value, for correct matching of the hash records from the
    *hashtable.
@@ -224,6 +224,14 @@ public:
   uint32_t getExtendTableBytes() const { return getExtendTableRecordCount() * 8; }
   uint32_t getMinimunFrequencyToExtend() const { return header_.minFreqToExtend; }
   uint32_t getMaxSeedFrequency() const { return header_.maxSeedFreq; }
+  /// digest of the reference, ref_index and hashtables
+  uint32_t getDigest() const { return header_.digest; }
+  /// algorithm used for all the digests (see DigestType)
+  uint32_t getDigestType() const { return header_.digestType; }
+  /// digest of hash_table.bin
+  uint32_t getHashtableDigest() const { return header_.hashDigest; }
+  /// digest of extend_table.bin
+  uint32_t getExtendTableDigest() const { return header_.extTabDigest; }
   /// total number of bases in the reference sequence file - including padding
   uint64_t                     getReferenceSequenceLength() const { return header_.refSeqLen; }
   unsigned long                getReferenceLength() const;
@@ -0,0 +1,114 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef REFERENCE_PACKED_REFERENCE_HPP
+#define REFERENCE_PACKED_REFERENCE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dragenos {
+namespace reference {
+
+/**
+ ** \brief In-memory copy of "reference.bin" at 2 bits per base
+ **
+ ** A, C, G and T are stored as 2 bits codes (0, 1, 2 and 3), 32 bases per 64 bits
+ ** word, first base in the 2 LSB. Anything else (padding, N and the other IUPAC
+ ** codes) is stored as a list of runs of identical 4 bits values, sorted by
+ ** position, which is short because these bases come in long stretches.
+ **
+ ** The bases are extracted in the same 4 bits encoding as ReferenceSequence (see
+ ** ReferenceSequence.hpp), one base per byte, directly into buffers owned by the
+ ** caller. With AVX2, 32 bases are decoded at once.
+ **
+ ** This halves the memory footprint of the reference and the cache traffic of the
+ ** window extractions, at the cost of a lookup into the exception runs for each
+ ** window.
+ **/
+class PackedReference {
+public:
+  /**
+   ** \param data reference sequence encoded as 2 bases per byte, as in reference.bin
+   ** \param size number of bytes of data
+   **/
+  PackedReference(const unsigned char* data, std::size_t size);
+  PackedReference(const PackedReference&) = delete;
+  PackedReference& operator=(const PackedReference&) = delete;
+
+  /// number of bases, including padding
+  std::size_t getLength() const { return length_; }
+  /// number of runs of bases other than A, C, G or T
+  std::size_t getExceptionCount() const { return exceptions_.size(); }
+  /// memory used by the packed bases and the exceptions
+  std::size_t getMemoryBytes() const
+  {
+    return bases_.size() * sizeof(bases_[0]) + exceptions_.size() * sizeof(exceptions_[0]);
+  }
+
+  /// 4 bits encoding of the base at the given position
+  unsigned char getBase(const std::size_t position) const
+  {
+    const auto exception = findException(position);
+    if ((exceptions_.end() != exception) && (position >= exception->begin_)) {
+      return exception->base_;
+    }
+    return 1 << ((bases_[position / BASES_PER_WORD] >> (2 * (position % BASES_PER_WORD))) & 3);
+  }
+  /// 4 bits encoding of the bases in [beginPosition, endPosition), one base per byte, into out
+  void getBases(std::size_t beginPosition, std::size_t endPosition, unsigned char* out) const;
+  /// same as getBases for the complement of the bases (not reversed)
+  void getRcBases(std::size_t beginPosition, std::size_t endPosition, unsigned char* out) const;
+
+private:
+  static constexpr unsigned BASES_PER_WORD = 32;
+
+  /// [begin_, end_) positions with the same 4 bits value, other than A, C, G or T
+  struct Exception {
+    uint64_t      begin_;
+    uint64_t      end_;
+    unsigned char base_;
+  };
+
+  std::size_t length_;
+  /// 2 bits codes, with an additional word of 0 to read 32 bases from any position
+  std::vector<uint64_t>  bases_;
+  std::vector<Exception> exceptions_;
+
+  void addException(uint64_t position, unsigned char base);
+  /// first exception ending after the position
+  std::vector<Exception>::const_iterator findException(const std::size_t position) const
+  {
+    return std::upper_bound(
+        exceptions_.begin(), exceptions_.end(), position, [](const std::size_t p, const Exception& e) {
+          return p < e.end_;
+        });
+  }
+  /// 32 consecutive 2 bits codes starting at the given position
+  uint64_t getCodes(std::size_t position) const
+  {
+    const std::size_t word  = position / BASES_PER_WORD;
+    const unsigned    shift = 2 * (position % BASES_PER_WORD);
+    return shift ? ((bases_[word] >> shift) | (bases_[word + 1] << (64 - shift))) : bases_[word];
+  }
+  template <bool complement>
+  void extract(std::size_t beginPosition, std::size_t endPosition, unsigned char* out) const;
+};
+
+}  // namespace reference
+}  // namespace dragenos
+
+#endif  // #ifndef REFERENCE_PACKED_REFERENCE_HPP
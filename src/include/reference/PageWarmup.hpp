@@ -0,0 +1,80 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef REFERENCE_PAGE_WARMUP_HPP
+#define REFERENCE_PAGE_WARMUP_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace dragenos {
+namespace reference {
+
+/**
+ ** \brief Parallel page-in of memory mapped reference data
+ **
+ ** Random probes into a freshly mapped hashtable fault the pages in one at a time,
+ ** with the alignment threads blocked in the kernel. Instead, the warmup threads
+ ** take turns on fixed size chunks of the ranges, in order, and for each chunk
+ ** advise the kernel with MADV_WILLNEED before touching every page.
+ **
+ ** The warmup runs in the background from construction. wait() blocks until a
+ ** fraction of the bytes has been paged in, and the destructor stops the threads
+ ** without waiting for the remaining chunks.
+ **/
+class PageWarmup {
+public:
+  struct Range {
+    const void* data;
+    std::size_t size;
+  };
+  static constexpr std::size_t CHUNK_BYTES = 16 * 1024 * 1024;
+
+  PageWarmup(std::vector<Range> ranges, unsigned threadCount);
+  ~PageWarmup();
+  PageWarmup(const PageWarmup&) = delete;
+  PageWarmup& operator=(const PageWarmup&) = delete;
+
+  /// block until at least the given fraction of the bytes are paged in, reporting the progress every 10%
+  void wait(double fraction, std::ostream& progress);
+  std::size_t getTotalBytes() const { return totalBytes_; }
+  std::size_t getWarmBytes() const { return warmBytes_; }
+
+private:
+  struct Chunk {
+    const char* begin;
+    std::size_t size;
+  };
+  std::vector<Chunk>       chunks_;
+  std::size_t              totalBytes_;
+  std::atomic<std::size_t> nextChunk_;
+  std::atomic<std::size_t> warmBytes_;
+  std::atomic<bool>        stop_;
+  std::mutex               mutex_;
+  std::condition_variable  progressed_;
+  std::vector<std::thread> threads_;
+
+  void run();
+};
+
+}  // namespace reference
+}  // namespace dragenos
+
+#endif  // #ifndef REFERENCE_PAGE_WARMUP_HPP
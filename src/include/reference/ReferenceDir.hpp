@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "reference/HashtableConfig.hpp"
+#include "reference/PageWarmup.hpp"
 #include "reference/ReferenceSequence.hpp"
 
 namespace dragenos {
@@ -37,7 +38,17 @@ public:
 
 class ReferenceDir7 : public ReferenceDir {
 public:
-  ReferenceDir7(const boost::filesystem::path& path, bool mmap, bool load);
+  /**
+   ** \param pack2Bit keep the reference bases at 2 bits per base (see PackedReference)
+   ** \param cacheDirectory when not empty and neither mmap nor load are set, local directory where the
+   ** decompressed hashtable is stored on first use and memory mapped afterwards
+   **/
+  ReferenceDir7(
+      const boost::filesystem::path& path,
+      bool                           mmap,
+      bool                           load,
+      bool                           pack2Bit       = false,
+      const boost::filesystem::path& cacheDirectory = boost::filesystem::path());
   ~ReferenceDir7();
   virtual const reference::HashtableConfig& getHashtableConfig() const { return hashtableConfig_; };
   virtual const uint64_t*                   getHashtableData() const { return hashtableData_.get(); }
@@ -45,6 +56,8 @@ public:
   virtual const ReferenceSequence&          getReferenceSequence() const { return *referenceSequencePtr_; }
   size_t                                    getHashtableConfigSize() const;
   size_t                                    getHashtableDataSize() const;
+  /// hashtable, extend table and reference data when they are memory mapped, empty otherwise
+  std::vector<PageWarmup::Range> getMappedRanges() const;
 
 protected:
   static constexpr auto         hashtableConfigBin = "hash_table.cfg.bin";
@@ -79,15 +92,27 @@ protected:
   std::vector<char> getHashtableConfigData() const;
   template <typename T>
   std::unique_ptr<T, std::function<void(T*)>> mmapData(
-      std::string binFile, size_t expectedBinFileBytes) const;
+      const boost::filesystem::path& dataFile, size_t expectedBinFileBytes) const;
   template <typename T>
   std::unique_ptr<T, std::function<void(T*)>> readData(
       const std::string binFile, const size_t expectedBinFileBytes) const;
   typedef std::unique_ptr<unsigned char, std::function<void(unsigned char*)>> UcharPtr;
   UcharPtr                                                                    referenceData_;
+  std::unique_ptr<PackedReference>                                            packedReference_;
   std::unique_ptr<ReferenceSequence>                                          referenceSequencePtr_;
+  /// the tables are memory mapped from files, as opposed to loaded or decompressed
+  bool memoryMapped_ = false;
 
   UcharPtr ReadFileIntoBuffer(const boost::filesystem::path& directory, std::streamsize& size);
+  /// load reference.bin and decompress hash_table.cmp into hashtableData_ and extendTableData_, with the
+  /// digests of the decompressed tables when the pointers are not null
+  void decompressHashtable(uint32_t* hashtableDigest = nullptr, uint32_t* extendTableDigest = nullptr);
+  /// memory map the hashtable from the cache, after decompressing it into the cache if needed
+  void loadCachedHashtable(const boost::filesystem::path& cacheDirectory);
+  /// write the decompressed tables as a new entry of the cache
+  void writeCacheEntry(const boost::filesystem::path& entry) const;
+  /// zero-initialized memory, on transparent huge pages when available
+  Uint64Ptr allocateHugePages(size_t bytes) const;
 };
 
 }  // namespace reference
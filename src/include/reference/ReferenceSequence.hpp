@@ -25,6 +25,7 @@
 #endif
 
 #include "common/Exceptions.hpp"
+#include "reference/PackedReference.hpp"
 
 namespace dragenos {
 namespace reference {
@@ -64,6 +65,10 @@ namespace reference {
  ** Converting a hashtable position (or offset in the "reference.bin" file) back
  ** to a position in the original FASTA reference require to take into account
  ** the padding (regions of 0x00 added into "reference.bin") and trimming.
+ **
+ ** Alternatively, the bases can be provided as a PackedReference, at 2 bits per
+ ** base. The interface is the same in both cases, except for getData() which is
+ ** only available for the 4 bits encoding.
  **/
 class ReferenceSequence {
 public:
@@ -94,21 +99,54 @@ public:
   {
   }
 
+  /**
+   ** \brief Constructor for bases packed at 2 bits per base
+   **
+   ** Requires the packed reference to stay valid for the lifetime of the
+   ** ReferenceSequence instance and all its copies.
+   **/
+  ReferenceSequence(std::vector<Region> trimmedRegions, const PackedReference* packed)
+    : trimmedRegions_(std::move(trimmedRegions)), data_(nullptr), size_(packed->getLength() / 2), packed_(packed)
+  {
+  }
+
   void reset(std::vector<Region> trimmedRegions, const unsigned char* data, const size_t size)
   {
     trimmedRegions_ = std::move(trimmedRegions);
     data_           = data;
     size_           = size;
+    packed_         = nullptr;
+  }
+
+  /// Container is a vector of unsigned char, possibly with a custom allocator
+  template <typename Container>
+  void getBases(size_t beginPosition, size_t endPosition, Container& out) const
+  {
+    out.clear();
+    out.resize(endPosition - beginPosition);
+    extractBases(beginPosition, endPosition, out.data());
   }
 
-  void getBases(size_t beginPosition, size_t endPosition, std::vector<unsigned char>& out) const
+  /// Container is a vector of unsigned char, possibly with a custom allocator
+  template <typename Container>
+  void getRcBases(size_t beginPosition, size_t endPosition, Container& out) const
+  {
+    out.clear();
+    out.resize(endPosition - beginPosition);
+    extractRcBases(beginPosition, endPosition, out.data());
+  }
+
+  /// 4 bits encoding of the bases in [beginPosition, endPosition) into out, one base per byte
+  void extractBases(size_t beginPosition, size_t endPosition, unsigned char* out) const
   {
     checkPosition(endPosition);
+    if (nullptr != packed_) {
+      packed_->getBases(beginPosition, endPosition, out);
+      return;
+    }
 
     size_t len = endPosition - beginPosition;
     size_t pos = 0;
-    out.clear();
-    out.resize(len);
 
     // handle even position index
     if (beginPosition % 2 == 1) {
@@ -118,7 +156,7 @@ public:
 
 #ifdef __AVX2__
     constexpr int  ELEMS_AVX2 = 32;
-    unsigned char* dst        = out.data();
+    unsigned char* dst        = out;
     __m128i        mask       = _mm_set1_epi8(0x0F);
 
     for (; pos + ELEMS_AVX2 <= len; pos += ELEMS_AVX2) {
@@ -142,13 +180,16 @@ public:
     }
   }
 
-  void getRcBases(size_t beginPosition, size_t endPosition, std::vector<unsigned char>& out) const
+  /// 4 bits encoding of the complement of the bases in [beginPosition, endPosition) into out (not reversed)
+  void extractRcBases(size_t beginPosition, size_t endPosition, unsigned char* out) const
   {
     checkPosition(endPosition);
+    if (nullptr != packed_) {
+      packed_->getRcBases(beginPosition, endPosition, out);
+      return;
+    }
 
     size_t len = endPosition - beginPosition;
-    out.clear();
-    out.resize(len);
     for (size_t pos = 0; pos < len; pos++) {
       const unsigned char base4bpb = getRcBaseNoCheck(pos + beginPosition);
       out[pos]                     = base4bpb;
@@ -199,8 +240,10 @@ public:
     return getRcBaseNoCheck(position);
   }
 
+  /// 4 bits encoded data. nullptr when the bases are packed at 2 bits per base
   const unsigned char* getData() const { return data_; }
   size_t               getSize() const { return size_; }
+  bool                 isPacked() const { return nullptr != packed_; }
   /// decode 4 bits into AIUPAC character using only 4 LSB
   static char decodeBase(unsigned char base);
   /// translate into 2 bits encoding using only 4 LSB
@@ -208,7 +251,7 @@ public:
   /// translate into 2 bits reverse complement encoding using only 4 LSB
   static unsigned char translateToR2bpb(unsigned char base4bpb);
 
-private:
+  /// throws if the position is beyond the end of the data
   void checkPosition(size_t position) const
   {
     if (position / 2 >= size_) {
@@ -218,8 +261,13 @@ private:
     }
   }
 
+private:
+
   inline unsigned char getBaseNoCheck(size_t position) const
   {
+    if (nullptr != packed_) {
+      return packed_->getBase(position);
+    }
     const unsigned char twoBases = data_[position / 2];
     const bool          msb      = (position % 2);  // use the 4 MSB for odd positions
     return msb ? (twoBases >> 4) : (twoBases & 0xF);
@@ -251,8 +299,10 @@ private:
   std::vector<Region> trimmedRegions_;
   /// raw data from reference.bin, encoded as 2 bases per byte
   const unsigned char* data_;
-  /// number of bytes available in data_
+  /// number of bytes available in data_, or half the number of packed bases
   size_t size_;
+  /// bases at 2 bits per base, instead of data_
+  const PackedReference* packed_ = nullptr;
 };
 
 }  // namespace reference
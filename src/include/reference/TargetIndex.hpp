@@ -0,0 +1,116 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef REFERENCE_TARGET_INDEX_HPP
+#define REFERENCE_TARGET_INDEX_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+#include "reference/HashtableConfig.hpp"
+#include "reference/ReferenceSequence.hpp"
+#include "sequences/Read.hpp"
+
+namespace dragenos {
+namespace reference {
+
+/**
+ ** \brief Compact index of the k-mers of the targeted regions of the reference
+ **
+ ** Built from the bases of the regions of a BED file, extended by a padding, this
+ ** is a few bytes per targeted base instead of the whole genome hashtable. It tells
+ ** whether a read can possibly come from the targets, before paying for the full
+ ** seeding and alignment of the read against the whole genome.
+ **
+ ** Each k-mer is stored in its canonical form (the smallest of the 2 bits encodings
+ ** of the k-mer and its reverse complement), scrambled by a bijective mix, sorted,
+ ** and found through a table of the first index of each prefix of the mixed values.
+ ** A lookup is then a couple of cache misses.
+ **
+ ** The k-mers of a read are sampled every half k-mer length, which leaves several
+ ** chances to find an exact match for a read from the targets with a few sequencing
+ ** errors.
+ **/
+class TargetIndex {
+public:
+  /// [begin, end) positions in reference.bin
+  typedef std::array<uint64_t, 2> Region;
+  static constexpr unsigned MAX_KMER_LENGTH = 32;
+
+  /**
+   ** \brief regions of a BED file, as sorted and merged positions in reference.bin
+   **
+   ** Each region is extended by padding bases on both sides, within the bases of its
+   ** sequence that are stored in reference.bin (without the trimmed Ns).
+   **
+   ** \throw common::InvalidParameterException for invalid lines or unknown sequence names
+   **/
+  static std::vector<Region> parseBed(std::istream& bed, const HashtableConfig& config, unsigned padding);
+
+  /**
+   ** \param regions sorted disjoint regions of the reference, as returned by parseBed
+   ** \param kmerLength length of the k-mers, at most MAX_KMER_LENGTH
+   **/
+  TargetIndex(std::vector<Region> regions, const ReferenceSequence& referenceSequence, unsigned kmerLength);
+
+  /// true if any of the sampled k-mers of the bases (4 bits encoding) is in the targets
+  bool isOnTarget(const sequences::Read::Bases& bases) const;
+
+  const std::vector<Region>& getRegions() const { return regions_; }
+  /// number of bases in the regions
+  uint64_t    getTargetLength() const;
+  unsigned    getKmerLength() const { return kmerLength_; }
+  std::size_t getKmerCount() const { return kmers_.size(); }
+  std::size_t getMemoryBytes() const
+  {
+    return kmers_.size() * sizeof(kmers_[0]) + prefixStarts_.size() * sizeof(prefixStarts_[0]);
+  }
+
+private:
+  const std::vector<Region> regions_;
+  const unsigned            kmerLength_;
+  /// bits of the mixed k-mers used to index prefixStarts_
+  unsigned prefixBits_;
+  /// mixed canonical k-mers of the targets, sorted and unique
+  std::vector<uint64_t> kmers_;
+  /// first index in kmers_ for each prefix, followed by kmers_.size()
+  std::vector<uint32_t> prefixStarts_;
+
+  /// bijective scrambling of the k-mers to spread them evenly over the prefixes
+  static uint64_t mix(uint64_t kmer)
+  {
+    kmer ^= kmer >> 33;
+    kmer *= 0xff51afd7ed558ccdull;
+    kmer ^= kmer >> 33;
+    kmer *= 0xc4ceb9fe1a85ec53ull;
+    kmer ^= kmer >> 33;
+    return kmer;
+  }
+  bool contains(uint64_t kmer) const;
+  /**
+   ** \brief calls op(canonical) for each k-mer of A, C, G and T only in bases, every step positions
+   **
+   ** The 4 bits encoded bases are the same for the reads and the reference.
+   **/
+  template <typename Op>
+  bool forEachKmer(const unsigned char* begin, const unsigned char* end, std::size_t step, Op op) const;
+};
+
+}  // namespace reference
+}  // namespace dragenos
+
+#endif  // #ifndef REFERENCE_TARGET_INDEX_HPP
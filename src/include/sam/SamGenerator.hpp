@@ -15,10 +15,21 @@
 #ifndef ALIGN_SAM_HPP
 #define ALIGN_SAM_HPP
 
+#include <algorithm>
+#include <array>
 #include <boost/range/adaptor/reversed.hpp>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
+#include "align/Cigar.hpp"
 #include "align/Mapq.hpp"
+#include "align/MethylationCaller.hpp"
 #include "reference/HashtableConfig.hpp"
 #include "sequences/Read.hpp"
 
@@ -28,9 +39,30 @@ namespace sam {
 class SamGenerator {
   static const char                 Q0_ = 33;
   const reference::HashtableConfig& hashtableConfig_;
+  /// adds the methylation tags to the mapped records when not null
+  const align::MethylationCaller* const methylationCaller_;
+  /// sequence names by offset in the hashtable config, as used for the RNAME, RNEXT and SA fields
+  std::vector<std::string> sequenceNames_;
+  std::size_t              maxSequenceNameLength_ = 0;
 
 public:
-  SamGenerator(const reference::HashtableConfig& hashtableConfig) : hashtableConfig_(hashtableConfig) {}
+  /**
+   ** \param methylationCaller for the methylated hashtables, which are output with the original sequence
+   **        names. Must stay valid for the lifetime of the SamGenerator
+   **/
+  SamGenerator(
+      const reference::HashtableConfig& hashtableConfig,
+      const align::MethylationCaller*   methylationCaller = nullptr)
+    : hashtableConfig_(hashtableConfig), methylationCaller_(methylationCaller)
+  {
+    for (std::size_t offset = 0; hashtableConfig.getSequences().size() > offset; ++offset) {
+      const std::string& name = hashtableConfig.getSequenceName(offset);
+      sequenceNames_.push_back(methylationCaller ? align::MethylationCaller::getOriginalName(name) : name);
+      maxSequenceNameLength_ = std::max(maxSequenceNameLength_, sequenceNames_.back().size());
+    }
+  }
+
+  const align::MethylationCaller* getMethylationCaller() const { return methylationCaller_; }
 
   template <typename ReadT>
   static std::string getReadName(const ReadT& read)
@@ -49,8 +81,7 @@ public:
     if (alignment.isUnmapped() && (!alignment.hasMultipleSegments() || alignment.isUnmappedNextSegment())) {
       os << "*\t0\t0\t*\t";
     } else {
-      os << (-1 == alignment.getReference() ? std::string("=")
-                                            : hashtableConfig_.getSequenceName(alignment.getReference()))
+      os << (-1 == alignment.getReference() ? std::string("=") : sequenceNames_.at(alignment.getReference()))
          << '\t' << alignment.getPosition() + 1 << '\t'
          << std::min<align::MapqType>(alignment.getMapq(), align::MAPQ_MAX) << '\t';
       if (alignment.getCigar().empty()) {
@@ -65,7 +96,7 @@ public:
     } else {
       os << (-1 == alignment.getNextReference() || alignment.getReference() == alignment.getNextReference()
                  ? std::string("=")
-                 : hashtableConfig_.getSequenceName(alignment.getNextReference()))
+                 : sequenceNames_.at(alignment.getNextReference()))
          << '\t' << alignment.getNextPosition() + 1 << '\t';
     }
     os << (alignment.isUnmapped() ? 0 : alignment.getTemplateLength()) << '\t';
@@ -87,14 +118,121 @@ public:
 
     if (alignment.getSa()) {
       const auto& sa = *alignment.getSa();
-      os << "\tSA:Z:" << hashtableConfig_.getSequenceName(sa.getReference()) << ',' << (sa.getPosition() + 1)
+      os << "\tSA:Z:" << sequenceNames_.at(sa.getReference()) << ',' << (sa.getPosition() + 1)
          << ',' << (sa.reverse() ? "-," : "+,") << sa.getCigar()
          << ','
          //         << std::min<MapqType>(sa.getMapq(), MAPQ_MAX) <<
          << std::min<align::MapqType>(sa.getMapq(), align::HW_MAPQ_MAX) << ',' << sa.getNm() << ';';
     }
+    if (methylationCaller_ && !alignment.isUnmapped()) {
+      methylationCaller_->appendTags(std::ostreambuf_iterator<char>(os), read, alignment);
+    }
     return os;
   }
+  /**
+   ** \brief append the record mapped as described by an alignment structure, and a new line, to the buffer
+   **
+   ** Same output as generateRecord, without the iostreams: the buffer is grown once by an upper
+   ** bound of the record length, the fields are written through a pointer and the buffer is then
+   ** shrunk to the actual end of the record.
+   **/
+  template <typename ReadT, typename AlignmenT>
+  void appendRecord(
+      std::vector<char>& buffer, const ReadT& read, const AlignmenT& alignment, const std::string& rgid) const
+  {
+    const auto&       fullName = read.getName();
+    const auto        nameEnd  = std::find_if(std::begin(fullName), std::end(fullName), isspace);
+    const auto&       cigar    = alignment.getCigar();
+    const auto* const sa       = alignment.getSa();
+    const std::size_t before   = buffer.size();
+    // 11 characters for each integer and 1 per separator are plenty for the fixed fields and tags
+    buffer.resize(
+        before + fullName.size() + read.getBases().size() + read.getQualities().size() + rgid.size() +
+        3 * maxSequenceNameLength_ + 12 * (getOperationCount(cigar) + (sa ? getOperationCount(sa->getCigar()) : 0)) +
+        (methylationCaller_ ? align::MethylationCaller::getMaxTagsLength(read.getLength()) : 0) + 256);
+    char* out = buffer.data() + before;
+    out       = std::copy(std::begin(fullName), nameEnd, out);
+    *out++    = '\t';
+    out       = appendUnsigned(out, alignment.getFlags());
+    *out++    = '\t';
+    if (alignment.isUnmapped() && (!alignment.hasMultipleSegments() || alignment.isUnmappedNextSegment())) {
+      out = appendString(out, "*\t0\t0\t*\t", 8);
+    } else {
+      if (-1 == alignment.getReference()) {
+        *out++ = '=';
+      } else {
+        out = appendSequenceName(out, alignment.getReference());
+      }
+      *out++ = '\t';
+      out    = appendInt(out, alignment.getPosition() + 1);
+      *out++ = '\t';
+      out    = appendInt(out, std::min<align::MapqType>(alignment.getMapq(), align::MAPQ_MAX));
+      *out++ = '\t';
+      if (cigar.empty()) {
+        *out++ = '*';
+      } else {
+        out = appendCigar(out, cigar);
+      }
+      *out++ = '\t';
+    }
+
+    if (!alignment.hasMultipleSegments() || (alignment.isUnmapped() && alignment.isUnmappedNextSegment())) {
+      out = appendString(out, "*\t0\t", 4);
+    } else {
+      if (-1 == alignment.getNextReference() || alignment.getReference() == alignment.getNextReference()) {
+        *out++ = '=';
+      } else {
+        out = appendSequenceName(out, alignment.getNextReference());
+      }
+      *out++ = '\t';
+      out    = appendInt(out, alignment.getNextPosition() + 1);
+      *out++ = '\t';
+    }
+    out    = appendInt(out, alignment.isUnmapped() ? 0 : alignment.getTemplateLength());
+    *out++ = '\t';
+    out    = appendSequence(out, read, alignment);
+    *out++ = '\t';
+    out    = appendQualities(out, read, alignment);
+    *out++ = '\t';
+    out    = appendString(out, "RG:Z:", 5);
+    out    = appendString(out, rgid.data(), rgid.size());
+    if (-1 != alignment.getScore()) {
+      out = appendString(out, "\tAS:i:", 6);
+      out = appendInt(out, alignment.getScore());
+    }
+    if (align::INVALID_SCORE != alignment.getXs()) {
+      out = appendString(out, "\tXS:i:", 6);
+      out = appendInt(out, alignment.getXs());
+    }
+    if (-1 != alignment.getMismatchCount()) {
+      out = appendString(out, "\tNM:i:", 6);
+      out = appendInt(out, alignment.getMismatchCount());
+    }
+    if (align::MAPQ_MAX < alignment.getMapq()) {
+      out = appendString(out, "\tXQ:i:", 6);
+      out = appendInt(out, std::min<align::MapqType>(alignment.getMapq(), align::HW_MAPQ_MAX));
+    }
+
+    if (sa) {
+      out    = appendString(out, "\tSA:Z:", 6);
+      out    = appendSequenceName(out, sa->getReference());
+      *out++ = ',';
+      out    = appendInt(out, sa->getPosition() + 1);
+      out    = appendString(out, sa->reverse() ? ",-," : ",+,", 3);
+      out    = appendCigar(out, sa->getCigar());
+      *out++ = ',';
+      out    = appendInt(out, std::min<align::MapqType>(sa->getMapq(), align::HW_MAPQ_MAX));
+      *out++ = ',';
+      out    = appendInt(out, sa->getNm());
+      *out++ = ';';
+    }
+    if (methylationCaller_ && !alignment.isUnmapped()) {
+      out = methylationCaller_->appendTags(out, read, alignment);
+    }
+    *out++ = '\n';
+    buffer.resize(out - buffer.data());
+  }
+
   // generate an unmapped record
   template <typename ReadT>
   static std::ostream& generateRecord(
@@ -116,7 +254,7 @@ public:
   template <typename ReadT, typename AlignmenT>
   static std::ostream& generateSequence(std::ostream& os, const ReadT& read, const AlignmenT& a)
   {
-    const auto& bases = read.getBases();
+    const auto& bases = read.getSequencedBases();
     const auto& cigar = a.getCigar();
     if (cigar.countEndHardClips() + cigar.countStartHardClips() >= int(bases.size())) return os;
     if (a.isReverseComplement()) {
@@ -161,16 +299,75 @@ public:
     return os;
   }
 
+  /// same as generateSequence, into out. Returns the end of the bases
+  template <typename ReadT, typename AlignmenT>
+  static char* appendSequence(char* out, const ReadT& read, const AlignmenT& a)
+  {
+    static const std::array<char, 16> forward = getDecodingTable<ReadT>(false);
+    static const std::array<char, 16> reverse = getDecodingTable<ReadT>(true);
+    const auto&                       bases   = read.getSequencedBases();
+    const auto&                       cigar   = a.getCigar();
+    const int                         start   = cigar.countStartHardClips();
+    const int                         end     = cigar.countEndHardClips();
+    if (end + start >= int(bases.size())) return out;
+    const std::size_t count = bases.size() - start - end;
+    if (a.isReverseComplement()) {
+      return transform<true, true>(bases.data() + end, count, out, reverse.data());
+    }
+    return transform<false, true>(bases.data() + start, count, out, forward.data());
+  }
+
+  /// same as generateQualities, into out. Returns the end of the qualities
+  template <typename ReadT, typename AlignmenT>
+  static char* appendQualities(char* out, const ReadT& read, const AlignmenT& a)
+  {
+    const auto& qualities = read.getQualities();
+    const auto& cigar     = a.getCigar();
+    const int   start     = cigar.countStartHardClips();
+    const int   end       = cigar.countEndHardClips();
+    if (end + start >= int(qualities.size())) return out;
+    const std::size_t count = qualities.size() - start - end;
+    if (a.isReverseComplement()) {
+      return transform<true, false>(qualities.data() + end, count, out, nullptr);
+    }
+    return transform<false, false>(qualities.data() + start, count, out, nullptr);
+  }
+
+  /// fields of an @RG header line
+  struct ReadGroup {
+    std::string id_;
+    std::string sample_;
+    std::string library_;
+  };
+
   static std::ostream& generateHeader(
       std::ostream&                     os,
       const reference::HashtableConfig& hashtableConfig,
       const std::string&                commandLine,
       const std::string&                rgid,
       const std::string                 rgsm)
+  {
+    return generateHeader(os, hashtableConfig, commandLine, {ReadGroup{rgid, rgsm, "LB0"}});
+  }
+
+  /**
+   ** \brief header with one @RG line for each read group, in the given order
+   **
+   ** \param methylated list each sequence of a methylated hashtable once, under its original name
+   **/
+  static std::ostream& generateHeader(
+      std::ostream&                     os,
+      const reference::HashtableConfig& hashtableConfig,
+      const std::string&                commandLine,
+      const std::vector<ReadGroup>&     readGroups,
+      const bool                        methylated = false)
   {
     os << "@HD\tVN:1.4\tSO:unsorted\n";
     os << "@PG\tID: DRAGEN-OS\tVN:" DRAGEN_OS_VERSION "\tCL:" << commandLine << "\n";
-    os << "@RG\tID:" << rgid << "\tLB:LB0\tPL:PL0\tPU:PU0\tSM:" << rgsm << "\n";
+    for (const auto& readGroup : readGroups) {
+      os << "@RG\tID:" << readGroup.id_ << "\tLB:" << readGroup.library_ << "\tPL:PL0\tPU:PU0\tSM:"
+         << readGroup.sample_ << "\n";
+    }
 
     // sequences must be generated in the original order but they are internally sorted by increasing
     // positions
@@ -183,10 +380,132 @@ public:
     for (std::size_t s = 0; s < sequences.size(); ++s) {
       const auto& sequence = sequences.at(s);
       assert(sequence.id_ == s);
-      os << "@SQ\tSN:" << sequenceNames[s] << "\tLN:" << sequence.seqLen << "\n";
+      if (!methylated) {
+        os << "@SQ\tSN:" << sequenceNames[s] << "\tLN:" << sequence.seqLen << "\n";
+      } else if (!align::MethylationCaller::isGaConverted(sequenceNames[s])) {
+        os << "@SQ\tSN:" << align::MethylationCaller::getOriginalName(sequenceNames[s]) << "\tLN:" << sequence.seqLen
+           << "\n";
+      }
     }
     return os;
   }
+
+private:
+  /// 2 decimal digits for each value in [0, 100)
+  static const char* getDigitPairs()
+  {
+    static const struct DigitPairs {
+      char digits_[200];
+      DigitPairs()
+      {
+        for (unsigned i = 0; 100 > i; ++i) {
+          digits_[2 * i]     = '0' + i / 10;
+          digits_[2 * i + 1] = '0' + i % 10;
+        }
+      }
+    } digitPairs;
+    return digitPairs.digits_;
+  }
+
+  static char* appendUnsigned(char* out, uint32_t value)
+  {
+    const char* const digitPairs = getDigitPairs();
+    char              digits[10];
+    char*             begin = digits + sizeof(digits);
+    while (100 <= value) {
+      begin -= 2;
+      std::memcpy(begin, digitPairs + 2 * (value % 100), 2);
+      value /= 100;
+    }
+    if (10 <= value) {
+      begin -= 2;
+      std::memcpy(begin, digitPairs + 2 * value, 2);
+    } else {
+      *--begin = '0' + value;
+    }
+    return std::copy(begin, digits + sizeof(digits), out);
+  }
+
+  static char* appendInt(char* out, const int value)
+  {
+    if (0 > value) {
+      *out++ = '-';
+      return appendUnsigned(out, 0U - static_cast<uint32_t>(value));
+    }
+    return appendUnsigned(out, value);
+  }
+
+  static char* appendString(char* out, const char* string, const std::size_t length)
+  {
+    std::memcpy(out, string, length);
+    return out + length;
+  }
+
+  char* appendSequenceName(char* out, const int sequenceOffset) const
+  {
+    const std::string& name = sequenceNames_.at(sequenceOffset);
+    return appendString(out, name.data(), name.size());
+  }
+
+  template <typename CigarT>
+  static std::size_t getOperationCount(const CigarT& cigar)
+  {
+    return std::end(cigar) - std::begin(cigar);
+  }
+
+  template <typename CigarT>
+  static char* appendCigar(char* out, const CigarT& cigar)
+  {
+    for (const auto& operation : cigar) {
+      out    = appendUnsigned(out, operation.second);
+      *out++ = align::Cigar::getOperationName(operation.first);
+    }
+    return out;
+  }
+
+  /// 16 entries table for the decoding of the 4 bits bases
+  template <typename ReadT>
+  static std::array<char, 16> getDecodingTable(const bool reverseComplement)
+  {
+    std::array<char, 16> table;
+    for (unsigned base = 0; table.size() > base; ++base) {
+      table[base] = reverseComplement ? ReadT::decodeRcBase(base) : ReadT::decodeBase(base);
+    }
+    return table;
+  }
+
+  /**
+   ** \brief write the count bytes at in, reversed if needed, into out
+   **
+   ** The bases are decoded through the 16 entries table, anything above 15 becoming the same as 15,
+   ** and the qualities are offset by Q0_. With AVX2, 32 bytes are processed at once.
+   **/
+  template <bool reverse, bool bases>
+  static char* transform(const unsigned char* in, const std::size_t count, char* out, const char* table)
+  {
+    std::size_t i = 0;
+#ifdef __AVX2__
+    const __m256i lut = bases ? _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)))
+                              : _mm256_setzero_si256();
+    const __m256i maxBase   = _mm256_set1_epi8(15);
+    const __m256i q0        = _mm256_set1_epi8(Q0_);
+    const __m256i reversing = _mm256_setr_epi8(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    for (; i + 32 <= count; i += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + (reverse ? count - i - 32 : i)));
+      v         = bases ? _mm256_shuffle_epi8(lut, _mm256_min_epu8(v, maxBase)) : _mm256_add_epi8(v, q0);
+      if (reverse) {
+        v = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, reversing), 0x4E);
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+    }
+#endif
+    for (; count > i; ++i) {
+      const unsigned char c = in[reverse ? count - i - 1 : i];
+      out[i]                = bases ? table[std::min<unsigned char>(c, 15)] : static_cast<char>(c + Q0_);
+    }
+    return out + count;
+  }
 };
 
 }  // namespace sam
@@ -32,6 +32,8 @@ public:
   unsigned         getBitCount() const { return bitCount_; }
   unsigned         getByteCount() const { return (bitCount_ + 7) / 8; }
   uint64_t         getHash64(uint64_t value) const;
+  /// same as getHash64 for count values, interleaving the table lookups of several values
+  void             getHashes64(const uint64_t* values, std::size_t count, uint64_t* hashes) const;
   static void      crcHashSlow(int bitCount, const uint8_t* poly, const uint8_t* data, uint8_t* hash);
   static uint64_t* crcHash64Init(int bitCount, const uint8_t* poly);
 
@@ -29,8 +29,10 @@ public:
   typedef std::vector<Base>   Bases;
   typedef unsigned char       Qscore;
   typedef std::vector<Qscore> Qualities;
+  /// in silico bisulfite conversion of the bases, for the alignment of methylation data
+  enum Conversion { NO_CONVERSION, C_TO_T, G_TO_A };
 
-  explicit Read() : id_(0), position_(0) {}
+  explicit Read() : id_(0), position_(0), conversion_(NO_CONVERSION) {}
 
   // The expected usage pattern is to create a bunch of persistent Read objects
   // and init them for each new input sequence from the corresponding parser.
@@ -41,6 +43,13 @@ public:
   Read& operator=(Read&& that);
 
   void init(Name&& name, Bases&& bases, Qualities&& qualities, uint64_t id, unsigned position);
+  /**
+   ** \brief convert the bases, and their reverse complement, for the alignment against a converted reference
+   **
+   ** Every C (respectively G) becomes a T (respectively A), including in the IUPAC codes, except N. The
+   ** sequenced bases are kept for the output. Reset by init.
+   **/
+  void convert(Conversion conversion);
 
   uint64_t          getId() const { return id_; }
   unsigned          getPosition() const { return position_; }
@@ -58,6 +67,9 @@ public:
     return bases2bpb[getBase4bpb(i)];
   }
   const Bases&     getBases() const { return bases_; }
+  /// the bases as sequenced, before any conversion
+  const Bases& getSequencedBases() const { return (NO_CONVERSION == conversion_) ? bases_ : sequencedBases_; }
+  Conversion   getConversion() const { return conversion_; }
   const Bases&     getRcBases() const { return rcBases_; }
   const Qualities& getQualities() const { return qualities_; }
   static char      decodeBase(unsigned int b)
@@ -84,70 +96,15 @@ public:
   }
 
 private:
-  uint64_t  id_;
-  unsigned  position_;
-  Name      name_;
-  Bases     bases_;
-  Bases     rcBases_;
-  Qualities qualities_;
-};
-
-class SerializedRead {
-  short nameLen_;
-  short readLen_;
-  char  bytes_[];
-
-public:
-  void operator<<(const Read& read)
-  {
-    nameLen_        = read.getName().size();
-    readLen_        = read.getLength();
-    char* bases     = std::copy(read.getName().begin(), read.getName().end(), bytes_);
-    char* qualities = std::copy(read.getBases().begin(), read.getBases().end(), bases);
-    std::copy(read.getQualities().begin(), read.getQualities().end(), qualities);
-  }
-
-  short getReadLen() const { return readLen_; }
-
-  std::size_t getByteSize() const { return sizeof(SerializedRead) + nameLen_ + readLen_ * 2; }
-
-  static std::size_t getByteSize(const Read& read)
-  {
-    return sizeof(SerializedRead) + read.getName().size() + read.getLength() * 2;
-  }
-
-  class SerializationString {
-    const char* begin_;
-    const char* end_;
-
-  public:
-    SerializationString(const char* begin, const char* end) : begin_(begin), end_(end) {}
-
-    const char* begin() const { return begin_; }
-    const char* end() const { return end_; }
-
-    friend std::ostream& operator<<(std::ostream& os, const SerializationString& str)
-    {
-      return os << std::string(str.begin_, str.end_);
-    }
-  };
-
-  SerializationString getName() const { return SerializationString(bytes_, bytes_ + nameLen_); }
-  std::pair<const Read::Base*, const Read::Base*> getBases() const
-  {
-    return std::make_pair(
-        reinterpret_cast<const Read::Base*>(bytes_) + nameLen_,
-        reinterpret_cast<const Read::Base*>(bytes_) + nameLen_ + readLen_);
-  }
-  std::pair<const Read::Qscore*, const Read::Qscore*> getQualities() const
-  {
-    return std::make_pair(
-        reinterpret_cast<const Read::Qscore*>(bytes_) + nameLen_ + readLen_,
-        reinterpret_cast<const Read::Qscore*>(bytes_) + nameLen_ + readLen_ * 2);
-  }
-
-  static char decodeBase(unsigned int b) { return Read::decodeBase(b); }
-  static char decodeRcBase(unsigned int b) { return Read::decodeRcBase(b); }
+  uint64_t   id_;
+  unsigned   position_;
+  Name       name_;
+  Bases      bases_;
+  Bases      rcBases_;
+  Qualities  qualities_;
+  Conversion conversion_;
+  /// only set when the bases are converted
+  Bases sequencedBases_;
 };
 
 }  // namespace sequences
@@ -48,8 +48,6 @@ public:
   Seed(const Read* read, unsigned readPosition, unsigned primaryLength);
   /**
    ** \brief returns the list of seed offsets for a read of the given read length
-   **
-   ** TODO: verify that the vector allocation is acceptable, otherwise, pass it as a reference parameter
    */
   static std::vector<size_t> getSeedOffsets(
       const size_t   readLength,
@@ -57,6 +55,14 @@ public:
       const uint32_t period     = DEFAULT_PERIOD,
       const uint32_t pattern    = DEFAULT_PATTERN,
       const uint8_t  forceLastN = DEFAULT_FORCE_LAST_N);
+  /// same as above, into a buffer reused by the caller. Any previous content is discarded
+  static void getSeedOffsets(
+      const size_t         readLength,
+      const unsigned       length,
+      const uint32_t       period,
+      const uint32_t       pattern,
+      const uint8_t        forceLastN,
+      std::vector<size_t>& seedOffsets);
   /**
    ** \brief the encoded data for the primary seed in the format required by the CrCHasher
    **
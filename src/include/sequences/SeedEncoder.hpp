@@ -0,0 +1,70 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#ifndef SEQUENCES_SEED_ENCODER_HPP
+#define SEQUENCES_SEED_ENCODER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "sequences/CrcHasher.hpp"
+#include "sequences/Read.hpp"
+#include "sequences/Seed.hpp"
+
+namespace dragenos {
+namespace sequences {
+
+/**
+ ** \brief 2 bits encoding and primary hash of all the seeds of a read
+ **
+ ** The forward and reverse complement encodings are rolled along the read one base
+ ** at a time instead of being rebuilt from the read for each seed, and the hashes of
+ ** all the seeds are computed in a single batch. The encodings are identical to
+ ** Seed::getPrimaryData and the hashes to the CrcHasher::getHash64 of the smallest
+ ** of the two encodings.
+ **
+ ** The instance is meant to be reused across reads to avoid memory allocations.
+ **/
+class SeedEncoder {
+public:
+  /**
+   ** \brief encode the seeds at the given offsets
+   **
+   ** \pre the offsets are increasing and all the seeds are within the read
+   **/
+  void encode(const Read& read, unsigned primaryLength, const std::vector<size_t>& seedOffsets);
+  /// hash the primary data of all the encoded seeds
+  void hash(const CrcHasher& hasher);
+
+  std::size_t size() const { return forwardData_.size(); }
+  Seed::Data  getForwardData(std::size_t i) const { return forwardData_[i]; }
+  Seed::Data  getReverseData(std::size_t i) const { return reverseData_[i]; }
+  /// true when the primary data is the reverse complement of the seed
+  bool isReverseComplement(std::size_t i) const { return reverseData_[i] < forwardData_[i]; }
+  /// smallest of the forward and reverse complement data
+  Seed::Data getPrimaryData(std::size_t i) const { return primaryData_[i]; }
+  /// \pre hash() was called after the last encode()
+  uint64_t getHash(std::size_t i) const { return hashes_[i]; }
+
+private:
+  std::vector<Seed::Data> forwardData_;
+  std::vector<Seed::Data> reverseData_;
+  std::vector<Seed::Data> primaryData_;
+  std::vector<uint64_t>   hashes_;
+};
+
+}  // namespace sequences
+}  // namespace dragenos
+
+#endif  // #ifndef SEQUENCES_SEED_ENCODER_HPP
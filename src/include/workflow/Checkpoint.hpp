@@ -0,0 +1,68 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <boost/filesystem/path.hpp>
+
+namespace dragenos {
+namespace workflow {
+
+/**
+ ** \brief Progress of the alignment of the read groups that go to one set of output files
+ **
+ ** Saved periodically next to the output files, after a block is stored in input order,
+ ** so that a run killed before completion can resume from the last checkpoint instead of
+ ** starting over: the output files are truncated to the sizes of the checkpoint, and the
+ ** inputs of the read group in progress are skipped up to its offsets.
+ **/
+struct Checkpoint {
+  /// all the read groups are aligned and the output files are complete
+  bool complete_ = false;
+  /// position of the read group in progress in the read groups of the output, and its ID
+  std::size_t readGroup_ = 0;
+  std::string readGroupId_;
+  /// records of the read group in progress stored in the output, and the bytes of its inputs they come from
+  uint64_t records_  = 0;
+  uint64_t r1Offset_ = 0;
+  uint64_t r2Offset_ = 0;
+  /// sizes of the output files
+  uint64_t samOffset_         = 0;
+  uint64_t insertStatsOffset_ = 0;
+  /// state of the insert size estimator of the read group in progress, see InsertSizeDistribution::saveFixed
+  std::string insertStats_;
+  /// fixed insert size statistics of the read groups, by position of their @RG line, for their remaining inputs
+  std::map<std::size_t, std::string> readGroupInsertStats_;
+  /// counts of all the records in the output, see ReadGroupAlignmentCounts::save
+  std::string mappingMetrics_;
+};
+
+/// writes the checkpoint to a temporary file renamed to path, so that path always holds a complete checkpoint
+void saveCheckpoint(const Checkpoint& checkpoint, const boost::filesystem::path& path);
+
+/**
+ ** \brief reads the checkpoint saved at path
+ **
+ ** \return false if there is no checkpoint at path
+ ** \throw common::InvalidParameterException if the file is not a valid checkpoint
+ **/
+bool loadCheckpoint(const boost::filesystem::path& path, Checkpoint& checkpoint);
+
+}  // namespace workflow
+}  // namespace dragenos
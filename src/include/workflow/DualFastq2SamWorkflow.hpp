@@ -12,20 +12,46 @@
  **
  **/
 
+#include <functional>
+#include <string>
+
+#include "align/Aligner.hpp"
 #include "align/InsertSizeDistribution.hpp"
 #include "fastq/FastqNRecordReader.hpp"
+#include "fastq/MappedFastqReader.hpp"
+#include "map/HotSeedCache.hpp"
 #include "options/DragenOsOptions.hpp"
+#include "options/FastqList.hpp"
 #include "reference/Hashtable.hpp"
 #include "reference/ReferenceDir.hpp"
+#include "reference/TargetIndex.hpp"
 
 namespace dragenos {
 namespace workflow {
 
 class DualFastq2SamWorkflow {
+public:
+  /// read group after the blocks stored so far, in input order
+  struct Progress {
+    uint64_t records_  = 0;
+    uint64_t r1Offset_ = 0;
+    uint64_t r2Offset_ = 0;
+    /// the insert size parameters of the remaining reads no longer depend on their alignments
+    bool insertSizesFixed_ = false;
+    /// when insertSizesFixed_, state of the insert size estimator, see InsertSizeDistribution::saveFixed
+    std::string insertStats_;
+  };
+  /// called after each block written to the output, with the counts of its records in mappingMetrics
+  typedef std::function<void(const Progress&)> StoredBlockCallback;
+
+private:
   const options::DragenOsOptions&     options_;
+  const options::FastqListEntry&      readGroup_;
+  const uint16_t                      readGroupIndex_;
   const reference::ReferenceSequence& refSeq_;
   const reference::HashtableConfig&   htConfig_;
   const reference::Hashtable&         hashtable_;
+  const reference::TargetIndex* const targetIndex_;
   // IMPORTANT: this has to divide INIT_INTERVAL_SIZE without remainder. Else the whole insert
   // size stats detection will hang because it depends on processing alignment results exactly
   // after sending INIT_INTERVAL_SIZE into the aligner.
@@ -35,37 +61,98 @@ class DualFastq2SamWorkflow {
   int blockToStart_          = 0;
   int blockToGetInsertSizes_ = 0;
   int blockToAlign_          = 0;
+  int blockToAddInsertSizes_ = 0;
   int blockToRead_           = 0;
   int blockToStore_          = 0;
 
   bool r1Eof_ = false;
   bool r2Eof_ = false;
 
+  // read group after the blocks stored so far, and who wants to know about it
+  Progress            progress_;
+  StoredBlockCallback storedBlock_;
+
+  // accumulated by the threads as they complete
+  map::HotSeedCache::Statistics             hotSeedCacheStatistics_;
+  align::Aligner::SparseSeedingStatistics   sparseSeedingStatistics_;
+  align::Aligner::TargetedMappingStatistics targetedMappingStatistics_;
+
 public:
+  /**
+   ** \param readGroup inputs of the read group and ID of its records
+   ** \param readGroupIndex RG column of the insert stats, the position of the @RG line of the read group
+   ** \param targetIndex when not null, only the pairs with a k-mer of the targets are aligned
+   **/
   DualFastq2SamWorkflow(
       const options::DragenOsOptions&     options,
+      const options::FastqListEntry&      readGroup,
+      const uint16_t                      readGroupIndex,
       const reference::ReferenceSequence& refSeq,
       const reference::HashtableConfig&   htConfig,
-      const reference::Hashtable&         hashtable)
-    : options_(options), refSeq_(refSeq), htConfig_(htConfig), hashtable_(hashtable)
+      const reference::Hashtable&         hashtable,
+      const reference::TargetIndex*       targetIndex = nullptr)
+    : options_(options),
+      readGroup_(readGroup),
+      readGroupIndex_(readGroupIndex),
+      refSeq_(refSeq),
+      htConfig_(htConfig),
+      hashtable_(hashtable),
+      targetIndex_(targetIndex)
   {
   }
 
+  /// calls storedBlock after each block written to the output. Requires preserve-map-align-order
+  void setStoredBlockCallback(const StoredBlockCallback& storedBlock) { storedBlock_ = storedBlock; }
+  /**
+   ** \brief continues the read group from the progress of a previous run, with the inputs already at its offsets
+   **
+   ** With insertSizesFixed_, the insert size statistics are restored instead of detected, and not logged again.
+   ** This also applies the statistics of a read group to its other inputs, from an empty progress.
+   **/
+  void resume(const Progress& progress) { progress_ = progress; }
+  /// read group after the blocks stored so far, with the final insert size statistics once aligned
+  const Progress& getProgress() const { return progress_; }
+
+  /// aligns the read group into os, adding the counts of its records to mappingMetrics
   void parseDualFastq(
-      std::ostream& os, std::ostream& insertSizeDistributionLogStream, std::ostream& mappingMetricsLogStream);
+      std::istream&             r1Stream,
+      std::istream&             r2Stream,
+      std::ostream&             os,
+      std::ostream&             insertSizeDistributionLogStream,
+      ReadGroupAlignmentCounts& mappingMetrics);
+
+  /// same as above, aligning the records in place in the memory mapped files
+  void parseDualFastq(
+      fastq::MappedFastqReader& r1Reader,
+      fastq::MappedFastqReader& r2Reader,
+      std::ostream&             os,
+      std::ostream&             insertSizeDistributionLogStream,
+      ReadGroupAlignmentCounts& mappingMetrics);
 
 private:
+  /// records of a block, in the buffer of the block or directly in the mapped file
+  struct RecordBlock {
+    std::vector<char> buffer_;
+    const char*       begin_ = nullptr;
+    const char*       end_   = nullptr;
+  };
+
+  static std::size_t readRecords(fastq::FastqNRecordReader& reader, RecordBlock& block, std::size_t n);
+  static std::size_t readRecords(fastq::MappedFastqReader& reader, RecordBlock& block, std::size_t n);
+
   align::InsertSizeParameters requestInsertSizeInfo(
-      align::InsertSizeDistribution& insertSizeDistribution, std::istream& inputR1, std::istream& inputR2);
+      align::InsertSizeDistribution& insertSizeDistribution,
+      const RecordBlock&             r1Block,
+      const RecordBlock&             r2Block);
 
+  template <typename Reader>
   void alignDualFastqBlock(
       common::ThreadPool::lock_type&         lock,
       std::size_t&                           cpuThreads,
-      std::size_t&                           threadID,
-      std::vector<ReadGroupAlignmentCounts>& mappingMetricsVector,
+      ReadGroupAlignmentCounts&              mappingMetrics,
       align::InsertSizeDistribution&         insertSizeDistribution,
-      fastq::FastqNRecordReader&             r1Reader,
-      fastq::FastqNRecordReader&             r2Reader,
+      Reader&                                r1Reader,
+      Reader&                                r2Reader,
       std::ostream&                          os,
       const align::SinglePicker&             singlePicker,
       const align::SimilarityScores&         similarity,
@@ -74,8 +161,8 @@ private:
   template <typename StoreOp>
   void alignDualFastq(
       align::InsertSizeParameters& insertSizeParameters,
-      std::istream&                inputR1,
-      std::istream&                inputR2,
+      const RecordBlock&           r1Block,
+      const RecordBlock&           r2Block,
       align::Aligner&              aligner,
       const align::SinglePicker&   singlePicker,
       const align::PairBuilder&    pairBuilder,
@@ -84,22 +171,24 @@ private:
   //  void parseDualFastq(
   //    const align::InsertSizeDistribution& insertSizeDistribution,
   //    std::istream& inputR1, std::istream& inputR2, align::Aligner& aligner, std::ostream& output);
+  template <typename Reader>
   void readBlockThread(
       common::ThreadPool::lock_type& lock,
       const int                      ourBlock,
       int&                           r1Records,
-      std::vector<char>&             r1Block,
-      fastq::FastqNRecordReader&     r1Reader,
+      RecordBlock&                   r1Block,
+      Reader&                        r1Reader,
       int&                           r2Records,
-      std::vector<char>&             r2Block,
-      fastq::FastqNRecordReader&     r2Reader);
+      RecordBlock&                   r2Block,
+      Reader&                        r2Reader);
 
-  void parseDualFastq(
-      std::istream& r1Stream,
-      std::istream& r2Stream,
-      std::ostream& os,
-      std::ostream& insertSizeDistributionLogStream,
-      std::ostream& mappingMetricsLogStream);
+  template <typename Reader>
+  void alignDualFastq(
+      Reader&                   r1Reader,
+      Reader&                   r2Reader,
+      std::ostream&             os,
+      std::ostream&             insertSizeDistributionLogStream,
+      ReadGroupAlignmentCounts& mappingMetrics);
 };
 
 }  // namespace workflow
@@ -14,12 +14,20 @@
 
 #pragma once
 
+#include <memory>
+
 #include "fastq/FastqNRecordReader.hpp"
 #include "options/DragenOsOptions.hpp"
+#include "reference/ReferenceDir.hpp"
+#include "reference/TargetIndex.hpp"
 
 namespace dragenos {
 namespace workflow {
 void input2Sam(const dragenos::options::DragenOsOptions& options);
 
+/// index of the k-mers of the regions of Mapper.target-bed, at the length of the primary seeds. Null without it
+std::unique_ptr<reference::TargetIndex> loadTargetIndex(
+    const options::DragenOsOptions& options, const reference::ReferenceDir7& referenceDir);
+
 }  // namespace workflow
 }  // namespace dragenos
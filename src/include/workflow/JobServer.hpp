@@ -0,0 +1,66 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace dragenos {
+namespace workflow {
+
+/**
+ ** \brief runs one job: the working directory of the client and its command line, including argv[0]
+ **
+ ** Any exception thrown fails the job without stopping the server.
+ **/
+typedef std::function<void(const std::string& workingDirectory, const std::vector<std::string>& arguments)>
+    JobFunction;
+
+/**
+ ** \brief Accepts jobs on a Unix domain socket and runs them one at a time until a shutdown request
+ **
+ ** Each connection carries a single request, as NUL terminated strings: either "run", the working
+ ** directory and the arguments of the job, or "shutdown". The reply is a single line, "OK <seconds>"
+ ** or "ERROR <message>", sent when the job completes.
+ **
+ ** The socket file is only accessible to the user of the server, and the connections of the other
+ ** users are rejected, as the jobs run with the privileges of the server. A stale socket file left
+ ** by a previous server is replaced. The socket file is removed on shutdown.
+ **
+ ** \param requestTimeout time given to each client to send its complete request, after which the
+ **        connection is closed without a reply
+ **/
+void serveJobs(
+    const std::string&              socketPath,
+    const JobFunction&              job,
+    std::ostream&                   log,
+    const std::chrono::milliseconds requestTimeout = std::chrono::seconds(10));
+
+/**
+ ** \brief submits a job to the server and waits for its completion
+ **
+ ** \param arguments full command line of the job, including argv[0]
+ ** \throw common::DragenOsException if the server reports a failure
+ **/
+void submitJob(const std::string& socketPath, const std::vector<std::string>& arguments, std::ostream& log);
+
+/// asks the server to exit once the current job is complete
+void shutdownServer(const std::string& socketPath, std::ostream& log);
+
+}  // namespace workflow
+}  // namespace dragenos
@@ -17,6 +17,7 @@
 #include "align/Aligner.hpp"
 #include "align/Pairs.hpp"
 #include "align/Tlen.hpp"
+#include "common/Arena.hpp"
 
 namespace dragenos {
 namespace workflow {
@@ -196,6 +197,8 @@ void alignAndStorePair(
     align::AlignmentPairs&             alignmentPairs,
     StoreOp                            store)
 {
+  // the scratch memory of the previous fragment is not needed anymore
+  common::Arena::resetCurrent();
   alignmentPairs.clear();
   const auto best = aligner.getAlignments(pair, alignmentPairs, insertSizeParameters, pairBuilder);
   if (alignmentPairs.end() != best) {
@@ -267,6 +270,8 @@ void alignAndStoreSingle(
 {
   static const align::Alignment unmappedSE(align::AlignmentHeader::UNMAPPED);
 
+  // the scratch memory of the previous read is not needed anymore
+  common::Arena::resetCurrent();
   alignments.clear();
   aligner.getAlignments(read, alignments);
   const auto best = singlePicker.pickBest(read.getLength(), alignments);
@@ -12,9 +12,12 @@
  **
  **/
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
+#include <iomanip>
 #include <queue>
 
 #include <fcntl.h>
@@ -33,6 +36,30 @@
 namespace dragenos {
 namespace align {
 
+namespace {
+
+/// adds the nanoseconds elapsed over its lifetime to the counter, if any
+class ElapsedNanoseconds {
+public:
+  explicit ElapsedNanoseconds(uint64_t* counter)
+    : counter_(counter), start_(counter ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+  {
+  }
+  ~ElapsedNanoseconds()
+  {
+    if (nullptr != counter_) {
+      *counter_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_)
+                       .count();
+    }
+  }
+
+private:
+  uint64_t* const                             counter_;
+  const std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace
+
 Aligner::Aligner(
     const reference::ReferenceSequence& refSeq,
     const reference::HashtableConfig&   htConfig,
@@ -47,13 +74,21 @@ Aligner::Aligner(
     const int                           aln_cfg_mapq_min_len,
     const uint32_t                      aln_cfg_unpaired_pen,
     const double                        aln_cfg_filter_len_ratio,
-    const bool                          vectorizedSW)
+    const bool                          vectorizedSW,
+    const std::size_t                   hotSeedCacheSize,
+    const unsigned                      hotSeedCacheMinBuckets,
+    const bool                          sparseSeeding,
+    const reference::TargetIndex*       targetIndex,
+    const MethylationCaller*            methylationCaller)
   : refSeq_(refSeq),
     htConfig_(htConfig),
     mapOnly_(mapOnly),
     swAll_(swAll),
     vectorizedSW_(vectorizedSW),
-    mapper_(&hashtable),
+    sparseSeeding_(sparseSeeding),
+    targetIndex_(targetIndex),
+    methylationCaller_(methylationCaller),
+    mapper_(&hashtable, hotSeedCacheSize, hotSeedCacheMinBuckets),
     similarity_(similarity),
     gapInit_(gapInit),
     gapExtend_(gapExtend),
@@ -212,7 +247,7 @@ unsigned Aligner::calculatePotentialScore(
 int Aligner::initializeUngappedAlignmentScores(
     const Read& read, const bool rcFlag, const size_t referenceOffset, Alignment& alignment)
 {
-  std::string       operations;
+  std::string&      operations           = ungappedOperations_;
   static const char ALIGNMENT_MATCH      = Cigar::getOperationName(Cigar::ALIGNMENT_MATCH);
   static const char SOFT_CLIP            = Cigar::getOperationName(Cigar::SOFT_CLIP);
   static const int  SOFT_CLIP_ADJUSTMENT = -5;
@@ -236,43 +271,47 @@ int Aligner::initializeUngappedAlignmentScores(
   const auto                                  posRange = htConfig_.getPositionRange(seq);
   const int seqLeft = std::min(readBases.size(), posRange.second - referenceOffset);
 
-  Database databaseSeqLeft;
-  databaseSeqLeft.reserve(seqLeft + 1);
-  refSeq_.getBases(referenceOffset, referenceOffset + seqLeft, databaseSeqLeft);
-
-  for (int i = 0; i < seqLeft; ++i) {
-    const auto          readBase      = readBases[i];
-    const unsigned char referenceBase = databaseSeqLeft[i];
-    //    const bool          goodReadBase      = (readBase > 0) && (readBase != N);
-    //    const bool          goodReferenceBase = (referenceBase > 0) && (referenceBase != N);
-    //    const bool          goodBase          = goodReadBase && goodReferenceBase;
-    //    const bool          match             = goodBase && (readBase == referenceBase);
-    alignmentScore += similarity_(readBase, referenceBase);
-    alignmentScore = std::max(0, alignmentScore);
-    if (0 == alignmentScore) {
-      if (currentScore > bestScore) {
-        bestScore = currentScore;
-        bestFirst = currentFirst;
-        bestLast  = currentLast;
-      }
-      currentScore = 0;
-      currentFirst = i;
-      currentLast  = i;
-    } else {
-      if (0 == currentScore) {
+  // compare the whole read against the packed reference once, then score from the masks
+  mismatchMask_.compare(readBases.data(), seqLeft, refSeq_, referenceOffset);
+  const auto similarity = [this](const int i) -> int {
+    return mismatchMask_.isN(i) ? similarity_.nScore_
+                                : (mismatchMask_.isMismatch(i) ? similarity_.mismatch_ : similarity_.match_);
+  };
+
+  if (mismatchMask_.isClean() && (0 < seqLeft) && (0 < similarity_.match_)) {
+    // the score increases monotonically: single stretch covering all the bases
+    bestScore = alignmentScore + seqLeft * similarity_.match_;
+    bestFirst = 0;
+    bestLast  = seqLeft - 1;
+  } else {
+    for (int i = 0; i < seqLeft; ++i) {
+      alignmentScore += similarity(i);
+      alignmentScore = std::max(0, alignmentScore);
+      if (0 == alignmentScore) {
+        if (currentScore > bestScore) {
+          bestScore = currentScore;
+          bestFirst = currentFirst;
+          bestLast  = currentLast;
+        }
+        currentScore = 0;
         currentFirst = i;
-      }
-
-      if (alignmentScore > currentScore) {
-        currentScore = alignmentScore;
         currentLast  = i;
+      } else {
+        if (0 == currentScore) {
+          currentFirst = i;
+        }
+
+        if (alignmentScore > currentScore) {
+          currentScore = alignmentScore;
+          currentLast  = i;
+        }
       }
     }
-  }
-  if (currentScore > bestScore) {
-    bestScore = currentScore;
-    bestFirst = currentFirst;
-    bestLast  = currentLast;
+    if (currentScore > bestScore) {
+      bestScore = currentScore;
+      bestFirst = currentFirst;
+      bestLast  = currentLast;
+    }
   }
   assert(bestScore > 0);
   assert(bestFirst <= bestLast);
@@ -286,21 +325,8 @@ int Aligner::initializeUngappedAlignmentScores(
   }
   // TODO: check if final soft clip is needed
   int malus = 0;
-
-  Database databaseBestLastToSeqLeft;
-  size_t   bestToLastRefStart = referenceOffset + bestLast + 1;
-  databaseBestLastToSeqLeft.reserve(seqLeft + 1);
-  refSeq_.getBases(bestToLastRefStart, bestToLastRefStart + seqLeft, databaseBestLastToSeqLeft);
-
-  /*
-  databaseBestLastToSeqLeft.reserve(seqLeft - bestLast + 1);
-  refSeq_.getBases(referenceOffset + bestLast + 1, referenceOffset + bestLast + 1 + seqLeft, databaseBestLastToSeqLeft);
-  */
-
   for (int i = bestLast + 1; i < seqLeft; ++i) {
-    const auto          readBase      = readBases[i];
-    const unsigned char referenceBase = databaseBestLastToSeqLeft[i - (bestLast + 1)];
-    malus += similarity_(readBase, referenceBase);
+    malus += similarity(i);
   }
   if (bestLast + 1 < seqLeft && malus >= SOFT_CLIP_ADJUSTMENT) {
     bestLast = seqLeft - 1;
@@ -357,8 +383,80 @@ void Aligner::runSmithWatermanWorthy(
   }
 }
 
+void Aligner::getPositionChains(const Read& read, map::ChainBuilder& chainBuilder)
+{
+  if (sparseSeeding_) {
+    ++sparseSeedingStatistics_.reads_;
+    if (mapper_.getSparsePositionChain(read, chainBuilder) && !removeNonDirectionalChains(read, chainBuilder) &&
+        isPerfectSparseChain(read, chainBuilder.at(0))) {
+      ++sparseSeedingStatistics_.fastPath_;
+      return;
+    }
+  }
+  mapper_.getPositionChains(read, chainBuilder);
+  removeNonDirectionalChains(read, chainBuilder);
+}
+
+bool Aligner::removeNonDirectionalChains(const Read& read, map::ChainBuilder& chainBuilder) const
+{
+  if (nullptr == methylationCaller_) {
+    return false;
+  }
+  // before any alignment, so that they compete neither for the best pair nor for the MAPQ
+  return 0 != chainBuilder.removeChains([this, &read](const map::SeedChain& seedChain) {
+           const auto referenceCoordinates =
+               htConfig_.convertToReferenceCoordinates(seedChain.firstReferencePosition());
+           return !methylationCaller_->isDirectional(
+               read.getConversion(), seedChain.isReverseComplement(), referenceCoordinates.first);
+         });
+}
+
+bool Aligner::isPerfectSparseChain(const Read& read, const map::SeedChain& seedChain)
+{
+  const size_t referenceOffset = seedChain.firstReferencePosition();
+  // the read must be entirely within a single reference sequence
+  const auto  referenceCoordinates = htConfig_.convertToReferenceCoordinates(referenceOffset);
+  const auto& sequence             = htConfig_.getSequences().at(referenceCoordinates.first);
+  const auto  positionRange        = htConfig_.getPositionRange(sequence);
+  if ((referenceOffset < positionRange.first) || (positionRange.second < referenceOffset + read.getLength())) {
+    return false;
+  }
+  const auto& query = seedChain.isReverseComplement() ? read.getRcBases() : read.getBases();
+  refSeq_.getBases(referenceOffset, referenceOffset + query.size(), sparseSeedingReference_);
+  const auto queryBegin    = reinterpret_cast<const char*>(query.data());
+  const auto databaseBegin = reinterpret_cast<const char*>(sparseSeedingReference_.data());
+  // only the outcome is needed: the alignments are generated again from the chains
+  return 0 < getPerfectAlignmentScore(
+                 queryBegin,
+                 queryBegin + query.size(),
+                 databaseBegin,
+                 databaseBegin + sparseSeedingReference_.size(),
+                 mismatchMask_);
+}
+
+bool Aligner::isOffTarget(const Read& read, const Read* mate)
+{
+  if (nullptr == targetIndex_) {
+    return false;
+  }
+  const ElapsedNanoseconds elapsed(&targetedMappingStatistics_.classifyNanoseconds_);
+  ++targetedMappingStatistics_.fragments_;
+  if (targetIndex_->isOnTarget(read.getBases()) ||
+      ((nullptr != mate) && targetIndex_->isOnTarget(mate->getBases()))) {
+    ++targetedMappingStatistics_.onTarget_;
+    return false;
+  }
+  return true;
+}
+
 void Aligner::getAlignments(const Read& read, Alignments& alignments)
 {
+  if (isOffTarget(read, nullptr)) {
+    alignments.clear();
+    return;
+  }
+  const ElapsedNanoseconds elapsed(targetIndex_ ? &targetedMappingStatistics_.alignNanoseconds_ : nullptr);
+
   if (vectorizedSW_) {
     const auto& query0 = read.getBases();
     vectorSmithWaterman_.initReadContext(query0.data(), query0.data() + query0.size(), 0);
@@ -367,7 +465,7 @@ void Aligner::getAlignments(const Read& read, Alignments& alignments)
   alignments.clear();
   map::ChainBuilder& chainBuilder = chainBuilders_[0];
   chainBuilder.clear();
-  mapper_.getPositionChains(read, chainBuilder);
+  getPositionChains(read, chainBuilder);
 
   if (0 != chainBuilder.size()) {
     buildUngappedAlignments(chainBuilder, read, alignments);
@@ -518,6 +616,14 @@ AlignmentPairs::iterator Aligner::getAlignments(
     const InsertSizeParameters& insertSizeParameters,
     const PairBuilder&          pairBuilder)
 {
+  if (isOffTarget(readPair[0], &readPair[1])) {
+    alignmentPairs.clear();
+    unpairedAlignments_[0].clear();
+    unpairedAlignments_[1].clear();
+    return alignmentPairs.end();
+  }
+  const ElapsedNanoseconds elapsed(targetIndex_ ? &targetedMappingStatistics_.alignNanoseconds_ : nullptr);
+
   if (vectorizedSW_) {
     const auto& query0 = readPair[0].getBases();
     vectorSmithWaterman_.initReadContext(query0.data(), query0.data() + query0.size(), 0);
@@ -529,8 +635,8 @@ AlignmentPairs::iterator Aligner::getAlignments(
   alignmentPairs.clear();
   chainBuilders_[0].clear();
   chainBuilders_[1].clear();
-  mapper_.getPositionChains(readPair[0], chainBuilders_[0]);
-  mapper_.getPositionChains(readPair[1], chainBuilders_[1]);
+  getPositionChains(readPair[0], chainBuilders_[0]);
+  getPositionChains(readPair[1], chainBuilders_[1]);
   //  std::vector<std::array<map::ChainBuilder *, 2> > seedChainPairs; // keeping trace of the seed chains used for each
   // max number of chains is seed chains + rescued chains. Rescued is at most one per mate seed chain
   chainBuilders_[0].reserve(chainBuilders_[0].size() + chainBuilders_[1].size());
@@ -570,14 +676,33 @@ AlignmentPairs::iterator Aligner::getAlignments(
 
   //  std::cerr << "pairsFound[0].size():" << pairsFound[0].size() << std::endl;
   //  std::cerr << "pairsFound[1].size():" << pairsFound[1].size() << std::endl;
-  // find all combinations from seeds
+  // find all combinations from seeds. Only the chains that pair and the ones combined with the best
+  // unpaired alignments are needed. With sw-all, deFilterChain realigns the chains in the loop,
+  // which can move them after their indexing: all the combinations are checked then
+  mateChainIndex_.build(readPair, chainBuilders_[1], pairsFound[1].size(), swAll_);
   for (unsigned i0 = 0; pairsFound[0].size() > i0; ++i0) {
     auto& chain0 = chainBuilders_[0].at(i0);
     if (unpairedAlignments_[0].at(i0).getIneligibilityStatus()) {
       continue;
     }
 
-    for (unsigned i1 = 0; pairsFound[1].size() > i1; ++i1) {
+    // the filtering of the chains can change in the loop, where it is checked
+    mateCandidates_.clear();
+    if (std::size_t(bestOffset0) == i0) {
+      for (unsigned i1 = 0; pairsFound[1].size() > i1; ++i1) {
+        mateCandidates_.push_back(i1);
+      }
+    } else {
+      mateChainIndex_.getCandidates(insertSizeParameters, readPair, chain0, mateCandidates_);
+      if (-1 != bestOffset1) {
+        mateCandidates_.push_back(bestOffset1);
+      }
+      // same order as the exhaustive enumeration
+      std::sort(mateCandidates_.begin(), mateCandidates_.end());
+      mateCandidates_.erase(std::unique(mateCandidates_.begin(), mateCandidates_.end()), mateCandidates_.end());
+    }
+
+    for (const unsigned i1 : mateCandidates_) {
       if (unpairedAlignments_[1].at(i1).getIneligibilityStatus()) {
         continue;
       }
@@ -905,11 +1030,33 @@ void Aligner::generateDummyAlignments(
 }
 
 bool Aligner::isPerfectAlignment(
-    const char* queryBegin,
-    const char* queryEnd,
-    const char* databaseBegin,
-    const char* databaseEnd,
-    Alignment&  alignment)
+    const char*   queryBegin,
+    const char*   queryEnd,
+    const char*   databaseBegin,
+    const char*   databaseEnd,
+    MismatchMask& mismatchMask,
+    Alignment&    alignment)
+{
+  const int score = getPerfectAlignmentScore(queryBegin, queryEnd, databaseBegin, databaseEnd, mismatchMask);
+  if (score <= 0) {
+    return false;
+  }
+  // We have a score, no burst - fill in the alignment
+  // TODO: check for clipping
+  // TODO: implement indel detection
+  alignment.setScore(score);
+  auto& cigar = alignment.cigar();
+  cigar.clear();
+  cigar.emplace_back(Cigar::ALIGNMENT_MATCH, queryEnd - queryBegin);
+  return true;
+}
+
+int Aligner::getPerfectAlignmentScore(
+    const char*   queryBegin,
+    const char*   queryEnd,
+    const char*   databaseBegin,
+    const char*   databaseEnd,
+    MismatchMask& mismatchMask)
 {
   assert(nullptr != queryBegin);
   assert(nullptr != queryEnd);
@@ -920,57 +1067,23 @@ bool Aligner::isPerfectAlignment(
   // query and database must be exactly the same length and non-empty
   const auto count = queryEnd - queryBegin;
   if ((0 >= count) || (databaseEnd - databaseBegin != count)) {
-    return false;
-  }
-  const char*                    query          = queryBegin;
-  const char*                    database       = databaseBegin;
-  int                            score          = 0;
-  unsigned                       snpCount       = 0;  // number of SNPs in the current burst window
-  constexpr int                  BURST_WINDOW   = 8;
-  constexpr int                  BURST_MINIMUM  = 4;
-  constexpr int                  MATCH_SCORE    = 1;
-  constexpr int                  MATCH_N_SCORE  = -1;
-  constexpr int                  MISMATCH_SCORE = -4;
-  std::array<bool, BURST_WINDOW> burst;
-  std::fill(burst.begin(), burst.end(), false);
-  size_t front = 0;
-  while (query != queryEnd) {
-    // remove the SNP falling out of the window if any
-    snpCount -= burst[front];
-    // Ns have their own score, count as mismatches but not as burst
-    constexpr char N = 0xF;
-    if ((0 == *query) || (0 == *database) || (N == *query) || (N == *database)) {
-      score += MATCH_N_SCORE;
-      ++snpCount;
-      burst[front] = false;
-    }
-    // TODO: add support for 2-3 base codes
-    else if (*query == *database) {
-      score += MATCH_SCORE;
-      burst[front] = false;
-    } else {
-      score += MISMATCH_SCORE;
-      ++snpCount;
-      burst[front] = true;
-    }
-    if (BURST_MINIMUM <= snpCount) {
-      return false;
-    }
-    front = ((front + 1) % burst.size());
-    ++query;
-    ++database;
+    return 0;
   }
-  if (score <= 0) {
-    return false;
+  constexpr int BURST_WINDOW   = 8;
+  constexpr int BURST_MINIMUM  = 4;
+  constexpr int MATCH_SCORE    = 1;
+  constexpr int MATCH_N_SCORE  = -1;
+  constexpr int MISMATCH_SCORE = -4;
+  // Ns have their own score, count as mismatches but not as burst
+  // TODO: add support for 2-3 base codes
+  mismatchMask.compare(
+      reinterpret_cast<const unsigned char*>(queryBegin),
+      reinterpret_cast<const unsigned char*>(databaseBegin),
+      count);
+  if (mismatchMask.hasBurst(BURST_WINDOW, BURST_MINIMUM)) {
+    return 0;
   }
-  // We have a score, no burst - fill in the alignment
-  // TODO: check for clipping
-  // TODO: implement indel detection
-  alignment.setScore(score);
-  auto& cigar = alignment.cigar();
-  cigar.clear();
-  cigar.emplace_back(Cigar::ALIGNMENT_MATCH, count);
-  return true;
+  return std::max(0, mismatchMask.getScore(MATCH_SCORE, MISMATCH_SCORE, MATCH_N_SCORE));
 }
 
 void Aligner::filter(AlignmentPairs& alignmentPairs, std::array<Alignments, 2>& unpairedAlignments)
@@ -1013,5 +1126,24 @@ void Aligner::filter(Alignments& alignments)
   }
 }
 
+std::ostream& operator<<(std::ostream& os, const Aligner::SparseSeedingStatistics& statistics)
+{
+  const double fraction = statistics.reads_ ? 100.0 * statistics.fastPath_ / statistics.reads_ : 0.0;
+  return os << statistics.reads_ << " reads, " << statistics.fastPath_ << " fast path (" << std::fixed
+            << std::setprecision(2) << fraction << "%)";
+}
+
+std::ostream& operator<<(std::ostream& os, const Aligner::TargetedMappingStatistics& statistics)
+{
+  const double fraction = statistics.fragments_ ? 100.0 * statistics.onTarget_ / statistics.fragments_ : 0.0;
+  // assuming the fragments left unmapped would have taken the mean alignment time of the fragments on target
+  const double fullGenome =
+      statistics.onTarget_ ? double(statistics.alignNanoseconds_) * statistics.fragments_ / statistics.onTarget_ : 0.0;
+  const uint64_t elapsed = statistics.classifyNanoseconds_ + statistics.alignNanoseconds_;
+  const double   speedup = elapsed ? fullGenome / elapsed : 0.0;
+  return os << statistics.fragments_ << " fragments, " << statistics.onTarget_ << " on target (" << std::fixed
+            << std::setprecision(2) << fraction << "%), estimated speedup " << speedup << "x";
+}
+
 }  // namespace align
 }  // namespace dragenos
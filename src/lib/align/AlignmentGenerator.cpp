@@ -143,10 +143,10 @@ bool AlignmentGenerator::generateAlignment(
                                        : seedChain.firstReadBase()));  //10;//1;
   static constexpr size_t forcedHorizontalMotion = smithWaterman_.width;
   // initialize the query from the base and the orientation of the seedChain
-  const auto& query = read.getBases();
-  int         move  = 0;
-  std::string operations;
-  FlagType    flags = !read.getPosition() ? Alignment::FIRST_IN_TEMPLATE : Alignment::LAST_IN_TEMPLATE;
+  const auto&  query      = read.getBases();
+  int          move       = 0;
+  std::string& operations = operations_;
+  FlagType     flags      = !read.getPosition() ? Alignment::FIRST_IN_TEMPLATE : Alignment::LAST_IN_TEMPLATE;
   {
     ScoreType scoreSW;
 
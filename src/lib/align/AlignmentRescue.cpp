@@ -13,6 +13,9 @@
  **/
 
 #include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include <boost/assert.hpp>
 #include <iomanip>
 
@@ -46,7 +49,7 @@ uint32_t AlignmentRescue::getReferenceInterval(
     const SeedChain&                    anchoredChain,
     const int                           rescuedReadLength,
     const reference::ReferenceSequence& reference,
-    std::vector<unsigned char>&         referenceBases,
+    ReferenceBases&                     referenceBases,
     const bool /*second*/) const
 {
   typedef map::SeedPosition::ReferencePosition ReferencePosition;
@@ -136,7 +139,7 @@ bool AlignmentRescue::scan(
 {
   rescuedChain.clear();
 
-  std::vector<unsigned char> referenceBases;
+  ReferenceBases referenceBases;
   if (((pe_orientation_ == Orientation::pe_orient_fr_c) ||
        (pe_orientation_ == Orientation::pe_orient_rf_c))) {
     // get the rescue reference interval
@@ -165,7 +168,7 @@ bool AlignmentRescue::scan(
     // the offsets that give the least number of mismatches for each kmer
     int bestOffsets[] = {scanLength, scanLength};
     int bestCounts[]  = {rescueKmers[0].size(), rescueKmers[1].size()};
-    const std::vector<unsigned char>::const_iterator startIterators[] = {
+    const ReferenceBases::const_iterator startIterators[] = {
         referenceBases.begin(), referenceBases.end() - scanLength - rescueKmers[1].size() - modOffset};
     bool conflict = false;
 
@@ -173,52 +176,31 @@ bool AlignmentRescue::scan(
     //   std::cerr << "referenceBases.size(): " << referenceBases.size() << ", scanLength=" << scanLength
     //           << ", rescueKmers[1].size()=" << rescueKmers[1].size() << std::endl;
 
-    __m128i kmer1_m = loadRescueKmer(rescueKmers[0]);
-    __m128i kmer2_m = loadRescueKmer(rescueKmers[1]);
-
-    __m128i refkmer1_m = loadRefKmer(startIterators[0], rescueKmers[0].size());
-    __m128i refkmer2_m = loadRefKmer(startIterators[1], rescueKmers[0].size());
-
-    for (int i = 0; scanLength > i; ++i) {
-      // get the number of mismatches for both kmer
-      //    const int mismatchCounts[] = {
-      //        countMismatches(rescueKmers[0], startIterators[0] + i),
-      //        countMismatches(rescueKmers[1], startIterators[1] + i)};
-
-      // count matches = compare with &, then popcount
-      __m128i comparek1 = _mm_and_si128(refkmer1_m, kmer1_m);
-      __m128i comparek2 = _mm_and_si128(refkmer2_m, kmer2_m);
-      int     nbmis0    = rescueKmers[0].size() - popcnt128(comparek1);
-      int     nbmis1    = rescueKmers[1].size() - popcnt128(comparek2);
-
-      const int mismatchCounts[] = {nbmis0, nbmis1};
-
-      // update best counts and best offsets
+    // scan the offsets by blocks, then update the best counts and offsets in order
+    std::array<std::array<int, SCAN_BLOCK>, 2> mismatchCounts;
+    for (int block = 0; scanLength > block; block += SCAN_BLOCK) {
+      const int blockLength = std::min(SCAN_BLOCK, scanLength - block);
       for (int j = 0; j != 2; ++j) {
-        if (bestCounts[j] > mismatchCounts[j] or
-            (bestCounts[j] == mismatchCounts[j] and i <= scanLength / 2)) {
-          // flag a conflic if the kmer maps at multiple locations
-          conflict |= (bestCounts[j] <= RESCUE_MAX_SNPS);
-          bestCounts[j]  = mismatchCounts[j];
-          bestOffsets[j] = i;
+        if (SCAN_BLOCK == blockLength) {
+          scanMismatchesBlock(rescueKmers[j], startIterators[j] + block, mismatchCounts[j].data());
+        } else {
+          scanMismatches(rescueKmers[j], startIterators[j] + block, blockLength, mismatchCounts[j].data());
         }
       }
-      // if (log) std::cerr << i << '\t' << mismatchCounts[0] << ":" << mismatchCounts[1] << " - " << bestCounts[0] << ":" << bestCounts[1] << " - " << bestOffsets[0] << ":" << bestOffsets[1] << std::endl;
-
-      unsigned char newBase;
-      // shift kmer window on reference by one base : shift left vector 4 bits and insert new base
-      refkmer1_m = mm_bitshift_left4(refkmer1_m);
-      newBase    = *(startIterators[0] + rescueKmers[0].size() - 1 + i + 1);
-      if (newBase == 0xF) newBase = 0;
-      __m128i newBase_m = _mm_setr_epi8(newBase, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
-      refkmer1_m        = _mm_or_si128(refkmer1_m, newBase_m);
-
-      // idem for second kmer
-      refkmer2_m = mm_bitshift_left4(refkmer2_m);
-      newBase    = *(startIterators[1] + rescueKmers[0].size() - 1 + i + 1);
-      if (newBase == 0xF) newBase = 0;
-      newBase_m  = _mm_setr_epi8(newBase, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
-      refkmer2_m = _mm_or_si128(refkmer2_m, newBase_m);
+
+      for (int i = block; block + blockLength > i; ++i) {
+        // update best counts and best offsets
+        for (int j = 0; j != 2; ++j) {
+          const int mismatchCount = mismatchCounts[j][i - block];
+          if (bestCounts[j] > mismatchCount or (bestCounts[j] == mismatchCount and i <= scanLength / 2)) {
+            // flag a conflic if the kmer maps at multiple locations
+            conflict |= (bestCounts[j] <= RESCUE_MAX_SNPS);
+            bestCounts[j]  = mismatchCount;
+            bestOffsets[j] = i;
+          }
+        }
+        // if (log) std::cerr << i << '\t' << mismatchCounts[0][i - block] << ":" << mismatchCounts[1][i - block] << " - " << bestCounts[0] << ":" << bestCounts[1] << " - " << bestOffsets[0] << ":" << bestOffsets[1] << std::endl;
+      }
     }
 
     // flag a conflict and adjust the best offset if they are on different diagonals
@@ -276,8 +258,7 @@ bool AlignmentRescue::scan(
   return false;
 }
 
-int AlignmentRescue::countMismatches(
-    const RescueKmer& rescueKmer, const std::vector<unsigned char>::const_iterator position) const
+int AlignmentRescue::countMismatches(const RescueKmer& rescueKmer, const ReferenceBases::const_iterator position) const
 {
   //for (int i = 0; i < rescueKmer.size() ; ++i) std::cerr << " " << (int)rescueKmer[i] << ":" << (int)(*(position + i));
   //std::cerr << std::endl;
@@ -298,6 +279,60 @@ int AlignmentRescue::countMismatches(
   return count;
 }
 
+void AlignmentRescue::scanMismatches(
+    const RescueKmer&              rescueKmer,
+    ReferenceBases::const_iterator refIter,
+    const int                      count,
+    int*                           mismatchCounts) const
+{
+  const __m128i kmer_m    = loadRescueKmer(rescueKmer);
+  __m128i       refkmer_m = loadRefKmer(refIter, rescueKmer.size());
+  for (int i = 0; count > i; ++i) {
+    // count matches = compare with &, then popcount
+    const __m128i compare = _mm_and_si128(refkmer_m, kmer_m);
+    mismatchCounts[i]     = rescueKmer.size() - popcnt128(compare);
+    if (count == i + 1) {
+      break;
+    }
+    // shift kmer window on reference by one base : shift left vector 4 bits and insert new base
+    refkmer_m             = mm_bitshift_left4(refkmer_m);
+    unsigned char newBase = *(refIter + rescueKmer.size() + i);
+    if (newBase == 0xF) newBase = 0;
+    refkmer_m = _mm_or_si128(refkmer_m, _mm_setr_epi8(newBase, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+  }
+}
+
+void AlignmentRescue::scanMismatchesBlock(
+    const RescueKmer&              rescueKmer,
+    ReferenceBases::const_iterator refIter,
+    int*                           mismatchCounts) const
+{
+#ifdef __AVX2__
+  static_assert(32 == SCAN_BLOCK, "one AVX2 vector per block");
+  // number of bits set in each nibble value
+  const __m256i popcount4 =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i        n       = _mm256_set1_epi8(0xF);
+  const unsigned char* ref     = &*refIter;
+  __m256i              matches = _mm256_setzero_si256();
+  for (size_t k = 0; rescueKmer.size() != k; ++k) {
+    // reference bases aligned with base k of the kmer for the SCAN_BLOCK offsets - Ns never match
+    __m256i refBases = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ref + k));
+    refBases         = _mm256_andnot_si256(_mm256_cmpeq_epi8(refBases, n), refBases);
+    const __m256i compare = _mm256_and_si256(refBases, _mm256_set1_epi8(rescueKmer[k]));
+    // at most 4 bits per base, 32 bases: no overflow in 8 bits
+    matches = _mm256_add_epi8(matches, _mm256_shuffle_epi8(popcount4, compare));
+  }
+  std::array<unsigned char, SCAN_BLOCK> matchCounts;
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(matchCounts.data()), matches);
+  for (int i = 0; SCAN_BLOCK > i; ++i) {
+    mismatchCounts[i] = rescueKmer.size() - matchCounts[i];
+  }
+#else
+  scanMismatches(rescueKmer, refIter, SCAN_BLOCK, mismatchCounts);
+#endif
+}
+
 __m128i AlignmentRescue::loadRescueKmer(AlignmentRescue::RescueKmer rescueKmer) const
 {
   // left most base on kmer =  highest address in vector
@@ -320,7 +355,7 @@ __m128i AlignmentRescue::loadRescueKmer(AlignmentRescue::RescueKmer rescueKmer)
 }
 
 // load kmer from reference into mm128 vector, and set all non ATCG to 0
-__m128i AlignmentRescue::loadRefKmer(std::vector<unsigned char>::const_iterator refIter, size_t size) const
+__m128i AlignmentRescue::loadRefKmer(ReferenceBases::const_iterator refIter, size_t size) const
 {
   std::array<unsigned char, 16> kmer_packed;
 
@@ -363,7 +398,7 @@ std::array<AlignmentRescue::RescueKmer, 2> AlignmentRescue::getRescueKmers(
 
 bool AlignmentRescue::findRescueChain(
     const Read& /*rescuedRead*/,
-    const std::vector<unsigned char>& /*referenceBases*/,
+    const ReferenceBases& /*referenceBases*/,
     SeedChain& /*rescuedChain*/) const
 {
   return false;
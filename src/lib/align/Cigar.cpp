@@ -424,95 +424,5 @@ void Cigar::softClipsToHardClips()
   }
 }
 
-uint32_t SerializedCigar::getReferenceLength() const
-{
-  std::size_t ret = 0;
-  for (const auto& op : boost::make_iterator_range(operations_, operations_ + cigarLength_)) {
-    if (op.first == Cigar::ALIGNMENT_MATCH || op.first == Cigar::DELETE || op.first == Cigar::SKIP
-        /* || op.first == SEQUENCE_MATCH || op.first == SEQUENCE_MISMATCH*/) {
-      ret += op.second;
-    }
-  }
-
-  return ret;
-}
-
-//--------------------------------------------------------------------------------adam
-// Count how many hard or soft clips are at the start of the cigar
-//
-int SerializedCigar::countStartClips() const
-{
-  int rv = 0;
-
-  for (const auto& op : boost::make_iterator_range(operations_, operations_ + cigarLength_)) {
-    if (op.first != Cigar::SOFT_CLIP && op.first != Cigar::HARD_CLIP) {
-      break;
-    }
-    rv += op.second;
-  }
-
-  return rv;
-}
-
-//--------------------------------------------------------------------------------adam
-// Count how many hard or soft clips are at the start of the cigar
-//
-int SerializedCigar::countStartHardClips() const
-{
-  int rv = 0;
-
-  for (const auto& op : boost::make_iterator_range(operations_, operations_ + cigarLength_)) {
-    if (op.first != Cigar::HARD_CLIP) {
-      break;
-    }
-    rv += op.second;
-  }
-
-  return rv;
-}
-
-//--------------------------------------------------------------------------------adam
-// Count how many hard or soft clips are at the end of the cigar
-//
-int SerializedCigar::countEndClips() const
-{
-  int rv = 0;
-
-  for (int32_t i = cigarLength_ - 1; i >= 0; --i) {
-    const auto& op = operations_[i];
-
-    if (op.first != Cigar::SOFT_CLIP && op.first != Cigar::HARD_CLIP) {
-      break;
-    }
-    rv += op.second;
-  }
-
-  return rv;
-}
-
-int SerializedCigar::countEndHardClips() const
-{
-  int rv = 0;
-
-  for (int32_t i = cigarLength_ - 1; i >= 0; --i) {
-    const auto& op = operations_[i];
-
-    if (op.first != Cigar::HARD_CLIP) {
-      break;
-    }
-    rv += op.second;
-  }
-
-  return rv;
-}
-
-//--------------------------------------------------------------------------------adam
-// return the equivalent of GetReferenceLength() + CountEndClips()
-//
-int SerializedCigar::getReferenceLengthPlusEndClips() const
-{
-  return getReferenceLength() + countEndClips();
-}
-
 }  // namespace align
 }  // namespace dragenos
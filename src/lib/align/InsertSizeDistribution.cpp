@@ -14,10 +14,13 @@
 
 #include "align/InsertSizeDistribution.hpp"
 
+#include <cassert>
+
 namespace dragenos {
 namespace align {
 
 InsertSizeDistribution::InsertSizeDistribution(
+    uint16_t      readGroupIndex,
     bool          samplingEnabled,
     int           alignerPeq25,
     int           alignerPeq50,
@@ -40,7 +43,7 @@ InsertSizeDistribution::InsertSizeDistribution(
     std::ostream& logStream)
   : samplingEnabled_(samplingEnabled),
     dragenInsertStats_(
-        0,                        // read group index
+        readGroupIndex,           // read group index
         false,                    // true for RNA, false for DNA
         peStatsContinuousUpdate,  // whether to update stats continuously
         peStatsUpdateLogOnly,     // whether updates should just be logged, or also applied to input reads
@@ -107,11 +110,10 @@ InsertSizeParameters InsertSizeDistribution::getInsertSizeParameters(std::size_t
   return ret;
 }
 
-void InsertSizeDistribution::add(
-    const align::SerializedAlignment& aln, const dragenos::sequences::SerializedRead& read)
+void InsertSizeDistribution::add(const RecordSummary& record)
 {
   if (samplingEnabled_) {
-    const DbamHeader dbh(aln, read);
+    const DbamHeader dbh(record);
     dragenInsertStats_.sample(&dbh);
   }
 }
@@ -122,5 +124,19 @@ void InsertSizeDistribution::forceInitDoneSending()
   dragenInsertStats_.checkForInitComplete();
 }
 
+void InsertSizeDistribution::saveFixed(std::ostream& os) const
+{
+  assert(isFixed());
+  if (samplingEnabled_) {
+    dragenInsertStats_.saveFixedStats(os);
+  }
+}
+
+bool InsertSizeDistribution::restoreFixed(std::istream& is)
+{
+  // without sampling the parameters come from the options
+  return !samplingEnabled_ || dragenInsertStats_.restoreFixedStats(is);
+}
+
 }  // namespace align
 }  // namespace dragenos
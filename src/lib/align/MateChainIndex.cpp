@@ -0,0 +1,100 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "align/MateChainIndex.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace dragenos {
+namespace align {
+
+void MateChainIndex::build(
+    const sequences::ReadPair& readPair,
+    const map::ChainBuilder&   chains,
+    const std::size_t          count,
+    const bool                 exhaustive)
+{
+  count_   = count;
+  indexed_ = !exhaustive && (MIN_INDEXED_CHAINS <= count_);
+  entries_[0].clear();
+  entries_[1].clear();
+  if (!indexed_) {
+    return;
+  }
+  maxEndOffset_.fill(std::numeric_limits<int64_t>::min());
+  for (unsigned i = 0; count_ > i; ++i) {
+    const map::SeedChain& chain = chains.at(i);
+    // same as pairMatch: the effective positions of the mate are computed with the first read
+    const std::pair<int, int> effBegEnd = calculateEffBegEnd(readPair[0], chain);
+    const int                 rc        = chain.isReverseComplement();
+    entries_[rc].push_back(Entry{effBegEnd.first, effBegEnd.second, i});
+    maxEndOffset_[rc] = std::max(maxEndOffset_[rc], int64_t(effBegEnd.second) - effBegEnd.first);
+  }
+  std::sort(entries_[0].begin(), entries_[0].end());
+  std::sort(entries_[1].begin(), entries_[1].end());
+}
+
+void MateChainIndex::appendRange(
+    const std::vector<Entry>& entries,
+    const PairMatchWindow&    window,
+    const int64_t             minBeg,
+    const int64_t             maxBeg,
+    std::vector<unsigned>&    candidates)
+{
+  const auto begin = std::lower_bound(
+      entries.begin(), entries.end(), minBeg, [](const Entry& e, const int64_t v) { return e.effBeg_ < v; });
+  for (auto it = begin; entries.end() != it && maxBeg >= it->effBeg_; ++it) {
+    if (window.contains(it->effBeg_, it->effEnd_)) {
+      candidates.push_back(it->chain_);
+    }
+  }
+}
+
+void MateChainIndex::getCandidates(
+    const InsertSizeParameters& insertSizeParameters,
+    const sequences::ReadPair&  readPair,
+    const map::SeedChain&       first,
+    std::vector<unsigned>&      candidates) const
+{
+  if (!indexed_) {
+    for (unsigned i = 0; count_ > i; ++i) {
+      candidates.push_back(i);
+    }
+    return;
+  }
+  const PairMatchWindow     window  = getPairMatchWindow(insertSizeParameters, readPair, first);
+  const std::vector<Entry>& entries = entries_[window.mateReverseComplement_];
+  if (entries.empty()) {
+    return;
+  }
+  // effEnd >= minEnd implies effBeg >= minEnd - maxEndOffset
+  const int64_t endMinBeg = int64_t(window.minEnd_) - maxEndOffset_[window.mateReverseComplement_];
+  const int64_t endMaxBeg = window.maxEnd_;
+  if ((endMinBeg > window.maxBeg_) || (endMaxBeg < window.minBeg_)) {
+    appendRange(entries, window, window.minBeg_, window.maxBeg_, candidates);
+    appendRange(entries, window, endMinBeg, endMaxBeg, candidates);
+  } else {
+    // overlapping ranges: scan them at once to avoid duplicates
+    appendRange(
+        entries,
+        window,
+        std::min<int64_t>(window.minBeg_, endMinBeg),
+        std::max<int64_t>(window.maxBeg_, endMaxBeg),
+        candidates);
+  }
+}
+
+}  // namespace align
+}  // namespace dragenos
@@ -0,0 +1,207 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "align/MethylationCaller.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+
+#include "common/Exceptions.hpp"
+
+namespace dragenos {
+namespace align {
+
+const std::string MethylationCaller::CT_CONVERTED_SUFFIX = "_CT_converted";
+const std::string MethylationCaller::GA_CONVERTED_SUFFIX = "_GA_converted";
+
+namespace {
+
+constexpr unsigned char C = 2;
+constexpr unsigned char G = 4;
+constexpr unsigned char T = 8;
+
+bool endsWith(const std::string& name, const std::string& suffix)
+{
+  return (name.size() > suffix.size()) && (0 == name.compare(name.size() - suffix.size(), suffix.size(), suffix));
+}
+
+bool isAcgt(const unsigned char base)
+{
+  return (1 == base) || (C == base) || (G == base) || (T == base);
+}
+
+/// lower case context of a C followed by next and afterNext, where partner is the G of a CpG on that strand
+char getContext(const unsigned char next, const unsigned char afterNext, const unsigned char partner)
+{
+  if (partner == next) {
+    return 'z';
+  }
+  if (!isAcgt(next)) {
+    return 'u';
+  }
+  if (partner == afterNext) {
+    return 'x';
+  }
+  return isAcgt(afterNext) ? 'h' : 'u';
+}
+
+template <typename OutputIt>
+OutputIt appendString(OutputIt out, const char* string)
+{
+  return std::copy(string, string + std::strlen(string), out);
+}
+
+}  // namespace
+
+MethylationCaller::MethylationCaller(
+    const reference::HashtableConfig& hashtableConfig, const reference::ReferenceSequence& referenceSequence)
+  : referenceSequence_(referenceSequence)
+{
+  const auto& sequences = hashtableConfig.getSequences();
+  // offsets of the C->T and G->A converted sequences, by original name
+  std::map<std::string, std::array<int, 2>> conversions;
+  for (std::size_t offset = 0; sequences.size() > offset; ++offset) {
+    const std::string& name = hashtableConfig.getSequenceName(offset);
+    if (!endsWith(name, CT_CONVERTED_SUFFIX) && !endsWith(name, GA_CONVERTED_SUFFIX)) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Methylation requires the hashtable built with --ht-methylated. Unexpected sequence: " + name));
+    }
+    auto& conversion = conversions.emplace(getOriginalName(name), std::array<int, 2>{{-1, -1}}).first->second;
+    conversion[isGaConverted(name)] = offset;
+  }
+
+  sequences_.resize(sequences.size());
+  for (const auto& conversion : conversions) {
+    if ((0 > conversion.second[0]) || (0 > conversion.second[1])) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Missing C->T or G->A converted sequence in the methylated hashtable for " + conversion.first));
+    }
+    const auto& ct = sequences.at(conversion.second[0]);
+    const auto& ga = sequences.at(conversion.second[1]);
+    if ((ct.seqLen != ga.seqLen) || (ct.begTrim != ga.begTrim) || (ct.endTrim != ga.endTrim)) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Different C->T and G->A converted sequences in the methylated hashtable for " + conversion.first));
+    }
+    for (const bool gaConverted : {false, true}) {
+      // reference.bin starts with the first base after the trimmed Ns
+      sequences_[conversion.second[gaConverted]] = ConvertedSequence{
+          gaConverted,
+          ct.begTrim,
+          ct.seqLen - ct.endTrim,
+          {{ct.seqStart - ct.begTrim, ga.seqStart - ga.begTrim}}};
+    }
+  }
+}
+
+std::string MethylationCaller::getOriginalName(const std::string& sequenceName)
+{
+  for (const auto& suffix : {CT_CONVERTED_SUFFIX, GA_CONVERTED_SUFFIX}) {
+    if (endsWith(sequenceName, suffix)) {
+      return sequenceName.substr(0, sequenceName.size() - suffix.size());
+    }
+  }
+  return sequenceName;
+}
+
+bool MethylationCaller::isGaConverted(const std::string& sequenceName)
+{
+  return endsWith(sequenceName, GA_CONVERTED_SUFFIX);
+}
+
+unsigned char MethylationCaller::getOriginalBase(const ConvertedSequence& sequence, const int64_t position) const
+{
+  if ((sequence.begin_ > position) || (sequence.end_ <= position)) {
+    return 0xF;
+  }
+  // a T of the C->T conversion is a C or a T, left as they are by the G->A conversion
+  const unsigned char ctBase = referenceSequence_.getBase(sequence.origins_[0] + position);
+  return (T == ctBase) ? referenceSequence_.getBase(sequence.origins_[1] + position) : ctBase;
+}
+
+char MethylationCaller::call(const ConvertedSequence& sequence, const int64_t position, const char readBase) const
+{
+  char context      = 0;
+  bool methylated   = false;
+  bool unmethylated = false;
+  if (sequence.gaConverted_) {
+    // C of the bottom strand, with its context before it on the top strand
+    if (G != getOriginalBase(sequence, position)) {
+      return '.';
+    }
+    context =
+        getContext(getOriginalBase(sequence, position - 1), getOriginalBase(sequence, position - 2), C);
+    methylated   = ('G' == readBase);
+    unmethylated = ('A' == readBase);
+  } else {
+    if (C != getOriginalBase(sequence, position)) {
+      return '.';
+    }
+    context =
+        getContext(getOriginalBase(sequence, position + 1), getOriginalBase(sequence, position + 2), G);
+    methylated   = ('C' == readBase);
+    unmethylated = ('T' == readBase);
+  }
+  if (methylated) {
+    return std::toupper(context);
+  }
+  return unmethylated ? context : '.';
+}
+
+template <typename OutputIt>
+OutputIt MethylationCaller::appendTags(OutputIt out, const sequences::Read& read, const Alignment& alignment) const
+{
+  const ConvertedSequence& sequence = sequences_.at(alignment.getReference());
+  const auto&              bases    = read.getSequencedBases();
+  const bool               reverse  = alignment.isReverseComplement();
+  // the calls are in the order of the SEQ field, which starts after the hard clips
+  std::size_t readIndex = alignment.getCigar().countStartHardClips();
+  int64_t     position  = alignment.getPosition();
+
+  out = appendString(out, "\tXM:Z:");
+  for (const auto& operation : alignment.getCigar()) {
+    switch (operation.first) {
+    case Cigar::ALIGNMENT_MATCH:
+    case Cigar::SEQUENCE_MATCH:
+    case Cigar::SEQUENCE_MISMATCH:
+      for (unsigned i = 0; operation.second > i; ++i, ++readIndex, ++position) {
+        const char readBase = reverse ? sequences::Read::decodeRcBase(bases[bases.size() - 1 - readIndex])
+                                      : sequences::Read::decodeBase(bases[readIndex]);
+        *out++ = call(sequence, position, readBase);
+      }
+      break;
+    case Cigar::INSERT:
+    case Cigar::SOFT_CLIP:
+      out = std::fill_n(out, operation.second, '.');
+      readIndex += operation.second;
+      break;
+    case Cigar::DELETE:
+    case Cigar::SKIP:
+      position += operation.second;
+      break;
+    default:
+      break;
+    }
+  }
+  out = appendString(out, (sequences::Read::G_TO_A == read.getConversion()) ? "\tXR:Z:GA" : "\tXR:Z:CT");
+  return appendString(out, sequence.gaConverted_ ? "\tXG:Z:GA" : "\tXG:Z:CT");
+}
+
+template char* MethylationCaller::appendTags(char* out, const sequences::Read& read, const Alignment& alignment) const;
+template std::ostreambuf_iterator<char> MethylationCaller::appendTags(
+    std::ostreambuf_iterator<char> out, const sequences::Read& read, const Alignment& alignment) const;
+
+}  // namespace align
+}  // namespace dragenos
@@ -0,0 +1,218 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "align/MismatchMask.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace dragenos {
+namespace align {
+
+#ifdef __AVX2__
+namespace {
+
+/// expand 16 bytes of 4 bits packed bases into 32 bytes, one base per byte
+inline __m256i unpackBases(const __m128i packed)
+{
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  const __m128i low  = _mm_and_si128(packed, mask);
+  const __m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+  return _mm256_set_m128i(_mm_unpackhi_epi8(low, high), _mm_unpacklo_epi8(low, high));
+}
+
+/// load 32 bases from the 4 bits packed data starting at an even position
+inline __m256i loadEvenBases(const unsigned char* packed)
+{
+  return unpackBases(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packed)));
+}
+
+/// load 32 bases from the 4 bits packed data starting at the MSB of the first byte
+inline __m256i loadOddBases(const unsigned char* packed)
+{
+  const __m128i lo      = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed));
+  const __m128i hi      = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + 1));
+  const __m128i shifted = _mm_or_si128(
+      _mm_and_si128(_mm_srli_epi16(lo, 4), _mm_set1_epi8(0x0F)),
+      _mm_and_si128(_mm_slli_epi16(hi, 4), _mm_set1_epi8(char(0xF0))));
+  return unpackBases(shifted);
+}
+
+/// compare 32 bases and produce the mismatch and N masks
+inline void compareBases(const __m256i query, const __m256i reference, uint32_t& mismatches, uint32_t& ns)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i n    = _mm256_set1_epi8(0xF);
+  const __m256i nMask =
+      _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(query, zero), _mm256_cmpeq_epi8(query, n)),
+          _mm256_or_si256(_mm256_cmpeq_epi8(reference, zero), _mm256_cmpeq_epi8(reference, n)));
+  const __m256i eqOrN = _mm256_or_si256(_mm256_cmpeq_epi8(query, reference), nMask);
+  ns                  = _mm256_movemask_epi8(nMask);
+  mismatches          = ~uint32_t(_mm256_movemask_epi8(eqOrN));
+}
+
+}  // namespace
+#endif
+
+void MismatchMask::reset(size_t length)
+{
+  length_            = length;
+  const size_t words = (length + WORD_BITS - 1) / WORD_BITS;
+  mismatches_.assign(words, 0);
+  ns_.assign(words, 0);
+}
+
+void MismatchMask::count()
+{
+  mismatchCount_ = 0;
+  nCount_        = 0;
+  for (size_t w = 0; mismatches_.size() > w; ++w) {
+    mismatchCount_ += __builtin_popcountll(mismatches_[w]);
+    nCount_ += __builtin_popcountll(ns_[w]);
+  }
+}
+
+void MismatchMask::setBase(size_t i, unsigned char queryBase, unsigned char referenceBase)
+{
+  const Word bit = Word(1) << (i % WORD_BITS);
+  if (isNBase(queryBase) || isNBase(referenceBase)) {
+    ns_[i / WORD_BITS] |= bit;
+  } else if (queryBase != referenceBase) {
+    mismatches_[i / WORD_BITS] |= bit;
+  }
+}
+
+void MismatchMask::setBits(size_t i, uint32_t mismatches, uint32_t ns)
+{
+  assert(0 == i % 32);
+  const unsigned shift = i % WORD_BITS;
+  mismatches_[i / WORD_BITS] |= Word(mismatches) << shift;
+  ns_[i / WORD_BITS] |= Word(ns) << shift;
+}
+
+void MismatchMask::compare(
+    const unsigned char*                query,
+    const size_t                        length,
+    const reference::ReferenceSequence& reference,
+    const size_t                        referencePosition)
+{
+  if (reference.isPacked()) {
+    referenceBases_.resize(length);
+    reference.extractBases(referencePosition, referencePosition + length, referenceBases_.data());
+    compare(query, referenceBases_.data(), length);
+    return;
+  }
+  reference.checkPosition(referencePosition + length);
+  reset(length);
+  const unsigned char* data = reference.getData();
+  size_t               i    = 0;
+#ifdef __AVX2__
+  constexpr size_t ELEMS_AVX2 = 32;
+  if (referencePosition % 2) {
+    // the second load reads up to the byte holding the last base
+    for (; i + ELEMS_AVX2 <= length; i += ELEMS_AVX2) {
+      uint32_t      mismatches = 0;
+      uint32_t      ns         = 0;
+      const __m256i q          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query + i));
+      compareBases(q, loadOddBases(data + (referencePosition + i) / 2), mismatches, ns);
+      setBits(i, mismatches, ns);
+    }
+  } else {
+    for (; i + ELEMS_AVX2 <= length; i += ELEMS_AVX2) {
+      uint32_t      mismatches = 0;
+      uint32_t      ns         = 0;
+      const __m256i q          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query + i));
+      compareBases(q, loadEvenBases(data + (referencePosition + i) / 2), mismatches, ns);
+      setBits(i, mismatches, ns);
+    }
+  }
+#endif
+  for (; length > i; ++i) {
+    const size_t        position      = referencePosition + i;
+    const unsigned char referenceBase = (data[position / 2] >> (4 * (position % 2))) & 0xF;
+    setBase(i, query[i], referenceBase);
+  }
+  count();
+}
+
+void MismatchMask::compare(const unsigned char* query, const unsigned char* database, const size_t length)
+{
+  reset(length);
+  size_t i = 0;
+#ifdef __AVX2__
+  constexpr size_t ELEMS_AVX2 = 32;
+  for (; i + ELEMS_AVX2 <= length; i += ELEMS_AVX2) {
+    uint32_t      mismatches = 0;
+    uint32_t      ns         = 0;
+    const __m256i q          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query + i));
+    const __m256i d          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(database + i));
+    compareBases(q, d, mismatches, ns);
+    setBits(i, mismatches, ns);
+  }
+#endif
+  for (; length > i; ++i) {
+    setBase(i, query[i], database[i]);
+  }
+  count();
+}
+
+unsigned MismatchMask::countMismatches(const size_t begin, const size_t end) const
+{
+  assert(begin <= end);
+  assert(end <= length_);
+  unsigned ret = 0;
+  for (size_t i = begin; end > i;) {
+    const size_t   w     = i / WORD_BITS;
+    const unsigned first = i % WORD_BITS;
+    const unsigned last  = std::min<size_t>(WORD_BITS, first + (end - i));
+    Word           bits  = mismatches_[w] >> first;
+    if (last - first < WORD_BITS) {
+      bits &= (Word(1) << (last - first)) - 1;
+    }
+    ret += __builtin_popcountll(bits);
+    i += last - first;
+  }
+  return ret;
+}
+
+bool MismatchMask::hasBurst(const unsigned window, const unsigned minimum) const
+{
+  if (0 == minimum) {
+    return 0 < length_;
+  }
+  // the SNP count only increases on mismatches and Ns, which is where the check is needed
+  unsigned nCount = 0;
+  for (size_t w = 0; mismatches_.size() > w; ++w) {
+    Word snps = mismatches_[w] | ns_[w];
+    while (snps) {
+      const unsigned bit = __builtin_ctzll(snps);
+      snps &= snps - 1;
+      const size_t i = w * WORD_BITS + bit;
+      nCount += (ns_[w] >> bit) & 1;
+      const size_t windowBegin = (i + 1 > window) ? i + 1 - window : 0;
+      if (minimum <= nCount + countMismatches(windowBegin, i + 1)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace align
+}  // namespace dragenos
@@ -12,6 +12,8 @@
  **
  **/
 
+#include "align/Pairs.hpp"
+
 #include "align/AlignmentRescue.hpp"
 #include "align/PairBuilder.hpp"
 #include "align/Tlen.hpp"
@@ -36,11 +38,10 @@ std::pair<int, int> calculateEffBegEnd(const sequences::Read& read, const map::S
   }
 }
 
-bool pairMatch(
+PairMatchWindow getPairMatchWindow(
     const InsertSizeParameters& insertSizeParameters,
     const sequences::ReadPair&  readPair,
-    const map::SeedChain&       first,
-    const map::SeedChain&       second)
+    const map::SeedChain&       first)
 {
   using Orientation = InsertSizeParameters::Orientation;
   bool end1_pair_rc = false;
@@ -101,22 +102,22 @@ bool pairMatch(
     break;
   }
 
+  return PairMatchWindow{end1_pair_rc, end1_pair_min_beg, end1_pair_max_beg, end1_pair_min_end, end1_pair_max_end};
+}
+
+bool pairMatch(
+    const InsertSizeParameters& insertSizeParameters,
+    const sequences::ReadPair&  readPair,
+    const map::SeedChain&       first,
+    const map::SeedChain&       second)
+{
+  const PairMatchWindow     window         = getPairMatchWindow(insertSizeParameters, readPair, first);
   const std::pair<int, int> r2_eff_beg_end = calculateEffBegEnd(readPair[0], second);
 
   //  -- Pair match if orientation as expected, and either the effective beginning or end is in the expected
   //  inteval
-  const bool pair_match =
-      !(end1_pair_rc ^ second.isReverseComplement()) &&
-      (((r2_eff_beg_end.first >= end1_pair_min_beg) && (r2_eff_beg_end.first <= end1_pair_max_beg)) ||
-       ((r2_eff_beg_end.second >= end1_pair_min_end) && (r2_eff_beg_end.first <= end1_pair_max_end)));
-
-  //    std::cerr << "end1_pair_rc:" << end1_pair_rc << " second.isReverseComplement():" << second.isReverseComplement() <<
-  //      " pipe3_eff_beg:" << r2_eff_beg_end.first << " pipe3_eff_end:" << r2_eff_beg_end.second <<
-  //      " end1_pair_min_beg:" << end1_pair_min_beg << " end1_pair_max_beg:" << end1_pair_max_beg <<
-  //      " end1_pair_min_end:" << end1_pair_min_end << " end1_pair_max_end:" << end1_pair_max_end <<
-  //      " pair_match:" << pair_match <<
-  //      (((r2_eff_beg_end.first >= end1_pair_min_beg) && (r2_eff_beg_end.first <= end1_pair_max_beg)) ? " yes" : " no") <<
-  //      (((r2_eff_beg_end.second >= end1_pair_min_end) && (r2_eff_beg_end.first <= end1_pair_max_end)) ? " yes" : " no") << std::endl;
+  const bool pair_match = !(window.mateReverseComplement_ ^ second.isReverseComplement()) &&
+                          window.contains(r2_eff_beg_end.first, r2_eff_beg_end.second);
 
   //  if (pair_match)
   //  {
@@ -181,7 +181,8 @@ TEST(Aligner, updateMapqSingleEnded1XRepeat)
 
 TEST(Aligner, isPerfectAlignment)
 {
-  dragenos::align::Alignment alignment;
+  dragenos::align::Alignment    alignment;
+  dragenos::align::MismatchMask mismatchMask;
   using dragenos::align::Aligner;
   constexpr char A   = 1;
   constexpr char C   = 2;
@@ -191,11 +192,15 @@ TEST(Aligner, isPerfectAlignment)
   char           q[] = {N, A, C, G, T, A, A, C, C, G, G, T, T};
   char           d[] = {N, A, C, G, T, A, A, C, C, G, G, T, T};
   // both empty
-  ASSERT_FALSE(Aligner::isPerfectAlignment(q, q, d, d, alignment));
+  ASSERT_FALSE(Aligner::isPerfectAlignment(q, q, d, d, mismatchMask, alignment));
   // different lengths
-  ASSERT_FALSE(Aligner::isPerfectAlignment(q + 1, q + 2, d + 1, d + 3, alignment));
-  ASSERT_FALSE(Aligner::isPerfectAlignment(q + 1, q + 3, d + 1, d + 2, alignment));
+  ASSERT_FALSE(Aligner::isPerfectAlignment(q + 1, q + 2, d + 1, d + 3, mismatchMask, alignment));
+  ASSERT_FALSE(Aligner::isPerfectAlignment(q + 1, q + 3, d + 1, d + 2, mismatchMask, alignment));
   // ok
-  ASSERT_TRUE(Aligner::isPerfectAlignment(q + 1, q + 3, d + 1, d + 3, alignment));
+  ASSERT_TRUE(Aligner::isPerfectAlignment(q + 1, q + 3, d + 1, d + 3, mismatchMask, alignment));
   ASSERT_EQ(alignment.getScore(), 2);
+  // same outcome without the alignment
+  ASSERT_EQ(0, Aligner::getPerfectAlignmentScore(q, q, d, d, mismatchMask));
+  ASSERT_EQ(0, Aligner::getPerfectAlignmentScore(q + 1, q + 2, d + 1, d + 3, mismatchMask));
+  ASSERT_EQ(2, Aligner::getPerfectAlignmentScore(q + 1, q + 3, d + 1, d + 3, mismatchMask));
 }
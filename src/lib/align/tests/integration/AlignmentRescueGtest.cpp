@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "align/AlignmentRescue.hpp"
+
+using dragenos::align::AlignmentRescue;
+typedef dragenos::align::InsertSizeParameters::Orientation Orientation;
+
+namespace {
+
+AlignmentRescue::ReferenceBases randomBases(std::mt19937& gen, size_t length)
+{
+  // mostly ACGT with the occasional N, padding and IUPAC code
+  static const std::array<unsigned char, 13> bases{1, 2, 4, 8, 1, 2, 4, 8, 1, 2, 0xF, 0, 5};
+  AlignmentRescue::ReferenceBases            ret(length);
+  for (auto& b : ret) {
+    b = bases[gen() % bases.size()];
+  }
+  return ret;
+}
+
+// mismatches as counted by the 4 bits AND of the packed kmers: Ns on the reference never match
+int countMatchMismatches(const AlignmentRescue::RescueKmer& kmer, const unsigned char* ref)
+{
+  int matches = 0;
+  for (size_t k = 0; kmer.size() != k; ++k) {
+    const unsigned char r = (0xF == ref[k]) ? 0 : ref[k];
+    matches += __builtin_popcount(r & kmer[k]);
+  }
+  return kmer.size() - matches;
+}
+
+}  // namespace
+
+TEST(AlignmentRescue, scanMismatchesBlock)
+{
+  const AlignmentRescue alignmentRescue(0, 500, Orientation::pe_orient_fr_c);
+  std::mt19937          gen(11);
+  for (int iteration = 0; 200 > iteration; ++iteration) {
+    auto                        reference = randomBases(gen, 200);
+    AlignmentRescue::RescueKmer kmer;
+    const auto                  kmerBases = randomBases(gen, kmer.size());
+    std::copy(kmerBases.begin(), kmerBases.end(), kmer.begin());
+    // plant the kmer with a few mismatches to get low counts too
+    const size_t planted = gen() % (reference.size() - kmer.size());
+    for (size_t k = 0; kmer.size() != k; ++k) {
+      if (gen() % 8) {
+        reference[planted + k] = kmer[k];
+      }
+    }
+
+    const int        count = reference.size() - kmer.size() - AlignmentRescue::SCAN_BLOCK;
+    std::vector<int> expected(count);
+    alignmentRescue.scanMismatches(kmer, reference.begin(), count, expected.data());
+    for (int i = 0; count > i; ++i) {
+      ASSERT_EQ(countMatchMismatches(kmer, reference.data() + i), expected[i]) << "offset: " << i;
+    }
+    for (int i = 0; count > i; ++i) {
+      std::array<int, AlignmentRescue::SCAN_BLOCK> block;
+      alignmentRescue.scanMismatchesBlock(kmer, reference.begin() + i, block.data());
+      for (int j = 0; AlignmentRescue::SCAN_BLOCK > j && count > i + j; ++j) {
+        ASSERT_EQ(expected[i + j], block[j]) << "offset: " << i << " + " << j;
+      }
+    }
+  }
+}
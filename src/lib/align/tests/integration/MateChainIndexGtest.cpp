@@ -0,0 +1,142 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "align/MateChainIndex.hpp"
+#include "align/Pairs.hpp"
+
+using namespace dragenos;
+typedef sequences::Read             Read;
+typedef sequences::ReadPair         ReadPair;
+typedef align::InsertSizeParameters InsertSizeParameters;
+typedef InsertSizeParameters::Orientation Orientation;
+
+namespace {
+
+void initRead(Read& read, const unsigned length, const unsigned position)
+{
+  const std::string name      = "read";
+  const std::string bases     = std::string(length, 'A');
+  const std::string qualities = std::string(length, 'E');
+  read.init(
+      Read::Name(name.begin(), name.end()),
+      Read::Bases(bases.begin(), bases.end()),
+      Read::Qualities(qualities.begin(), qualities.end()),
+      0,
+      position);
+}
+
+map::SeedChain randomChain(std::mt19937& gen, const Read& read, const uint32_t referencePosition)
+{
+  map::SeedChain chain;
+  chain.setReverseComplement(gen() % 2);
+  // a few seeds along the diagonal, with the occasional indel
+  const unsigned seedCount = 1 + gen() % 4;
+  for (unsigned i = 0; seedCount > i; ++i) {
+    const unsigned readPosition = i * 40;
+    const uint32_t indel        = gen() % 3;
+    chain.addSeedPosition(
+        map::SeedPosition(sequences::Seed(&read, readPosition, 21), referencePosition + readPosition + indel, 0),
+        false);
+  }
+  return chain;
+}
+
+}  // namespace
+
+TEST(MateChainIndex, sameAsPairMatch)
+{
+  ReadPair readPair;
+  initRead(readPair[0], 151, 0);
+  initRead(readPair[1], 151, 1);
+  std::mt19937 gen(17);
+
+  for (const auto orientation :
+       {Orientation::pe_orient_fr_c, Orientation::pe_orient_rf_c, Orientation::pe_orient_ff_c}) {
+    const InsertSizeParameters insertSizeParameters(200, 600, 400, 100, 800, 50.0, orientation);
+    for (int iteration = 0; 20 > iteration; ++iteration) {
+      // both small and indexed chain counts, clustered to get plenty of pairs, some close to 0
+      std::array<map::ChainBuilder, 2> chains{map::ChainBuilder(4.0), map::ChainBuilder(4.0)};
+      const unsigned                   chainCount = 1 + gen() % 60;
+      for (unsigned r = 0; 2 > r; ++r) {
+        for (unsigned i = 0; chainCount > i; ++i) {
+          const uint32_t position = (iteration % 2) ? gen() % 3000 : 1000000 + gen() % 3000;
+          chains[r].addSeedChain(randomChain(gen, readPair[r], position));
+        }
+      }
+
+      align::MateChainIndex index;
+      index.build(readPair, chains[1], chains[1].size());
+      for (unsigned i0 = 0; chains[0].size() > i0; ++i0) {
+        std::vector<unsigned> candidates;
+        index.getCandidates(insertSizeParameters, readPair, chains[0].at(i0), candidates);
+        std::vector<unsigned> sorted(candidates);
+        std::sort(sorted.begin(), sorted.end());
+        ASSERT_EQ(sorted.end(), std::unique(sorted.begin(), sorted.end()));
+
+        std::vector<unsigned> expected;
+        for (unsigned i1 = 0; chains[1].size() > i1; ++i1) {
+          if (pairMatch(insertSizeParameters, readPair, chains[0].at(i0), chains[1].at(i1))) {
+            expected.push_back(i1);
+          }
+        }
+        if (align::MateChainIndex::MIN_INDEXED_CHAINS > chains[1].size()) {
+          ASSERT_EQ(chains[1].size(), sorted.size());
+        } else {
+          ASSERT_EQ(expected, sorted) << "chain: " << i0 << " of " << chains[0].size();
+        }
+      }
+    }
+  }
+}
+
+TEST(MateChainIndex, exhaustiveWithMovingChains)
+{
+  ReadPair readPair;
+  initRead(readPair[0], 151, 0);
+  initRead(readPair[1], 151, 1);
+  std::mt19937               gen(29);
+  const InsertSizeParameters insertSizeParameters(
+      200, 600, 400, 100, 800, 50.0, Orientation::pe_orient_fr_c);
+
+  std::array<map::ChainBuilder, 2> chains{map::ChainBuilder(4.0), map::ChainBuilder(4.0)};
+  const unsigned                   chainCount = 4 * align::MateChainIndex::MIN_INDEXED_CHAINS;
+  for (unsigned r = 0; 2 > r; ++r) {
+    for (unsigned i = 0; chainCount > i; ++i) {
+      chains[r].addSeedChain(randomChain(gen, readPair[r], 1000000 + gen() % 3000));
+    }
+  }
+  align::MateChainIndex indexed;
+  indexed.build(readPair, chains[1], chains[1].size());
+  align::MateChainIndex exhaustive;
+  exhaustive.build(readPair, chains[1], chains[1].size(), true);
+
+  // as when the pairing realigns the chains of the second read after their indexing
+  for (unsigned i1 = 0; chains[1].size() > i1; i1 += 2) {
+    chains[1].at(i1) = randomChain(gen, readPair[1], 1000000 + gen() % 3000);
+  }
+  bool stale = false;
+  for (unsigned i0 = 0; chains[0].size() > i0; ++i0) {
+    std::vector<unsigned> expected;
+    for (unsigned i1 = 0; chains[1].size() > i1; ++i1) {
+      if (pairMatch(insertSizeParameters, readPair, chains[0].at(i0), chains[1].at(i1))) {
+        expected.push_back(i1);
+      }
+    }
+    std::vector<unsigned> candidates;
+    exhaustive.getCandidates(insertSizeParameters, readPair, chains[0].at(i0), candidates);
+    ASSERT_EQ(chains[1].size(), candidates.size());
+    ASSERT_TRUE(std::includes(candidates.begin(), candidates.end(), expected.begin(), expected.end()));
+
+    candidates.clear();
+    indexed.getCandidates(insertSizeParameters, readPair, chains[0].at(i0), candidates);
+    std::sort(candidates.begin(), candidates.end());
+    stale |= !std::includes(candidates.begin(), candidates.end(), expected.begin(), expected.end());
+  }
+  // the indexed enumeration misses pairs of the moved chains, which is why sw-all is exhaustive
+  ASSERT_TRUE(stale);
+}
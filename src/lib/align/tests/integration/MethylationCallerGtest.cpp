@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "align/MethylationCaller.hpp"
+#include "common/Exceptions.hpp"
+
+using namespace dragenos;
+using align::Alignment;
+using align::Cigar;
+using align::MethylationCaller;
+using reference::HashtableConfig;
+using sequences::Read;
+
+namespace {
+
+/// original reference, converted into the 2 sequences of a methylated hashtable
+const std::string ORIGINAL = "TTCGACAGTCCATGCAGTTC";
+
+std::vector<char> makeConfigData(const std::vector<std::string>& names)
+{
+  HashtableConfig::Header header;
+  std::memset(&header, 0, sizeof(header));
+  header.hashtableVersion = 8;
+  header.numRefSeqs       = names.size();
+  std::vector<char> data(sizeof(header));
+  std::memcpy(data.data(), &header, sizeof(header));
+  for (std::size_t i = 0; names.size() > i; ++i) {
+    const reference::detail::hashtableSeq_t sequence{i * ORIGINAL.size(), 0, 0, uint32_t(ORIGINAL.size())};
+    const char* const                       bytes = reinterpret_cast<const char*>(&sequence);
+    data.insert(data.end(), bytes, bytes + sizeof(sequence));
+  }
+  for (const auto& name : names) {
+    data.insert(data.end(), name.c_str(), name.c_str() + name.size() + 1);
+  }
+  // followed by the empty strings for the versions, command line and file names
+  data.resize(data.size() + 64, 0);
+  return data;
+}
+
+/// 4 bits encoding, with N as 0 as in the reads
+unsigned char encode(const char base)
+{
+  return ('A' == base) ? 1 : ('C' == base) ? 2 : ('G' == base) ? 4 : ('T' == base) ? 8 : 0;
+}
+
+/// C->T then G->A converted copies of ORIGINAL, 2 bases per byte as in reference.bin
+std::vector<unsigned char> makeReferenceData()
+{
+  std::string bases;
+  for (const char base : ORIGINAL) {
+    bases.push_back(('C' == base) ? 'T' : base);
+  }
+  for (const char base : ORIGINAL) {
+    bases.push_back(('G' == base) ? 'A' : base);
+  }
+  std::vector<unsigned char> data(bases.size() / 2, 0);
+  for (std::size_t i = 0; bases.size() > i; ++i) {
+    data[i / 2] |= encode(bases[i]) << (4 * (i % 2));
+  }
+  return data;
+}
+
+void initRead(const std::string& sequenced, const Read::Conversion conversion, Read& read)
+{
+  Read::Bases bases;
+  for (const char base : sequenced) {
+    bases.push_back(encode(base));
+  }
+  read.init(Read::Name{'r'}, std::move(bases), Read::Qualities(sequenced.size(), 30), 0, 0);
+  read.convert(conversion);
+}
+
+std::string getTags(
+    const MethylationCaller&             caller,
+    const Read&                          read,
+    const int                            reference,
+    const int                            position,
+    const bool                           reverse,
+    const std::vector<Cigar::Operation>& operations)
+{
+  Alignment alignment;
+  alignment.resetFlags(reverse ? Alignment::REVERSE_COMPLEMENT : 0);
+  alignment.setReference(reference);
+  alignment.setPosition(position);
+  alignment.cigar().clear();
+  for (const auto& operation : operations) {
+    alignment.cigar().emplace_back(operation.first, operation.second);
+  }
+  std::vector<char>  tags(MethylationCaller::getMaxTagsLength(read.getLength()));
+  const std::string  appended(tags.data(), caller.appendTags(tags.data(), read, alignment));
+  std::ostringstream os;
+  caller.appendTags(std::ostreambuf_iterator<char>(os), read, alignment);
+  // same tags written to a stream
+  EXPECT_EQ(appended, os.str());
+  return appended;
+}
+
+}  // namespace
+
+TEST(MethylationCaller, convert)
+{
+  Read read;
+  initRead("ACGTN", Read::C_TO_T, read);
+  ASSERT_EQ((Read::Bases{1, 8, 4, 8, 0}), read.getBases());
+  ASSERT_EQ((Read::Bases{1, 2, 4, 8, 0}), read.getSequencedBases());
+  ASSERT_EQ((Read::Bases{0xF, 1, 2, 1, 8}), read.getRcBases());
+  initRead("ACGTN", Read::G_TO_A, read);
+  ASSERT_EQ((Read::Bases{1, 2, 1, 8, 0}), read.getBases());
+  initRead("ACGTN", Read::NO_CONVERSION, read);
+  ASSERT_EQ(read.getBases(), read.getSequencedBases());
+  ASSERT_EQ(Read::NO_CONVERSION, read.getConversion());
+}
+
+TEST(MethylationCaller, names)
+{
+  ASSERT_EQ("chr1", MethylationCaller::getOriginalName("chr1_CT_converted"));
+  ASSERT_EQ("chr1", MethylationCaller::getOriginalName("chr1_GA_converted"));
+  ASSERT_EQ("chr1", MethylationCaller::getOriginalName("chr1"));
+  ASSERT_TRUE(MethylationCaller::isGaConverted("chr1_GA_converted"));
+  ASSERT_FALSE(MethylationCaller::isGaConverted("chr1_CT_converted"));
+
+  const std::vector<unsigned char>   data = makeReferenceData();
+  const reference::ReferenceSequence referenceSequence(
+      std::vector<reference::ReferenceSequence::Region>(), data.data(), data.size());
+  const std::vector<char> normal = makeConfigData({"chrA", "chrB"});
+  ASSERT_THROW(
+      MethylationCaller(HashtableConfig(normal.data(), normal.size()), referenceSequence),
+      common::InvalidParameterException);
+  const std::vector<char> missing = makeConfigData({"chrA_CT_converted", "chrB_GA_converted"});
+  ASSERT_THROW(
+      MethylationCaller(HashtableConfig(missing.data(), missing.size()), referenceSequence),
+      common::InvalidParameterException);
+}
+
+TEST(MethylationCaller, appendTags)
+{
+  const std::vector<char>            configData = makeConfigData({"chrA_CT_converted", "chrA_GA_converted"});
+  const HashtableConfig              config(configData.data(), configData.size());
+  const std::vector<unsigned char>   data = makeReferenceData();
+  const reference::ReferenceSequence referenceSequence(
+      std::vector<reference::ReferenceSequence::Region>(), data.data(), data.size());
+  const MethylationCaller caller(config, referenceSequence);
+
+  Read read;
+  // top strand: methylated CpG, then unmethylated CHG and CHH
+  initRead("CGATAGTTTA", Read::C_TO_T, read);
+  ASSERT_EQ(
+      "\tXM:Z:Z..x...hh.\tXR:Z:CT\tXG:Z:CT",
+      getTags(caller, read, 0, 2, false, {{Cigar::ALIGNMENT_MATCH, 10}}));
+  // with a deletion and an insertion
+  const std::vector<Cigar::Operation> indels{{Cigar::ALIGNMENT_MATCH, 6},
+                                             {Cigar::DELETE, 2},
+                                             {Cigar::ALIGNMENT_MATCH, 1},
+                                             {Cigar::INSERT, 2},
+                                             {Cigar::ALIGNMENT_MATCH, 1}};
+  ASSERT_EQ("\tXM:Z:Z..x..h...\tXR:Z:CT\tXG:Z:CT", getTags(caller, read, 0, 2, false, indels));
+  // unknown context at the end of the sequence
+  initRead("TC", Read::C_TO_T, read);
+  ASSERT_EQ("\tXM:Z:.U\tXR:Z:CT\tXG:Z:CT", getTags(caller, read, 0, 18, false, {{Cigar::ALIGNMENT_MATCH, 2}}));
+
+  // bottom strand, reverse complement of TGCAAT: methylated CHH and unmethylated CHG, after a soft clip
+  initRead("ATTGCA", Read::G_TO_A, read);
+  ASSERT_EQ(
+      "\tXM:Z:.H..x.\tXR:Z:GA\tXG:Z:GA",
+      getTags(caller, read, 1, 13, true, {{Cigar::SOFT_CLIP, 1}, {Cigar::ALIGNMENT_MATCH, 5}}));
+  // hard clipped bases are not in SEQ
+  ASSERT_EQ(
+      "\tXM:Z:H..x.\tXR:Z:GA\tXG:Z:GA",
+      getTags(caller, read, 1, 13, true, {{Cigar::HARD_CLIP, 1}, {Cigar::ALIGNMENT_MATCH, 5}}));
+}
+
+TEST(MethylationCaller, isDirectional)
+{
+  const std::vector<char>            configData = makeConfigData({"chrA_CT_converted", "chrA_GA_converted"});
+  const HashtableConfig              config(configData.data(), configData.size());
+  const std::vector<unsigned char>   data = makeReferenceData();
+  const reference::ReferenceSequence referenceSequence(
+      std::vector<reference::ReferenceSequence::Region>(), data.data(), data.size());
+  const MethylationCaller caller(config, referenceSequence);
+
+  // original top strand: first reads forward on the C->T copy, second reads reverse
+  ASSERT_TRUE(caller.isDirectional(Read::C_TO_T, false, 0));
+  ASSERT_TRUE(caller.isDirectional(Read::G_TO_A, true, 0));
+  // original bottom strand: first reads reverse on the G->A copy, second reads forward
+  ASSERT_TRUE(caller.isDirectional(Read::C_TO_T, true, 1));
+  ASSERT_TRUE(caller.isDirectional(Read::G_TO_A, false, 1));
+  // complementary strands, not in a directional library
+  ASSERT_FALSE(caller.isDirectional(Read::C_TO_T, true, 0));
+  ASSERT_FALSE(caller.isDirectional(Read::G_TO_A, false, 0));
+  ASSERT_FALSE(caller.isDirectional(Read::C_TO_T, false, 1));
+  ASSERT_FALSE(caller.isDirectional(Read::G_TO_A, true, 1));
+}
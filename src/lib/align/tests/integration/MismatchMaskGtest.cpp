@@ -0,0 +1,146 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "align/MismatchMask.hpp"
+
+using dragenos::align::MismatchMask;
+using dragenos::reference::PackedReference;
+using dragenos::reference::ReferenceSequence;
+
+namespace {
+
+bool isN(unsigned char base) { return (0 == base) || (0xF == base); }
+
+std::vector<unsigned char> randomBases(std::mt19937& gen, size_t length)
+{
+  // mostly ACGT with the occasional N and IUPAC code
+  static const std::array<unsigned char, 12> bases{1, 2, 4, 8, 1, 2, 4, 8, 1, 2, 0xF, 5};
+  std::vector<unsigned char>                 ret(length);
+  for (auto& b : ret) {
+    b = bases[gen() % bases.size()];
+  }
+  return ret;
+}
+
+std::vector<unsigned char> pack(const std::vector<unsigned char>& bases)
+{
+  std::vector<unsigned char> ret((bases.size() + 1) / 2, 0);
+  for (size_t i = 0; bases.size() > i; ++i) {
+    ret[i / 2] |= bases[i] << (4 * (i % 2));
+  }
+  return ret;
+}
+
+// straight port of the base by base burst detection in Aligner::isPerfectAlignment
+bool referenceBurst(
+    const std::vector<unsigned char>& query, const unsigned char* database, unsigned window, unsigned minimum)
+{
+  unsigned          snpCount = 0;
+  std::vector<bool> burst(window, false);
+  size_t            front = 0;
+  for (size_t i = 0; query.size() > i; ++i) {
+    snpCount -= burst[front];
+    if (isN(query[i]) || isN(database[i])) {
+      ++snpCount;
+      burst[front] = false;
+    } else if (query[i] == database[i]) {
+      burst[front] = false;
+    } else {
+      ++snpCount;
+      burst[front] = true;
+    }
+    if (minimum <= snpCount) {
+      return true;
+    }
+    front = (front + 1) % window;
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST(MismatchMask, compareUnpacked)
+{
+  std::mt19937 gen(42);
+  MismatchMask mask;
+  for (size_t length = 0; 300 > length; ++length) {
+    const auto query    = randomBases(gen, length);
+    auto       database = query;
+    for (size_t i = 0; length > i; i += 1 + gen() % 20) {
+      database[i] = randomBases(gen, 1)[0];
+    }
+    mask.compare(query.data(), database.data(), length);
+    ASSERT_EQ(length, mask.size());
+    unsigned mismatches = 0;
+    unsigned ns         = 0;
+    for (size_t i = 0; length > i; ++i) {
+      const bool n        = isN(query[i]) || isN(database[i]);
+      const bool mismatch = !n && (query[i] != database[i]);
+      ASSERT_EQ(n, mask.isN(i)) << "length: " << length << " i: " << i;
+      ASSERT_EQ(mismatch, mask.isMismatch(i)) << "length: " << length << " i: " << i;
+      mismatches += mismatch;
+      ns += n;
+    }
+    ASSERT_EQ(mismatches, mask.getMismatchCount());
+    ASSERT_EQ(ns, mask.getNCount());
+    ASSERT_EQ(
+        int(length - mismatches - ns) * 1 - 4 * int(mismatches) - int(ns), mask.getScore(1, -4, -1));
+    ASSERT_EQ(referenceBurst(query, database.data(), 8, 4), mask.hasBurst(8, 4)) << "length: " << length;
+  }
+}
+
+TEST(MismatchMask, comparePacked)
+{
+  std::mt19937               gen(17);
+  const auto                 reference = randomBases(gen, 1000);
+  const auto                 packed    = pack(reference);
+  const ReferenceSequence    referenceSequence({}, packed.data(), packed.size());
+  const PackedReference      twoBits(packed.data(), packed.size());
+  const ReferenceSequence    twoBitsSequence({}, &twoBits);
+  MismatchMask               mask;
+  for (const ReferenceSequence* sequence : {&referenceSequence, &twoBitsSequence}) {
+    for (size_t position = 0; 40 > position; ++position) {
+      for (size_t length = 0; 300 > length; length += 7) {
+        std::vector<unsigned char> query(reference.begin() + position, reference.begin() + position + length);
+        for (size_t i = 0; length > i; i += 1 + gen() % 30) {
+          query[i] = randomBases(gen, 1)[0];
+        }
+        mask.compare(query.data(), length, *sequence, position);
+        for (size_t i = 0; length > i; ++i) {
+          const unsigned char r        = reference[position + i];
+          const bool          n        = isN(query[i]) || isN(r);
+          const bool          mismatch = !n && (query[i] != r);
+          ASSERT_EQ(n, mask.isN(i)) << "position: " << position << " length: " << length << " i: " << i;
+          ASSERT_EQ(mismatch, mask.isMismatch(i))
+              << "position: " << position << " length: " << length << " i: " << i;
+        }
+      }
+    }
+    // reading beyond the end of the reference is an error
+    std::vector<unsigned char> query(10, 1);
+    ASSERT_THROW(mask.compare(query.data(), query.size(), *sequence, 995), std::exception);
+  }
+}
+
+TEST(MismatchMask, countMismatches)
+{
+  std::vector<unsigned char> query(150, 1);
+  std::vector<unsigned char> database(150, 1);
+  for (size_t i : {0, 5, 63, 64, 65, 127, 128, 149}) {
+    database[i] = 2;
+  }
+  MismatchMask mask;
+  mask.compare(query.data(), database.data(), query.size());
+  ASSERT_EQ(8u, mask.getMismatchCount());
+  ASSERT_EQ(8u, mask.countMismatches(0, 150));
+  ASSERT_EQ(0u, mask.countMismatches(1, 5));
+  ASSERT_EQ(3u, mask.countMismatches(63, 66));
+  ASSERT_EQ(2u, mask.countMismatches(60, 65));
+  ASSERT_EQ(2u, mask.countMismatches(127, 129));
+  ASSERT_EQ(1u, mask.countMismatches(149, 150));
+  ASSERT_FALSE(mask.hasBurst(8, 4));
+  ASSERT_TRUE(mask.hasBurst(8, 3));
+}
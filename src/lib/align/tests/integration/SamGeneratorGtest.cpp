@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "align/Alignment.hpp"
+#include "sam/SamGenerator.hpp"
+
+using namespace dragenos;
+typedef reference::HashtableConfig HashtableConfig;
+typedef sequences::Read            Read;
+typedef align::Alignment           Alignment;
+typedef align::Cigar               Cigar;
+
+namespace {
+
+/// config with 3 sequences, stored out of order to make the offsets differ from the ids
+std::vector<char> makeConfigData()
+{
+  HashtableConfig::Header header;
+  std::memset(&header, 0, sizeof(header));
+  header.hashtableVersion = 8;
+  header.numRefSeqs       = 3;
+  std::vector<char> data(sizeof(header));
+  std::memcpy(data.data(), &header, sizeof(header));
+  for (const uint64_t seqStart : {20000, 0, 10000}) {
+    reference::detail::hashtableSeq_t sequence;
+    std::memset(&sequence, 0, sizeof(sequence));
+    sequence.seqStart = seqStart;
+    sequence.seqLen   = 10000;
+    const char* const bytes = reinterpret_cast<const char*>(&sequence);
+    data.insert(data.end(), bytes, bytes + sizeof(sequence));
+  }
+  for (const std::string name : {"chr1", "chr2_longer_name", "chrM"}) {
+    data.insert(data.end(), name.c_str(), name.c_str() + name.size() + 1);
+  }
+  // followed by the empty strings for the versions, command line and file names
+  data.resize(data.size() + 64, 0);
+  return data;
+}
+
+void randomCigar(std::mt19937& gen, const std::size_t readLength, Cigar& cigar)
+{
+  cigar.clear();
+  const unsigned startClip = (0 == gen() % 3) ? gen() % 20 : 0;
+  const unsigned endClip   = (0 == gen() % 3) ? gen() % 20 : 0;
+  if (startClip) {
+    cigar.emplace_back((gen() % 2) ? Cigar::HARD_CLIP : Cigar::SOFT_CLIP, startClip);
+  }
+  cigar.emplace_back(Cigar::ALIGNMENT_MATCH, readLength / 2);
+  cigar.emplace_back((gen() % 2) ? Cigar::INSERT : Cigar::DELETE, 1 + gen() % 3);
+  cigar.emplace_back(Cigar::ALIGNMENT_MATCH, 123456);
+  if (endClip) {
+    cigar.emplace_back((gen() % 2) ? Cigar::HARD_CLIP : Cigar::SOFT_CLIP, endClip);
+  }
+}
+
+void randomAlignment(std::mt19937& gen, const std::size_t readLength, Alignment& alignment)
+{
+  alignment.resetFlags(gen() & 0xFFF);
+  alignment.setReference(gen() % 4 - 1);
+  alignment.setNextReference(gen() % 4 - 1);
+  alignment.setPosition(int(gen() % 20000) - 10);
+  alignment.setNextPosition(int(gen() % 20000) - 10);
+  alignment.setTemplateLength(int(gen() % 2000) - 1000);
+  alignment.mapq_ = int(gen() % 300) - 1;
+  alignment.setScore((gen() % 2) ? -1 : int(gen() % 200));
+  alignment.setXs((gen() % 2) ? align::INVALID_SCORE : int(gen() % 200) - 100);
+  alignment.setMismatchCount(int(gen() % 12) - 1);
+  if (gen() % 4) {
+    randomCigar(gen, readLength, alignment.cigar());
+  } else {
+    alignment.cigar().clear();
+  }
+}
+
+}  // namespace
+
+TEST(SamGenerator, appendRecordMatchesGenerateRecord)
+{
+  const std::vector<char>  configData = makeConfigData();
+  const HashtableConfig    config(configData.data(), configData.size());
+  const sam::SamGenerator  sam(config);
+  std::mt19937             gen(41);
+  const std::array<std::string, 3> names{"read", "read/1 with a comment", "r\t2"};
+
+  std::vector<char> buffer;
+  Read              read;
+  Alignment         alignment;
+  Alignment         sa;
+  for (unsigned i = 0; 2000 > i; ++i) {
+    // all lengths around the 32 bytes blocks, with every 4 bits value and a few invalid ones
+    const std::size_t length = gen() % 160;
+    Read::Bases       bases(length);
+    Read::Qualities   qualities(length);
+    for (std::size_t j = 0; length > j; ++j) {
+      bases[j]     = (0 == gen() % 50) ? 16 + gen() % 240 : gen() % 16;
+      qualities[j] = gen() % 42;
+    }
+    const std::string& name = names[gen() % names.size()];
+    read.init(Read::Name(name.begin(), name.end()), std::move(bases), std::move(qualities), i, 0);
+    randomAlignment(gen, length, alignment);
+    if (0 == gen() % 3) {
+      randomAlignment(gen, length, sa);
+      sa.setReference(gen() % 3);
+      alignment.setSa(&sa);
+    } else {
+      alignment.setSa(nullptr);
+    }
+    const std::string rgid = (gen() % 2) ? "1" : "sample_group";
+
+    std::ostringstream os;
+    sam.generateRecord(os, read, alignment, rgid) << "\n";
+    const std::size_t before = buffer.size();
+    sam.appendRecord(buffer, read, alignment, rgid);
+    ASSERT_EQ(os.str(), std::string(buffer.begin() + before, buffer.end())) << i;
+  }
+}
@@ -0,0 +1,226 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "api/AlignerContext.hpp"
+
+#include <iostream>
+
+#include "common/Exceptions.hpp"
+#include "workflow/alignment/AlignmentUtils.hpp"
+
+namespace dragenos {
+namespace api {
+
+namespace {
+
+std::vector<int> getSequenceIndexes(const reference::HashtableConfig& config)
+{
+  std::vector<int> ret;
+  for (const auto& sequence : config.getSequences()) {
+    ret.push_back(sequence.id_);
+  }
+  return ret;
+}
+
+}  // namespace
+
+AlignerContext::AlignerContext(const Reference& reference)
+  : reference_(reference),
+    similarity_(reference.getOptions().matchScore_, reference.getOptions().mismatchScore_),
+    singlePicker_(
+        similarity_,
+        reference.getOptions().alnMinScore_,
+        reference.getOptions().suppMinScoreAdj_,
+        reference.getOptions().alignerSecAligns_,
+        reference.getOptions().alignerSecScoreDelta_,
+        reference.getOptions().alignerSecPhredDelta_,
+        reference.getOptions().alignerSecAlignsHard_,
+        reference.getOptions().alignerMapqMinLen_,
+        reference.getOptions().alignerSampleMapq0_),
+    pairBuilder_(
+        similarity_,
+        reference.getOptions().alnMinScore_,
+        reference.getOptions().alignerUnpairedPen_,
+        reference.getOptions().alignerXsPairPen_,
+        reference.getOptions().alignerSecAligns_,
+        reference.getOptions().alignerSecScoreDelta_,
+        reference.getOptions().alignerSecPhredDelta_,
+        reference.getOptions().alignerSecAlignsHard_,
+        reference.getOptions().alignerMapqMinLen_,
+        reference.getOptions().alignerSampleMapq0_),
+    aligner_(
+        reference.getReferenceDir().getReferenceSequence(),
+        reference.getHashtableConfig(),
+        reference.getHashtable(),
+        reference.getOptions().mapOnly_,
+        reference.getOptions().swAll_,
+        similarity_,
+        reference.getOptions().gapInitPenalty_,
+        reference.getOptions().gapExtendPenalty_,
+        reference.getOptions().unclipScore_,
+        reference.getOptions().alnMinScore_,
+        reference.getOptions().alignerMapqMinLen_,
+        reference.getOptions().alignerUnpairedPen_,
+        reference.getOptions().mapperFilterLenRatio_,
+        !reference.getOptions().methodSmithWaterman_.compare("mengyao"),
+        reference.getOptions().mapperHotSeedCacheSize_,
+        reference.getOptions().mapperHotSeedCacheMinBuckets_,
+        reference.getOptions().mapperSparseSeeding_,
+        reference.getTargetIndex()),
+    sam_(reference.getHashtableConfig()),
+    transformer_(reference.getOptions().inputQnameSuffixDelim_, reference.getOptions().fastqOffset_),
+    sequenceIndexes_(getSequenceIndexes(reference.getHashtableConfig()))
+{
+  const options::DragenOsOptions& options = reference.getOptions();
+  if (!options.samplingEnabled_) {
+    insertSizeDistribution_.reset(new align::InsertSizeDistribution(
+        0,
+        false,
+        options.alignerPeq25_,
+        options.alignerPeq50_,
+        options.alignerPeq75_,
+        options.alignerPeMeanInsert_,
+        options.alignerPeStddevInsert_,
+        options.alignerPeMeanReadLen_,
+        options.peStatsIntervalSize_,
+        options.peStatsSampleSize_,
+        options.peStatsIntervalMemory_,
+        options.peStatsIntervalDelay_,
+        options.peStatsContinuousUpdate_,
+        options.peStatsUpdateLogOnly_,
+        options.alignerMapqMax_,
+        options.alignerPeOrientation_,
+        options.alignerResqueSigmas_,
+        options.alignerResqueCeilFactor_,
+        options.alignerResqueMinIns_,
+        options.alignerResqueMaxIns_,
+        std::cerr));
+  }
+}
+
+void AlignerContext::makeRead(
+    const ReadRecord& record, const unsigned position, const uint64_t index, sequences::Read& read)
+{
+  if (record.bases_.size() != record.qualities_.size()) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+        "ERROR: bases and qualities have different lengths for read " + record.name_));
+  }
+  transformer_(
+      std::make_pair(record.name_.begin(), record.name_.end()),
+      std::make_pair(record.bases_.begin(), record.bases_.end()),
+      std::make_pair(record.qualities_.begin(), record.qualities_.end()),
+      position,
+      index,
+      read);
+}
+
+AlignmentRecord AlignerContext::makeRecord(const sequences::Read& read, const align::Alignment& alignment) const
+{
+  // same placement rules as SamGenerator::appendRecord
+  const bool unplaced =
+      alignment.isUnmapped() && (!alignment.hasMultipleSegments() || alignment.isUnmappedNextSegment());
+  const bool noMate =
+      !alignment.hasMultipleSegments() || (alignment.isUnmapped() && alignment.isUnmappedNextSegment());
+  AlignmentRecord record;
+  record.read_      = read.getId();
+  record.flags_     = alignment.getFlags();
+  record.reference_ = (unplaced || (-1 == alignment.getReference())) ? -1
+                                                                     : sequenceIndexes_.at(alignment.getReference());
+  record.position_  = unplaced ? -1 : alignment.getPosition();
+  record.mapq_      = unplaced ? 0 : std::min<align::MapqType>(alignment.getMapq(), align::MAPQ_MAX);
+  if (!unplaced) {
+    for (const auto& operation : alignment.getCigar()) {
+      record.cigar_ += std::to_string(operation.second);
+      record.cigar_ += align::Cigar::getOperationName(operation.first);
+    }
+  }
+  if (noMate) {
+    record.nextReference_ = -1;
+    record.nextPosition_  = -1;
+  } else {
+    record.nextReference_ = (-1 == alignment.getNextReference()) ? record.reference_
+                                                                 : sequenceIndexes_.at(alignment.getNextReference());
+    record.nextPosition_ = alignment.getNextPosition();
+  }
+  record.templateLength_ = alignment.isUnmapped() ? 0 : alignment.getTemplateLength();
+  record.score_          = alignment.getScore();
+  record.mismatches_     = alignment.getMismatchCount();
+  return record;
+}
+
+template <typename StoreOp>
+void AlignerContext::alignSingle(const std::vector<ReadRecord>& reads, StoreOp store)
+{
+  common::Arena::Scope arenaScope(arena_);
+  for (std::size_t i = 0; reads.size() > i; ++i) {
+    makeRead(reads[i], 0, i, pair_[0]);
+    workflow::alignment::alignAndStoreSingle(pair_.at(0), aligner_, singlePicker_, alignments_, store);
+  }
+}
+
+template <typename StoreOp>
+void AlignerContext::alignPairs(
+    const std::vector<ReadRecord>& reads1, const std::vector<ReadRecord>& reads2, StoreOp store)
+{
+  if (reads1.size() != reads2.size()) {
+    BOOST_THROW_EXCEPTION(
+        common::InvalidParameterException("ERROR: the batches of reads 1 and reads 2 have different sizes"));
+  }
+  common::Arena::Scope arenaScope(arena_);
+  for (std::size_t i = 0; reads1.size() > i; ++i) {
+    makeRead(reads1[i], 0, i, pair_[0]);
+    makeRead(reads2[i], 1, i, pair_[1]);
+    if (insertSizeDistribution_ && (pair_[0].getLength() != insertSizeReadLength_)) {
+      insertSizeReadLength_ = pair_[0].getLength();
+      insertSizeParameters_ = insertSizeDistribution_->getInsertSizeParameters(insertSizeReadLength_);
+    }
+    workflow::alignment::alignAndStorePair(
+        insertSizeParameters_, pair_, aligner_, singlePicker_, pairBuilder_, alignmentPairs_, store);
+  }
+}
+
+void AlignerContext::alignSingle(const std::vector<ReadRecord>& reads, std::vector<AlignmentRecord>& records)
+{
+  alignSingle(reads, [&](const sequences::Read& read, const align::Alignment& alignment) {
+    records.push_back(makeRecord(read, alignment));
+  });
+}
+
+void AlignerContext::alignPairs(
+    const std::vector<ReadRecord>& reads1,
+    const std::vector<ReadRecord>& reads2,
+    std::vector<AlignmentRecord>&  records)
+{
+  alignPairs(reads1, reads2, [&](const sequences::Read& read, const align::Alignment& alignment) {
+    records.push_back(makeRecord(read, alignment));
+  });
+}
+
+void AlignerContext::alignSingle(const std::vector<ReadRecord>& reads, std::vector<char>& sam)
+{
+  alignSingle(reads, [&](const sequences::Read& read, const align::Alignment& alignment) {
+    sam_.appendRecord(sam, read, alignment, reference_.getOptions().rgid_);
+  });
+}
+
+void AlignerContext::alignPairs(
+    const std::vector<ReadRecord>& reads1, const std::vector<ReadRecord>& reads2, std::vector<char>& sam)
+{
+  alignPairs(reads1, reads2, [&](const sequences::Read& read, const align::Alignment& alignment) {
+    sam_.appendRecord(sam, read, alignment, reference_.getOptions().rgid_);
+  });
+}
+
+}  // namespace api
+}  // namespace dragenos
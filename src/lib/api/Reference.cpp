@@ -0,0 +1,81 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "api/Reference.hpp"
+
+#include <iostream>
+
+#include "common/Exceptions.hpp"
+#include "sam/SamGenerator.hpp"
+#include "workflow/Input2SamWorkflow.hpp"
+
+namespace dragenos {
+namespace api {
+
+namespace {
+
+/// the arguments preceded by the program name, as expected by the command line parser
+std::vector<const char*> makeArgv(const std::vector<std::string>& arguments)
+{
+  std::vector<const char*> ret{"dragen-os"};
+  for (const auto& argument : arguments) {
+    ret.push_back(argument.c_str());
+  }
+  return ret;
+}
+
+}  // namespace
+
+Reference::Reference(const std::vector<std::string>& arguments)
+  : arguments_(arguments), argv_(makeArgv(arguments_)), options_(false)
+{
+  if (options::DragenOsOptions::RUN != options_.parse(int(argv_.size()), argv_.data())) {
+    BOOST_THROW_EXCEPTION(common::InvalidOptionException("ERROR: invalid options for the embedded aligner"));
+  }
+  if (options_.buildHashTable_ || options_.htUncompress_ || !options_.daemonSocket_.empty() ||
+      !options_.submitSocket_.empty() || !options_.fastqList_.empty()) {
+    BOOST_THROW_EXCEPTION(
+        common::InvalidOptionException("ERROR: the embedded aligner only supports the alignment options"));
+  }
+  // the reads would be aligned unconverted, without the methylation calls
+  if (options_.isMethylated()) {
+    BOOST_THROW_EXCEPTION(common::InvalidOptionException(
+        "ERROR: the embedded aligner doesn't support methylation-protocol " + options_.methylationProtocol_));
+  }
+
+  referenceDir_.reset(new reference::ReferenceDir7(
+      options_.refDir_,
+      options_.mmapReference_,
+      options_.loadReference_,
+      options_.packReference_,
+      options_.htCacheDirectory_));
+  if (options_.refWarmupThreads_ && !referenceDir_->getMappedRanges().empty()) {
+    warmup_.reset(new reference::PageWarmup(referenceDir_->getMappedRanges(), options_.refWarmupThreads_));
+    warmup_->wait(options_.refWarmupFraction_, std::cerr);
+  }
+  hashtable_.reset(new reference::Hashtable(
+      &referenceDir_->getHashtableConfig(),
+      referenceDir_->getHashtableData(),
+      referenceDir_->getExtendTableData()));
+  targetIndex_ = workflow::loadTargetIndex(options_, *referenceDir_);
+}
+
+void Reference::writeSamHeader(std::ostream& os) const
+{
+  sam::SamGenerator::generateHeader(
+      os, getHashtableConfig(), options_.getCommandLine(), options_.rgid_, options_.rgsm_);
+}
+
+}  // namespace api
+}  // namespace dragenos
@@ -0,0 +1,106 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "common/AllocationCounter.hpp"
+
+#ifdef DRAGEN_OS_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> allocationCount(0);
+std::atomic<std::size_t> allocationBytes(0);
+
+void* countedAllocate(const std::size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocationBytes.fetch_add(size, std::memory_order_relaxed);
+  // malloc(0) is allowed to return nullptr
+  void* ret = std::malloc(size ? size : 1);
+  if (nullptr == ret) {
+    throw std::bad_alloc();
+  }
+  return ret;
+}
+
+}  // namespace
+
+void* operator new(const std::size_t size)
+{
+  return countedAllocate(size);
+}
+
+void* operator new[](const std::size_t size)
+{
+  return countedAllocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace dragenos {
+namespace common {
+
+std::size_t getAllocationCount()
+{
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+std::size_t getAllocationBytes()
+{
+  return allocationBytes.load(std::memory_order_relaxed);
+}
+
+}  // namespace common
+}  // namespace dragenos
+
+#else  // #ifdef DRAGEN_OS_COUNT_ALLOCATIONS
+
+namespace dragenos {
+namespace common {
+
+std::size_t getAllocationCount()
+{
+  return 0;
+}
+
+std::size_t getAllocationBytes()
+{
+  return 0;
+}
+
+}  // namespace common
+}  // namespace dragenos
+
+#endif  // #ifdef DRAGEN_OS_COUNT_ALLOCATIONS
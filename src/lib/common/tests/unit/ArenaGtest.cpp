@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+#include "common/Arena.hpp"
+
+using dragenos::common::Arena;
+using dragenos::common::ArenaAllocator;
+using dragenos::common::ArenaVector;
+
+TEST(Arena, Alignment)
+{
+  Arena arena(1024);
+  for (std::size_t alignment = 1; 64 >= alignment; alignment *= 2) {
+    arena.allocate(1, 1);
+    const void* p = arena.allocate(7, alignment);
+    ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(p) % alignment) << "alignment: " << alignment;
+  }
+  ASSERT_EQ(1u, arena.getChunkCount());
+}
+
+TEST(Arena, ResetReusesChunks)
+{
+  Arena      arena(1024);
+  const auto first = arena.allocate(100, 8);
+  arena.allocate(1000, 8);
+  ASSERT_EQ(2u, arena.getChunkCount());
+  ASSERT_EQ(1100u, arena.getAllocatedBytes());
+  arena.reset();
+  ASSERT_EQ(0u, arena.getAllocatedBytes());
+  ASSERT_EQ(first, arena.allocate(100, 8));
+  arena.allocate(1000, 8);
+  ASSERT_EQ(2u, arena.getChunkCount());
+}
+
+TEST(Arena, LargeAllocation)
+{
+  Arena arena(1024);
+  char* p = static_cast<char*>(arena.allocate(10000, 16));
+  std::fill(p, p + 10000, 'x');
+  ASSERT_EQ(1u, arena.getChunkCount());
+  ASSERT_EQ(10000u, arena.getAllocatedBytes());
+}
+
+TEST(Arena, Scope)
+{
+  ASSERT_EQ(nullptr, Arena::current());
+  Arena arena;
+  {
+    const Arena::Scope scope(arena);
+    ASSERT_EQ(&arena, Arena::current());
+    Arena other;
+    {
+      const Arena::Scope nested(other);
+      ASSERT_EQ(&other, Arena::current());
+    }
+    ASSERT_EQ(&arena, Arena::current());
+    // the current arena is specific to each thread
+    std::thread([]() { ASSERT_EQ(nullptr, Arena::current()); }).join();
+  }
+  ASSERT_EQ(nullptr, Arena::current());
+}
+
+TEST(ArenaAllocator, HeapWithoutArena)
+{
+  ArenaVector<int> v(100, 1);
+  ASSERT_EQ(nullptr, v.get_allocator().getArena());
+  v.resize(1000, 2);
+  ASSERT_EQ(100, std::count(v.begin(), v.end(), 1));
+}
+
+TEST(ArenaAllocator, Vector)
+{
+  Arena              arena;
+  const Arena::Scope scope(arena);
+  ArenaVector<int>   v;
+  ASSERT_EQ(&arena, v.get_allocator().getArena());
+  for (int i = 0; 1000 > i; ++i) {
+    v.push_back(i);
+  }
+  ASSERT_LE(1000 * sizeof(int), arena.getAllocatedBytes());
+  for (int i = 0; 1000 > i; ++i) {
+    ASSERT_EQ(i, v[i]);
+  }
+
+  // copies go to the arena of the thread doing the copy
+  Arena other;
+  {
+    const Arena::Scope     nested(other);
+    const ArenaVector<int> copy(v);
+    ASSERT_EQ(&other, copy.get_allocator().getArena());
+    ASSERT_EQ(v, copy);
+  }
+  const ArenaVector<int> heap(v, ArenaAllocator<int>(nullptr));
+  ASSERT_EQ(nullptr, heap.get_allocator().getArena());
+  ASSERT_EQ(v, heap);
+}
@@ -0,0 +1,120 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "fastq/MappedFastqReader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <boost/throw_exception.hpp>
+
+#include "common/Exceptions.hpp"
+
+namespace dragenos {
+namespace fastq {
+
+MappedFastqReader::MappedFastqReader(const std::string& path)
+  : path_(path), size_(0), data_(nullptr), end_(nullptr), current_(nullptr), advised_(nullptr)
+{
+  const int fd = open(path_.c_str(), O_RDONLY);
+  if (-1 == fd) {
+    BOOST_THROW_EXCEPTION(common::IoException(errno, std::string("Failed to open FASTQ file: ") + path_));
+  }
+  struct stat st;
+  if (-1 == fstat(fd, &st)) {
+    const int error = errno;
+    close(fd);
+    BOOST_THROW_EXCEPTION(common::IoException(error, std::string("Failed to stat FASTQ file: ") + path_));
+  }
+  size_ = st.st_size;
+  // mmap fails on empty files, which simply have no records
+  if (size_) {
+    void* data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE | MAP_NORESERVE, fd, 0);
+    if (MAP_FAILED == data) {
+      const int error = errno;
+      close(fd);
+      BOOST_THROW_EXCEPTION(common::IoException(error, std::string("Failed to map FASTQ file: ") + path_));
+    }
+    // readahead hints only, failures are harmless
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+  }
+  close(fd);
+  end_     = data_ + size_;
+  current_ = data_;
+  advised_ = data_;
+  adviseReadahead();
+}
+
+MappedFastqReader::~MappedFastqReader()
+{
+  if (data_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+std::size_t MappedFastqReader::read(const char*& begin, const char*& end, const std::size_t n)
+{
+  static const int FASTQ_LINES_PER_RECORD = 4;
+  std::size_t      lines                  = n * FASTQ_LINES_PER_RECORD;
+
+  begin = current_;
+  while (lines && end_ != current_) {
+    const void* newLine = memchr(current_, '\n', end_ - current_);
+    // the last line of the file might not have a newline
+    current_ = newLine ? static_cast<const char*>(newLine) + 1 : end_;
+    --lines;
+  }
+  end = current_;
+  adviseReadahead();
+
+  return n - lines / FASTQ_LINES_PER_RECORD;
+}
+
+bool MappedFastqReader::skip(const std::size_t bytes)
+{
+  const std::size_t remaining = end_ - current_;
+  // FastqNRecordReader counts a newline at the end of a last line without one
+  const bool missingNewline = (remaining + 1 == bytes) && (data_ != end_) && ('\n' != end_[-1]);
+  if ((remaining < bytes) && !missingNewline) {
+    return false;
+  }
+  current_ += std::min(bytes, remaining);
+  advised_ = std::max(advised_, current_);
+  adviseReadahead();
+  return true;
+}
+
+void MappedFastqReader::adviseReadahead()
+{
+  const char* const target = current_ + std::min<std::size_t>(READAHEAD_BYTES, end_ - current_);
+  if (advised_ < target) {
+    // madvise needs a page aligned address, which the start of the mapping is
+    static const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+    const uintptr_t        address  = reinterpret_cast<uintptr_t>(advised_);
+    const uintptr_t        aligned  = address - address % pageSize;
+    madvise(reinterpret_cast<void*>(aligned), target - advised_ + (address - aligned), MADV_WILLNEED);
+    advised_ = target;
+  }
+}
+
+}  // namespace fastq
+}  // namespace dragenos
@@ -0,0 +1,169 @@
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/Exceptions.hpp"
+#include "fastq/BlockTokenizer.hpp"
+#include "fastq/FastqNRecordReader.hpp"
+#include "fastq/MappedFastqReader.hpp"
+
+using dragenos::fastq::BlockTokenizer;
+using dragenos::fastq::FastqNRecordReader;
+using dragenos::fastq::MappedFastqReader;
+
+namespace {
+
+struct TemporaryFile {
+  TemporaryFile()
+    : path_("/tmp/MappedFastqReaderGtest." + std::to_string(getpid()) + "." + std::to_string(++count_))
+  {
+  }
+  ~TemporaryFile() { unlink(path_.c_str()); }
+  const std::string path_;
+  static unsigned   count_;
+};
+unsigned TemporaryFile::count_ = 0;
+
+std::string makeContent(const unsigned records)
+{
+  std::string content;
+  for (unsigned i = 0; records > i; ++i) {
+    content += "@read" + std::to_string(i) + " 1:N:0\nACGTACGTNN\n+\nAAAAEEEEEE\n";
+  }
+  return content;
+}
+
+/// blocks of n records of the mapped file
+std::vector<std::string> readBlocks(MappedFastqReader& reader, const std::size_t n, std::size_t& records)
+{
+  std::vector<std::string> blocks;
+  records = 0;
+  while (!reader.eof()) {
+    const char* begin = nullptr;
+    const char* end   = nullptr;
+    records += reader.read(begin, end, n);
+    blocks.emplace_back(begin, end);
+  }
+  return blocks;
+}
+
+}  // namespace
+
+TEST(MappedFastqReader, sameBlocksAsStream)
+{
+  const std::string   content = makeContent(25);
+  const TemporaryFile file;
+  std::ofstream(file.path_) << content;
+  MappedFastqReader reader(file.path_);
+  ASSERT_EQ(content.size(), reader.size());
+
+  std::istringstream is(content);
+  FastqNRecordReader streamReader(is);
+  std::size_t        records = 0;
+  for (const auto& block : readBlocks(reader, 10, records)) {
+    std::string streamBlock;
+    streamReader.read(std::back_inserter(streamBlock), 10);
+    EXPECT_EQ(streamBlock, block);
+  }
+  EXPECT_EQ(25U, records);
+}
+
+TEST(MappedFastqReader, missingFinalNewline)
+{
+  const std::string   content = makeContent(3);
+  const TemporaryFile file;
+  std::ofstream(file.path_) << content.substr(0, content.size() - 1);
+  MappedFastqReader reader(file.path_);
+
+  std::size_t records = 0;
+  const auto  blocks  = readBlocks(reader, 2, records);
+  ASSERT_EQ(2U, blocks.size());
+  EXPECT_EQ(3U, records);
+
+  BlockTokenizer tokenizer(blocks[1].data(), blocks[1].data() + blocks[1].size());
+  ASSERT_TRUE(tokenizer.next());
+  const auto qscores = tokenizer.token().getQscores();
+  EXPECT_EQ("AAAAEEEEEE", std::string(qscores.first, qscores.second));
+  EXPECT_FALSE(tokenizer.next());
+}
+
+TEST(MappedFastqReader, empty)
+{
+  const TemporaryFile file;
+  std::ofstream(file.path_).flush();
+  MappedFastqReader reader(file.path_);
+  EXPECT_TRUE(reader.eof());
+}
+
+TEST(MappedFastqReader, missingFile)
+{
+  EXPECT_THROW(MappedFastqReader("/nonexistent/MappedFastqReaderGtest.fastq"), dragenos::common::IoException);
+}
+
+TEST(BlockTokenizer, tokensPointIntoTheBlock)
+{
+  const std::string content = makeContent(2);
+  BlockTokenizer    tokenizer(content.data(), content.data() + content.size());
+  ASSERT_TRUE(tokenizer.next());
+  EXPECT_EQ(10U, tokenizer.token().readLength());
+  const auto name = tokenizer.token().getName(' ');
+  EXPECT_EQ(content.data() + 1, name.first);
+  EXPECT_EQ("read0", std::string(name.first, name.second));
+  ASSERT_TRUE(tokenizer.next());
+  EXPECT_FALSE(tokenizer.next());
+  EXPECT_TRUE(tokenizer.token().empty());
+}
+
+TEST(BlockTokenizer, truncatedRecord)
+{
+  const std::string content = makeContent(2).substr(0, 60);
+  BlockTokenizer    tokenizer(content.data(), content.data() + content.size());
+  ASSERT_TRUE(tokenizer.next());
+  EXPECT_THROW(tokenizer.next(), std::logic_error);
+}
+
+TEST(MappedFastqReader, skipStreamOffsets)
+{
+  for (const bool finalNewline : {true, false}) {
+    const std::string   content = makeContent(3).substr(0, makeContent(3).size() - (finalNewline ? 0 : 1));
+    const TemporaryFile file;
+    std::ofstream(file.path_) << content;
+
+    // offsets as counted by the stream reader, which always ends the last line with a newline
+    std::istringstream is(content);
+    FastqNRecordReader streamReader(is);
+    std::string        first;
+    std::string        last;
+    streamReader.read(std::back_inserter(first), 2);
+    streamReader.read(std::back_inserter(last), 1);
+    const std::size_t total = first.size() + last.size();
+    EXPECT_EQ(content.size() + (finalNewline ? 0 : 1), total);
+
+    std::istringstream partial(content);
+    ASSERT_TRUE(FastqNRecordReader::skip(partial, first.size()));
+    std::string remaining;
+    FastqNRecordReader(partial).read(std::back_inserter(remaining), 2);
+    EXPECT_EQ(last, remaining);
+    MappedFastqReader mapped(file.path_);
+    ASSERT_TRUE(mapped.skip(first.size()));
+    const char* begin = nullptr;
+    const char* end   = nullptr;
+    EXPECT_EQ(1U, mapped.read(begin, end, 2));
+    EXPECT_EQ(content.substr(first.size()), std::string(begin, end));
+
+    std::istringstream whole(content);
+    EXPECT_TRUE(FastqNRecordReader::skip(whole, total));
+    MappedFastqReader all(file.path_);
+    EXPECT_TRUE(all.skip(total));
+    EXPECT_TRUE(all.eof());
+
+    std::istringstream longer(content);
+    EXPECT_FALSE(FastqNRecordReader::skip(longer, total + 1));
+    MappedFastqReader tooFar(file.path_);
+    EXPECT_FALSE(tooFar.skip(total + 1));
+  }
+}
@@ -0,0 +1,130 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "io/PrefetchedInput.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include "common/Exceptions.hpp"
+
+namespace dragenos {
+namespace io {
+
+PrefetchedInput::PrefetchedInput(const std::string& path, const bool gzip)
+  : std::istream(nullptr), buffer_(path, gzip)
+{
+  rdbuf(&buffer_);
+  exceptions(std::ios_base::badbit);
+}
+
+PrefetchedInput::~PrefetchedInput() {}
+
+PrefetchedInput::Buffer::Buffer(const std::string& path, const bool gzip)
+{
+  thread_ = std::thread(&Buffer::read, this, path, gzip);
+}
+
+PrefetchedInput::Buffer::~Buffer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  changed_.notify_all();
+  thread_.join();
+}
+
+void PrefetchedInput::Buffer::read(const std::string& path, const bool gzip)
+{
+  try {
+    std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+    if (!file) {
+      BOOST_THROW_EXCEPTION(common::IoException(
+          errno, std::string("Failed to open input file: ") + path + ": " + std::strerror(errno)));
+    }
+    boost::iostreams::filtering_istream input;
+    if (gzip) {
+      input.push(boost::iostreams::gzip_decompressor());
+    }
+    input.push(file);
+    input.exceptions(std::ios_base::badbit);
+    while (input) {
+      std::vector<char> chunk;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return stop_ || (CHUNK_COUNT > full_.size()); });
+        if (stop_) {
+          return;
+        }
+        if (!free_.empty()) {
+          chunk = std::move(free_.back());
+          free_.pop_back();
+        }
+      }
+      chunk.resize(CHUNK_BYTES);
+      input.read(chunk.data(), chunk.size());
+      chunk.resize(input.gcount());
+      if (!chunk.empty()) {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          full_.push_back(std::move(chunk));
+        }
+        changed_.notify_all();
+      }
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exception_ = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  changed_.notify_all();
+}
+
+PrefetchedInput::Buffer::int_type PrefetchedInput::Buffer::underflow()
+{
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!current_.empty()) {
+      free_.push_back(std::move(current_));
+      current_.clear();
+    }
+    changed_.wait(lock, [this] { return done_ || !full_.empty(); });
+    if (full_.empty()) {
+      setg(nullptr, nullptr, nullptr);
+      if (exception_) {
+        std::rethrow_exception(exception_);
+      }
+      return traits_type::eof();
+    }
+    current_ = std::move(full_.front());
+    full_.pop_front();
+  }
+  changed_.notify_all();
+  setg(current_.data(), current_.data(), current_.data() + current_.size());
+  return traits_type::to_int_type(*gptr());
+}
+
+}  // namespace io
+}  // namespace dragenos
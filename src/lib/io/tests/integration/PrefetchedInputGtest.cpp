@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include "common/Exceptions.hpp"
+#include "io/PrefetchedInput.hpp"
+
+using dragenos::io::PrefetchedInput;
+
+namespace {
+
+struct TemporaryFile {
+  TemporaryFile() : path_("/tmp/PrefetchedInputGtest." + std::to_string(getpid()) + "." + std::to_string(++count_))
+  {
+  }
+  ~TemporaryFile() { unlink(path_.c_str()); }
+  const std::string path_;
+  static unsigned   count_;
+};
+unsigned TemporaryFile::count_ = 0;
+
+/// several chunks, the last one partial
+std::string makeContent()
+{
+  std::string content;
+  for (unsigned i = 0; content.size() < 2 * PrefetchedInput::CHUNK_BYTES + 1234; ++i) {
+    content += "@read" + std::to_string(i) + "\nACGTACGTNN\n+\nAAAAEEEEEE\n";
+  }
+  return content;
+}
+
+std::string readAll(std::istream& is)
+{
+  return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(PrefetchedInput, plain)
+{
+  const std::string   content = makeContent();
+  const TemporaryFile file;
+  std::ofstream(file.path_) << content;
+  PrefetchedInput input(file.path_, false);
+  EXPECT_EQ(content, readAll(input));
+}
+
+TEST(PrefetchedInput, gzip)
+{
+  const std::string   content = makeContent();
+  const TemporaryFile file;
+  {
+    std::ofstream                       os(file.path_, std::ios_base::binary);
+    boost::iostreams::filtering_ostream gzip;
+    gzip.push(boost::iostreams::gzip_compressor());
+    gzip.push(os);
+    gzip << content;
+  }
+  PrefetchedInput input(file.path_, true);
+  EXPECT_EQ(content, readAll(input));
+}
+
+TEST(PrefetchedInput, errors)
+{
+  EXPECT_THROW(
+      {
+        PrefetchedInput input("/nonexistent/PrefetchedInputGtest.fq", false);
+        readAll(input);
+      },
+      dragenos::common::IoException);
+
+  const TemporaryFile file;
+  std::ofstream(file.path_) << makeContent();
+  PrefetchedInput input(file.path_, true);
+  EXPECT_THROW(readAll(input), boost::iostreams::gzip_error);
+}
+
+TEST(PrefetchedInput, destroyBeforeTheEnd)
+{
+  const TemporaryFile file;
+  std::ofstream(file.path_) << makeContent();
+  for (unsigned i = 0; 10 > i; ++i) {
+    PrefetchedInput input(file.path_, false);
+    char            c = 0;
+    input.get(c);
+    EXPECT_EQ('@', c);
+  }
+}
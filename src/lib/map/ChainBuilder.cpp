@@ -20,6 +20,67 @@
 namespace dragenos {
 namespace map {
 
+void ChainBuilder::clear()
+{
+  for (const uint32_t key : diagonalIndexKeys_) {
+    diagonalIndexHeads_[key % DIAGONAL_INDEX_SIZE] = -1;
+  }
+  diagonalIndexKeys_.clear();
+  diagonalIndexNext_.clear();
+  diagonalIndexValid_ = true;
+  seedChainCount_     = 0;
+}
+
+void ChainBuilder::indexChain(const std::size_t chain)
+{
+  assert(diagonalIndexKeys_.size() == chain);
+  const SeedChain& seedChain = seedChains_[chain];
+  diagonalIndexValid_ &= !seedChain.empty();
+  const uint32_t key = getDiagonalKey(
+      seedChain.getInitialDiagonal() / SeedChain::DIAG_HALF_BIN_SIZE, seedChain.isReverseComplement());
+  int& head = diagonalIndexHeads_[key % DIAGONAL_INDEX_SIZE];
+  diagonalIndexKeys_.push_back(key);
+  diagonalIndexNext_.push_back(head);
+  head = chain;
+}
+
+void ChainBuilder::rebuildDiagonalIndex()
+{
+  std::fill(diagonalIndexHeads_.begin(), diagonalIndexHeads_.end(), -1);
+  diagonalIndexKeys_.clear();
+  diagonalIndexNext_.clear();
+  diagonalIndexValid_ = true;
+  for (std::size_t i = 0; seedChainCount_ > i; ++i) {
+    indexChain(i);
+  }
+}
+
+bool ChainBuilder::addToDiagonalBin(
+    const uint32_t      diagonalBin,
+    const SeedPosition& seedPosition,
+    const bool          reverseComplement,
+    const bool          randomSample)
+{
+  bool           accepted = false;
+  const uint32_t key      = getDiagonalKey(diagonalBin, reverseComplement);
+  for (int i = diagonalIndexHeads_[key % DIAGONAL_INDEX_SIZE]; -1 != i; i = diagonalIndexNext_[i]) {
+    if (key != diagonalIndexKeys_[i]) {
+      continue;
+    }
+    SeedChain& seedChain = seedChains_[i];
+    if (seedChain.accepts(seedPosition, reverseComplement)) {
+///////////
+#ifdef TRACE_SEED_CHAINS
+      std::cerr << seedPosition << "  Accepted by: " << seedChain << std::endl;
+#endif
+      ///////////
+      seedChain.addSeedPosition(seedPosition, randomSample);
+      accepted = true;
+    }
+  }
+  return accepted;
+}
+
 void ChainBuilder::addSeedPosition(
     const SeedPosition& seedPosition, const bool reverseComplement, const bool randomSample)
 {
@@ -32,25 +93,37 @@ void ChainBuilder::addSeedPosition(
   ///////////
 
   bool accepted = false;
-  for (auto& seedChain : *this) {
-    if (seedChain.accepts(seedPosition, reverseComplement)) {
+  if (diagonalIndexValid_) {
+    // the seed is added to all the accepting chains, which can only be in the neighbouring bins
+    const uint32_t diagonalBin =
+        SeedChain::getDiagonal(seedPosition.getSeed(), seedPosition.getReferencePosition(), reverseComplement) /
+        SeedChain::DIAG_HALF_BIN_SIZE;
+    if (0 < diagonalBin) {
+      accepted |= addToDiagonalBin(diagonalBin - 1, seedPosition, reverseComplement, randomSample);
+    }
+    accepted |= addToDiagonalBin(diagonalBin, seedPosition, reverseComplement, randomSample);
+    accepted |= addToDiagonalBin(diagonalBin + 1, seedPosition, reverseComplement, randomSample);
+  } else {
+    for (auto& seedChain : *this) {
+      if (seedChain.accepts(seedPosition, reverseComplement)) {
 ///////////
 #ifdef TRACE_SEED_CHAINS
-      std::cerr << seedPosition << "  Accepted by: " << seedChain << std::endl;
+        std::cerr << seedPosition << "  Accepted by: " << seedChain << std::endl;
 #endif
-      ///////////
-      seedChain.addSeedPosition(seedPosition, randomSample);
-      accepted = true;
-      // TODO: verify that we don't have to add the seed possition to all accepting seed chains
-      //return;
-    }
+        ///////////
+        seedChain.addSeedPosition(seedPosition, randomSample);
+        accepted = true;
+        // TODO: verify that we don't have to add the seed possition to all accepting seed chains
+        //return;
+      }
 /////////
 #ifdef TRACE_SEED_CHAINS
-    else {
-      //      std::cerr << seedPosition << "  Rejected by: " << seedChain << std::endl;
-    }
+      else {
+        //      std::cerr << seedPosition << "  Rejected by: " << seedChain << std::endl;
+      }
 #endif
-    /////////
+      /////////
+    }
   }
   if (accepted) {
     return;
@@ -67,6 +140,7 @@ void ChainBuilder::addSeedPosition(
   seedChains_[seedChainCount_].clear();
   seedChains_[seedChainCount_].setReverseComplement(reverseComplement);
   seedChains_[seedChainCount_].addSeedPosition(seedPosition, randomSample);
+  indexChain(seedChainCount_);
   ++seedChainCount_;
 }
 
@@ -77,6 +151,7 @@ void ChainBuilder::addSeedChain(const SeedChain& seedChain)
   } else {
     seedChains_[seedChainCount_] = seedChain;
   }
+  indexChain(seedChainCount_);
   ++seedChainCount_;
 }
 
@@ -0,0 +1,103 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include <algorithm>
+#include <iomanip>
+
+#include "map/HotSeedCache.hpp"
+
+namespace dragenos {
+namespace map {
+
+namespace {
+std::size_t roundUpToPowerOfTwo(const std::size_t value)
+{
+  std::size_t ret = 1;
+  while (value > ret) {
+    ret <<= 1;
+  }
+  return ret;
+}
+}  // namespace
+
+HotSeedCache::HotSeedCache(const std::size_t slotCount, const unsigned minBucketAccesses)
+  : minBucketAccesses_(minBucketAccesses),
+    slots_(slotCount ? roundUpToPowerOfTwo(slotCount) : 0),
+    slotMask_(slots_.empty() ? 0 : slots_.size() - 1)
+{
+}
+
+HotSeedCache::Slot& HotSeedCache::getSlot(const uint64_t hash, const bool isExtended)
+{
+  // the hashes are CRCs, but the address segment bits are shared by all the extensions of a seed
+  const uint64_t mixed = (hash ^ (hash >> 29) ^ isExtended) * 0x9E3779B97F4A7C15UL;
+  return slots_[(mixed >> 32) & slotMask_];
+}
+
+bool HotSeedCache::get(
+    const uint64_t                    hash,
+    const bool                        isExtended,
+    std::vector<HashRecord>&          hits,
+    std::vector<ExtendTableInterval>& extendTableIntervals)
+{
+  ++statistics_.lookups_;
+  const Slot& slot = getSlot(hash, isExtended);
+  if (!slot.valid_ || (hash != slot.hash_) || (isExtended != slot.isExtended_)) {
+    return false;
+  }
+  ++statistics_.hits_;
+  hits.assign(slot.hits_.begin(), slot.hits_.begin() + slot.hitCount_);
+  if (slot.interval_) {
+    extendTableIntervals.push_back(*slot.interval_);
+  }
+  return true;
+}
+
+void HotSeedCache::put(
+    const uint64_t                 hash,
+    const bool                     isExtended,
+    const unsigned                 bucketAccesses,
+    const std::vector<HashRecord>& hits,
+    const ExtendTableInterval*     interval)
+{
+  if ((minBucketAccesses_ > bucketAccesses) || (MAX_HITS < hits.size())) {
+    return;
+  }
+  Slot& slot = getSlot(hash, isExtended);
+  if (slot.valid_) {
+    ++statistics_.evictions_;
+  }
+  ++statistics_.inserts_;
+  slot.hash_       = hash;
+  slot.valid_      = true;
+  slot.isExtended_ = isExtended;
+  slot.hitCount_   = hits.size();
+  std::copy(hits.begin(), hits.end(), slot.hits_.begin());
+  if (nullptr != interval) {
+    slot.interval_ = *interval;
+  } else {
+    slot.interval_.reset();
+  }
+}
+
+std::ostream& operator<<(std::ostream& os, const HotSeedCache::Statistics& statistics)
+{
+  const double hitRate = statistics.lookups_ ? 100.0 * statistics.hits_ / statistics.lookups_ : 0.0;
+  return os << statistics.lookups_ << " lookups, " << statistics.hits_ << " hits (" << std::fixed
+            << std::setprecision(2) << hitRate << "%), " << statistics.inserts_ << " inserts, "
+            << statistics.evictions_ << " evictions";
+}
+
+}  // namespace map
+}  // namespace dragenos
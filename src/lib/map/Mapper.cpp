@@ -14,8 +14,8 @@
 
 #include <boost/format.hpp>
 //#include <boost/range/adaptor/reversed.hpp>
+#include <algorithm>
 #include <numeric>
-#include <unordered_set>
 
 #include "host/infra/public/crc32_hw.h"
 
@@ -53,23 +53,20 @@ void Mapper::getPositionChains(const Read& read, ChainBuilder& chainBuilder) con
   chainBuilder.clear();
   const unsigned seedLength = hashtable_->getPrimarySeedBases();
   chainBuilder.setFilterConstant(seedLength);
-  const unsigned                   readLength         = read.getLength();
-  constexpr int32_t                SEED_PERIOD        = 2;
-  constexpr uint32_t               SEED_PATTERN       = 0x01;
-  constexpr uint8_t                FORCE_LAST_N_SEEDS = 0;  //1;
-  std::vector<BestIntervalTracker> globalBestIntvls;
-  globalBestIntvls.reserve(readLength);
-  uint32_t num_extension_failure      = 0;
-  uint32_t longest_nonsample_seed_len = 0;
-  uint32_t num_non_sample_seed_chains = 0;
-  // TODO: check the cost of the underlying memory allocations and cace the seed positions buffer if needed
-  const auto seedOffsets =
-      Seed::getSeedOffsets(readLength, seedLength, SEED_PERIOD, SEED_PATTERN, FORCE_LAST_N_SEEDS);
-#ifdef TRACE_SEED_CHAINS
+  std::vector<BestIntervalTracker>& globalBestIntvls = globalBestIntvls_;
+  globalBestIntvls.clear();
+  uint32_t                   num_extension_failure      = 0;
+  uint32_t                   longest_nonsample_seed_len = 0;
+  uint32_t                   num_non_sample_seed_chains = 0;
+  const std::vector<size_t>& seedOffsets                = getSeedOffsets(read.getLength());
+  // the primary data and hashes of all the seeds are computed in one pass over the read
+  seedEncoder_.encode(read, seedLength, seedOffsets);
+  seedEncoder_.hash(*getHashtable()->getPrimaryHasher());
   for (size_t i = 0; i != seedOffsets.size(); ++i) {
+#ifdef TRACE_SEED_CHAINS
     seedOffset = seedOffsets[i];
 #else
-  for (const auto& seedOffset : seedOffsets) {
+    const auto seedOffset = seedOffsets[i];
 #endif
 
 #ifdef TRACE_SEED_CHAINS
@@ -84,7 +81,13 @@ void Mapper::getPositionChains(const Read& read, ChainBuilder& chainBuilder) con
       assert(
           seed.isValid(0));  // getSeedOffset is supposed to produce offsets only for valid non-extended seeds
       addToPositionChains(
-          seed, chainBuilder, globalBestIntvls, longest_nonsample_seed_len, num_extension_failure);
+          seed,
+          seedEncoder_.isReverseComplement(i),
+          seedEncoder_.getHash(i),
+          chainBuilder,
+          globalBestIntvls,
+          longest_nonsample_seed_len,
+          num_extension_failure);
     } else {
 #ifdef TRACE_SEED_CHAINS
       std::cerr << "Seed validation failed(either contains N or longer than read length)." << std::endl;
@@ -109,9 +112,10 @@ void Mapper::getPositionChains(const Read& read, ChainBuilder& chainBuilder) con
       }
     }
 
-    num_non_sample_seed_chains = std::count_if(chainBuilder.begin(), chainBuilder.end(), [](SeedChain item) {
-      return not item.hasOnlyRandomSamples();
-    });
+    num_non_sample_seed_chains =
+        std::count_if(chainBuilder.begin(), chainBuilder.end(), [](const SeedChain& item) {
+          return not item.hasOnlyRandomSamples();
+        });
     if (globalBestIntvl.isValidExtra(num_non_sample_seed_chains, longest_nonsample_seed_len)) {
 #ifdef TRACE_SEED_CHAINS
       std::cerr << "Sampling from global best interval:\t" << globalBestIntvl.getStart() << ":"
@@ -130,6 +134,82 @@ void Mapper::getPositionChains(const Read& read, ChainBuilder& chainBuilder) con
   chainBuilder.filterChains();
 }
 
+bool Mapper::getSparsePositionChain(const Read& read, ChainBuilder& chainBuilder) const
+{
+  chainBuilder.clear();
+  const unsigned seedLength = hashtable_->getPrimarySeedBases();
+  chainBuilder.setFilterConstant(seedLength);
+  const std::vector<size_t>& seedOffsets = getSeedOffsets(read.getLength());
+  // non-overlapping seeds, plus the last one to cover the end of the read
+  sparseSeedOffsets_.clear();
+  for (const auto seedOffset : seedOffsets) {
+    if (sparseSeedOffsets_.empty() || (sparseSeedOffsets_.back() + seedLength <= seedOffset)) {
+      sparseSeedOffsets_.push_back(seedOffset);
+    }
+  }
+  if (!seedOffsets.empty() && (seedOffsets.back() != sparseSeedOffsets_.back())) {
+    sparseSeedOffsets_.push_back(seedOffsets.back());
+  }
+  seedEncoder_.encode(read, seedLength, sparseSeedOffsets_);
+  seedEncoder_.hash(*getHashtable()->getPrimaryHasher());
+  unsigned hitCount = 0;
+  for (size_t i = 0; i != sparseSeedOffsets_.size(); ++i) {
+    if (!Seed::isValid(read, sparseSeedOffsets_[i], seedLength)) {
+      continue;
+    }
+    hashRecords_.clear();
+    extendTableIntervals_.clear();
+    getHits(seedEncoder_.getHash(i), false);
+    // anything but a single HIT (or none) means a repetitive seed
+    const HashRecord* hit      = nullptr;
+    bool              isUnique = extendTableIntervals_.empty();
+    for (const auto& record : hashRecords_) {
+      if (record.isDummyHit()) {
+        continue;
+      }
+      isUnique = isUnique && record.isHit() && (nullptr == hit);
+      hit      = &record;
+    }
+    if (!isUnique) {
+      chainBuilder.clear();
+      return false;
+    }
+    if (nullptr != hit) {
+      const Seed seed(&read, sparseSeedOffsets_[i], seedLength);
+      const bool orientation    = (seedEncoder_.isReverseComplement(i) ^ hit->isReverseComplement());
+      const bool isRandomSample = false;
+      chainBuilder.addSeedPosition(SeedPosition(seed, hit->getPosition(), 0), orientation, isRandomSample);
+      ++hitCount;
+    }
+  }
+  hashRecords_.clear();
+  if ((MIN_SPARSE_SEED_HITS > hitCount) || (1 != chainBuilder.size())) {
+    chainBuilder.clear();
+    return false;
+  }
+  chainBuilder.filterChains();
+  return true;
+}
+
+const std::vector<size_t>& Mapper::getSeedOffsets(const unsigned readLength) const
+{
+  constexpr int32_t  SEED_PERIOD        = 2;
+  constexpr uint32_t SEED_PATTERN       = 0x01;
+  constexpr uint8_t  FORCE_LAST_N_SEEDS = 0;  //1;
+  // the seed offsets only depend on the read length, which rarely changes from one read to the next
+  if (readLength != seedOffsetsReadLength_) {
+    Seed::getSeedOffsets(
+        readLength,
+        hashtable_->getPrimarySeedBases(),
+        SEED_PERIOD,
+        SEED_PATTERN,
+        FORCE_LAST_N_SEEDS,
+        seedOffsets_);
+    seedOffsetsReadLength_ = readLength;
+  }
+  return seedOffsets_;
+}
+
 void Mapper::addRandomSamplesToPositionChains(
     const Seed&                    seed,
     const bool                     seedIsReverseComplement,
@@ -169,8 +249,29 @@ uint64_t Mapper::getExtendedKey(
   return shiftedExtensionIdBin | shiftedExtensionId | extendBases;
 }
 
+void Mapper::getHits(const uint64_t hash, const bool isExtended) const
+{
+  if (!hotSeedCache_.isEnabled()) {
+    getHashtable()->getHits(hash, isExtended, hashRecords_, extendTableIntervals_);
+    return;
+  }
+  if (hotSeedCache_.get(hash, isExtended, hashRecords_, extendTableIntervals_)) {
+    return;
+  }
+  const auto intervalCount  = extendTableIntervals_.size();
+  const auto bucketAccesses = getHashtable()->getHits(hash, isExtended, hashRecords_, extendTableIntervals_);
+  hotSeedCache_.put(
+      hash,
+      isExtended,
+      bucketAccesses,
+      hashRecords_,
+      (intervalCount != extendTableIntervals_.size()) ? &extendTableIntervals_.back() : nullptr);
+}
+
 void Mapper::addToPositionChains(
     const Seed&                       seed,
+    const bool                        seedIsReverseComplement,
+    const uint64_t                    hash,
     ChainBuilder&                     chainBuilder,
     std::vector<BestIntervalTracker>& globalBestIntvls,
     uint32_t&                         longest_nonsample_seed_len,
@@ -183,13 +284,8 @@ void Mapper::addToPositionChains(
   hashRecords_.clear();
   extendTableIntervals_.clear();
 
-  unsigned   fromHalfExtension       = 0;  // all seeds start as primary seeds
-  const auto forwardData             = seed.getPrimaryData(false);
-  const auto reverseData             = seed.getPrimaryData(true);
-  const bool seedIsReverseComplement = (reverseData < forwardData);
-  const auto primaryData             = seedIsReverseComplement ? reverseData : forwardData;
-  const auto hash                    = getHashtable()->getPrimaryHasher()->getHash64(primaryData);
-  getHashtable()->getHits(hash, false, hashRecords_, extendTableIntervals_);
+  unsigned fromHalfExtension = 0;  // all seeds start as primary seeds
+  getHits(hash, false);
 
   ////////////////
   // std::cerr << "Mapper::addToPositionChains: found " << hashRecords.size() << " hash records:";
@@ -256,7 +352,7 @@ void Mapper::addToPositionChains(
       const auto extendedKey =
           getExtendedKey(seed, extensionHash, extendRecord, fromHalfExtension, seedIsReverseComplement);
       const auto extendedHash = addressSegment | getHashtable()->getSecondaryHasher()->getHash64(extendedKey);
-      getHashtable()->getHits(extendedHash, true, hashRecords_, extendTableIntervals_);
+      getHits(extendedHash, true);
       fromHalfExtension += extendRecord.getExtensionLength() / 2;
       extensionHash = extendedHash;
 
@@ -369,10 +465,10 @@ void Mapper::addToPositionChains(
       num_extension_failure++;
       if (num_extension_failure > MAX_HIFREQ_HITS) return;
 
-      std::vector<ExtendTableRecord> sampledExtendHashRecords;
-      getRandomSamplesFromMatchInterval(seed, 1, start, length, sampledExtendHashRecords);
-      if (!sampledExtendHashRecords.empty()) {
-        const auto& record         = sampledExtendHashRecords.front();
+      sampledExtendHashRecords_.clear();
+      getRandomSamplesFromMatchInterval(seed, 1, start, length, sampledExtendHashRecords_);
+      if (!sampledExtendHashRecords_.empty()) {
+        const auto& record         = sampledExtendHashRecords_.front();
         const bool  isRandomSample = true;
         const bool  orientation    = (seedIsReverseComplement ^ record.isReverseComplement());
         chainBuilder.addSeedPosition(
@@ -434,15 +530,15 @@ void Mapper::addExtraIntervalSamplesToPositionChains(
     }
   } else  // random sample
   {
-    std::vector<ExtendTableRecord> sampledExtendHashRecords;
+    sampledExtendHashRecords_.clear();
     getRandomSamplesFromMatchInterval(
         seed,
         BestIntervalTracker::intvl_sample_hits,
         bestIntvl.getStart(),
         bestIntvl.getLength(),
-        sampledExtendHashRecords);
+        sampledExtendHashRecords_);
 
-    for (const auto& record : sampledExtendHashRecords) {
+    for (const auto& record : sampledExtendHashRecords_) {
       const bool isRandomSample = true;
       const bool orientation    = (seedIsReverseComplement ^ record.isReverseComplement());
       chainBuilder.addSeedPosition(
@@ -462,15 +558,17 @@ void Mapper::getRandomSamplesFromMatchInterval(
     const uint32_t                  intvl_len,
     std::vector<ExtendTableRecord>& hashRecords) const
 {
-  auto read     = seed.getRead();
-  auto readName = read->getName();
+  const auto  read     = seed.getRead();
+  const auto& readName = read->getName();
 
   uint32_t sampledIndex = 0;
   uint32_t SEED         = 0;  // 32-bit SEED for random sampling
   uint32_t maxRounds    = 0;  // failsafe, maximum sampling rounds
 
-  std::bitset<0x4000>          hitVector;
-  std::unordered_set<uint32_t> alreadyFetchedIntvlPos;
+  std::bitset<0x4000> hitVector;
+  // at most sampleSize positions: a linear search is cheaper than a hash set
+  std::vector<uint32_t>& alreadyFetchedIntvlPos = alreadyFetchedIntvlPos_;
+  alreadyFetchedIntvlPos.clear();
 
   // Calculate SEED for random sampling
   // For 1 random sample after failed seed extension:
@@ -511,7 +609,8 @@ void Mapper::getRandomSamplesFromMatchInterval(
 #endif
 
     // filter record
-    if (alreadyFetchedIntvlPos.find(record.getPosition()) != alreadyFetchedIntvlPos.end() ||
+    if (std::find(alreadyFetchedIntvlPos.begin(), alreadyFetchedIntvlPos.end(), record.getPosition()) !=
+            alreadyFetchedIntvlPos.end() ||
         ExtendTableRecord::LiftCode::ALT == record.getLiftCode() ||
         ExtendTableRecord::LiftCode::DIF_PRI == record.getLiftCode()) {
 #ifdef TRACE_SEED_CHAINS
@@ -536,7 +635,7 @@ void Mapper::getRandomSamplesFromMatchInterval(
 #endif
 
     hitVector.set(sampledIndex);
-    alreadyFetchedIntvlPos.insert(record.getPosition());
+    alreadyFetchedIntvlPos.push_back(record.getPosition());
 
     hashRecords.push_back(record);
     K++;
@@ -14,6 +14,7 @@
 
 #include "map/SeedChain.hpp"
 
+#include <algorithm>
 #include <boost/assert.hpp>
 #include <cstdlib>
 #include <limits>
@@ -53,11 +54,6 @@ bool SeedChain::accepts(const SeedPosition& seedPosition, const bool reverseComp
   return passesDiameterTest(seedPosition.getSeed().getReadPosition(), diagonal) && passesRadiusTest(diagonal);
 }
 
-uint32_t SeedChain::getDiagonal(const Seed& seed, const uint32_t referencePosition) const
-{
-  return referencePosition + (reverseComplement_ ? seed.getReadPosition() : -seed.getReadPosition());
-}
-
 bool SeedChain::passesInversionTest(const SeedPosition& seedPosition) const
 {
   // original values
@@ -158,14 +154,25 @@ void SeedChain::updateReadBase(const SeedPosition& a)
 void SeedChain::updateDiagonalTable(const SeedPosition& seedPosition)
 {
   auto lastSeedOffset = seedPosition.getSeed().getReadPosition();
-  for (auto it = diagonalTable_.cbegin(); it != diagonalTable_.cend();) {
-    if (it->second / LARGE_QUANTIZER + ANCIENT < lastSeedOffset / LARGE_QUANTIZER) {
-      diagonalTable_.erase(it++);
-    } else {
-      ++it;
-    }
+  diagonalTable_.erase(
+      std::remove_if(
+          diagonalTable_.begin(),
+          diagonalTable_.end(),
+          [lastSeedOffset](const std::pair<uint32_t, uint32_t>& kv) {
+            return kv.second / LARGE_QUANTIZER + ANCIENT < lastSeedOffset / LARGE_QUANTIZER;
+          }),
+      diagonalTable_.end());
+  const uint32_t diagonal = getDiagonal(seedPosition);
+  const auto     it       = std::lower_bound(
+      diagonalTable_.begin(),
+      diagonalTable_.end(),
+      diagonal,
+      [](const std::pair<uint32_t, uint32_t>& kv, const uint32_t d) { return kv.first < d; });
+  if ((diagonalTable_.end() != it) && (diagonal == it->first)) {
+    it->second = lastSeedOffset;
+  } else {
+    diagonalTable_.emplace(it, diagonal, lastSeedOffset);
   }
-  diagonalTable_[getDiagonal(seedPosition)] = lastSeedOffset;
 }
 
 void SeedChain::updateRefBase(const SeedPosition& a)
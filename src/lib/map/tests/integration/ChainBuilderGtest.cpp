@@ -1,5 +1,10 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
 #include "map/ChainBuilder.hpp"
 
 TEST(ChainBuilder, Constructor)
@@ -26,3 +31,155 @@ TEST(ChainBuilder, Clear)
 {
   // FAIL() << "NOT IMPLEMENTED";
 }
+
+namespace {
+
+using dragenos::map::ChainBuilder;
+using dragenos::map::SeedChain;
+using dragenos::map::SeedPosition;
+using dragenos::sequences::Read;
+using dragenos::sequences::Seed;
+
+// reference implementation: test all the chains
+void addSeedPositionLinear(
+    std::vector<SeedChain>& chains, const SeedPosition& seedPosition, const bool rc, const bool randomSample)
+{
+  bool accepted = false;
+  for (auto& chain : chains) {
+    if (chain.accepts(seedPosition, rc)) {
+      chain.addSeedPosition(seedPosition, randomSample);
+      accepted = true;
+    }
+  }
+  if (!accepted) {
+    chains.emplace_back();
+    chains.back().setReverseComplement(rc);
+    chains.back().addSeedPosition(seedPosition, randomSample);
+  }
+}
+
+void expectSameChains(const std::vector<SeedChain>& expected, const ChainBuilder& chainBuilder)
+{
+  ASSERT_EQ(expected.size(), chainBuilder.size());
+  for (std::size_t i = 0; expected.size() > i; ++i) {
+    const SeedChain& e = expected[i];
+    const SeedChain& c = chainBuilder.at(i);
+    ASSERT_EQ(e.isReverseComplement(), c.isReverseComplement()) << "chain " << i;
+    ASSERT_EQ(e.getInitialDiagonal(), c.getInitialDiagonal()) << "chain " << i;
+    ASSERT_EQ(e.getReadCovLength(), c.getReadCovLength()) << "chain " << i;
+    ASSERT_EQ(e.firstReferencePosition(), c.firstReferencePosition()) << "chain " << i;
+    ASSERT_EQ(e.lastReferencePosition(), c.lastReferencePosition()) << "chain " << i;
+    ASSERT_EQ(e.size(), c.size()) << "chain " << i;
+    for (auto ei = e.begin(), ci = c.begin(); e.end() != ei; ++ei, ++ci) {
+      ASSERT_EQ(ei->getReferencePosition(), ci->getReferencePosition()) << "chain " << i;
+      ASSERT_EQ(ei->getSeed().getReadPosition(), ci->getSeed().getReadPosition()) << "chain " << i;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(ChainBuilder, SameAsLinearScan)
+{
+  Read read;
+  read.init(Read::Name(), Read::Bases(151), Read::Qualities(151), 0, 0);
+  std::mt19937 gen(3);
+  for (int iteration = 0; 50 > iteration; ++iteration) {
+    // repeat-like: many copies of the read, some close to each other, to the ends of the
+    // reference positions and across diagonal bins, with small indels
+    std::vector<uint32_t> copies(1 + gen() % 200);
+    for (auto& copy : copies) {
+      switch (gen() % 4) {
+      case 0: copy = gen() % 2000; break;
+      case 1: copy = std::numeric_limits<uint32_t>::max() - gen() % 2000; break;
+      default: copy = 1000000 + gen() % 20000; break;
+      }
+    }
+    ChainBuilder           chainBuilder(0.5);
+    std::vector<SeedChain> expected;
+    for (unsigned readPosition = 0; 130 > readPosition; readPosition += 1 + gen() % 8) {
+      const Seed seed(&read, readPosition, 21);
+      for (const auto copy : copies) {
+        const bool         rc           = gen() % 2;
+        const bool         randomSample = (0 == gen() % 8);
+        const uint32_t     indel        = (0 == gen() % 10) ? gen() % 64 : 0;
+        const SeedPosition seedPosition(seed, copy + readPosition + indel, gen() % 2);
+        chainBuilder.addSeedPosition(seedPosition, rc, randomSample);
+        addSeedPositionLinear(expected, seedPosition, rc, randomSample);
+      }
+    }
+    expectSameChains(expected, chainBuilder);
+    chainBuilder.clear();
+    ASSERT_EQ(0u, chainBuilder.size());
+  }
+}
+
+TEST(ChainBuilder, SortAndAddSeedChain)
+{
+  Read read;
+  read.init(Read::Name(), Read::Bases(151), Read::Qualities(151), 0, 0);
+  std::mt19937           gen(5);
+  ChainBuilder           chainBuilder(0.5);
+  std::vector<SeedChain> expected;
+  const auto             compare = [](const SeedChain& l, const SeedChain& r) {
+    return l.getInitialDiagonal() > r.getInitialDiagonal();
+  };
+  for (unsigned readPosition = 0; 130 > readPosition; readPosition += 10) {
+    const Seed seed(&read, readPosition, 21);
+    for (int i = 0; 50 > i; ++i) {
+      const SeedPosition seedPosition(seed, gen() % 100000 + readPosition, 0);
+      chainBuilder.addSeedPosition(seedPosition, false, false);
+      addSeedPositionLinear(expected, seedPosition, false, false);
+    }
+    if (60 == readPosition) {
+      // the index must follow the chains when they are moved around
+      chainBuilder.sort(compare);
+      std::sort(expected.begin(), expected.end(), compare);
+      SeedChain extra;
+      extra.addSeedPosition(SeedPosition(seed, 5000 + readPosition, 0), false);
+      chainBuilder.addSeedChain(extra);
+      expected.push_back(extra);
+    }
+  }
+  expectSameChains(expected, chainBuilder);
+
+  // empty chains accept everything
+  chainBuilder.addSeedChain(SeedChain());
+  expected.push_back(SeedChain());
+  const SeedPosition seedPosition(Seed(&read, 140, 11), 77777, 0);
+  chainBuilder.addSeedPosition(seedPosition, false, false);
+  addSeedPositionLinear(expected, seedPosition, false, false);
+  expectSameChains(expected, chainBuilder);
+}
+
+TEST(ChainBuilder, RemoveChains)
+{
+  Read read;
+  read.init(Read::Name(), Read::Bases(151), Read::Qualities(151), 0, 0);
+  ChainBuilder chainBuilder(2.0);
+  // the best chain, reverse complemented and covering the whole read, filters the shorter one
+  for (unsigned readPosition = 0; 130 >= readPosition; readPosition += 10) {
+    chainBuilder.addSeedPosition(SeedPosition(Seed(&read, readPosition, 21), 2000 - readPosition, 0), true, false);
+  }
+  for (unsigned readPosition = 40; 60 >= readPosition; readPosition += 20) {
+    chainBuilder.addSeedPosition(
+        SeedPosition(Seed(&read, readPosition, 21), 500000 + readPosition, 0), false, false);
+  }
+  chainBuilder.filterChains();
+  ASSERT_EQ(2u, chainBuilder.size());
+  ASSERT_FALSE(chainBuilder.at(0).isFiltered());
+  ASSERT_TRUE(chainBuilder.at(1).isFiltered());
+
+  ASSERT_EQ(0u, chainBuilder.removeChains([](const SeedChain&) { return false; }));
+  ASSERT_TRUE(chainBuilder.at(1).isFiltered());
+
+  // without the best chain, the other one is not filtered anymore
+  ASSERT_EQ(1u, chainBuilder.removeChains([](const SeedChain& chain) { return chain.isReverseComplement(); }));
+  ASSERT_EQ(1u, chainBuilder.size());
+  ASSERT_FALSE(chainBuilder.at(0).isReverseComplement());
+  ASSERT_FALSE(chainBuilder.at(0).isFiltered());
+  // and the index follows the remaining chains
+  chainBuilder.addSeedPosition(SeedPosition(Seed(&read, 80, 21), 500080, 0), false, false);
+  ASSERT_EQ(1u, chainBuilder.size());
+  ASSERT_EQ(3u, chainBuilder.at(0).size());
+}
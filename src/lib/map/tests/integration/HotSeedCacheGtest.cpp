@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "map/HotSeedCache.hpp"
+
+using dragenos::map::HotSeedCache;
+using dragenos::reference::ExtendTableInterval;
+using dragenos::reference::HashRecord;
+
+namespace {
+
+HashRecord makeRecord(const uint64_t value)
+{
+  return *reinterpret_cast<const HashRecord*>(&value);
+}
+
+std::vector<HashRecord> makeHits(const unsigned count, const uint32_t firstPosition)
+{
+  std::vector<HashRecord> hits;
+  for (unsigned i = 0; count > i; ++i) {
+    hits.push_back(makeRecord(firstPosition + i));
+  }
+  return hits;
+}
+
+// INTERVAL_SL0: Length[23:15] Start[14:0]
+ExtendTableInterval makeInterval(const uint32_t start, const uint32_t length)
+{
+  const uint64_t type = (uint64_t(0xF) << HashRecord::NOT_HIT_START) |
+                        (uint64_t(HashRecord::INTERVAL_SL) << HashRecord::OP_CODE_START);
+  const std::vector<HashRecord> records{makeRecord(type | (length << 15) | start)};
+  return ExtendTableInterval(records.begin(), records.end());
+}
+
+}  // namespace
+
+TEST(HotSeedCache, Disabled)
+{
+  HotSeedCache cache(0, 1);
+  ASSERT_FALSE(cache.isEnabled());
+}
+
+TEST(HotSeedCache, GetAfterPut)
+{
+  HotSeedCache cache(1000, 2);
+  ASSERT_TRUE(cache.isEnabled());
+  std::vector<HashRecord>          hits = makeHits(3, 100);
+  std::vector<ExtendTableInterval> intervals;
+  ASSERT_FALSE(cache.get(42, false, hits, intervals));
+  // not enough bucket accesses
+  cache.put(42, false, 1, makeHits(3, 100), nullptr);
+  ASSERT_FALSE(cache.get(42, false, hits, intervals));
+  cache.put(42, false, 2, makeHits(3, 100), nullptr);
+  hits.clear();
+  ASSERT_TRUE(cache.get(42, false, hits, intervals));
+  ASSERT_EQ(3u, hits.size());
+  ASSERT_EQ(102u, hits.back().getPosition());
+  ASSERT_TRUE(intervals.empty());
+  // the extended flag is part of the key
+  ASSERT_FALSE(cache.get(42, true, hits, intervals));
+
+  const auto interval = makeInterval(1000, 20);
+  cache.put(43, true, 5, std::vector<HashRecord>(), &interval);
+  intervals.push_back(makeInterval(0, 300));
+  ASSERT_TRUE(cache.get(43, true, hits, intervals));
+  ASSERT_TRUE(hits.empty());
+  ASSERT_EQ(2u, intervals.size());
+  ASSERT_EQ(1000u, intervals.back().getStart());
+  ASSERT_EQ(20u, intervals.back().getLength());
+
+  // too many hits to be cached
+  cache.put(44, false, 5, makeHits(HotSeedCache::MAX_HITS + 1, 0), nullptr);
+  ASSERT_FALSE(cache.get(44, false, hits, intervals));
+
+  const auto& statistics = cache.getStatistics();
+  ASSERT_EQ(6u, statistics.lookups_);
+  ASSERT_EQ(2u, statistics.hits_);
+  ASSERT_EQ(2u, statistics.inserts_);
+}
+
+TEST(HotSeedCache, BoundedMemory)
+{
+  HotSeedCache                     cache(16, 1);
+  std::vector<HashRecord>          hits;
+  std::vector<ExtendTableInterval> intervals;
+  for (uint64_t hash = 0; 1000 > hash; ++hash) {
+    cache.put(hash, false, 1, makeHits(1, hash + 1), nullptr);
+  }
+  unsigned found = 0;
+  for (uint64_t hash = 0; 1000 > hash; ++hash) {
+    if (cache.get(hash, false, hits, intervals)) {
+      ASSERT_EQ(hash + 1, hits.front().getPosition());
+      ++found;
+    }
+  }
+  ASSERT_GE(16u, found);
+  ASSERT_LT(0u, found);
+  ASSERT_EQ(1000u, cache.getStatistics().inserts_);
+  // every slot keeps the last hash stored into it
+  ASSERT_EQ(1000u - found, cache.getStatistics().evictions_);
+}
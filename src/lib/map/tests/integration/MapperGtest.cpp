@@ -0,0 +1,238 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "common/AllocationCounter.hpp"
+#include "map/Mapper.hpp"
+
+// heap allocations made by the test program: with COUNT_ALLOCATIONS=1 the common library replaces the global
+// operator new, otherwise the test does. The operators are kept out of line to prevent mismatched new/delete
+// false positives at the inlined call sites
+#ifdef DRAGEN_OS_COUNT_ALLOCATIONS
+namespace {
+std::size_t getAllocationCount()
+{
+  return dragenos::common::getAllocationCount();
+}
+}  // namespace
+#else
+namespace {
+std::atomic<std::size_t> allocationCount(0);
+std::size_t              getAllocationCount()
+{
+  return allocationCount.load();
+}
+}  // namespace
+
+__attribute__((noinline)) void* operator new(const std::size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  void* ret = std::malloc(size ? size : 1);
+  if (nullptr == ret) {
+    throw std::bad_alloc();
+  }
+  return ret;
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+#endif  // #ifdef DRAGEN_OS_COUNT_ALLOCATIONS
+
+using namespace dragenos;
+typedef reference::Hashtable       Hashtable;
+typedef reference::HashtableConfig HashtableConfig;
+typedef reference::HashRecord      HashRecord;
+typedef sequences::Read            Read;
+typedef sequences::Seed            Seed;
+
+namespace {
+
+/**
+ ** \brief small hashtable with one HIT record per reference seed, built in memory
+ **
+ ** Same geometry and polynomials as the tiny test hashtables: 17 bases seeds, 35 bits
+ ** CRC and 64KB of buckets.
+ **/
+class SyntheticHashtable {
+public:
+  static constexpr unsigned SEED_LENGTH = 17;
+
+  explicit SyntheticHashtable(const Read::Bases& reference)
+    : configData_(makeConfigData()),
+      config_(configData_.data(), configData_.size()),
+      table_(config_.getHashtableRecordCount(), EMPTY_RECORD),
+      hashtable_(&config_, table_.data(), nullptr)
+  {
+    Read read;
+    initRead(read, reference);
+    // hit records for each thread of each bucket, in reference order
+    std::map<uint64_t, std::map<uint8_t, std::vector<uint64_t>>> buckets;
+    for (unsigned position = 0; position + SEED_LENGTH <= reference.size(); ++position) {
+      const Seed     seed(&read, position, SEED_LENGTH);
+      const auto     forwardData        = seed.getPrimaryData(false);
+      const auto     reverseData        = seed.getPrimaryData(true);
+      const bool     reverseComplement  = (reverseData < forwardData);
+      const auto     hash               = hashtable_.getPrimaryHasher()->getHash64(
+          reverseComplement ? reverseData : forwardData);
+      const auto     virtualByteAddress = hashtable_.getVirtualByteAddress(hash);
+      const auto     bucketIndex        = hashtable_.getBucketIndex(virtualByteAddress);
+      const uint8_t  threadId           = hashtable_.getThreadIdFromVirtualByteAddress(virtualByteAddress);
+      const uint64_t matchBits          = hashtable_.getMatchBits(hash, false);
+      buckets[bucketIndex][threadId].push_back(
+          (matchBits << HashRecord::MATCH_BITS_START) |
+          (uint64_t(reverseComplement) << HashRecord::RC_FLAG) | (REFERENCE_START + position));
+    }
+    for (const auto& bucket : buckets) {
+      unsigned record = 0;
+      for (const auto& thread : bucket.second) {
+        // drop the seeds that don't fit in their bucket
+        if (thread.second.size() + record > Hashtable::getRecordsPerBucket()) {
+          continue;
+        }
+        for (const auto value : thread.second) {
+          table_[bucket.first * Hashtable::getRecordsPerBucket() + record++] = value;
+        }
+        table_[bucket.first * Hashtable::getRecordsPerBucket() + record - 1] |= uint64_t(1)
+                                                                                << HashRecord::LF_FLAG;
+      }
+    }
+  }
+  const Hashtable* get() const { return &hashtable_; }
+
+  static void initRead(Read& read, const Read::Bases& bases)
+  {
+    const std::string name = "read";
+    read.init(
+        Read::Name(name.begin(), name.end()), Read::Bases(bases), Read::Qualities(bases.size(), 30), 0, 0);
+  }
+
+private:
+  static constexpr uint64_t EMPTY_RECORD    = uint64_t(0xF) << HashRecord::NOT_HIT_START;
+  static constexpr uint32_t REFERENCE_START = 1000;
+
+  const std::vector<char> configData_;
+  const HashtableConfig   config_;
+  std::vector<uint64_t>   table_;
+  const Hashtable         hashtable_;
+
+  static std::vector<char> makeConfigData()
+  {
+    HashtableConfig::Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.hashtableVersion = 8;
+    header.hashtableBytes   = 65536;
+    header.priSeedBases     = SEED_LENGTH;
+    header.tableSize64ths   = 64;
+    header.maxSeedFreq      = 16;
+    header.priCrcBits       = 35;
+    header.secCrcBits       = 35;
+    const std::array<uint8_t, 8> polynomial{0xcd, 0x51, 0xd4, 0x66, 0x06, 0, 0, 0};
+    std::copy(polynomial.begin(), polynomial.end(), header.priCrcPoly);
+    std::copy(polynomial.begin(), polynomial.end(), header.secCrcPoly);
+    // followed by the empty strings for the versions, command line and file names
+    std::vector<char> data(sizeof(header) + 64, 0);
+    std::memcpy(data.data(), &header, sizeof(header));
+    return data;
+  }
+};
+
+Read::Bases randomBases(std::mt19937& gen, const std::size_t length)
+{
+  static const std::array<Read::Base, 4> bases{1, 2, 4, 8};
+  Read::Bases                            ret(length);
+  for (auto& b : ret) {
+    b = bases[gen() % bases.size()];
+  }
+  return ret;
+}
+
+}  // namespace
+
+TEST(Mapper, getPositionChainsWithoutAllocations)
+{
+  std::mt19937      gen(23);
+  const auto        reference = randomBases(gen, 4000);
+  SyntheticHashtable hashtable(reference);
+  const map::Mapper mapper(hashtable.get());
+
+  // reads from the reference with a few mismatches, of a couple of different lengths
+  std::vector<Read> reads(40);
+  for (auto& read : reads) {
+    const std::size_t length   = (gen() % 2) ? 151 : 101;
+    const std::size_t position = gen() % (reference.size() - length);
+    Read::Bases       bases(reference.begin() + position, reference.begin() + position + length);
+    for (unsigned i = 0; 3 > i; ++i) {
+      bases[gen() % length] = 1 << (gen() % 4);
+    }
+    SyntheticHashtable::initRead(read, bases);
+  }
+
+  map::ChainBuilder chainBuilder(4.0);
+  for (const auto& read : reads) {
+    mapper.getPositionChains(read, chainBuilder);
+    ASSERT_LT(0u, chainBuilder.size());
+  }
+  // all the buffers have reached their working size
+  const std::size_t before = getAllocationCount();
+  for (const auto& read : reads) {
+    mapper.getPositionChains(read, chainBuilder);
+  }
+  ASSERT_EQ(before, getAllocationCount());
+}
+
+TEST(Mapper, getSparsePositionChain)
+{
+  std::mt19937 gen(29);
+  auto         reference = randomBases(gen, 4000);
+  // repeated region
+  std::copy(reference.begin() + 500, reference.begin() + 800, reference.begin() + 2500);
+  SyntheticHashtable hashtable(reference);
+  const map::Mapper  mapper(hashtable.get());
+
+  map::ChainBuilder sparse(4.0);
+  map::ChainBuilder full(4.0);
+  Read              read;
+  for (const std::size_t position : {100, 1200, 3300}) {
+    for (const bool reverseComplement : {false, true}) {
+      Read::Bases bases(reference.begin() + position, reference.begin() + position + 151);
+      if (reverseComplement) {
+        std::reverse(bases.begin(), bases.end());
+        for (auto& b : bases) {
+          // 4 bits per base: A=1, C=2, G=4, T=8
+          b = ((b & 1) << 3) | ((b & 2) << 1) | ((b & 4) >> 1) | ((b & 8) >> 3);
+        }
+      }
+      SyntheticHashtable::initRead(read, bases);
+      ASSERT_TRUE(mapper.getSparsePositionChain(read, sparse)) << position;
+      ASSERT_EQ(1u, sparse.size());
+      mapper.getPositionChains(read, full);
+      ASSERT_EQ(1u, full.size());
+      ASSERT_EQ(full.at(0).isReverseComplement(), sparse.at(0).isReverseComplement());
+      ASSERT_EQ(reverseComplement, sparse.at(0).isReverseComplement());
+      ASSERT_EQ(full.at(0).firstReferencePosition(), sparse.at(0).firstReferencePosition());
+    }
+  }
+  // repetitive seeds fall back to full seeding
+  SyntheticHashtable::initRead(
+      read, Read::Bases(reference.begin() + 550, reference.begin() + 550 + 151));
+  ASSERT_FALSE(mapper.getSparsePositionChain(read, sparse));
+  ASSERT_EQ(0u, sparse.size());
+  // as well as reads with too few seed hits
+  SyntheticHashtable::initRead(read, randomBases(gen, 151));
+  ASSERT_FALSE(mapper.getSparsePositionChain(read, sparse));
+}
@@ -40,7 +40,8 @@ namespace bfs = boost::filesystem;
 using boost::format;
 using common::InvalidOptionException;
 
-DragenOsOptions::DragenOsOptions() : refDir_("./"), inputFile1_(""), inputFile2_(""), mapOnly_(false)
+DragenOsOptions::DragenOsOptions(const bool inputRequired)
+  : inputRequired_(inputRequired), refDir_("./"), mapOnly_(false)
 {
   // deprecated command line options. Still valid but will error when conflict with official ones or warning
   // when the corresponding official is not being used instead.
@@ -53,11 +54,22 @@ DragenOsOptions::DragenOsOptions() : refDir_("./"), inputFile1_(""), inputFile2_
       "ref-dir,r",
       bpo::value<decltype(refDir_)>(&refDir_),
       "directory with reference and hash tables. Must contain the uncompressed hashtable.")(
-      "fastq-file1,1", bpo::value<std::string>(&inputFile1_), "FASTQ file to send to card (may be gzipped)")(
+      "fastq-file1,1",
+      bpo::value<decltype(inputFiles1_)>(&inputFiles1_)->multitoken()->composing(),
+      "FASTQ file to send to card (may be gzipped). Several files or quoted glob patterns give several lanes, "
+      "read concurrently and aligned as separate read groups.")(
       "fastq-file2,2",
-      bpo::value<std::string>(&inputFile2_),
-      "Second FASTQ file with paired-end reads (may be gzipped)")(
-      "bam-input,b", bpo::value<std::string>(&inputFile1_), "Input BAM file")(
+      bpo::value<decltype(inputFiles2_)>(&inputFiles2_)->multitoken()->composing(),
+      "Second FASTQ file with paired-end reads (may be gzipped), one for each lane of fastq-file1")(
+      "bam-input,b", bpo::value<decltype(inputFiles1_)>(&inputFiles1_), "Input BAM file")(
+      "fastq-list",
+      bpo::value<std::string>(&fastqList_),
+      "CSV file with one line per read group and lane (RGID,RGSM,RGLB,Lane,Read1File,Read2File), all aligned "
+      "with the reference loaded once. Writes one set of output files per sample, named after the prefix and "
+      "the sample.")(
+      "fastq-list-all-samples",
+      bpo::value<bool>(&fastqListAllSamples_)->default_value(fastqListAllSamples_)->implicit_value(true),
+      "With --fastq-list, write the read groups of all the samples to a single set of output files.")(
       "interleaved",
       bpo::value<bool>(&interleaved_)->default_value(interleaved_)->implicit_value(true),
       "Interleaved paired-end reads in single bam or FASTQ")
@@ -68,6 +80,10 @@ DragenOsOptions::DragenOsOptions() : refDir_("./"), inputFile1_(""), inputFile2_
        bpo::value<bool>(&mmapReference_)->default_value(mmapReference_),
        "memory-map reference data instead of pre-loading. This allows for quicker runs when only a "
        "handful of reads need to be aligned")(
+          "mmap-fastq",
+          bpo::value<bool>(&mmapFastq_)->default_value(mmapFastq_),
+          "memory-map the uncompressed paired-end FASTQ files and align the records in place instead of "
+          "reading them through a stream. Compressed files and single-end reads are always streamed")(
           "RGID", bpo::value<std::string>(&rgid_)->default_value(rgid_), "Read Group ID")(
           "RGSM", bpo::value<std::string>(&rgsm_)->default_value(rgsm_), "Read Group Sample")(
           "output-directory",
@@ -76,9 +92,46 @@ DragenOsOptions::DragenOsOptions() : refDir_("./"), inputFile1_(""), inputFile2_
           "output-file-prefix",
           bpo::value<std::string>(&outputFilePrefix_)->default_value(outputFilePrefix_),
           "Output filename prefix")(
+          "checkpoint-interval",
+          bpo::value<unsigned>(&checkpointInterval_)->default_value(checkpointInterval_),
+          "Seconds between the checkpoints of the progress of paired-end alignments, saved next to the output "
+          "files as <prefix>.checkpoint for --resume. 0 disables them. Requires --output-directory and "
+          "--preserve-map-align-order")(
+          "resume",
+          bpo::value<bool>(&resume_)->default_value(resume_)->implicit_value(true),
+          "Continue from the checkpoint of an interrupted run with the same options: the output files are "
+          "truncated to the checkpoint and the inputs aligned from there. Starts from the beginning when there "
+          "is no checkpoint")(
           "ref-load-hash-bin",
           bpo::value<bool>(&loadReference_)->default_value(loadReference_),
           "Expect to find uncompressed hash table in the reference directory.")(
+          "pack-reference",
+          bpo::value<bool>(&packReference_)->default_value(packReference_),
+          "Keep the reference bases in memory at 2 bits per base, with the N and IUPAC bases stored "
+          "separately. Halves the memory footprint of the reference.")(
+          "ht-cache-dir",
+          bpo::value<decltype(htCacheDirectory_)>(&htCacheDirectory_),
+          "Local directory where the hashtable is decompressed on first use, and memory mapped by the "
+          "following runs. Concurrent runs on the same host share a single decompression.")(
+          "daemon-socket",
+          bpo::value<decltype(daemonSocket_)>(&daemonSocket_),
+          "Load the reference once and serve the alignment jobs submitted on this Unix domain socket, one at a "
+          "time, until a shutdown request. Only the user of the server can submit jobs.")(
+          "submit-socket",
+          bpo::value<decltype(submitSocket_)>(&submitSocket_),
+          "Run the job on the server listening on this socket instead of loading the reference. Requires "
+          "--output-directory, the paths being relative to the current directory.")(
+          "daemon-shutdown",
+          bpo::value<decltype(daemonShutdown_)>(&daemonShutdown_)->default_value(daemonShutdown_),
+          "With --submit-socket, ask the server to exit instead of submitting a job.")(
+          "ref-warmup-threads",
+          bpo::value<decltype(refWarmupThreads_)>(&refWarmupThreads_)->default_value(refWarmupThreads_),
+          "Threads paging in the memory mapped hashtable and reference before the alignment starts. 0 to "
+          "let the pages fault in on demand.")(
+          "ref-warmup-fraction",
+          bpo::value<decltype(refWarmupFraction_)>(&refWarmupFraction_)->default_value(refWarmupFraction_),
+          "Fraction of the memory mapped data paged in before the alignment starts, the rest being paged in "
+          "by the warmup threads in the background.")(
           "fastq-offset",
           bpo::value<int>(&fastqOffset_)->default_value(fastqOffset_),
           "FASTQ quality offset value. Set to 33 or 64")(
@@ -124,6 +177,28 @@ DragenOsOptions::DragenOsOptions() : refDir_("./"), inputFile1_(""), inputFile2_
           "Mapper.filter-len-ratio",
           bpo::value<double>(&mapperFilterLenRatio_)->default_value(mapperFilterLenRatio_),
           "Ratio for controlling seed chain filtering")(
+          "Mapper.hot-seed-cache-size",
+          bpo::value<uint64_t>(&mapperHotSeedCacheSize_)->default_value(mapperHotSeedCacheSize_),
+          "Number of hashtable lookups of repetitive seeds memoized by each mapper thread (0 = disabled)")(
+          "Mapper.hot-seed-cache-min-buckets",
+          bpo::value<unsigned>(&mapperHotSeedCacheMinBuckets_)->default_value(mapperHotSeedCacheMinBuckets_),
+          "Minimum number of hashtable bucket accesses for a lookup to be memoized in the hot seed cache")(
+          "Mapper.sparse-seeding",
+          bpo::value<bool>(&mapperSparseSeeding_)->default_value(mapperSparseSeeding_),
+          "Map the reads with only a few non-overlapping seeds when they all agree on a single unique position "
+          "confirmed by a perfect ungapped alignment, before falling back to full seeding")(
+          "Mapper.target-bed",
+          bpo::value<std::string>(&mapperTargetBed_)->default_value(mapperTargetBed_),
+          "BED file of the targeted regions. Only the reads or pairs with a k-mer of the targets are aligned, "
+          "against the whole genome. The others are reported unmapped")(
+          "Mapper.target-padding",
+          bpo::value<unsigned>(&mapperTargetPadding_)->default_value(mapperTargetPadding_),
+          "Bases added on both sides of the regions of Mapper.target-bed")(
+          "methylation-protocol",
+          bpo::value<std::string>(&methylationProtocol_)->default_value(methylationProtocol_),
+          "Library type of bisulfite sequenced reads: none or directional (C->T converted first reads and G->A "
+          "converted second reads). Aligns against the hashtable built with --ht-methylated, in the "
+          "methyl_converted subdirectory of the reference, and adds the XM, XR and XG methylation tags")(
           "Aligner.pe-orientation",
           bpo::value<unsigned>(&alignerPeOrientation_),
           "Expected paired-end orientation: 0=FR, 1=RF, 2=FF")(
@@ -214,7 +289,8 @@ DragenOsOptions::DragenOsOptions() : refDir_("./"), inputFile1_(""), inputFile2_
                           "Include a random hit with each EXTEND record of this frequency")(
                           "ht-methylated",
                           bpo::value<decltype(htMethylated_)>(&htMethylated_)->default_value(htMethylated_),
-                          "If set to true, generate C->T and G->A converted pair of hashtables")(
+                          "If set to true, generate the hashtable of the C->T and G->A converted reference, in "
+                          "the methyl_converted subdirectory of the output directory")(
                           "ht-num-threads",
                           bpo::value<decltype(htNumThreads_)>(&htNumThreads_),
                           "Worker threads for generating hash table")(
@@ -331,13 +407,55 @@ void DragenOsOptions::postProcess(bpo::variables_map& vm)
       "Aligner.sw-method",
       methodSmithWatermanDeprecated_);
 
-  if (inputFile1_.empty() || boost::filesystem::is_directory(inputFile1_)) {
+  if (!daemonSocket_.empty() && !submitSocket_.empty()) {
+    BOOST_THROW_EXCEPTION(InvalidOptionException("ERROR: daemon-socket and submit-socket are exclusive"));
+  }
+
+  if (daemonShutdown_ && submitSocket_.empty()) {
+    BOOST_THROW_EXCEPTION(InvalidOptionException("ERROR: daemon-shutdown requires submit-socket"));
+  }
+
+  if (!fastqList_.empty()) {
+    if (!inputFiles1_.empty() || !inputFiles2_.empty()) {
+      BOOST_THROW_EXCEPTION(
+          InvalidOptionException("ERROR: fastq-list is exclusive with fastq-file1, fastq-file2 and bam-input"));
+    }
+    if (!fastqListAllSamples_ && outputDirectory_.empty()) {
+      BOOST_THROW_EXCEPTION(InvalidOptionException(
+          "ERROR: Output directory (--output-directory) is required with --fastq-list, unless all the samples go "
+          "to the standard output with --fastq-list-all-samples"));
+    }
+  }
+
+  // the server gets the inputs with the jobs
+  if (inputRequired_ && daemonSocket_.empty() && !daemonShutdown_ && fastqList_.empty()) {
+    const auto isDirectory = [](const std::string& path) { return bfs::is_directory(path); };
+    if (inputFiles1_.empty() || std::any_of(inputFiles1_.begin(), inputFiles1_.end(), isDirectory)) {
+      BOOST_THROW_EXCEPTION(
+          InvalidOptionException("fastq-file1 or bam-input must point to an existing fastq file"));
+    }
+
+    if (std::any_of(inputFiles2_.begin(), inputFiles2_.end(), isDirectory)) {
+      BOOST_THROW_EXCEPTION(InvalidOptionException("fastq-file2 must point to an existing fastq file"));
+    }
+  }
+
+  if (!submitSocket_.empty() && !daemonShutdown_ && outputDirectory_.empty()) {
     BOOST_THROW_EXCEPTION(
-        InvalidOptionException("fastq-file1 or bam-input must point to an existing fastq file"));
+        InvalidOptionException("ERROR: Output directory (--output-directory) is required with --submit-socket"));
+  }
+
+  if ((checkpointInterval_ || resume_) && (outputDirectory_.empty() || !preserveMapAlignOrder_)) {
+    BOOST_THROW_EXCEPTION(InvalidOptionException(
+        "ERROR: --checkpoint-interval and --resume require --output-directory and --preserve-map-align-order"));
   }
 
-  if (!inputFile2_.empty() && boost::filesystem::is_directory(inputFile2_)) {
-    BOOST_THROW_EXCEPTION(InvalidOptionException("fastq-file2 must point to an existing fastq file"));
+  if (("none" != methylationProtocol_) && ("directional" != methylationProtocol_)) {
+    BOOST_THROW_EXCEPTION(
+        InvalidOptionException("ERROR: methylation-protocol must be none or directional: " + methylationProtocol_));
+  }
+  if (isMethylated() && bfs::is_directory(refDir_ / "methyl_converted")) {
+    refDir_ /= "methyl_converted";
   }
 
   if (!alignerPeQuartilesInsert_.empty()) {
@@ -361,6 +479,10 @@ void DragenOsOptions::postProcess(bpo::variables_map& vm)
     samplingEnabled_ = false;
   }
 
+  if ((0.0 > refWarmupFraction_) || (1.0 < refWarmupFraction_)) {
+    BOOST_THROW_EXCEPTION(InvalidOptionException("ERROR: ref-warmup-fraction must be between 0 and 1"));
+  }
+
   if (!outputDirectory_.empty()) {
     if (outputFilePrefix_.empty()) {
       BOOST_THROW_EXCEPTION(InvalidOptionException(
@@ -0,0 +1,221 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "options/FastqList.hpp"
+
+#include <glob.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/regex.hpp>
+
+#include "common/Exceptions.hpp"
+
+namespace dragenos {
+namespace options {
+
+namespace {
+
+std::vector<std::string> splitLine(std::string line)
+{
+  if (!line.empty() && '\r' == line.back()) {
+    line.pop_back();
+  }
+  std::vector<std::string> fields;
+  boost::split(fields, line, boost::is_any_of(","));
+  for (auto& field : fields) {
+    boost::trim(field);
+  }
+  return fields;
+}
+
+std::string resolve(const std::string& fileName, const boost::filesystem::path& directory)
+{
+  return fileName.empty() ? fileName : boost::filesystem::absolute(fileName, directory).string();
+}
+
+}  // namespace
+
+std::vector<FastqListEntry> parseFastqList(std::istream& is, const boost::filesystem::path& directory)
+{
+  using common::InvalidParameterException;
+  std::string line;
+  if (!std::getline(is, line)) {
+    BOOST_THROW_EXCEPTION(InvalidParameterException("ERROR: empty FASTQ list"));
+  }
+  const std::vector<std::string> columns = splitLine(line);
+  const auto                     column  = [&columns](const std::string& name) {
+    const auto found = std::find(columns.begin(), columns.end(), name);
+    return (columns.end() == found) ? -1 : int(found - columns.begin());
+  };
+  const int rgid  = column("RGID");
+  const int rgsm  = column("RGSM");
+  const int rglb  = column("RGLB");
+  const int lane  = column("Lane");
+  const int read1 = column("Read1File");
+  const int read2 = column("Read2File");
+  if ((0 > rgid) || (0 > read1)) {
+    BOOST_THROW_EXCEPTION(
+        InvalidParameterException("ERROR: the FASTQ list header must have the RGID and Read1File columns: " + line));
+  }
+
+  std::vector<FastqListEntry>                                entries;
+  std::map<std::string, std::pair<std::string, std::string>> readGroups;
+  for (std::size_t lineNumber = 2; std::getline(is, line); ++lineNumber) {
+    if (line.empty() || ("\r" == line)) {
+      continue;
+    }
+    const std::vector<std::string> fields = splitLine(line);
+    if (columns.size() != fields.size()) {
+      BOOST_THROW_EXCEPTION(InvalidParameterException(
+          "ERROR: expected " + std::to_string(columns.size()) + " fields on line " + std::to_string(lineNumber) +
+          " of the FASTQ list: " + line));
+    }
+    FastqListEntry entry;
+    entry.readGroupId_ = fields[rgid];
+    entry.read1File_   = resolve(fields[read1], directory);
+    if ((0 <= rgsm) && !fields[rgsm].empty()) {
+      entry.readGroupSample_ = fields[rgsm];
+    }
+    if ((0 <= rglb) && !fields[rglb].empty()) {
+      entry.readGroupLibrary_ = fields[rglb];
+    }
+    if ((0 <= lane) && !fields[lane].empty()) {
+      try {
+        entry.lane_ = std::stoul(fields[lane]);
+      } catch (const std::logic_error&) {
+        BOOST_THROW_EXCEPTION(InvalidParameterException(
+            "ERROR: invalid lane on line " + std::to_string(lineNumber) + " of the FASTQ list: " + line));
+      }
+    }
+    if (0 <= read2) {
+      entry.read2File_ = resolve(fields[read2], directory);
+    }
+    if (entry.readGroupId_.empty() || entry.read1File_.empty()) {
+      BOOST_THROW_EXCEPTION(InvalidParameterException(
+          "ERROR: missing RGID or Read1File on line " + std::to_string(lineNumber) + " of the FASTQ list: " + line));
+    }
+    // the lanes of a read group go to a single @RG line
+    const auto readGroup = readGroups.emplace(
+        entry.readGroupId_, std::make_pair(entry.readGroupSample_, entry.readGroupLibrary_));
+    if (readGroup.first->second != std::make_pair(entry.readGroupSample_, entry.readGroupLibrary_)) {
+      BOOST_THROW_EXCEPTION(InvalidParameterException(
+          "ERROR: read group " + entry.readGroupId_ + " has different samples or libraries in the FASTQ list"));
+    }
+    entries.push_back(entry);
+  }
+  if (entries.empty()) {
+    BOOST_THROW_EXCEPTION(InvalidParameterException("ERROR: no read group in the FASTQ list"));
+  }
+  return entries;
+}
+
+std::vector<FastqListEntry> loadFastqList(const boost::filesystem::path& path)
+{
+  std::ifstream is(path.string());
+  if (!is) {
+    BOOST_THROW_EXCEPTION(common::IoException(
+        errno, "Failed to open FASTQ list: " + path.string() + ": " + std::strerror(errno)));
+  }
+  return parseFastqList(is, boost::filesystem::absolute(path).parent_path());
+}
+
+std::vector<std::size_t> getReadGroupPositions(
+    const std::vector<FastqListEntry>& fastqList, const std::vector<std::size_t>& indexes)
+{
+  std::vector<std::string> readGroupIds;
+  std::vector<std::size_t> positions;
+  for (const auto index : indexes) {
+    const std::string& readGroupId = fastqList.at(index).readGroupId_;
+    positions.push_back(
+        std::find(readGroupIds.begin(), readGroupIds.end(), readGroupId) - readGroupIds.begin());
+    if (readGroupIds.size() == positions.back()) {
+      readGroupIds.push_back(readGroupId);
+    }
+  }
+  return positions;
+}
+
+std::vector<std::string> expandFileNames(const std::string& pattern)
+{
+  if (std::string::npos == pattern.find_first_of("*?[")) {
+    return {pattern};
+  }
+  glob_t matches;
+  const int ret = glob(pattern.c_str(), 0, nullptr, &matches);
+  std::vector<std::string> fileNames(matches.gl_pathv, matches.gl_pathv + (ret ? 0 : matches.gl_pathc));
+  globfree(&matches);
+  if (fileNames.empty()) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException("ERROR: no input file matches " + pattern));
+  }
+  return fileNames;
+}
+
+std::vector<FastqListEntry> makeLaneList(
+    const std::string&              rgid,
+    const std::string&              rgsm,
+    const std::vector<std::string>& read1Files,
+    const std::vector<std::string>& read2Files)
+{
+  std::vector<FastqListEntry> entries;
+  for (const auto& pattern : read1Files) {
+    for (const auto& fileName : expandFileNames(pattern)) {
+      entries.emplace_back();
+      entries.back().readGroupId_     = rgid;
+      entries.back().readGroupSample_ = rgsm;
+      entries.back().read1File_       = fileName;
+    }
+  }
+  std::vector<std::string> expanded2;
+  for (const auto& pattern : read2Files) {
+    const std::vector<std::string> fileNames = expandFileNames(pattern);
+    expanded2.insert(expanded2.end(), fileNames.begin(), fileNames.end());
+  }
+  if (!expanded2.empty() && (expanded2.size() != entries.size())) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+        "ERROR: " + std::to_string(entries.size()) + " fastq-file1 for " + std::to_string(expanded2.size()) +
+        " fastq-file2"));
+  }
+  for (std::size_t i = 0; expanded2.size() > i; ++i) {
+    entries[i].read2File_ = expanded2[i];
+  }
+  if (1 == entries.size()) {
+    return entries;
+  }
+
+  static const boost::regex laneRegex("_L0*([0-9]+)_");
+  std::set<unsigned>        lanes;
+  for (auto& entry : entries) {
+    boost::smatch match;
+    const auto    fileName = boost::filesystem::path(entry.read1File_).filename().string();
+    entry.lane_ = boost::regex_search(fileName, match, laneRegex) ? std::stoul(match[1]) : 0;
+    lanes.insert(entry.lane_);
+  }
+  const bool fileNameLanes = (lanes.size() == entries.size()) && !lanes.count(0);
+  for (std::size_t i = 0; entries.size() > i; ++i) {
+    if (!fileNameLanes) {
+      entries[i].lane_ = i + 1;
+    }
+    entries[i].readGroupId_ = rgid + "." + std::to_string(entries[i].lane_);
+  }
+  return entries;
+}
+
+}  // namespace options
+}  // namespace dragenos
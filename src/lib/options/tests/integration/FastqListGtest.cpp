@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/Exceptions.hpp"
+#include "options/FastqList.hpp"
+
+using dragenos::options::FastqListEntry;
+using dragenos::options::parseFastqList;
+
+TEST(FastqList, parseFastqList)
+{
+  std::istringstream is(
+      "RGID,RGSM,RGLB,Lane,Read1File,Read2File\r\n"
+      "rg1,sample1,lib1,1,/data/s1_L001_R1.fastq.gz,/data/s1_L001_R2.fastq.gz\r\n"
+      "rg1,sample1,lib1,2,s1_L002_R1.fastq.gz,s1_L002_R2.fastq.gz\r\n"
+      "\r\n"
+      "rg2,sample2,,3,s2_R1.fastq,\r\n");
+  const auto entries = parseFastqList(is, "/runs/list");
+  ASSERT_EQ(3u, entries.size());
+  EXPECT_EQ("rg1", entries[0].readGroupId_);
+  EXPECT_EQ("sample1", entries[0].readGroupSample_);
+  EXPECT_EQ("lib1", entries[0].readGroupLibrary_);
+  EXPECT_EQ(1u, entries[0].lane_);
+  EXPECT_EQ("/data/s1_L001_R1.fastq.gz", entries[0].read1File_);
+  EXPECT_EQ("/data/s1_L001_R2.fastq.gz", entries[0].read2File_);
+  EXPECT_EQ(2u, entries[1].lane_);
+  EXPECT_EQ("/runs/list/s1_L002_R1.fastq.gz", entries[1].read1File_);
+  EXPECT_EQ("/runs/list/s1_L002_R2.fastq.gz", entries[1].read2File_);
+  EXPECT_EQ("sample2", entries[2].readGroupSample_);
+  EXPECT_EQ("LB0", entries[2].readGroupLibrary_);
+  EXPECT_EQ(3u, entries[2].lane_);
+  EXPECT_TRUE(entries[2].read2File_.empty());
+}
+
+TEST(FastqList, optionalColumns)
+{
+  std::istringstream is("Read1File,Comment,RGID\nr1.fq,anything,rg\n");
+  const auto         entries = parseFastqList(is, "/");
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ("rg", entries[0].readGroupId_);
+  EXPECT_EQ("none", entries[0].readGroupSample_);
+  EXPECT_EQ(1u, entries[0].lane_);
+  EXPECT_EQ("/r1.fq", entries[0].read1File_);
+  EXPECT_TRUE(entries[0].read2File_.empty());
+}
+
+TEST(FastqList, invalid)
+{
+  typedef dragenos::common::InvalidParameterException InvalidParameterException;
+  for (const std::string list :
+       {"",
+        "RGID,RGSM\nrg,sample\n",
+        "RGID,Read1File\n",
+        "RGID,Read1File\nrg\n",
+        "RGID,Read1File\n,r1.fq\n",
+        "RGID,Lane,Read1File\nrg,L1,r1.fq\n",
+        "RGID,RGSM,Read1File\nrg,sample1,r1.fq\nrg,sample2,r2.fq\n"}) {
+    std::istringstream is(list);
+    EXPECT_THROW(parseFastqList(is, "/"), InvalidParameterException) << list;
+  }
+}
+
+TEST(FastqList, makeLaneList)
+{
+  using dragenos::options::makeLaneList;
+  const auto single = makeLaneList("rg", "sample", {"s_L002_R1.fq"}, {"s_L002_R2.fq"});
+  ASSERT_EQ(1u, single.size());
+  EXPECT_EQ("rg", single[0].readGroupId_);
+  EXPECT_EQ("sample", single[0].readGroupSample_);
+  EXPECT_EQ("s_L002_R2.fq", single[0].read2File_);
+
+  const auto lanes = makeLaneList("rg", "sample", {"/a/s_L002_R1.fq", "/a/s_L004_R1.fq"}, {});
+  ASSERT_EQ(2u, lanes.size());
+  EXPECT_EQ("rg.2", lanes[0].readGroupId_);
+  EXPECT_EQ(4u, lanes[1].lane_);
+  EXPECT_EQ("rg.4", lanes[1].readGroupId_);
+  EXPECT_TRUE(lanes[1].read2File_.empty());
+
+  // repeated or missing lane numbers fall back to the positions
+  const auto positions = makeLaneList("rg", "sample", {"x_L001_R1.fq", "y_L001_R1.fq", "z.fq"}, {"1", "2", "3"});
+  ASSERT_EQ(3u, positions.size());
+  EXPECT_EQ("rg.1", positions[0].readGroupId_);
+  EXPECT_EQ("rg.3", positions[2].readGroupId_);
+  EXPECT_EQ("3", positions[2].read2File_);
+
+  EXPECT_THROW(
+      makeLaneList("rg", "sample", {"a.fq", "b.fq"}, {"a2.fq"}), dragenos::common::InvalidParameterException);
+  EXPECT_THROW(
+      makeLaneList("rg", "sample", {"/nonexistent/*.fq"}, {}), dragenos::common::InvalidParameterException);
+}
+
+TEST(FastqList, getReadGroupPositions)
+{
+  using dragenos::options::getReadGroupPositions;
+  std::istringstream is(
+      "RGID,RGSM,Lane,Read1File\n"
+      "rg1,sample1,1,s1_L001_R1.fastq\n"
+      "rg2,sample2,1,s2_L001_R1.fastq\n"
+      "rg1,sample1,2,s1_L002_R1.fastq\n"
+      "rg3,sample1,3,s1_L003_R1.fastq\n");
+  const auto entries = parseFastqList(is, "/");
+  // the lanes of rg1 are under the same @RG line
+  EXPECT_EQ((std::vector<std::size_t>{0, 1, 0, 2}), getReadGroupPositions(entries, {0, 1, 2, 3}));
+  // positions within the read groups of one sample, as in its own output files
+  EXPECT_EQ((std::vector<std::size_t>{0, 0, 1}), getReadGroupPositions(entries, {0, 2, 3}));
+  EXPECT_EQ((std::vector<std::size_t>{0}), getReadGroupPositions(entries, {1}));
+}
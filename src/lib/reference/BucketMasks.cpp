@@ -0,0 +1,115 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "reference/BucketMasks.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace dragenos {
+namespace reference {
+
+namespace {
+
+/// bit of the record type in the type sets below. Op codes for non-HIT records
+constexpr uint32_t typeBit(const unsigned type) { return uint32_t(1) << type; }
+
+constexpr uint32_t DATA_TYPES = typeBit(HashRecord::HIT) | typeBit(HashRecord::HIFREQ) |
+                                typeBit(HashRecord::EXTEND) | typeBit(HashRecord::INTERVAL_SL) |
+                                typeBit(HashRecord::INTERVAL_SLE) | typeBit(HashRecord::INTERVAL_S) |
+                                typeBit(HashRecord::INTERVAL_L);
+constexpr uint32_t CHAIN_BEGIN_TYPES = typeBit(HashRecord::CHAIN_BEG_MASK) | typeBit(HashRecord::CHAIN_BEG_LIST);
+constexpr uint32_t CHAIN_CON_TYPES   = typeBit(HashRecord::CHAIN_CON_MASK) | typeBit(HashRecord::CHAIN_CON_LIST);
+constexpr uint32_t EMPTY_TYPES       = typeBit(HashRecord::EMPTY);
+constexpr uint32_t VALID_TYPES       = DATA_TYPES | CHAIN_BEGIN_TYPES | CHAIN_CON_TYPES | EMPTY_TYPES;
+
+#ifdef __AVX2__
+/// 4 bits mask of the lanes with a non-zero value
+inline uint32_t nonZero(const __m256i v)
+{
+  const __m256i zero = _mm256_cmpeq_epi64(v, _mm256_setzero_si256());
+  return ~_mm256_movemask_pd(_mm256_castsi256_pd(zero)) & 0xF;
+}
+
+/// 4 bits mask of the lanes equal to the reference
+inline uint32_t equal(const __m256i v, const __m256i reference)
+{
+  return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, reference)));
+}
+
+/// classify 4 consecutive records into the bits [shift + 3:shift] of the masks
+void classify(
+    const __m256i records, const __m256i matchBits, const __m256i threadId, const unsigned shift, BucketMasks& masks)
+{
+  const __m256i nibble = _mm256_set1_epi64x(0xF);
+  const __m256i notHit = _mm256_cmpeq_epi64(
+      _mm256_and_si256(_mm256_srli_epi64(records, HashRecord::NOT_HIT_START), nibble), nibble);
+  const __m256i opCode = _mm256_and_si256(_mm256_srli_epi64(records, HashRecord::OP_CODE_START), nibble);
+  // one bit per lane for the type, as in typeBit
+  const __m256i type = _mm256_blendv_epi8(
+      _mm256_set1_epi64x(typeBit(HashRecord::HIT)), _mm256_sllv_epi64(_mm256_set1_epi64x(1), opCode), notHit);
+  const uint32_t data   = nonZero(_mm256_and_si256(type, _mm256_set1_epi64x(DATA_TYPES)));
+  const uint32_t thread = data & equal(_mm256_srli_epi64(records, HashRecord::THREAD_ID_START), threadId);
+  const uint32_t match  = thread & equal(_mm256_srli_epi64(records, HashRecord::MATCH_BITS_START), matchBits);
+  const __m256i  lf     = _mm256_and_si256(records, _mm256_set1_epi64x(uint64_t(1) << HashRecord::LF_FLAG));
+  masks.data_ |= data << shift;
+  masks.thread_ |= thread << shift;
+  masks.match_ |= match << shift;
+  masks.lastInThread_ |= nonZero(lf) << shift;
+  masks.chainBegin_ |= nonZero(_mm256_and_si256(type, _mm256_set1_epi64x(CHAIN_BEGIN_TYPES))) << shift;
+  masks.chainCon_ |= nonZero(_mm256_and_si256(type, _mm256_set1_epi64x(CHAIN_CON_TYPES))) << shift;
+  masks.empty_ |= nonZero(_mm256_and_si256(type, _mm256_set1_epi64x(EMPTY_TYPES))) << shift;
+  masks.invalid_ |= (~nonZero(_mm256_and_si256(type, _mm256_set1_epi64x(VALID_TYPES))) & 0xF) << shift;
+}
+#endif
+
+}  // namespace
+
+BucketMasks::BucketMasks(const Bucket& bucket, const uint64_t matchBits, const uint8_t threadId)
+  : data_(0), thread_(0), match_(0), lastInThread_(0), chainBegin_(0), chainCon_(0), empty_(0), invalid_(0)
+{
+  static_assert(8 == Bucket::hashRecordCount, "BucketMasks expects 8 records per bucket");
+#ifdef __AVX2__
+  const __m256i matchBits4 = _mm256_set1_epi64x(matchBits);
+  const __m256i threadId4  = _mm256_set1_epi64x(threadId);
+  for (unsigned half = 0; 2 > half; ++half) {
+    const __m256i records = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bucket.data() + 4 * half));
+    classify(records, matchBits4, threadId4, 4 * half, *this);
+  }
+#else
+  for (unsigned i = 0; Bucket::hashRecordCount > i; ++i) {
+    const HashRecord& record = bucket[i];
+    const uint32_t    bit    = uint32_t(1) << i;
+    const uint32_t    type   = typeBit(record.getType());
+    if (type & DATA_TYPES) {
+      data_ |= bit;
+      if (threadId == record.getThreadId()) {
+        thread_ |= bit;
+        if (matchBits == record.getMatchBits()) {
+          match_ |= bit;
+        }
+      }
+    }
+    lastInThread_ |= record.isLastInThread() ? bit : 0;
+    chainBegin_ |= (type & CHAIN_BEGIN_TYPES) ? bit : 0;
+    chainCon_ |= (type & CHAIN_CON_TYPES) ? bit : 0;
+    empty_ |= (type & EMPTY_TYPES) ? bit : 0;
+    invalid_ |= (type & VALID_TYPES) ? 0 : bit;
+  }
+#endif
+}
+
+}  // namespace reference
+}  // namespace dragenos
@@ -0,0 +1,97 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "reference/ChunkedFileReader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+
+#include <boost/format.hpp>
+
+#include "common/Exceptions.hpp"
+
+namespace dragenos {
+namespace reference {
+
+namespace {
+
+uint64_t getFileSize(const boost::filesystem::path& path)
+{
+  boost::system::error_code error;
+  const auto                size = boost::filesystem::file_size(path, error);
+  if (error) {
+    BOOST_THROW_EXCEPTION(
+        common::IoException(error.value(), "ERROR: failed to get stats for file: " + path.string()));
+  }
+  return size;
+}
+
+}  // namespace
+
+ChunkedFileReader::ChunkedFileReader(const boost::filesystem::path& path, const uint64_t chunkBytes)
+  : path_(path),
+    chunkBytes_(std::max<uint64_t>(1, chunkBytes)),
+    size_(getFileSize(path)),
+    data_(new uint8_t[size_]),
+    thread_(&ChunkedFileReader::read, this)
+{
+}
+
+ChunkedFileReader::~ChunkedFileReader()
+{
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void ChunkedFileReader::waitBytes(void* reader, const uint64_t bytes)
+{
+  ChunkedFileReader&           self = *static_cast<ChunkedFileReader*>(reader);
+  std::unique_lock<std::mutex> lock(self.mutex_);
+  self.availableChanged_.wait(lock, [&self, bytes] { return self.available_ >= bytes; });
+}
+
+void ChunkedFileReader::finish()
+{
+  thread_.join();
+  if (!error_.empty()) {
+    BOOST_THROW_EXCEPTION(common::IoException(EIO, error_));
+  }
+}
+
+void ChunkedFileReader::read()
+{
+  std::ifstream is(path_.string(), std::ios::binary);
+  uint64_t      offset = 0;
+  while (is && (size_ > offset)) {
+    is.read(reinterpret_cast<char*>(data_.get() + offset), std::min(chunkBytes_, size_ - offset));
+    offset += is.gcount();
+    std::lock_guard<std::mutex> lock(mutex_);
+    available_ = offset;
+    availableChanged_.notify_all();
+  }
+  if (size_ > offset) {
+    std::fill(data_.get() + offset, data_.get() + size_, 0);
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ =
+        (boost::format("ERROR: failed to read %i bytes from %s: %i bytes read") % size_ % path_.string() % offset)
+            .str();
+    available_ = size_;
+    availableChanged_.notify_all();
+  }
+}
+
+}  // namespace reference
+}  // namespace dragenos
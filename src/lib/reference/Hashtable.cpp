@@ -29,62 +29,69 @@ Hashtable::Hashtable(const HashtableConfig* config, const uint64_t* table, const
 {
 }
 
-bool Hashtable::processInitialBucket(
+#ifdef TRACE_HASHTABLE
+namespace {
+void traceBucket(const char* scan, const Bucket& bucket, const uint8_t hashThreadId)
+{
+  for (const auto& hashRecord : bucket) {
+    std::cerr << "    Hashtable::scanBucket<" << scan << ">: record: " << std::hex << std::setw(8)
+              << std::setfill('0') << (hashRecord.getValue() >> 32) << " " << std::setw(8)
+              << (hashRecord.getValue() & 0xFFFFFFFF) << " : " << std::setw(2)
+              << ((hashRecord.getValue() >> 24) & 0xFF) << " hashThreadId: " << (unsigned)hashThreadId
+              << " hashRecord thread Id: " << std::setw(2) << (unsigned)hashRecord.getThreadId()
+              << std::setfill(' ') << " LF: " << hashRecord.isLastInThread() << std::dec
+              << " recordType: " << (int)hashRecord.getType() << std::endl;
+  }
+}
+}  // namespace
+#endif
+
+template <Hashtable::BucketScan SCAN>
+bool Hashtable::scanBucket(
     const Bucket&            bucket,
     const Hash&              hash,
     const uint64_t           matchBits,
     const uint8_t            hashThreadId,
-    std::vector<HashRecord>& hits,
-    std::vector<ExtendTableInterval>& /*extendTableIntervals*/,
-    const bool trace) const
+    std::vector<HashRecord>& hits) const
 {
-  // TODO: check if it is required to have at least one hash record in the thread Id to start probing
-  bool       lastInThread = true;
-  bool       fullBucket   = true;  // probably not useful, other than sanity check
-  bool       chaining     = false;
-  HashRecord chainBeginRecord;
-  for (auto& hashRecord : bucket) {
-    //////////
-    if (trace) {
-      std::cerr << "    Hashtable::processInitialBucket: record: " << std::hex << std::setw(8)
-                << std::setfill('0') << (hashRecord.getValue() >> 32) << " " << std::setw(8)
-                << (hashRecord.getValue() & 0xFFFFFFFF) << " : " << std::setw(2)
-                << ((hashRecord.getValue() >> 24) & 0xFF) << " hashThreadId: " << (unsigned)hashThreadId
-                << " hashRecord thread Id: " << std::setw(2) << (unsigned)hashRecord.getThreadId()
-                << std::setfill(' ') << " LF: " << hashRecord.isLastInThread() << std::dec
-                << " recordType: " << (int)hashRecord.getType() << std::endl;
+#ifdef TRACE_HASHTABLE
+  static const char* scanNames[] = {"initial", "probe", "chain"};
+  traceBucket(scanNames[SCAN], bucket, hashThreadId);
+#endif
+  const BucketMasks masks(bucket, matchBits, hashThreadId);
+  constexpr uint32_t ALL = (1U << Bucket::hashRecordCount) - 1;
+  // records considered by the scan
+  uint32_t scanned = ALL;
+  if (CHAIN_BUCKET == SCAN) {
+    // skip all hash records until the first CHAIN_CON_{MASK,LIST}
+    if (0 == masks.chainCon_) {
+      BOOST_THROW_EXCEPTION(std::invalid_argument("Failed to fing CHAIN_CON record in bucket"));
     }
-    //////////
-
-    const auto type = hashRecord.getType();
-    if ((HashRecord::HIT == type) || (HashRecord::HIFREQ == type) || (HashRecord::EXTEND == type) ||
-        (HashRecord::INTERVAL_SL == type) || (HashRecord::INTERVAL_SLE == type) ||
-        (HashRecord::INTERVAL_S == type) || (HashRecord::INTERVAL_L == type)) {
-      if (hashThreadId == hashRecord.getThreadId()) {
-        if (matchBits == hashRecord.getMatchBits()) {
-          hits.push_back(hashRecord);
-        }
-        lastInThread = hashRecord.isLastInThread();
-        if (lastInThread) {
-          break;
-        }
-      }
-      continue;
-    } else if ((HashRecord::CHAIN_BEG_MASK == type) || (HashRecord::CHAIN_BEG_LIST == type)) {
-      if (followChain(hashRecord, hash)) {
-        chaining         = true;
-        lastInThread     = false;
-        chainBeginRecord = hashRecord;
-      }
-      continue;
-    } else if (HashRecord::EMPTY == type) {
-      fullBucket = false;  // probably not useful because there should be LF for all threads in the bucket
-      // in principle this would imply no probing and no chaining;
-      // NOTE: there could be more records after the EMPTY record therefore we can't break
-      continue;
-    } else if ((HashRecord::CHAIN_CON_MASK == type) || (HashRecord::CHAIN_CON_LIST == type)) {
-      // all subsequent records are only relevant to chaining into this bucket
-      break;
+    scanned = (ALL << (__builtin_ctz(masks.chainCon_) + 1)) & ALL;
+  }
+  // the first relevant record with LF terminates the thread. So does a CHAIN_CON when it is
+  // not expected, and the unexpected record types terminate the scan with an exception
+  const uint32_t lastInThreadRecords = masks.thread_ & masks.lastInThread_;
+  uint32_t       stopRecords         = lastInThreadRecords;
+  uint32_t       invalidRecords      = 0;
+  if (INITIAL_BUCKET == SCAN) {
+    stopRecords |= masks.chainCon_;
+    invalidRecords = masks.invalid_;
+  } else if (PROBE_BUCKET == SCAN) {
+    stopRecords |= masks.chainCon_;
+  } else {
+    invalidRecords = ALL & ~(masks.data_ | masks.empty_);
+  }
+  stopRecords = (stopRecords | invalidRecords) & scanned;
+  const unsigned stop   = stopRecords ? __builtin_ctz(stopRecords) : Bucket::hashRecordCount;
+  const uint32_t before = ((1U << stop) - 1) & scanned;
+  if ((invalidRecords >> stop) & 1) {
+    const auto& hashRecord = bucket[stop];
+    const auto  type       = hashRecord.getType();
+    if (CHAIN_BUCKET == SCAN) {
+      boost::format message = boost::format("Unexpected record type while chaining: %1x: %8x %8x") % type %
+                              (hashRecord.getValue() >> 32) % (hashRecord.getValue() & 0xFFFFFFFF);
+      BOOST_THROW_EXCEPTION(std::invalid_argument(message.str()));
     } else if (HashRecord::REPAIR == type) {
       BOOST_THROW_EXCEPTION(std::invalid_argument("REPAIR type obsolete for Hash Records"));
     }
@@ -92,87 +99,76 @@ bool Hashtable::processInitialBucket(
         boost::format("Unknown Hash Record type: %x: record: %x") % type % hashRecord.getValue();
     BOOST_THROW_EXCEPTION(std::invalid_argument(message.str()));
   }
-  // if there are EMPTY records then there should be no chaining and no probing
-  BOOST_ASSERT(fullBucket || lastInThread);
-  BOOST_ASSERT(fullBucket || !chaining);
-  // if lastInChain then chaining should not be possible
-  BOOST_ASSERT(!(lastInThread && chaining));
-  if (chaining) {
-    BOOST_ASSERT(!lastInThread);
-    hits.push_back(chainBeginRecord);
+  const bool stopsOnLastInThread = (lastInThreadRecords >> stop) & 1;
+  for (uint32_t matches = masks.match_ & (before | (uint32_t(stopsOnLastInThread) << stop)); matches;
+       matches &= matches - 1) {
+    hits.push_back(bucket[__builtin_ctz(matches)]);
   }
-  return lastInThread;
-}
-
-bool Hashtable::probeBucket(
-    const Bucket&            bucket,
-    const uint64_t           matchBits,
-    const uint8_t            hashThreadId,
-    std::vector<HashRecord>& hits,
-    std::vector<ExtendTableInterval>& /*extendTableIntervals*/,
-    const bool trace) const
-{
-  auto hashRecord = bucket.cbegin();
-  // alternate exit on relevant hashRecord->isLastInThread()
-  while (hashRecord != bucket.cend() && (HashRecord::CHAIN_CON_MASK != hashRecord->getType()) &&
-         (HashRecord::CHAIN_CON_LIST != hashRecord->getType())) {
-    //////////
-    if (trace) {
-      std::cerr << "    Hashtable::processInitialBucket(probeBucket): record: " << std::hex << std::setw(8)
-                << std::setfill('0') << (hashRecord->getValue() >> 32) << " " << std::setw(8)
-                << (hashRecord->getValue() & 0xFFFFFFFF) << " : " << std::setw(2)
-                << ((hashRecord->getValue() >> 24) & 0xFF) << " hashThreadId: " << (unsigned)hashThreadId
-                << " hashRecord thread Id: " << std::setw(2) << (unsigned)hashRecord->getThreadId()
-                << std::setfill(' ') << " LF: " << hashRecord->isLastInThread() << std::dec
-                << " recordType: " << (int)hashRecord->getType() << std::endl;
-    }
-    //////////
 
-    const auto type = hashRecord->getType();
-    if ((HashRecord::HIT == type) || (HashRecord::HIFREQ == type) || (HashRecord::EXTEND == type) ||
-        (HashRecord::INTERVAL_SL == type) || (HashRecord::INTERVAL_SLE == type) ||
-        (HashRecord::INTERVAL_S == type) || (HashRecord::INTERVAL_L == type)) {
-      if (hashThreadId == hashRecord->getThreadId()) {
-        if (matchBits == hashRecord->getMatchBits()) {
-          hits.push_back(*hashRecord);
-        }
-        if (hashRecord->isLastInThread()) {
-          return true;
-        }
+  if (INITIAL_BUCKET == SCAN) {
+    bool       chaining = false;
+    HashRecord chainBeginRecord;
+    for (uint32_t chainBegins = masks.chainBegin_ & before; chainBegins; chainBegins &= chainBegins - 1) {
+      const HashRecord& hashRecord = bucket[__builtin_ctz(chainBegins)];
+      if (followChain(hashRecord, hash)) {
+        chaining         = true;
+        chainBeginRecord = hashRecord;
       }
     }
-    ++hashRecord;
+    // any relevant record without LF, or chaining, means that the thread continues
+    const bool lastInThread = stopsOnLastInThread || ((0 == (masks.thread_ & before)) && !chaining);
+    // probably not useful, other than sanity check
+    const bool fullBucket = (0 == (masks.empty_ & before));
+    // if there are EMPTY records then there should be no chaining and no probing
+    BOOST_ASSERT(fullBucket || lastInThread);
+    BOOST_ASSERT(fullBucket || !chaining);
+    // if lastInChain then chaining should not be possible
+    BOOST_ASSERT(!(lastInThread && chaining));
+    if (chaining) {
+      BOOST_ASSERT(!lastInThread);
+      hits.push_back(chainBeginRecord);
+    }
+    return lastInThread;
+  } else if (PROBE_BUCKET == SCAN) {
+    return stopsOnLastInThread;
+  } else {
+    // the CHAIN_CON record just before the scanned records
+    const HashRecord& chainConRecord = bucket[__builtin_ctz(masks.chainCon_)];
+    if ((!stopsOnLastInThread) && followChain(chainConRecord, hash)) {
+      hits.push_back(chainConRecord);
+      return false;
+    } else {
+      return true;
+    }
   }
-  return false;
 }
 
-void Hashtable::probeNeighborBuckets(
-    const uint64_t                    initialBucketIndex,
-    const uint64_t                    matchBits,
-    const uint8_t                     hashThreadId,
-    std::vector<HashRecord>&          hits,
-    std::vector<ExtendTableInterval>& extendTableIntervals,
-    const bool                        trace) const
+unsigned Hashtable::probeNeighborBuckets(
+    const uint64_t           initialBucketIndex,
+    const Hash&              hash,
+    const uint64_t           matchBits,
+    const uint8_t            hashThreadId,
+    std::vector<HashRecord>& hits) const
 {
   // probing is forced to be constrained to a single block with a modulo operation
   const uint64_t blockStartBucketIndex = initialBucketIndex - (initialBucketIndex % getBucketsPerBlock());
 
-  if (trace)
-    std::cerr << std::hex << " bucket address: " << &buckets_[blockStartBucketIndex]
-              << "\tbucket index: " << blockStartBucketIndex << std::dec
-              << "\tgetBucketsPerBlock() :" << getBucketsPerBlock() << std::endl;
+#ifdef TRACE_HASHTABLE
+  std::cerr << std::hex << " bucket address: " << &buckets_[blockStartBucketIndex]
+            << "\tbucket index: " << blockStartBucketIndex << std::dec
+            << "\tgetBucketsPerBlock() :" << getBucketsPerBlock() << std::endl;
+#endif
   // In practice, should exit on an LF=true record
   for (unsigned i = 1; Traits::MAX_PROBES > i; ++i) {
-    if (trace) std::cerr << " probe cnt:" << i << std::endl;
     const uint64_t currentbucketIndex =
         blockStartBucketIndex + ((initialBucketIndex + i) % getBucketsPerBlock());
-    if (probeBucket(
-            buckets_[currentbucketIndex], matchBits, hashThreadId, hits, extendTableIntervals, trace)) {
-      return;
+    if (scanBucket<PROBE_BUCKET>(buckets_[currentbucketIndex], hash, matchBits, hashThreadId, hits)) {
+      return i;
     }
   }
   // TODO: check if the LF is expected to be always set when probing
   // BOOST_THROW_EXCEPTION(std::invalid_argument("Probing completed through all neighbor buckets without finding any hash record with LF=true"));
+  return Traits::MAX_PROBES - 1;
 }
 
 bool Hashtable::followChain(const HashRecord& record, const Hash hash) const
@@ -199,141 +195,36 @@ bool Hashtable::followChain(const HashRecord& record, const Hash hash) const
   return false;
 }
 
-bool Hashtable::chainBucket(
-    const Bucket&            bucket,
-    const Hash&              hash,
-    const uint64_t           matchBits,
-    const uint8_t            hashThreadId,
-    std::vector<HashRecord>& hits,
-    std::vector<ExtendTableInterval>& /*extendTableIntervals*/,
-    const bool trace) const
-{
-  //bool fullBucket = true;
-  auto hashRecord = bucket.cbegin();
-  // skip all hash records until the first CHAIN_CON_{MASK,LIST}
-  while ((hashRecord != bucket.cend()) && !hashRecord->isChainCon()) {
-    //////////
-    if (trace) {
-      std::cerr << "    Hashtable::chainBucket: discarding: record: " << std::hex << std::setw(8)
-                << std::setfill('0') << (hashRecord->getValue() >> 32) << " " << std::setw(8)
-                << (hashRecord->getValue() & 0xFFFFFFFF) << " : " << std::setw(2)
-                << ((hashRecord->getValue() >> 24) & 0xFF) << " hashThreadId: " << (unsigned)hashThreadId
-                << " hashRecord thread Id: " << std::setw(2) << (unsigned)hashRecord->getThreadId()
-                << std::setfill(' ') << " LF: " << hashRecord->isLastInThread() << std::dec
-                << " recordType: " << (int)hashRecord->getType() << std::endl;
-    }
-    //////////
-
-    // if (HashRecord::EMPTY == hashRecord->getType())
-    //{
-    //  fullBucket = false; // probably not useful because there should be LF for all threads in the bucket
-    //}
-    ++hashRecord;
-  }
-  if (hashRecord == bucket.cend()) {
-    BOOST_THROW_EXCEPTION(std::invalid_argument("Failed to fing CHAIN_CON record in bucket"));
-  }
-
-  //////////
-  if (trace) {
-    std::cerr << "    Hashtable::chainBucket: CHAIN_CON record: " << std::hex << std::setw(8)
-              << std::setfill('0') << (hashRecord->getValue() >> 32) << " " << std::setw(8)
-              << (hashRecord->getValue() & 0xFFFFFFFF) << " : " << std::setw(2)
-              << ((hashRecord->getValue() >> 24) & 0xFF) << " hashThreadId: " << (unsigned)hashThreadId
-              << " hashRecord thread Id: " << std::setw(2) << (unsigned)hashRecord->getThreadId()
-              << std::setfill(' ') << " LF: " << hashRecord->isLastInThread() << std::dec
-              << " recordType: " << (int)hashRecord->getType() << std::endl;
-  }
-  //////////
-
-  const auto chainConRecord = *hashRecord;
-  // if this is the last bucket in the chain for the hash, it will also be the Last in Thread
-  bool lastInThread = false;
-  ++hashRecord;
-  while (hashRecord != bucket.cend()) {
-    //////////
-    if (trace) {
-      std::cerr << "    Hashtable::chainBucket: considering record: " << std::hex << std::setw(8)
-                << std::setfill('0') << (hashRecord->getValue() >> 32) << " " << std::setw(8)
-                << (hashRecord->getValue() & 0xFFFFFFFF) << " : " << std::setw(2)
-                << ((hashRecord->getValue() >> 24) & 0xFF) << " hashThreadId: " << (unsigned)hashThreadId
-                << " hashRecord thread Id: " << std::setw(2) << (unsigned)hashRecord->getThreadId()
-                << std::setfill(' ') << " LF: " << hashRecord->isLastInThread() << std::dec
-                << " recordType: " << (int)hashRecord->getType() << std::endl;
-    }
-    //////////
-
-    const auto type = hashRecord->getType();
-    if ((HashRecord::HIT == type) || (HashRecord::HIFREQ == type) || (HashRecord::EXTEND == type) ||
-        (HashRecord::INTERVAL_SL == type) || (HashRecord::INTERVAL_SLE == type) ||
-        (HashRecord::INTERVAL_S == type) || (HashRecord::INTERVAL_L == type)) {
-      if (hashThreadId == hashRecord->getThreadId()) {
-        if (matchBits == hashRecord->getMatchBits()) {
-          hits.push_back(*hashRecord);
-        }
-        if (hashRecord->isLastInThread()) {
-          lastInThread = true;
-          break;
-        }
-      }
-    }
-    // else if (HashRecord::EMPTY == type)
-    //{
-    //  fullBucket = false; // probably not useful because there should be LF for all threads in the bucket
-    //}
-    else if (HashRecord::EMPTY != type)
-    // else
-    {
-      boost::format message = boost::format("Unexpected record type while chaining: %1x: %8x %8x") % type %
-                              (hashRecord->getValue() >> 32) % (hashRecord->getValue() & 0xFFFFFFFF);
-      BOOST_THROW_EXCEPTION(std::invalid_argument(message.str()));
-    }
-    ++hashRecord;
-  }
-  // TODO: verify consistency between lastInThread, fullBucket and followChain
-  //BOOST_ASSERT(fullBucket || lastInThread);
-  // if (lastInThread && followChain(chainConRecord, hash))
-  //{
-  //  BOOST_THROW_EXCEPTION(std::invalid_argument("Both 'Last in thread' and 'Follow chain' are true"));
-  //}
-  // if (followChain(chainConRecord, hash))
-  if ((!lastInThread) && followChain(chainConRecord, hash)) {
-    hits.push_back(chainConRecord);
-    return false;
-  } else {
-    return true;
-  }
-}
-
-void Hashtable::getHits(
+unsigned Hashtable::getHits(
     const Hash&                       hash,
     const bool                        isExtended,
     std::vector<HashRecord>&          hits,
-    std::vector<ExtendTableInterval>& extendTableIntervals,
-    const bool                        trace) const
+    std::vector<ExtendTableInterval>& extendTableIntervals) const
 {
   hits.clear();
   const auto matchBits          = getMatchBits(hash, isExtended);
   const auto virtualByteAddress = getVirtualByteAddress(hash);
   const auto bucketIndex        = getBucketIndex(virtualByteAddress);
   const auto hashThreadId       = getThreadIdFromVirtualByteAddress(virtualByteAddress);
-  hits.clear();
 
-  if (trace)
-    std::cerr << std::hex << "hash: " << hash << " bucket index: " << bucketIndex << std::dec
-              << " initial interval count: " << extendTableIntervals.size() << std::endl;
+#ifdef TRACE_HASHTABLE
+  std::cerr << std::hex << "hash: " << hash << " bucket index: " << bucketIndex << std::dec
+            << " initial interval count: " << extendTableIntervals.size() << std::endl;
+#endif
 
-  bool lastInThread = processInitialBucket(
-      buckets_[bucketIndex], hash, matchBits, hashThreadId, hits, extendTableIntervals, trace);
+  bool lastInThread =
+      scanBucket<INITIAL_BUCKET>(buckets_[bucketIndex], hash, matchBits, hashThreadId, hits);
+  unsigned bucketAccesses = 1;
 
-  if (trace)
-    std::cerr << "found hits:" << hits.size() << " interval count: " << extendTableIntervals.size()
-              << " lastInThread: " << lastInThread << std::endl;
+#ifdef TRACE_HASHTABLE
+  std::cerr << "found hits:" << hits.size() << " interval count: " << extendTableIntervals.size()
+            << " lastInThread: " << lastInThread << std::endl;
+#endif
 
   if (!lastInThread) {
     const bool probing = hits.empty() || (!hits.back().isChainBegin());
     if (probing) {
-      probeNeighborBuckets(bucketIndex, matchBits, hashThreadId, hits, extendTableIntervals, trace);
+      bucketAccesses += probeNeighborBuckets(bucketIndex, hash, matchBits, hashThreadId, hits);
     } else /* chaining */
     {
       const auto baseBucketIndex = (bucketIndex >> HashRecord::CHAIN_POINTER_BITS)
@@ -344,23 +235,18 @@ void Hashtable::getHits(
         hits.pop_back();
         BOOST_ASSERT(chainingRecord.isChainRecord());
         const uint64_t chainPointer = chainingRecord.getChainPointer();
-        lastInThread                = chainBucket(
-            buckets_[baseBucketIndex + chainPointer],
-            hash,
-            matchBits,
-            hashThreadId,
-            hits,
-            extendTableIntervals,
-            trace);
+        lastInThread                = scanBucket<CHAIN_BUCKET>(
+            buckets_[baseBucketIndex + chainPointer], hash, matchBits, hashThreadId, hits);
+        ++bucketAccesses;
       }
     }
   }
   // TODO: convert interval sets into extend table intervals, if any
   // ASSUMPTION: the interval records, if any are at the back
 
-  ////////////////////
-  if (trace) std::cerr << " final hit count: " << hits.size() << std::endl;
-  ////////////////////
+#ifdef TRACE_HASHTABLE
+  std::cerr << " final hit count: " << hits.size() << std::endl;
+#endif
 
   auto begin = hits.end();
   while ((hits.begin() != begin) && ((HashRecord::INTERVAL_SL == (begin - 1)->getType()) ||
@@ -373,6 +259,7 @@ void Hashtable::getHits(
     extendTableIntervals.push_back(ExtendTableInterval(begin, hits.end()));
     hits.erase(begin, hits.end());
   }
+  return bucketAccesses;
 }
 
 }  // namespace reference
@@ -0,0 +1,151 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "reference/PackedReference.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace dragenos {
+namespace reference {
+
+namespace {
+
+/// 2 bits code of each 4 bits value, -1 for anything but A, C, G and T
+constexpr std::array<int8_t, 16> CODES{-1, 0, 1, -1, 2, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1, -1};
+/// complement of each 4 bits value, including the IUPAC codes
+constexpr std::array<unsigned char, 16> COMPLEMENTS{0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+
+/// 2 bits codes of the two bases of each byte of reference.bin (first base in the LSB). -1 if any is not ACGT
+std::array<int8_t, 256> generateByteCodes()
+{
+  std::array<int8_t, 256> byteCodes;
+  for (unsigned byte = 0; 256 > byte; ++byte) {
+    const int first  = CODES[byte & 0xF];
+    const int second = CODES[byte >> 4];
+    byteCodes[byte]  = ((0 > first) || (0 > second)) ? -1 : (first | (second << 2));
+  }
+  return byteCodes;
+}
+
+}  // namespace
+
+PackedReference::PackedReference(const unsigned char* data, const std::size_t size)
+  : length_(2 * size), bases_(length_ / BASES_PER_WORD + 2, 0)
+{
+  static const std::array<int8_t, 256> byteCodes = generateByteCodes();
+  for (std::size_t i = 0; size > i; ++i) {
+    const uint64_t position = 2 * i;
+    const int      codes    = byteCodes[data[i]];
+    if (0 <= codes) {
+      bases_[position / BASES_PER_WORD] |= uint64_t(codes) << (2 * (position % BASES_PER_WORD));
+      continue;
+    }
+    for (unsigned j = 0; 2 > j; ++j) {
+      const unsigned char base = (data[i] >> (4 * j)) & 0xF;
+      const int           code = CODES[base];
+      if (0 <= code) {
+        bases_[(position + j) / BASES_PER_WORD] |= uint64_t(code) << (2 * ((position + j) % BASES_PER_WORD));
+      } else {
+        addException(position + j, base);
+      }
+    }
+  }
+}
+
+void PackedReference::addException(const uint64_t position, const unsigned char base)
+{
+  if (!exceptions_.empty() && (position == exceptions_.back().end_) && (base == exceptions_.back().base_)) {
+    ++exceptions_.back().end_;
+  } else {
+    exceptions_.push_back(Exception{position, position + 1, base});
+  }
+}
+
+void PackedReference::getBases(const std::size_t beginPosition, const std::size_t endPosition, unsigned char* out)
+    const
+{
+  extract<false>(beginPosition, endPosition, out);
+}
+
+void PackedReference::getRcBases(
+    const std::size_t beginPosition, const std::size_t endPosition, unsigned char* out) const
+{
+  extract<true>(beginPosition, endPosition, out);
+}
+
+template <bool complement>
+void PackedReference::extract(const std::size_t beginPosition, const std::size_t endPosition, unsigned char* out)
+    const
+{
+  assert(beginPosition <= endPosition);
+  assert(endPosition <= length_);
+  const std::size_t length = endPosition - beginPosition;
+  std::size_t       i      = 0;
+#ifdef __AVX2__
+  // each output byte gets the byte of codes holding its base, from the 8 bytes broadcast to both lanes
+  const __m256i spread = _mm256_setr_epi8(
+      0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+  // bases 2 and 3 of each byte are in the high nibble, and the odd bases in the 2 MSB of the nibble
+  const __m256i selectHigh = _mm256_setr_epi32(
+      0x80800000, 0x80800000, 0x80800000, 0x80800000, 0x80800000, 0x80800000, 0x80800000, 0x80800000);
+  const __m256i selectOdd = _mm256_setr_epi32(
+      0x80008000, 0x80008000, 0x80008000, 0x80008000, 0x80008000, 0x80008000, 0x80008000, 0x80008000);
+  // 4 bits encoding of the even and odd bases of each nibble
+  const __m256i lutEven = complement ? _mm256_setr_epi8(
+                                           8, 4, 2, 1, 8, 4, 2, 1, 8, 4, 2, 1, 8, 4, 2, 1,
+                                           8, 4, 2, 1, 8, 4, 2, 1, 8, 4, 2, 1, 8, 4, 2, 1)
+                                     : _mm256_setr_epi8(
+                                           1, 2, 4, 8, 1, 2, 4, 8, 1, 2, 4, 8, 1, 2, 4, 8,
+                                           1, 2, 4, 8, 1, 2, 4, 8, 1, 2, 4, 8, 1, 2, 4, 8);
+  const __m256i lutOdd = complement ? _mm256_setr_epi8(
+                                          8, 8, 8, 8, 4, 4, 4, 4, 2, 2, 2, 2, 1, 1, 1, 1,
+                                          8, 8, 8, 8, 4, 4, 4, 4, 2, 2, 2, 2, 1, 1, 1, 1)
+                                    : _mm256_setr_epi8(
+                                          1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 8, 8, 8, 8,
+                                          1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 8, 8, 8, 8);
+  const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+  for (; i + BASES_PER_WORD <= length; i += BASES_PER_WORD) {
+    const __m256i codes   = _mm256_set1_epi64x(static_cast<long long>(getCodes(beginPosition + i)));
+    const __m256i bytes   = _mm256_shuffle_epi8(codes, spread);
+    const __m256i low     = _mm256_and_si256(bytes, nibbleMask);
+    const __m256i high    = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibbleMask);
+    const __m256i nibbles = _mm256_blendv_epi8(low, high, selectHigh);
+    const __m256i even    = _mm256_shuffle_epi8(lutEven, nibbles);
+    const __m256i odd     = _mm256_shuffle_epi8(lutOdd, nibbles);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_blendv_epi8(even, odd, selectOdd));
+  }
+#endif
+  for (; length > i; ++i) {
+    const std::size_t position = beginPosition + i;
+    const unsigned    code = (bases_[position / BASES_PER_WORD] >> (2 * (position % BASES_PER_WORD))) & 3;
+    out[i]                 = complement ? (8 >> code) : (1 << code);
+  }
+  // overwrite the bases that are not A, C, G or T
+  for (auto exception = findException(beginPosition);
+       (exceptions_.end() != exception) && (endPosition > exception->begin_);
+       ++exception) {
+    const unsigned char base  = complement ? COMPLEMENTS[exception->base_] : exception->base_;
+    const std::size_t   first = std::max<std::size_t>(beginPosition, exception->begin_);
+    const std::size_t   last  = std::min<std::size_t>(endPosition, exception->end_);
+    std::fill(out + (first - beginPosition), out + (last - beginPosition), base);
+  }
+}
+
+}  // namespace reference
+}  // namespace dragenos
@@ -0,0 +1,98 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "reference/PageWarmup.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+
+#include <boost/format.hpp>
+
+namespace dragenos {
+namespace reference {
+
+PageWarmup::PageWarmup(std::vector<Range> ranges, const unsigned threadCount)
+  : totalBytes_(0), nextChunk_(0), warmBytes_(0), stop_(false)
+{
+  for (const auto& range : ranges) {
+    const char* data = static_cast<const char*>(range.data);
+    for (std::size_t offset = 0; range.size > offset; offset += CHUNK_BYTES) {
+      chunks_.push_back(Chunk{data + offset, std::min(CHUNK_BYTES, range.size - offset)});
+    }
+    totalBytes_ += range.size;
+  }
+  // at least one thread to make progress
+  for (unsigned i = 0; std::max(1u, threadCount) > i; ++i) {
+    threads_.emplace_back(&PageWarmup::run, this);
+  }
+}
+
+PageWarmup::~PageWarmup()
+{
+  stop_ = true;
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void PageWarmup::run()
+{
+  const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+  for (std::size_t i = nextChunk_++; (chunks_.size() > i) && !stop_; i = nextChunk_++) {
+    const Chunk& chunk = chunks_[i];
+    // madvise needs a page aligned address, which holds for the chunks of a mapping
+    const auto address = reinterpret_cast<uintptr_t>(chunk.begin);
+    const auto aligned = address - address % pageSize;
+    madvise(reinterpret_cast<void*>(aligned), chunk.size + address - aligned, MADV_WILLNEED);
+    unsigned char touched = 0;
+    for (std::size_t offset = 0; chunk.size > offset; offset += pageSize) {
+      touched ^= *reinterpret_cast<const volatile unsigned char*>(chunk.begin + offset);
+    }
+    // keep the reads
+    static_cast<void>(touched);
+    warmBytes_ += chunk.size;
+    std::lock_guard<std::mutex> lock(mutex_);
+    progressed_.notify_all();
+  }
+}
+
+void PageWarmup::wait(const double fraction, std::ostream& progress)
+{
+  const auto        start    = std::chrono::steady_clock::now();
+  const std::size_t target   = std::min<std::size_t>(totalBytes_, fraction * totalBytes_);
+  std::size_t       reported = 0;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    const std::size_t warm = warmBytes_;
+    if ((warm >= target) || (warm >= reported + totalBytes_ / 10)) {
+      const double seconds =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      progress << boost::format("Reference warmup: %.1f%% (%.1f MB of %.1f MB) in %.3f s") %
+                      (totalBytes_ ? 100.0 * warm / totalBytes_ : 100.0) % (warm / 1048576.0) %
+                      (totalBytes_ / 1048576.0) % seconds
+               << std::endl;
+      reported = warm;
+    }
+    if (warm >= target) {
+      return;
+    }
+    progressed_.wait_for(lock, std::chrono::seconds(1));
+  }
+}
+
+}  // namespace reference
+}  // namespace dragenos
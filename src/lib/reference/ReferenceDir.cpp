@@ -13,7 +13,12 @@
  **/
 
 #include <fcntl.h>
+#include <sys/file.h>
 #include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <thread>
@@ -21,6 +26,7 @@
 #include <boost/format.hpp>
 
 #include "common/hash_generation/hash_table_compress.h"
+#include "reference/ChunkedFileReader.hpp"
 #include "reference/ReferenceDir.hpp"
 
 namespace dragenos {
@@ -62,72 +68,55 @@ typename ReferenceDir7::UcharPtr ReferenceDir7::ReadFileIntoBuffer(
   return bufPtr;
 }
 
-ReferenceDir7::ReferenceDir7(const boost::filesystem::path& path, bool mmap, bool load)
+ReferenceDir7::ReferenceDir7(
+    const boost::filesystem::path& path,
+    bool                           mmap,
+    bool                           load,
+    bool                           pack2Bit,
+    const boost::filesystem::path& cacheDirectory)
   : path_(path),
     hashtableConfigData_(getHashtableConfigData()),
     hashtableConfig_(hashtableConfigData_.data(), hashtableConfigData_.size())
 {
   if (mmap) {
-    hashtableData_   = mmapData<uint64_t>(hashtableBin, hashtableConfig_.getHashtableBytes());
+    hashtableData_   = mmapData<uint64_t>(path_ / hashtableBin, hashtableConfig_.getHashtableBytes());
     extendTableData_ = (exists(path_ / extendTableBin))
-                           ? mmapData<uint64_t>(extendTableBin, hashtableConfig_.getExtendTableBytes())
+                           ? mmapData<uint64_t>(path_ / extendTableBin, hashtableConfig_.getExtendTableBytes())
                            : nullptr;
-    referenceData_ = mmapData<unsigned char>(referenceBin, hashtableConfig_.getReferenceSequenceLength() / 2);
+    referenceData_ =
+        mmapData<unsigned char>(path_ / referenceBin, hashtableConfig_.getReferenceSequenceLength() / 2);
+    memoryMapped_ = true;
   } else if (load) {
     hashtableData_   = readData<uint64_t>(hashtableBin, hashtableConfig_.getHashtableBytes());
     extendTableData_ = (exists(path_ / extendTableBin))
                            ? readData<uint64_t>(extendTableBin, hashtableConfig_.getExtendTableBytes())
                            : nullptr;
     referenceData_ = readData<unsigned char>(referenceBin, hashtableConfig_.getReferenceSequenceLength() / 2);
+  } else if (!cacheDirectory.empty()) {
+    loadCachedHashtable(cacheDirectory);
   } else  // uncompress
   {
-    std::streamsize hashcmpsize = 0, refsize = 0;
-    referenceData_         = ReadFileIntoBuffer(path_ / referenceBin, refsize);
-    UcharPtr hashcmpbufPtr = ReadFileIntoBuffer(path_ / hashTableCmp, hashcmpsize);
-
-    uint64_t hashsize        = hashtableConfig_.getHashtableBytes();
-    uint64_t extendTableSize = hashtableConfig_.getExtendTableBytes();
-
-    // I don't know why decompHashTable needs pointer to pointer to hashbuf and extendTableBuf RP.
-    uint8_t* hashbuf        = (uint8_t*)malloc(hashsize);
-    uint8_t* extendTableBuf = (uint8_t*)malloc(extendTableSize);
-
-    const int numThreads = std::thread::hardware_concurrency();
-
-    // dragen likes to log to stdout. Redirect to stderr. Affects both c and c++ code
-    int stdoutori = dup(1);
-    dup2(2, 1);
+    decompressHashtable();
+  }
 
-    char* err = decompHashTable(
-        numThreads,
-        hashcmpbufPtr.get(),
-        hashcmpsize,
+  if (pack2Bit) {
+    packedReference_ = std::unique_ptr<PackedReference>(
+        new PackedReference(referenceData_.get(), hashtableConfig_.getReferenceSequenceLength() / 2));
+    // the 4 bits data is not needed anymore
+    referenceData_.reset();
+    std::cerr << boost::format("Packed reference: %d bases, %d exception runs, %.1f MB instead of %.1f MB") %
+                     packedReference_->getLength() % packedReference_->getExceptionCount() %
+                     (packedReference_->getMemoryBytes() / 1048576.0) %
+                     (hashtableConfig_.getReferenceSequenceLength() / 2 / 1048576.0)
+              << std::endl;
+    referenceSequencePtr_ = std::unique_ptr<ReferenceSequence>(
+        new ReferenceSequence(hashtableConfig_.getTrimmedRegions(), packedReference_.get()));
+  } else {
+    referenceSequencePtr_ = std::unique_ptr<ReferenceSequence>(new ReferenceSequence(
+        hashtableConfig_.getTrimmedRegions(),
         referenceData_.get(),
-        refsize,
-        &hashbuf,
-        &hashsize,
-        &extendTableBuf,
-        &extendTableSize,
-        nullptr,
-        nullptr);
-
-    if (err) {
-      BOOST_THROW_EXCEPTION(std::logic_error(err));
-    }
-
-    // restore stdout
-    dup2(stdoutori, 1);
-
-    hashtableData_ =
-        Uint64Ptr(reinterpret_cast<uint64_t*>(hashbuf), [this](uint64_t* p) -> void { free(p); });
-    extendTableData_ =
-        Uint64Ptr(reinterpret_cast<uint64_t*>(extendTableBuf), [this](uint64_t* p) -> void { free(p); });
+        hashtableConfig_.getReferenceSequenceLength() / 2));
   }
-
-  referenceSequencePtr_ = std::unique_ptr<ReferenceSequence>(new ReferenceSequence(
-      hashtableConfig_.getTrimmedRegions(),
-      referenceData_.get(),
-      hashtableConfig_.getReferenceSequenceLength() / 2));
 }
 
 ReferenceDir7::~ReferenceDir7() {}
@@ -156,6 +145,187 @@ static uintmax_t getFileSize(const boost::filesystem::path& filePath)
   return fileSize;
 }
 
+namespace {
+
+/// exclusive lock on a file, for the jobs running on the same host
+class FileLock {
+public:
+  explicit FileLock(const boost::filesystem::path& path) : fd_(open(path.c_str(), O_RDWR | O_CREAT, 0666))
+  {
+    if (-1 == fd_) {
+      BOOST_THROW_EXCEPTION(common::IoException(errno, "ERROR: failed to open lock file " + path.string()));
+    }
+    if (flock(fd_, LOCK_EX)) {
+      const int error = errno;
+      close(fd_);
+      BOOST_THROW_EXCEPTION(common::IoException(error, "ERROR: failed to lock " + path.string()));
+    }
+  }
+  ~FileLock()
+  {
+    flock(fd_, LOCK_UN);
+    close(fd_);
+  }
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+
+private:
+  const int fd_;
+};
+
+/// write the whole buffer and flush it to the device
+void writeFile(const boost::filesystem::path& path, const void* data, const size_t size)
+{
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (-1 == fd) {
+    BOOST_THROW_EXCEPTION(common::IoException(errno, "ERROR: failed to create " + path.string()));
+  }
+  const char* current = static_cast<const char*>(data);
+  size_t      toWrite = size;
+  while (toWrite) {
+    const ssize_t written = write(fd, current, toWrite);
+    if (0 > written) {
+      const int error = errno;
+      close(fd);
+      BOOST_THROW_EXCEPTION(common::IoException(error, "ERROR: failed to write " + path.string()));
+    }
+    current += written;
+    toWrite -= written;
+  }
+  if (fsync(fd) || close(fd)) {
+    BOOST_THROW_EXCEPTION(common::IoException(errno, "ERROR: failed to flush " + path.string()));
+  }
+}
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+void ReferenceDir7::decompressHashtable(uint32_t* hashtableDigest, uint32_t* extendTableDigest)
+{
+  const auto start = std::chrono::steady_clock::now();
+  // hash_table.cmp is read in the background, while reference.bin is loaded and the blocks already read are
+  // decompressed
+  ChunkedFileReader compressed(path_ / hashTableCmp);
+  std::streamsize   refsize = 0;
+  referenceData_            = ReadFileIntoBuffer(path_ / referenceBin, refsize);
+  const double referenceSeconds = secondsSince(start);
+
+  const uint64_t hashtableBytes   = hashtableConfig_.getHashtableBytes();
+  const uint64_t extendTableBytes = hashtableConfig_.getExtendTableBytes();
+  hashtableData_                  = allocateHugePages(hashtableBytes);
+  extendTableData_                = allocateHugePages(extendTableBytes);
+
+  std::array<double, DECOMP_PHASES> phaseSeconds{};
+  const char*                       err = decompHashTableStream(
+      std::thread::hardware_concurrency(),
+      compressed.data(),
+      compressed.size(),
+      &ChunkedFileReader::waitBytes,
+      &compressed,
+      referenceData_.get(),
+      refsize,
+      reinterpret_cast<uint8_t*>(hashtableData_.get()),
+      hashtableBytes,
+      reinterpret_cast<uint8_t*>(extendTableData_.get()),
+      extendTableBytes,
+      hashtableDigest,
+      extendTableDigest,
+      phaseSeconds.data());
+  // a read error is the cause of any decompression error
+  compressed.finish();
+  if (err) {
+    BOOST_THROW_EXCEPTION(std::logic_error(err));
+  }
+  std::cerr << boost::format(
+                   "Hashtable decompressed in %.3f s from %.1f MB: reference.bin %.3f s, init %.3f s, header "
+                   "%.3f s, literals %.3f s, automatic hits %.3f s, flags %.3f s, digests %.3f s") %
+                   secondsSince(start) % (compressed.size() / 1048576.0) % referenceSeconds % phaseSeconds[0] %
+                   phaseSeconds[1] % phaseSeconds[2] % phaseSeconds[3] % phaseSeconds[4] % phaseSeconds[5]
+            << std::endl;
+}
+
+void ReferenceDir7::loadCachedHashtable(const boost::filesystem::path& cacheDirectory)
+{
+  // the expected digests of the decompressed tables identify the content of the entry
+  const std::string entryName = (boost::format("%08x-%08x-%08x") % hashtableConfig_.getDigest() %
+                                 hashtableConfig_.getHashtableDigest() % hashtableConfig_.getExtendTableDigest())
+                                    .str();
+  const auto entry = cacheDirectory / entryName;
+  if (!exists(entry)) {
+    boost::filesystem::create_directories(cacheDirectory);
+    // concurrent jobs on the same host wait for a single decompression
+    const FileLock lock(cacheDirectory / (entryName + ".lock"));
+    if (!exists(entry)) {
+      uint32_t hashtableDigest   = 0;
+      uint32_t extendTableDigest = 0;
+      decompressHashtable(&hashtableDigest, &extendTableDigest);
+      if ((DIGEST_CRC32C == hashtableConfig_.getDigestType()) &&
+          ((hashtableConfig_.getHashtableDigest() != hashtableDigest) ||
+           (hashtableConfig_.getExtendTableDigest() != extendTableDigest))) {
+        std::cerr << boost::format(
+                         "WARNING: decompressed hashtable digests 0x%08X and 0x%08X don't match the config: "
+                         "0x%08X and 0x%08X: not cached") %
+                         hashtableDigest % extendTableDigest % hashtableConfig_.getHashtableDigest() %
+                         hashtableConfig_.getExtendTableDigest()
+                  << std::endl;
+        return;
+      }
+      writeCacheEntry(entry);
+      return;
+    }
+  }
+  const auto start = std::chrono::steady_clock::now();
+  hashtableData_   = mmapData<uint64_t>(entry / hashtableBin, hashtableConfig_.getHashtableBytes());
+  extendTableData_ = mmapData<uint64_t>(entry / extendTableBin, hashtableConfig_.getExtendTableBytes());
+  referenceData_   = readData<unsigned char>(referenceBin, hashtableConfig_.getReferenceSequenceLength() / 2);
+  memoryMapped_    = true;
+  std::cerr << boost::format("Hashtable mapped from %s in %.3f s") % entry.string() % secondsSince(start)
+            << std::endl;
+}
+
+void ReferenceDir7::writeCacheEntry(const boost::filesystem::path& entry) const
+{
+  const auto start = std::chrono::steady_clock::now();
+  // built aside and renamed, so that the entry is either complete or absent. Any leftover from a failed
+  // job is discarded, as the caller holds the lock
+  const auto temporary = entry.parent_path() / (entry.filename().string() + ".tmp");
+  try {
+    boost::filesystem::remove_all(temporary);
+    boost::filesystem::create_directory(temporary);
+    writeFile(temporary / hashtableBin, hashtableData_.get(), hashtableConfig_.getHashtableBytes());
+    writeFile(temporary / extendTableBin, extendTableData_.get(), hashtableConfig_.getExtendTableBytes());
+    boost::filesystem::rename(temporary, entry);
+  } catch (const std::exception& e) {
+    // the tables are in memory anyway
+    std::cerr << "WARNING: failed to write the hashtable cache entry " << entry.string() << ": " << e.what()
+              << std::endl;
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(temporary, ec);
+    return;
+  }
+  std::cerr << boost::format("Hashtable cached into %s in %.3f s") % entry.string() % secondsSince(start)
+            << std::endl;
+}
+
+ReferenceDir7::Uint64Ptr ReferenceDir7::allocateHugePages(const size_t bytes) const
+{
+  // at least one page, for a valid pointer even when there is no data
+  const size_t length = std::max<size_t>(bytes, 1);
+  void* data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (MAP_FAILED == data) {
+    BOOST_THROW_EXCEPTION(std::bad_alloc());
+  }
+#ifdef MADV_HUGEPAGE
+  // the tables are accessed at random, huge pages save most of the TLB misses
+  madvise(data, length, MADV_HUGEPAGE);
+#endif
+  return Uint64Ptr(reinterpret_cast<uint64_t*>(data), [length](uint64_t* p) -> void { munmap(p, length); });
+}
+
 std::vector<char> ReferenceDir7::getHashtableConfigData() const
 {
   using namespace dragenos::common;
@@ -175,11 +345,10 @@ std::vector<char> ReferenceDir7::getHashtableConfigData() const
 
 template <typename T>
 std::unique_ptr<T, std::function<void(T*)>> ReferenceDir7::mmapData(
-    const std::string binFile, const size_t expectedBinFileBytes) const
+    const boost::filesystem::path& dataFile, const size_t expectedBinFileBytes) const
 {
   using namespace dragenos::common;
-  checkDirectoryAndFile(path_, binFile);
-  const auto dataFile = path_ / binFile;
+  checkDirectoryAndFile(dataFile.parent_path(), dataFile.filename());
   const auto fileSize = getFileSize(dataFile);
   if (fileSize != expectedBinFileBytes) {
     boost::format message =
@@ -204,8 +373,9 @@ std::unique_ptr<T, std::function<void(T*)>> ReferenceDir7::mmapData(
     BOOST_THROW_EXCEPTION(
         IoException(errno, std::string("ERROR: failed to map hashtable data file ") + dataFile.string()));
   }
+  close(hashtableFd);
   return std::unique_ptr<T, std::function<void(T*)>>(
-      reinterpret_cast<T*>(table), [this](T* p) -> void { munmap(p, hashtableConfig_.getHashtableBytes()); });
+      reinterpret_cast<T*>(table), [fileSize](T* p) -> void { munmap(p, fileSize); });
 }
 
 template <typename T>
@@ -263,5 +433,23 @@ size_t ReferenceDir7::getHashtableDataSize() const
   return hashtableConfig_.getHashtableBytes();
 }
 
+std::vector<PageWarmup::Range> ReferenceDir7::getMappedRanges() const
+{
+  std::vector<PageWarmup::Range> ranges;
+  if (!memoryMapped_) {
+    return ranges;
+  }
+  // the reference first, as it is the smallest and probed for every alignment
+  if (referenceData_) {
+    ranges.push_back(
+        PageWarmup::Range{referenceData_.get(), hashtableConfig_.getReferenceSequenceLength() / 2});
+  }
+  ranges.push_back(PageWarmup::Range{hashtableData_.get(), hashtableConfig_.getHashtableBytes()});
+  if (extendTableData_) {
+    ranges.push_back(PageWarmup::Range{extendTableData_.get(), hashtableConfig_.getExtendTableBytes()});
+  }
+  return ranges;
+}
+
 }  // namespace reference
 }  // namespace dragenos
@@ -0,0 +1,176 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "reference/TargetIndex.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include "common/Exceptions.hpp"
+
+namespace dragenos {
+namespace reference {
+
+namespace {
+
+/// 2 bits code of each 4 bits value, -1 for anything but A, C, G and T
+constexpr std::array<int8_t, 16> CODES{-1, 0, 1, -1, 2, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1, -1};
+
+}  // namespace
+
+template <typename Op>
+bool TargetIndex::forEachKmer(
+    const unsigned char* begin, const unsigned char* end, const std::size_t step, Op op) const
+{
+  const uint64_t mask = (MAX_KMER_LENGTH == kmerLength_) ? ~uint64_t(0) : (uint64_t(1) << (2 * kmerLength_)) - 1;
+  const unsigned shift   = 2 * (kmerLength_ - 1);
+  uint64_t       forward = 0;
+  uint64_t       reverse = 0;
+  // number of consecutive A, C, G or T ending at the current base
+  std::size_t valid = 0;
+  for (const unsigned char* base = begin; end != base; ++base) {
+    const int code = CODES[*base & 0xF];
+    if (0 > code) {
+      valid = 0;
+      continue;
+    }
+    forward = ((forward << 2) | code) & mask;
+    reverse = (reverse >> 2) | (uint64_t(3 - code) << shift);
+    if ((kmerLength_ <= ++valid) && (0 == (base + 1 - kmerLength_ - begin) % step) &&
+        op(std::min(forward, reverse))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<TargetIndex::Region> TargetIndex::parseBed(
+    std::istream& bed, const HashtableConfig& config, const unsigned padding)
+{
+  std::unordered_map<std::string, const HashtableConfig::Sequence*> sequences;
+  for (const auto& sequence : config.getSequences()) {
+    sequences.emplace(config.getSequenceNames().at(sequence.id_), &sequence);
+  }
+
+  std::vector<Region> regions;
+  std::string         line;
+  for (std::size_t lineNumber = 1; std::getline(bed, line); ++lineNumber) {
+    std::istringstream fields(line);
+    std::string        name;
+    if (!(fields >> name) || ('#' == name[0]) || ("track" == name) || ("browser" == name)) {
+      continue;
+    }
+    uint64_t start = 0;
+    uint64_t end   = 0;
+    if (!(fields >> start >> end) || (start >= end)) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Invalid region at line " + std::to_string(lineNumber) + " of the BED file: " + line));
+    }
+    const auto found = sequences.find(name);
+    if (sequences.end() == found) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Unknown reference sequence at line " + std::to_string(lineNumber) + " of the BED file: " + name));
+    }
+    // only the bases between the trimmed Ns are in reference.bin
+    const HashtableConfig::Sequence& sequence = *found->second;
+
+    const uint64_t first = std::max<uint64_t>(start - std::min<uint64_t>(start, padding), sequence.begTrim);
+    const uint64_t last  = std::min<uint64_t>(end + padding, sequence.seqLen - sequence.endTrim);
+    if (first < last) {
+      regions.push_back(
+          Region{sequence.seqStart + first - sequence.begTrim, sequence.seqStart + last - sequence.begTrim});
+    }
+  }
+
+  std::sort(regions.begin(), regions.end());
+  std::vector<Region> merged;
+  for (const auto& region : regions) {
+    if (!merged.empty() && (region[0] <= merged.back()[1])) {
+      merged.back()[1] = std::max(merged.back()[1], region[1]);
+    } else {
+      merged.push_back(region);
+    }
+  }
+  return merged;
+}
+
+TargetIndex::TargetIndex(
+    std::vector<Region> regions, const ReferenceSequence& referenceSequence, const unsigned kmerLength)
+  : regions_(std::move(regions)), kmerLength_(kmerLength), prefixBits_(1)
+{
+  if ((0 == kmerLength_) || (MAX_KMER_LENGTH < kmerLength_)) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+        "Invalid k-mer length for the target index: " + std::to_string(kmerLength_)));
+  }
+  std::vector<unsigned char> bases;
+  for (const auto& region : regions_) {
+    referenceSequence.getBases(region[0], region[1], bases);
+    forEachKmer(bases.data(), bases.data() + bases.size(), 1, [this](const uint64_t kmer) {
+      kmers_.push_back(mix(kmer));
+      return false;
+    });
+  }
+  std::sort(kmers_.begin(), kmers_.end());
+  kmers_.erase(std::unique(kmers_.begin(), kmers_.end()), kmers_.end());
+  kmers_.shrink_to_fit();
+  if (std::numeric_limits<uint32_t>::max() <= kmers_.size()) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+        "Too many k-mers in the targets: " + std::to_string(kmers_.size()) +
+        ". Use the whole genome hashtable instead"));
+  }
+
+  // about 4 k-mers per prefix
+  while ((28 > prefixBits_) && ((uint64_t(4) << prefixBits_) < kmers_.size())) {
+    ++prefixBits_;
+  }
+  prefixStarts_.resize((std::size_t(1) << prefixBits_) + 1);
+  std::size_t i = 0;
+  for (std::size_t prefix = 0; prefixStarts_.size() - 1 > prefix; ++prefix) {
+    prefixStarts_[prefix] = i;
+    while ((kmers_.size() > i) && ((kmers_[i] >> (64 - prefixBits_)) == prefix)) {
+      ++i;
+    }
+  }
+  prefixStarts_.back() = kmers_.size();
+}
+
+uint64_t TargetIndex::getTargetLength() const
+{
+  uint64_t length = 0;
+  for (const auto& region : regions_) {
+    length += region[1] - region[0];
+  }
+  return length;
+}
+
+bool TargetIndex::isOnTarget(const sequences::Read::Bases& bases) const
+{
+  const std::size_t step = std::max(1u, kmerLength_ / 2);
+  return forEachKmer(
+      bases.data(), bases.data() + bases.size(), step, [this](const uint64_t kmer) { return contains(kmer); });
+}
+
+bool TargetIndex::contains(const uint64_t kmer) const
+{
+  const uint64_t mixed  = mix(kmer);
+  const uint64_t prefix = mixed >> (64 - prefixBits_);
+  return std::binary_search(
+      kmers_.begin() + prefixStarts_[prefix], kmers_.begin() + prefixStarts_[prefix + 1], mixed);
+}
+
+}  // namespace reference
+}  // namespace dragenos
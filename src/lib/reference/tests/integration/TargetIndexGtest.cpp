@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/Exceptions.hpp"
+#include "reference/TargetIndex.hpp"
+
+using namespace dragenos;
+using reference::HashtableConfig;
+using reference::ReferenceSequence;
+using reference::TargetIndex;
+
+namespace {
+
+/// chrA: 1000 bases, 100 trimmed at the beginning. chrB: 2000 bases, 500 trimmed at the end
+std::vector<char> makeConfigData()
+{
+  HashtableConfig::Header header;
+  std::memset(&header, 0, sizeof(header));
+  header.hashtableVersion = 8;
+  header.numRefSeqs       = 2;
+  header.priSeedBases     = 21;
+  std::vector<char> data(sizeof(header));
+  std::memcpy(data.data(), &header, sizeof(header));
+  const reference::detail::hashtableSeq_t sequences[] = {{0, 100, 0, 1000}, {1000, 0, 500, 2000}};
+  for (const auto& sequence : sequences) {
+    const char* const bytes = reinterpret_cast<const char*>(&sequence);
+    data.insert(data.end(), bytes, bytes + sizeof(sequence));
+  }
+  for (const std::string name : {"chrA", "chrB"}) {
+    data.insert(data.end(), name.c_str(), name.c_str() + name.size() + 1);
+  }
+  // followed by the empty strings for the versions, command line and file names
+  data.resize(data.size() + 64, 0);
+  return data;
+}
+
+/// random ACGT, 2 bases per byte as in reference.bin
+std::vector<unsigned char> randomReference(std::mt19937& gen, const std::size_t length)
+{
+  std::vector<unsigned char> data(length / 2, 0);
+  for (std::size_t i = 0; length > i; ++i) {
+    data[i / 2] |= (1 << (gen() % 4)) << (4 * (i % 2));
+  }
+  return data;
+}
+
+/// reverse complement of 4 bits encoded bases
+std::vector<unsigned char> reverseComplement(const std::vector<unsigned char>& bases)
+{
+  std::vector<unsigned char> ret(bases.rbegin(), bases.rend());
+  for (auto& base : ret) {
+    base = ((base & 1) << 3) | ((base & 2) << 1) | ((base & 4) >> 1) | ((base & 8) >> 3);
+  }
+  return ret;
+}
+
+}  // namespace
+
+TEST(TargetIndex, parseBed)
+{
+  const std::vector<char> configData = makeConfigData();
+  const HashtableConfig   config(configData.data(), configData.size());
+  std::istringstream      bed(
+      "track name=targets\n"
+      "# padded by 10, starts in the trimmed bases\n"
+      "chrA\t50\t200\n"
+      "chrB\t100\t300\tfirst\n"
+      "chrB 290 400\n"
+      "\n"
+      "chrB\t1490\t1600\n"
+      "chrA\t10\t20\n");
+  const std::vector<TargetIndex::Region> regions = TargetIndex::parseBed(bed, config, 10);
+  ASSERT_EQ(3u, regions.size());
+  ASSERT_EQ((TargetIndex::Region{0, 110}), regions[0]);
+  ASSERT_EQ((TargetIndex::Region{1090, 1410}), regions[1]);
+  ASSERT_EQ((TargetIndex::Region{2480, 2500}), regions[2]);
+
+  std::istringstream unknown("chrC\t0\t100\n");
+  ASSERT_THROW(TargetIndex::parseBed(unknown, config, 10), common::InvalidParameterException);
+  std::istringstream empty("chrA\t100\t100\n");
+  ASSERT_THROW(TargetIndex::parseBed(empty, config, 10), common::InvalidParameterException);
+  std::istringstream missing("chrA\t100\n");
+  ASSERT_THROW(TargetIndex::parseBed(missing, config, 10), common::InvalidParameterException);
+}
+
+TEST(TargetIndex, isOnTarget)
+{
+  std::mt19937                     gen(42);
+  const std::vector<unsigned char> data = randomReference(gen, 2600);
+
+  const ReferenceSequence referenceSequence(std::vector<ReferenceSequence::Region>(), data.data(), data.size());
+  const TargetIndex       targetIndex({{1090, 1410}, {2480, 2500}}, referenceSequence, 21);
+  ASSERT_EQ(21u, targetIndex.getKmerLength());
+  ASSERT_EQ(340u, targetIndex.getTargetLength());
+  ASSERT_EQ(320u - 20u, targetIndex.getKmerCount());
+
+  std::vector<unsigned char> read;
+  referenceSequence.getBases(1100, 1250, read);
+  ASSERT_TRUE(targetIndex.isOnTarget(read));
+  ASSERT_TRUE(targetIndex.isOnTarget(reverseComplement(read)));
+  // a few sequencing errors and an N
+  for (std::size_t i = 25; read.size() > i; i += 50) {
+    read[i] = (8 == read[i]) ? 1 : read[i] << 1;
+  }
+  read[60] = 0xF;
+  ASSERT_TRUE(targetIndex.isOnTarget(read));
+  // overlapping the end of the targets by a single k-mer
+  referenceSequence.getBases(1389, 1539, read);
+  ASSERT_TRUE(targetIndex.isOnTarget(read));
+  // too short for a k-mer
+  referenceSequence.getBases(1100, 1120, read);
+  ASSERT_FALSE(targetIndex.isOnTarget(read));
+
+  // off target, including just past the end of the targets
+  for (const std::size_t begin : {0, 500, 939, 1390, 2300}) {
+    referenceSequence.getBases(begin, begin + 150, read);
+    ASSERT_FALSE(targetIndex.isOnTarget(read)) << begin;
+    ASSERT_FALSE(targetIndex.isOnTarget(reverseComplement(read))) << begin;
+  }
+  read.assign(150, 0xF);
+  ASSERT_FALSE(targetIndex.isOnTarget(read));
+}
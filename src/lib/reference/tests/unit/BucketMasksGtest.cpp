@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <random>
+
+#include "reference/BucketMasks.hpp"
+
+using dragenos::reference::Bucket;
+using dragenos::reference::BucketMasks;
+using dragenos::reference::HashRecord;
+
+TEST(BucketMasks, SameAsHashRecords)
+{
+  std::mt19937_64 gen(13);
+  for (int iteration = 0; 10000 > iteration; ++iteration) {
+    // few distinct thread Ids and match bits to get plenty of matches
+    const uint8_t  threadId  = gen() % 4;
+    const uint64_t matchBits = (uint64_t(threadId) << 24) | (gen() % 4);
+    uint64_t       values[Bucket::hashRecordCount];
+    for (auto& value : values) {
+      value = gen();
+      // thread Id, hash bits and EX flag
+      value = (value & ((uint64_t(1) << 34) - 1)) | (((uint64_t(gen() % 4) << 24) | (gen() % 4)) << 34);
+      if (gen() % 2) {
+        // all the op codes, including REPAIR and the unknown ones
+        value |= uint64_t(0xF) << HashRecord::NOT_HIT_START;
+      }
+    }
+    Bucket bucket;
+    static_assert(sizeof(bucket) == sizeof(values), "unexpected bucket size");
+    std::memcpy(bucket.data(), values, sizeof(values));
+
+    const BucketMasks masks(bucket, matchBits, threadId);
+    for (unsigned i = 0; Bucket::hashRecordCount > i; ++i) {
+      const HashRecord& record = bucket[i];
+      const auto        type   = record.getType();
+      const bool        data   = (HashRecord::HIT == type) || (HashRecord::HIFREQ == type) ||
+                          (HashRecord::EXTEND == type) || (HashRecord::INTERVAL_SL == type) ||
+                          (HashRecord::INTERVAL_SLE == type) || (HashRecord::INTERVAL_S == type) ||
+                          (HashRecord::INTERVAL_L == type);
+      const bool thread = data && (threadId == record.getThreadId());
+      ASSERT_EQ(data, (masks.data_ >> i) & 1) << std::hex << record.getValue();
+      ASSERT_EQ(thread, (masks.thread_ >> i) & 1) << std::hex << record.getValue();
+      ASSERT_EQ(thread && (matchBits == record.getMatchBits()), (masks.match_ >> i) & 1);
+      ASSERT_EQ(record.isLastInThread(), (masks.lastInThread_ >> i) & 1);
+      ASSERT_EQ(record.isChainBegin(), (masks.chainBegin_ >> i) & 1);
+      ASSERT_EQ(record.isChainCon(), (masks.chainCon_ >> i) & 1);
+      ASSERT_EQ(HashRecord::EMPTY == type, (masks.empty_ >> i) & 1);
+      const bool invalid =
+          (HashRecord::REPAIR == type) || ((HashRecord::INTERVAL_L < type) && (HashRecord::HIT != type));
+      ASSERT_EQ(invalid, (masks.invalid_ >> i) & 1) << std::hex << record.getValue();
+    }
+    // nothing beyond the bucket
+    ASSERT_EQ(0u, masks.data_ >> Bucket::hashRecordCount);
+    ASSERT_EQ(0u, masks.invalid_ >> Bucket::hashRecordCount);
+  }
+}
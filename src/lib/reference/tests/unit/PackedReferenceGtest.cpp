@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "reference/PackedReference.hpp"
+
+using dragenos::reference::PackedReference;
+
+namespace {
+
+const std::array<unsigned char, 16> COMPLEMENTS{0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+
+/// random ACGT with runs of padding, N and other IUPAC codes, 2 bases per byte as in reference.bin
+std::vector<unsigned char> randomReference(std::mt19937& gen, size_t length)
+{
+  static const std::array<unsigned char, 4> acgt{1, 2, 4, 8};
+  static const std::array<unsigned char, 4> others{0, 0xF, 5, 0xA};
+  std::vector<unsigned char>                ret(length / 2, 0);
+  for (size_t i = 0; length > i;) {
+    const bool          exception = (0 == gen() % 8);
+    const unsigned char base      = exception ? others[gen() % others.size()] : 0;
+    const size_t        run       = exception ? 1 + gen() % 70 : 1 + gen() % 200;
+    for (size_t j = 0; (run > j) && (length > i); ++j, ++i) {
+      ret[i / 2] |= (exception ? base : acgt[gen() % acgt.size()]) << (4 * (i % 2));
+    }
+  }
+  return ret;
+}
+
+unsigned char getBase(const std::vector<unsigned char>& data, size_t position)
+{
+  return (data[position / 2] >> (4 * (position % 2))) & 0xF;
+}
+
+}  // namespace
+
+TEST(PackedReference, getBase)
+{
+  // NNACGTATAGAC followed by padding, as in the example of ReferenceSequence.hpp
+  const std::vector<unsigned char> data{0xFF, 0x21, 0x84, 0x81, 0x41, 0x21, 0x00, 0x00};
+  const PackedReference            packed(data.data(), data.size());
+  ASSERT_EQ(16u, packed.getLength());
+  ASSERT_EQ(2u, packed.getExceptionCount());
+  for (size_t i = 0; packed.getLength() > i; ++i) {
+    ASSERT_EQ(getBase(data, i), packed.getBase(i)) << "i: " << i;
+  }
+}
+
+TEST(PackedReference, getBases)
+{
+  std::mt19937               gen(31);
+  const auto                 data = randomReference(gen, 5000);
+  const PackedReference      packed(data.data(), data.size());
+  std::vector<unsigned char> bases;
+  std::vector<unsigned char> rcBases;
+  for (unsigned iteration = 0; 2000 > iteration; ++iteration) {
+    // lengths below and above the 32 bases decoded at once, including the end of the reference
+    const size_t length = gen() % 200;
+    const size_t begin  = (0 == iteration % 100) ? packed.getLength() - length : gen() % (packed.getLength() - length);
+    bases.assign(length, 0xFF);
+    rcBases.assign(length, 0xFF);
+    packed.getBases(begin, begin + length, bases.data());
+    packed.getRcBases(begin, begin + length, rcBases.data());
+    for (size_t i = 0; length > i; ++i) {
+      const unsigned char expected = getBase(data, begin + i);
+      ASSERT_EQ(expected, bases[i]) << "begin: " << begin << " length: " << length << " i: " << i;
+      ASSERT_EQ(COMPLEMENTS[expected], rcBases[i]) << "begin: " << begin << " length: " << length << " i: " << i;
+    }
+  }
+  for (size_t i = 0; packed.getLength() > i; ++i) {
+    ASSERT_EQ(getBase(data, i), packed.getBase(i)) << "i: " << i;
+  }
+  // far fewer exception runs than bases, and half the memory of reference.bin
+  ASSERT_GT(packed.getLength() / 100, packed.getExceptionCount());
+  ASSERT_GT(data.size(), packed.getMemoryBytes());
+}
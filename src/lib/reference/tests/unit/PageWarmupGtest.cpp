@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+
+#include <sys/mman.h>
+#include <sstream>
+#include <vector>
+
+#include "reference/PageWarmup.hpp"
+
+using dragenos::reference::PageWarmup;
+
+namespace {
+
+/// anonymous mapping, so that the pages really fault in
+struct Mapping {
+  explicit Mapping(std::size_t size)
+    : size_(size), data_(mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0))
+  {
+  }
+  ~Mapping() { munmap(data_, size_); }
+  std::size_t size_;
+  void*       data_;
+};
+
+}  // namespace
+
+TEST(PageWarmup, wait)
+{
+  // several chunks, the last one partial, and a range smaller than a page
+  const Mapping     large(3 * PageWarmup::CHUNK_BYTES + 12345);
+  const Mapping     small(100);
+  std::stringstream progress;
+  PageWarmup        warmup({{large.data_, large.size_}, {small.data_, small.size_}}, 3);
+  ASSERT_EQ(large.size_ + small.size_, warmup.getTotalBytes());
+  warmup.wait(1.0, progress);
+  ASSERT_EQ(warmup.getTotalBytes(), warmup.getWarmBytes());
+  ASSERT_NE(std::string::npos, progress.str().find("100.0%")) << progress.str();
+}
+
+TEST(PageWarmup, fraction)
+{
+  const Mapping     mapping(8 * PageWarmup::CHUNK_BYTES);
+  std::stringstream progress;
+  {
+    PageWarmup warmup({{mapping.data_, mapping.size_}}, 1);
+    warmup.wait(0.5, progress);
+    ASSERT_LE(mapping.size_ / 2, warmup.getWarmBytes());
+    // stops without waiting for the remaining chunks
+  }
+  PageWarmup none({}, 0);
+  none.wait(1.0, progress);
+  ASSERT_EQ(0u, none.getWarmBytes());
+}
@@ -14,6 +14,7 @@
 
 #include <memory.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 
@@ -70,6 +71,33 @@ uint64_t CrcHasher::getHash64(const uint64_t value) const
   return hash;
 }
 
+void CrcHasher::getHashes64(const uint64_t* values, const std::size_t count, uint64_t* hashes) const
+{
+  static constexpr std::size_t INTERLEAVE = 4;
+  const unsigned               bytes      = getByteCount();
+  std::size_t                  i          = 0;
+  // independent lookup chains keep several loads from the table in flight
+  for (; count >= i + INTERLEAVE; i += INTERLEAVE) {
+    const uint64_t* init             = init64_.get();
+    uint64_t        hash[INTERLEAVE] = {0, 0, 0, 0};
+    for (unsigned byte = 0; bytes > byte; ++byte, init += 256) {
+      const unsigned shift = 8 * byte;
+      for (std::size_t j = 0; INTERLEAVE > j; ++j) {
+        hash[j] ^= init[(values[i + j] >> shift) & 0xFF];
+      }
+    }
+    std::copy(hash, hash + INTERLEAVE, hashes + i);
+  }
+  for (; count > i; ++i) {
+    const uint64_t* init = init64_.get();
+    uint64_t        hash = 0;
+    for (unsigned byte = 0; bytes > byte; ++byte, init += 256) {
+      hash ^= init[(values[i] >> (8 * byte)) & 0xFF];
+    }
+    hashes[i] = hash;
+  }
+}
+
 void CrcHasher::crcHashSlow(int bits, const uint8_t* poly, const uint8_t* data, uint8_t* hash)
 {
   int bytes = (bits + 7) >> 3, topByte = bytes - 1;
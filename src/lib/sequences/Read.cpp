@@ -35,6 +35,8 @@ Read& Read::operator=(Read&& that)
   bases_.swap(that.bases_);
   rcBases_.swap(that.rcBases_);
   qualities_.swap(that.qualities_);
+  conversion_ = that.conversion_;
+  sequencedBases_.swap(that.sequencedBases_);
   return *this;
 }
 
@@ -74,6 +76,25 @@ void Read::init(Name&& name, Bases&& bases, Qualities&& qualities, uint64_t id,
   //  qualities_ = std::move(qualities);
   qualities_.swap(qualities);
   reverseComplement4bpb(bases_, rcBases_);
+  conversion_ = NO_CONVERSION;
+}
+
+void Read::convert(const Conversion conversion)
+{
+  assert(NO_CONVERSION == conversion_);
+  if (NO_CONVERSION == conversion) {
+    return;
+  }
+  const Base from = (C_TO_T == conversion) ? 2 : 4;
+  const Base to   = (C_TO_T == conversion) ? 8 : 1;
+  sequencedBases_ = bases_;
+  for (auto& base : bases_) {
+    if ((0xF != base) && (base & from)) {
+      base = (base & ~from) | to;
+    }
+  }
+  reverseComplement4bpb(bases_, rcBases_);
+  conversion_ = conversion;
 }
 
 std::ostream& operator<<(std::ostream& os, const __m128i& i128)
@@ -104,7 +104,20 @@ std::vector<size_t> Seed::getSeedOffsets(
     const uint8_t  force)
 {
   std::vector<size_t> seedOffsets;
-  size_t              offset = 0;
+  getSeedOffsets(readLength, seedLength, period, pattern, force, seedOffsets);
+  return seedOffsets;
+}
+
+void Seed::getSeedOffsets(
+    const size_t         readLength,
+    const unsigned       seedLength,
+    const uint32_t       period,
+    const uint32_t       pattern,
+    const uint8_t        force,
+    std::vector<size_t>& seedOffsets)
+{
+  seedOffsets.clear();
+  size_t offset = 0;
   while (offset + seedLength <= readLength) {
     const bool forced         = (offset + seedLength + force > readLength);
     const bool matchesPattern = ((pattern >> (offset % period)) & 1);
@@ -113,7 +126,6 @@ std::vector<size_t> Seed::getSeedOffsets(
     }
     ++offset;
   }
-  return seedOffsets;
 }
 
 }  // namespace sequences
@@ -0,0 +1,68 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "sequences/SeedEncoder.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "common/Exceptions.hpp"
+
+namespace dragenos {
+namespace sequences {
+
+void SeedEncoder::encode(const Read& read, const unsigned primaryLength, const std::vector<size_t>& seedOffsets)
+{
+  if (primaryLength > sizeof(Seed::Data) * 4 || 0 == primaryLength) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException("Seed primary length is limited to 32 bases"));
+  }
+  forwardData_.clear();
+  reverseData_.clear();
+  primaryData_.clear();
+  hashes_.clear();
+  if (seedOffsets.empty()) {
+    return;
+  }
+  if (seedOffsets.back() + primaryLength > read.getLength()) {
+    BOOST_THROW_EXCEPTION(common::PreConditionException("Requesting primary data for an invalid seed"));
+  }
+  const Seed::Data mask          = (sizeof(Seed::Data) * 4 == primaryLength)
+                                       ? ~Seed::Data(0)
+                                       : (Seed::Data(1) << (2 * primaryLength)) - 1;
+  const unsigned   lastBaseShift = 2 * (primaryLength - 1);
+  Seed::Data       forward       = 0;
+  Seed::Data       reverse       = 0;
+  // the base at position i is shifted in when i is the last base of the seed starting at i + 1 - primaryLength
+  std::size_t position = seedOffsets.front();
+  for (const auto seedOffset : seedOffsets) {
+    assert(seedOffset + primaryLength > position);
+    for (position = std::max(position, seedOffset); seedOffset + primaryLength > position; ++position) {
+      const Seed::Data base = read.getBase2bpb(position) & 3;
+      forward               = (forward >> 2) | (base << lastBaseShift);
+      reverse               = ((reverse << 2) | (3 - base)) & mask;
+    }
+    forwardData_.push_back(forward);
+    reverseData_.push_back(reverse);
+    primaryData_.push_back(std::min(forward, reverse));
+  }
+}
+
+void SeedEncoder::hash(const CrcHasher& hasher)
+{
+  hashes_.resize(primaryData_.size());
+  hasher.getHashes64(primaryData_.data(), primaryData_.size(), hashes_.data());
+}
+
+}  // namespace sequences
+}  // namespace dragenos
@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/Exceptions.hpp"
+#include "sequences/SeedEncoder.hpp"
+
+using dragenos::sequences::CrcHasher;
+using dragenos::sequences::CrcPolynomial;
+using dragenos::sequences::Read;
+using dragenos::sequences::Seed;
+using dragenos::sequences::SeedEncoder;
+
+namespace {
+
+void initRandomRead(std::mt19937& gen, Read& read, const unsigned length)
+{
+  static const std::string bases = "ACGTACGTACGTN";
+  std::string              sequence;
+  for (unsigned i = 0; length > i; ++i) {
+    sequence.push_back(bases[gen() % bases.size()]);
+  }
+  const std::string qualities(length, 'E');
+  read.init(
+      Read::Name(),
+      Read::Bases(sequence.begin(), sequence.end()),
+      Read::Qualities(qualities.begin(), qualities.end()),
+      0,
+      0);
+}
+
+}  // namespace
+
+TEST(SeedEncoder, SameAsSeed)
+{
+  const CrcHasher hasher(CrcPolynomial(54, std::string("2C991CE6A8DD55")));
+  std::mt19937    gen(7);
+  SeedEncoder     encoder;
+  Read            read;
+  for (int iteration = 0; 200 > iteration; ++iteration) {
+    initRandomRead(gen, read, 32 + gen() % 150);
+    const unsigned primaryLength = 1 + gen() % 32;
+    // the default seed offsets, or sparse offsets with gaps longer than the seed
+    auto seedOffsets = Seed::getSeedOffsets(read.getLength(), primaryLength, 2, 1, 1);
+    if (iteration % 2) {
+      seedOffsets.clear();
+      for (size_t offset = gen() % 4; offset + primaryLength <= read.getLength(); offset += 1 + gen() % 40) {
+        seedOffsets.push_back(offset);
+      }
+    }
+    encoder.encode(read, primaryLength, seedOffsets);
+    encoder.hash(hasher);
+    ASSERT_EQ(seedOffsets.size(), encoder.size());
+    for (size_t i = 0; seedOffsets.size() > i; ++i) {
+      const Seed seed(&read, seedOffsets[i], primaryLength);
+      const auto forward = seed.getPrimaryData(false);
+      const auto reverse = seed.getPrimaryData(true);
+      ASSERT_EQ(forward, encoder.getForwardData(i)) << "length: " << primaryLength << " i: " << i;
+      ASSERT_EQ(reverse, encoder.getReverseData(i)) << "length: " << primaryLength << " i: " << i;
+      ASSERT_EQ(reverse < forward, encoder.isReverseComplement(i));
+      ASSERT_EQ(std::min(forward, reverse), encoder.getPrimaryData(i));
+      ASSERT_EQ(hasher.getHash64(std::min(forward, reverse)), encoder.getHash(i));
+    }
+  }
+}
+
+TEST(SeedEncoder, InvalidSeeds)
+{
+  std::mt19937 gen(7);
+  SeedEncoder  encoder;
+  Read         read;
+  initRandomRead(gen, read, 50);
+  ASSERT_THROW(encoder.encode(read, 33, {0}), dragenos::common::InvalidParameterException);
+  ASSERT_THROW(encoder.encode(read, 21, {0, 30}), dragenos::common::PreConditionException);
+  encoder.encode(read, 21, {});
+  ASSERT_EQ(0u, encoder.size());
+}
@@ -2,6 +2,7 @@
 #include "gtest/gtest.h"
 
 #include <string>
+#include <vector>
 #include "sequences/CrcHasher.hpp"
 
 TEST(CrcHasher, KnownHashValues)
@@ -17,3 +18,23 @@ TEST(CrcHasher, KnownHashValues)
   ASSERT_EQ(primaryHasher.getHash64(0x150d50d50d5), 0x9287b35d36195u);
   ASSERT_EQ(primaryHasher.getHash64(0xd50d50d50d), 0x22d3a73e8851c7u);
 }
+
+TEST(CrcHasher, BatchSameAsSingle)
+{
+  using dragenos::sequences::CrcHasher;
+  using dragenos::sequences::CrcPolynomial;
+  const CrcPolynomial   primaryPolynomial(54, std::string("2C991CE6A8DD55"));
+  const CrcHasher       primaryHasher(primaryPolynomial);
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; 11 > i; ++i) {
+    values.push_back(0x3543543543 * (i + 1) ^ (i << 40));
+  }
+  // all the batch sizes, including the ones not multiple of the interleaving
+  for (std::size_t count = 0; values.size() >= count; ++count) {
+    std::vector<uint64_t> hashes(count);
+    primaryHasher.getHashes64(values.data(), count, hashes.data());
+    for (std::size_t i = 0; count > i; ++i) {
+      ASSERT_EQ(primaryHasher.getHash64(values[i]), hashes[i]) << "count: " << count << " i: " << i;
+    }
+  }
+}
@@ -0,0 +1,145 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "workflow/Checkpoint.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/throw_exception.hpp>
+
+#include "common/Exceptions.hpp"
+
+namespace dragenos {
+namespace workflow {
+
+namespace {
+
+const std::string CHECKPOINT_HEADER = "DRAGMAP checkpoint 1";
+// repeated for each read group, and missing from the checkpoints of the previous versions
+const std::string READ_GROUP_INSERT_STATS = "read-group-insert-stats";
+
+}  // namespace
+
+void saveCheckpoint(const Checkpoint& checkpoint, const boost::filesystem::path& path)
+{
+  const std::string temporaryPath = path.string() + ".tmp";
+  {
+    std::ofstream os(temporaryPath.c_str());
+    os << CHECKPOINT_HEADER << "\n"
+       << "complete " << checkpoint.complete_ << "\n"
+       << "read-group " << checkpoint.readGroup_ << "\n"
+       << "read-group-id " << checkpoint.readGroupId_ << "\n"
+       << "records " << checkpoint.records_ << "\n"
+       << "r1-offset " << checkpoint.r1Offset_ << "\n"
+       << "r2-offset " << checkpoint.r2Offset_ << "\n"
+       << "sam-offset " << checkpoint.samOffset_ << "\n"
+       << "insert-stats-offset " << checkpoint.insertStatsOffset_ << "\n"
+       << "insert-stats " << checkpoint.insertStats_ << "\n"
+       << "mapping-metrics " << checkpoint.mappingMetrics_ << "\n";
+    for (const auto& stats : checkpoint.readGroupInsertStats_) {
+      os << READ_GROUP_INSERT_STATS << " " << stats.first << " " << stats.second << "\n";
+    }
+    os.close();
+    if (!os) {
+      BOOST_THROW_EXCEPTION(common::IoException(
+          errno, std::string("Failed to write checkpoint: ") + temporaryPath + ": " + strerror(errno)));
+    }
+  }
+  if (0 != std::rename(temporaryPath.c_str(), path.c_str())) {
+    BOOST_THROW_EXCEPTION(common::IoException(
+        errno, std::string("Failed to rename checkpoint to ") + path.string() + ": " + strerror(errno)));
+  }
+}
+
+bool loadCheckpoint(const boost::filesystem::path& path, Checkpoint& checkpoint)
+{
+  if (!boost::filesystem::exists(path)) {
+    return false;
+  }
+  std::ifstream is(path.c_str());
+  std::string   line;
+  if (!std::getline(is, line) || CHECKPOINT_HEADER != line) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException("Not a checkpoint file: " + path.string()));
+  }
+  std::map<std::string, std::string> values;
+  std::vector<std::string>           readGroupInsertStats;
+  while (std::getline(is, line)) {
+    const std::size_t space = line.find(' ');
+    const std::string key   = line.substr(0, space);
+    const std::string value = (std::string::npos == space) ? "" : line.substr(space + 1);
+    if (READ_GROUP_INSERT_STATS == key) {
+      readGroupInsertStats.push_back(value);
+    } else {
+      values[key] = value;
+    }
+  }
+  if (is.bad()) {
+    BOOST_THROW_EXCEPTION(common::IoException(
+        errno, std::string("Failed to read checkpoint: ") + path.string() + ": " + strerror(errno)));
+  }
+
+  const auto get = [&values, &path](const std::string& key) -> const std::string& {
+    const auto value = values.find(key);
+    if (values.end() == value) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Missing " + key + " in checkpoint file: " + path.string()));
+    }
+    return value->second;
+  };
+  const auto toNumber = [&path](const std::string& key, const std::string& value) -> uint64_t {
+    // stoull would also take leading spaces and negate a minus sign
+    try {
+      std::size_t end = 0;
+      const auto  ret = std::stoull(value, &end);
+      if (!value.empty() && std::isdigit(value.front()) && (value.size() == end)) {
+        return ret;
+      }
+    } catch (const std::logic_error&) {
+    }
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+        "Invalid " + key + " in checkpoint file: " + path.string() + ": " + value));
+  };
+  const auto getNumber = [&get, &toNumber](const std::string& key) { return toNumber(key, get(key)); };
+  checkpoint.complete_          = getNumber("complete");
+  checkpoint.readGroup_         = getNumber("read-group");
+  checkpoint.readGroupId_       = get("read-group-id");
+  checkpoint.records_           = getNumber("records");
+  checkpoint.r1Offset_          = getNumber("r1-offset");
+  checkpoint.r2Offset_          = getNumber("r2-offset");
+  checkpoint.samOffset_         = getNumber("sam-offset");
+  checkpoint.insertStatsOffset_ = getNumber("insert-stats-offset");
+  checkpoint.insertStats_       = get("insert-stats");
+  checkpoint.mappingMetrics_    = get("mapping-metrics");
+  checkpoint.readGroupInsertStats_.clear();
+  for (const auto& value : readGroupInsertStats) {
+    const std::size_t space = value.find(' ');
+    const std::size_t position = toNumber(READ_GROUP_INSERT_STATS, value.substr(0, space));
+    if ((std::string::npos == space) ||
+        !checkpoint.readGroupInsertStats_.emplace(position, value.substr(space + 1)).second) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Invalid " + READ_GROUP_INSERT_STATS + " in checkpoint file: " + path.string() + ": " + value));
+    }
+  }
+  return true;
+}
+
+}  // namespace workflow
+}  // namespace dragenos
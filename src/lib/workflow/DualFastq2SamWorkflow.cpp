@@ -14,19 +14,21 @@
 
 #include <fstream>
 #include <limits>
+#include <sstream>
 
-#include <boost/iostreams/device/back_inserter.hpp>
 // #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
 
+#include "common/Arena.hpp"
 #include "common/Debug.hpp"
+#include "common/Exceptions.hpp"
 #include "common/Threads.hpp"
 #include "mapping_stats.hpp"
 
 #include "align/Aligner.hpp"
+#include "align/MethylationCaller.hpp"
 #include "align/SinglePicker.hpp"
-#include "fastq/Tokenizer.hpp"
+#include "fastq/BlockTokenizer.hpp"
 #include "io/Fastq2ReadTransformer.hpp"
 #include "sam/SamGenerator.hpp"
 
@@ -37,11 +39,29 @@
 namespace dragenos {
 namespace workflow {
 
+std::size_t DualFastq2SamWorkflow::readRecords(
+    fastq::FastqNRecordReader& reader, RecordBlock& block, const std::size_t n)
+{
+  // arbitrary preallocation to avoid unnecessary copy/paste
+  block.buffer_.reserve(n * 1024);
+  block.buffer_.clear();
+  const std::size_t records = reader.read(std::back_inserter(block.buffer_), n);
+  block.begin_              = block.buffer_.data();
+  block.end_                = block.buffer_.data() + block.buffer_.size();
+  return records;
+}
+
+std::size_t DualFastq2SamWorkflow::readRecords(
+    fastq::MappedFastqReader& reader, RecordBlock& block, const std::size_t n)
+{
+  return reader.read(block.begin_, block.end_, n);
+}
+
 align::InsertSizeParameters DualFastq2SamWorkflow::requestInsertSizeInfo(
-    align::InsertSizeDistribution& insertSizeDistribution, std::istream& inputR1, std::istream& inputR2)
+    align::InsertSizeDistribution& insertSizeDistribution, const RecordBlock& r1Block, const RecordBlock& r2Block)
 {
-  fastq::Tokenizer r1Tokenizer(inputR1);
-  fastq::Tokenizer r2Tokenizer(inputR2);
+  fastq::BlockTokenizer r1Tokenizer(r1Block.begin_, r1Block.end_);
+  fastq::BlockTokenizer r2Tokenizer(r2Block.begin_, r2Block.end_);
 
   align::InsertSizeParameters ret;
   bool                        retDone = false;
@@ -61,9 +81,6 @@ align::InsertSizeParameters DualFastq2SamWorkflow::requestInsertSizeInfo(
     }
   }
 
-  // make sure both files have been read to end
-  assert(inputR1.eof());
-  assert(inputR2.eof());
   // make sure there is no case of one file having a good read and the other one not
   assert(!r1Tokenizer.token().valid() && !r2Tokenizer.next());
 
@@ -73,19 +90,20 @@ align::InsertSizeParameters DualFastq2SamWorkflow::requestInsertSizeInfo(
 template <typename StoreOp>
 void DualFastq2SamWorkflow::alignDualFastq(
     align::InsertSizeParameters& insertSizeParameters,
-    std::istream&                inputR1,
-    std::istream&                inputR2,
+    const RecordBlock&           r1Block,
+    const RecordBlock&           r2Block,
     align::Aligner&              aligner,
     const align::SinglePicker&   singlePicker,
     const align::PairBuilder&    pairBuilder,
     StoreOp                      store)
 {
-  fastq::Tokenizer r1Tokenizer(inputR1);
-  fastq::Tokenizer r2Tokenizer(inputR2);
+  fastq::BlockTokenizer r1Tokenizer(r1Block.begin_, r1Block.end_);
+  fastq::BlockTokenizer r2Tokenizer(r2Block.begin_, r2Block.end_);
 
   align::AlignmentPairs alignmentPairs;
 
-  io::FastqToReadTransformer fastq2Read(options_.inputQnameSuffixDelim_, options_.fastqOffset_);
+  io::FastqToReadTransformer fastq2Read(
+      options_.inputQnameSuffixDelim_, options_.fastqOffset_, options_.isMethylated());
   align::Aligner::ReadPair   pair;
 
   int64_t fragmentId = 0;
@@ -110,22 +128,20 @@ void DualFastq2SamWorkflow::alignDualFastq(
     ++fragmentId;
   }
 
-  // make sure both files have been read to end
-  assert(inputR1.eof());
-  assert(inputR2.eof());
   // make sure there is no case of one file having a good read and the other one not
   assert(!r1Tokenizer.token().valid() && !r2Tokenizer.next());
 }
 
+template <typename Reader>
 void DualFastq2SamWorkflow::readBlockThread(
     common::ThreadPool::lock_type& lock,
     const int                      ourBlock,
     int&                           r1Records,
-    std::vector<char>&             r1Block,
-    fastq::FastqNRecordReader&     r1Reader,
+    RecordBlock&                   r1Block,
+    Reader&                        r1Reader,
     int&                           r2Records,
-    std::vector<char>&             r2Block,
-    fastq::FastqNRecordReader&     r2Reader)
+    RecordBlock&                   r2Block,
+    Reader&                        r2Reader)
 {
   // if a thread is late to the party, both read blocks have been already done.
   // use < instead of != for wait
@@ -139,8 +155,7 @@ void DualFastq2SamWorkflow::readBlockThread(
       r1Records = 0;  // we will be reading this block.
       {
         common::unlock_guard<common::ThreadPool::lock_type> unlock(lock);
-        r1Block.clear();
-        r1Records = r1Reader.read(std::back_inserter(r1Block), RECORDS_AT_A_TIME_);
+        r1Records = readRecords(r1Reader, r1Block, RECORDS_AT_A_TIME_);
         r1Eof_    = r1Reader.eof();
       }
     }
@@ -151,8 +166,7 @@ void DualFastq2SamWorkflow::readBlockThread(
       r2Records = 0;
       {
         common::unlock_guard<common::ThreadPool::lock_type> unlock(lock);
-        r2Block.clear();
-        r2Records = r2Reader.read(std::back_inserter(r2Block), RECORDS_AT_A_TIME_);
+        r2Records = readRecords(r2Reader, r2Block, RECORDS_AT_A_TIME_);
         r2Eof_    = r2Reader.eof();
       }
     }
@@ -161,32 +175,16 @@ void DualFastq2SamWorkflow::readBlockThread(
 }
 
 void DualFastq2SamWorkflow::parseDualFastq(
-    std::ostream& os, std::ostream& insertSizeDistributionLogStream, std::ostream& mappingMetricsLogStream)
+    std::istream&             r1Stream,
+    std::istream&             r2Stream,
+    std::ostream&             os,
+    std::ostream&             insertSizeDistributionLogStream,
+    ReadGroupAlignmentCounts& mappingMetrics)
 {
-  std::ifstream r1Stream(options_.inputFile1_, std::ios_base::in | std::ios_base::binary);
-  //  r1Stream.exceptions(std::ios_base::badbit | std::ios_base::failbit);
-  boost::iostreams::filtering_istream r1Decomp;
-  if (options_.inputFile1_.length() > 3 &&
-      ".gz" == options_.inputFile1_.substr(options_.inputFile1_.length() - 3)) {
-    r1Decomp.push(boost::iostreams::gzip_decompressor());
-  }
-
-  boost::iostreams::filtering_istream r2Decomp;
-  std::ifstream r2Stream(options_.inputFile2_, std::ios_base::in | std::ios_base::binary);
-  //  r2Stream.exceptions(std::ios_base::badbit | std::ios_base::failbit);
-  if (options_.inputFile2_.length() > 3 &&
-      ".gz" == options_.inputFile2_.substr(options_.inputFile2_.length() - 3)) {
-    r2Decomp.push(boost::iostreams::gzip_decompressor());
-  }
-
-  //    r1Decomp.push(boost::iostreams::file_source(options_.fastqFile1_, BOOST_IOS::in | BOOST_IOS::binary));
-  r1Decomp.push(r1Stream);
-  r1Decomp.exceptions(std::ios_base::badbit);
-  //    r2Decomp.push(boost::iostreams::file_source(options_.fastqFile2_, BOOST_IOS::in | BOOST_IOS::binary));
-  r2Decomp.push(r2Stream);
-  r2Decomp.exceptions(std::ios_base::badbit);
+  fastq::FastqNRecordReader r1Reader(r1Stream);
+  fastq::FastqNRecordReader r2Reader(r2Stream);
   try {
-    parseDualFastq(r1Decomp, r2Decomp, os, insertSizeDistributionLogStream, mappingMetricsLogStream);
+    alignDualFastq(r1Reader, r2Reader, os, insertSizeDistributionLogStream, mappingMetrics);
   } catch (boost::iostreams::gzip_error& e) {
     BOOST_THROW_EXCEPTION(std::runtime_error(
         e.what() + std::string(" ") + std::to_string(e.error()) +
@@ -196,14 +194,24 @@ void DualFastq2SamWorkflow::parseDualFastq(
   }
 }
 
+void DualFastq2SamWorkflow::parseDualFastq(
+    fastq::MappedFastqReader& r1Reader,
+    fastq::MappedFastqReader& r2Reader,
+    std::ostream&             os,
+    std::ostream&             insertSizeDistributionLogStream,
+    ReadGroupAlignmentCounts& mappingMetrics)
+{
+  alignDualFastq(r1Reader, r2Reader, os, insertSizeDistributionLogStream, mappingMetrics);
+}
+
+template <typename Reader>
 void DualFastq2SamWorkflow::alignDualFastqBlock(
     common::ThreadPool::lock_type&         lock,
     std::size_t&                           cpuThreads,
-    std::size_t&                           threadID,
-    std::vector<ReadGroupAlignmentCounts>& mappingMetricsVector,
+    ReadGroupAlignmentCounts&              mappingMetrics,
     align::InsertSizeDistribution&         insertSizeDistribution,
-    fastq::FastqNRecordReader&             r1Reader,
-    fastq::FastqNRecordReader&             r2Reader,
+    Reader&                                r1Reader,
+    Reader&                                r2Reader,
     std::ostream&                          os,
     const align::SinglePicker&             singlePicker,
     const align::SimilarityScores&         similarity,
@@ -221,6 +229,10 @@ void DualFastq2SamWorkflow::alignDualFastqBlock(
       options_.alignerMapqMinLen_,
       options_.alignerSampleMapq0_);
 
+  // per-fragment scratch memory for the alignments of this thread
+  common::Arena        arena;
+  common::Arena::Scope arenaScope(arena);
+
   // aligner is not stateless, make sure each thread uses its own.
   align::Aligner aligner(
       refSeq_,
@@ -236,25 +248,27 @@ void DualFastq2SamWorkflow::alignDualFastqBlock(
       options_.alignerMapqMinLen_,
       options_.alignerUnpairedPen_,
       options_.mapperFilterLenRatio_,
-      !options_.methodSmithWaterman_.compare("mengyao"));
+      !options_.methodSmithWaterman_.compare("mengyao"),
+      options_.mapperHotSeedCacheSize_,
+      options_.mapperHotSeedCacheMinBuckets_,
+      options_.mapperSparseSeeding_,
+      targetIndex_,
+      sam.getMethylationCaller());
 
-  std::vector<char> r1Block;
-  // arbitrary preallocation to avoid unnecessary copy/paste
-  r1Block.reserve(RECORDS_AT_A_TIME_ * 1024);
-  std::vector<char> r2Block;
-  r2Block.reserve(RECORDS_AT_A_TIME_ * 1024);
+  RecordBlock r1Block;
+  RecordBlock r2Block;
 
   // records in output format
   std::vector<char> tmpBuffer;
   tmpBuffer.reserve(RECORDS_AT_A_TIME_ * 1024);
-  boost::iostreams::filtering_ostream ostrm;
-  ostrm.push(boost::iostreams::back_insert_device<std::vector<char>>(tmpBuffer));
   // minimum data required for insert size calculation
-  std::vector<char> insBuffer;
-  insBuffer.reserve(RECORDS_AT_A_TIME_ * 1024);
+  std::vector<align::RecordSummary> summaries;
+  summaries.reserve(RECORDS_AT_A_TIME_ * 2);
 
-  ReadGroupAlignmentCounts& mappingMetricsLocal = mappingMetricsVector[threadID];
-  threadID++;
+  // added to mappingMetrics when the block is stored, to keep them in sync with the output
+  ReadGroupAlignmentCounts blockCounts(std::cerr);
+  bool                     insertSizesFixed = false;
+  std::string              insertStats;
 
   do {
     const int ourBlock = blockToStart_++;
@@ -290,13 +304,7 @@ void DualFastq2SamWorkflow::alignDualFastqBlock(
         align::InsertSizeParameters insertSizeParameters;
         {
           common::unlock_guard<common::ThreadPool::lock_type> unlock(lock);
-          boost::iostreams::filtering_istream                 inputR1;
-          inputR1.push(boost::iostreams::basic_array_source<char>{&r1Block.front(),
-                                                                  &r1Block.front() + r1Block.size()});
-          boost::iostreams::filtering_istream inputR2;
-          inputR2.push(boost::iostreams::basic_array_source<char>{&r2Block.front(),
-                                                                  &r2Block.front() + r2Block.size()});
-          insertSizeParameters = requestInsertSizeInfo(insertSizeDistribution, inputR1, inputR2);
+          insertSizeParameters = requestInsertSizeInfo(insertSizeDistribution, r1Block, r2Block);
         }
         assert(blockToGetInsertSizes_ == ourBlock);
         ++blockToGetInsertSizes_;
@@ -310,47 +318,46 @@ void DualFastq2SamWorkflow::alignDualFastqBlock(
         common::CPU_THREADS().notify_all();
         {
           common::unlock_guard<common::ThreadPool::lock_type> unlock(lock);
-          boost::iostreams::filtering_istream                 inputR1;
-          inputR1.push(boost::iostreams::basic_array_source<char>{&r1Block.front(),
-                                                                  &r1Block.front() + r1Block.size()});
-          boost::iostreams::filtering_istream inputR2;
-          inputR2.push(boost::iostreams::basic_array_source<char>{&r2Block.front(),
-                                                                  &r2Block.front() + r2Block.size()});
-          insBuffer.clear();
+          summaries.clear();
           tmpBuffer.clear();
 
           alignDualFastq(
               insertSizeParameters,
-              inputR1,
-              inputR2,
+              r1Block,
+              r2Block,
               aligner,
               singlePicker,
               pairBuilder,
               [&](const sequences::Read& r, const align::Alignment& a) {
-                sam.generateRecord(ostrm, r, a, options_.rgid_) << "\n";
-
-                const auto before = insBuffer.size();
-                insBuffer.resize(before + sequences::SerializedRead::getByteSize(r));
-                const auto before2 = insBuffer.size();
-                insBuffer.resize(before2 + align::SerializedAlignment::getByteSize(a));
-
-                // resize can invalidate references...
-                sequences::SerializedRead& sr =
-                    *reinterpret_cast<sequences::SerializedRead*>(&insBuffer.front() + before);
-                sr << r;
-
-                align::SerializedAlignment& sa =
-                    *reinterpret_cast<align::SerializedAlignment*>(&insBuffer.front() + before2);
-                sa << a;
-
-                mappingMetricsLocal.addRecord(sa, sr);
+                sam.appendRecord(tmpBuffer, r, a, readGroup_.readGroupId_);
+                summaries.emplace_back(a, r);
+                blockCounts.addRecord(a, r);
               });
-          ostrm.flush();
         }
 
         --cpuThreads;
         common::CPU_THREADS().notify_all();
 
+        // insert size statistics in block order, independently of the order of the output
+        while (blockToAddInsertSizes_ != ourBlock) {
+          common::CPU_THREADS().waitForChange(lock);
+        }
+        {
+          common::unlock_guard<common::ThreadPool::lock_type> unlock(lock);
+          for (const auto& summary : summaries) {
+            insertSizeDistribution.add(summary);
+          }
+          // the state of the estimator as of the end of the block, for the progress after storing it
+          insertSizesFixed = storedBlock_ && insertSizeDistribution.isFixed();
+          if (insertSizesFixed) {
+            std::ostringstream stats;
+            insertSizeDistribution.saveFixed(stats);
+            insertStats = stats.str();
+          }
+        }
+        ++blockToAddInsertSizes_;
+        common::CPU_THREADS().notify_all();
+
         if (options_.preserveMapAlignOrder_) {
           while (blockToStore_ != ourBlock) {
             common::CPU_THREADS().waitForChange(lock);
@@ -364,20 +371,19 @@ void DualFastq2SamWorkflow::alignDualFastqBlock(
 
         {
           common::unlock_guard<common::ThreadPool::lock_type> unlock(lock);
-          for (auto it = insBuffer.begin(); insBuffer.end() != it;) {
-            char*                            p     = &*it;
-            const sequences::SerializedRead* pRead = reinterpret_cast<const sequences::SerializedRead*>(p);
-            it += pRead->getByteSize();
-            p = &*it;
-            const align::SerializedAlignment* pAlignment =
-                reinterpret_cast<const align::SerializedAlignment*>(p);
-            it += pAlignment->getByteSize();
-            // sam.generateRecord(os, *pRead, *pAlignment, options_.rgid_) << "\n";
-            insertSizeDistribution.add(*pAlignment, *pRead);
-          }
           if (!os.write(&tmpBuffer.front(), tmpBuffer.size())) {
             throw std::logic_error(std::string("Error writing output stream. Error: ") + strerror(errno));
           }
+          mappingMetrics.add(blockCounts);
+          blockCounts.reset();
+          progress_.records_ += r1Records;
+          progress_.r1Offset_ += r1Block.end_ - r1Block.begin_;
+          progress_.r2Offset_ += r2Block.end_ - r2Block.begin_;
+          if (storedBlock_) {
+            progress_.insertSizesFixed_ = insertSizesFixed;
+            progress_.insertStats_      = insertStats;
+            storedBlock_(progress_);
+          }
         }
         assert(blockToStore_ == ourBlock);
         if (options_.preserveMapAlignOrder_) {
@@ -391,21 +397,26 @@ void DualFastq2SamWorkflow::alignDualFastqBlock(
     // else we're a thread that waited to read its block until it learned that there will be no more
     // input data. just quietly exit
   } while (!common::CPU_THREADS().checkThreadFailed() && !r1Eof_ && !r2Eof_);
+  hotSeedCacheStatistics_.add(aligner.getMapper().getHotSeedCacheStatistics());
+  sparseSeedingStatistics_.add(aligner.getSparseSeedingStatistics());
+  targetedMappingStatistics_.add(aligner.getTargetedMappingStatistics());
 }
 
-void DualFastq2SamWorkflow::parseDualFastq(
-    std::istream& r1Stream,
-    std::istream& r2Stream,
-    std::ostream& os,
-    std::ostream& insertSizeDistributionLogStream,
-    std::ostream& mappingMetricsLogStream)
+template <typename Reader>
+void DualFastq2SamWorkflow::alignDualFastq(
+    Reader&                   r1Reader,
+    Reader&                   r2Reader,
+    std::ostream&             os,
+    std::ostream&             insertSizeDistributionLogStream,
+    ReadGroupAlignmentCounts& mappingMetrics)
 {
-  std::chrono::system_clock::time_point timeStart = std::chrono::system_clock::now();
-
   std::cerr << "Running dual fastq workflow on " << options_.mapperNumThreads_ << " threads. System supports "
             << std::thread::hardware_concurrency() << " threads." << std::endl;
 
+  // restored statistics already have the log of their detection in the insert stats file
+  std::ostream                  resumedLog(nullptr);
   align::InsertSizeDistribution insertSizeDistribution(
+      readGroupIndex_,
       options_.samplingEnabled_,
       options_.alignerPeq25_,
       options_.alignerPeq50_,
@@ -425,13 +436,19 @@ void DualFastq2SamWorkflow::parseDualFastq(
       options_.alignerResqueCeilFactor_,
       options_.alignerResqueMinIns_,
       options_.alignerResqueMaxIns_,
-      insertSizeDistributionLogStream);
+      progress_.insertSizesFixed_ ? resumedLog : insertSizeDistributionLogStream);
+
+  if (progress_.insertSizesFixed_) {
+    std::istringstream is(progress_.insertStats_);
+    if (!insertSizeDistribution.restoreFixed(is)) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Invalid insert size statistics to resume read group " + readGroup_.readGroupId_ + ": " +
+          progress_.insertStats_));
+    }
+  }
 
   // idle threads needed to hold results that arrive out of order
-  const int                             poolThreadCount = options_.mapperNumThreads_ * 2;
-  ReadGroupAlignmentCounts              mappingMetricsGlobal(mappingMetricsLogStream);
-  std::vector<ReadGroupAlignmentCounts> mappingMetricsVector(
-      poolThreadCount, ReadGroupAlignmentCounts(mappingMetricsLogStream));
+  const int poolThreadCount = options_.mapperNumThreads_ * 2;
 
   const align::SimilarityScores similarity(options_.matchScore_, options_.mismatchScore_);
   align::SinglePicker           singlePicker(
@@ -445,13 +462,11 @@ void DualFastq2SamWorkflow::parseDualFastq(
       options_.alignerMapqMinLen_,
       options_.alignerSampleMapq0_);
 
-  fastq::FastqNRecordReader r1Reader(r1Stream);
-  fastq::FastqNRecordReader r2Reader(r2Stream);
-
-  const sam::SamGenerator sam(htConfig_);
+  const std::unique_ptr<align::MethylationCaller> methylationCaller(
+      options_.isMethylated() ? new align::MethylationCaller(htConfig_, refSeq_) : nullptr);
+  const sam::SamGenerator sam(htConfig_, methylationCaller.get());
 
   std::size_t cpuThreads = 0;
-  std::size_t threadID   = 0;
   blockToStore_          = options_.preserveMapAlignOrder_ ? 0 : -1;
   // let all threads do the job have twice the hardware to make sure there are threads to
   // align while others are stuck in the save queue by one that takes
@@ -462,8 +477,7 @@ void DualFastq2SamWorkflow::parseDualFastq(
             alignDualFastqBlock(
                 lock,
                 cpuThreads,
-                threadID,
-                mappingMetricsVector,
+                mappingMetrics,
                 insertSizeDistribution,
                 r1Reader,
                 r2Reader,
@@ -474,15 +488,26 @@ void DualFastq2SamWorkflow::parseDualFastq(
           },
           options_.mapperNumThreads_);
 
-  // aggregate and print mapping metrics
-  for (std::size_t ii = 0; ii < mappingMetricsVector.size(); ii++) {
-    mappingMetricsGlobal.add(mappingMetricsVector[ii]);
+  if (options_.mapperHotSeedCacheSize_) {
+    std::cerr << "Hot seed cache: " << hotSeedCacheStatistics_ << std::endl;
+  }
+  if (options_.mapperSparseSeeding_) {
+    std::cerr << "Sparse seeding: " << sparseSeedingStatistics_ << std::endl;
+  }
+  if (targetIndex_) {
+    std::cerr << "Targeted mapping: " << targetedMappingStatistics_ << std::endl;
   }
-
-  mappingMetricsGlobal.printStats(std::chrono::system_clock::now() - timeStart);
 
   insertSizeDistribution.forceInitDoneSending();
   std::cerr << insertSizeDistribution << std::endl;
+  // the statistics of the whole read group, for its other inputs
+  progress_.insertSizesFixed_ = insertSizeDistribution.isFixed();
+  progress_.insertStats_.clear();
+  if (progress_.insertSizesFixed_) {
+    std::ostringstream stats;
+    insertSizeDistribution.saveFixed(stats);
+    progress_.insertStats_ = stats.str();
+  }
 }
 
 }  // namespace workflow
@@ -174,7 +174,8 @@ void SetBuildHashTableOptions(
 
   // Override parameters which are set based on the hash table type
   // Note: a default value should have been specified above
-  if (hashTableType == HT_TYPE_METHYL_G_TO_A or hashTableType == HT_TYPE_METHYL_C_TO_T) {
+  if (hashTableType == HT_TYPE_METHYL_G_TO_A or hashTableType == HT_TYPE_METHYL_C_TO_T or
+      hashTableType == HT_TYPE_METHYL_COMBINED) {
     config->methylatedConv = hashTableType;
   }
   if (hashTableType == HT_TYPE_ANCHORED) {
@@ -286,18 +287,18 @@ void buildHashTable(const options::DragenOsOptions& opts)
 
   // Determine the type of hash table to generate
   std::vector<HashTableType> hashTableTypes;
-  //  if (opts->BuildMethylatedHashtables()) {
-  //    hashTableTypes.push_back(HT_TYPE_METHYL_G_TO_A);
-  //    hashTableTypes.push_back(HT_TYPE_METHYL_C_TO_T);
-  //    hashTableTypes.push_back(HT_TYPE_NORMAL);
-  //  } else {
-  hashTableTypes.push_back(HT_TYPE_NORMAL);
+  if (opts.htMethylated_) {
+    // a single table with the C->T and G->A converted copies of each contig, in the methyl_converted
+    // subdirectory of the output directory
+    hashTableTypes.push_back(HT_TYPE_METHYL_COMBINED);
+  } else {
+    hashTableTypes.push_back(HT_TYPE_NORMAL);
+  }
 
   // If the user specifies to build RNA tables
   //    if (opts->BuildRNAHashTable()) {
   //      hashTableTypes.push_back(HT_TYPE_ANCHORED);
   //    }
-  //  }
 
   for (auto it = hashTableTypes.begin(); it != hashTableTypes.end(); ++it) {
     hashTableConfig_t bhtConfig;
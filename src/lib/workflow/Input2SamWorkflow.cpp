@@ -16,30 +16,43 @@
 #include <cstring>
 #include <fstream>
 #include <limits>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
 
 #include "boost/iostreams/filter/gzip.hpp"
 
 #include <boost/filesystem.hpp>
-#include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 
 #include "align/Aligner.hpp"
+#include "align/MethylationCaller.hpp"
 #include "align/SinglePicker.hpp"
 #include "bam/BamBlockReader.hpp"
 #include "bam/Tokenizer.hpp"
+#include "common/AllocationCounter.hpp"
+#include "common/Arena.hpp"
 #include "common/Debug.hpp"
 #include "common/Threads.hpp"
 #include "fastq/FastqBlockReader.hpp"
+#include "fastq/FastqNRecordReader.hpp"
+#include "fastq/MappedFastqReader.hpp"
 #include "fastq/Tokenizer.hpp"
 #include "io/Bam2ReadTransformer.hpp"
 #include "io/Fastq2ReadTransformer.hpp"
+#include "io/PrefetchedInput.hpp"
 #include "mapping_stats.hpp"
 #include "options/DragenOsOptions.hpp"
+#include "options/FastqList.hpp"
 #include "reference/ReferenceDir.hpp"
+#include "reference/TargetIndex.hpp"
 #include "sam/SamGenerator.hpp"
 
+#include "workflow/Checkpoint.hpp"
 #include "workflow/DualFastq2SamWorkflow.hpp"
 #include "workflow/Input2SamWorkflow.hpp"
+#include "workflow/JobServer.hpp"
 
 #include "workflow/alignment/AlignmentUtils.hpp"
 
@@ -102,7 +115,7 @@ template <>
 io::FastqToReadTransformer makeReadTransformer<io::FastqToReadTransformer>(
     const options::DragenOsOptions& options)
 {
-  return io::FastqToReadTransformer(options.inputQnameSuffixDelim_, options.fastqOffset_);
+  return io::FastqToReadTransformer(options.inputQnameSuffixDelim_, options.fastqOffset_, options.isMethylated());
 }
 
 template <>
@@ -186,14 +199,16 @@ void parseSingleInput(
     std::istream&                       is,
     std::ostream&                       os,
     const options::DragenOsOptions&     options,
+    const options::FastqListEntry&      readGroup,
+    const uint16_t                      readGroupIndex,
     const reference::ReferenceSequence& refSeq,
     const reference::HashtableConfig&   htConfig,
     const reference::Hashtable&         hashtable,
-    std::ostream&                       mappingMetricsLogStream)
+    const reference::TargetIndex*       targetIndex,
+    ReadGroupAlignmentCounts&           mappingMetrics)
 {
-  std::chrono::system_clock::time_point timeStart = std::chrono::system_clock::now();
-
   align::InsertSizeDistribution insertSizeDistribution(
+      readGroupIndex,
       options.samplingEnabled_,
       options.alignerPeq25_,
       options.alignerPeq50_,
@@ -227,13 +242,14 @@ void parseSingleInput(
       options.alignerMapqMinLen_,
       options.alignerSampleMapq0_);
 
-  const sam::SamGenerator sam(htConfig);
+  const std::unique_ptr<align::MethylationCaller> methylationCaller(
+      options.isMethylated() ? new align::MethylationCaller(htConfig, refSeq) : nullptr);
+  const sam::SamGenerator sam(htConfig, methylationCaller.get());
 
   // idle threads needed to hold results that arrive out of order
-  const int                             poolThreadCount = options.mapperNumThreads_ * 2;
-  ReadGroupAlignmentCounts              mappingMetricsGlobal(mappingMetricsLogStream);
-  std::vector<ReadGroupAlignmentCounts> mappingMetricsVector(
-      poolThreadCount, ReadGroupAlignmentCounts(mappingMetricsLogStream));
+  const int poolThreadCount = options.mapperNumThreads_ * 2;
+  // only aggregated into mappingMetrics, never printed
+  std::vector<ReadGroupAlignmentCounts> mappingMetricsVector(poolThreadCount, ReadGroupAlignmentCounts(std::cerr));
 
   BlockReader reader = makeBlockReader<BlockReader>(is, options);
 
@@ -242,7 +258,12 @@ void parseSingleInput(
   int         blockToRead           = 0;
   int         blockToGetInsertSizes = 0;
   int         blockToAlign          = 0;
+  int         blockToAddInsertSizes = 0;
   int         blockToStore          = options.preserveMapAlignOrder_ ? 0 : -1;
+  // accumulated by the threads as they complete
+  map::HotSeedCache::Statistics             hotSeedCacheStatistics;
+  align::Aligner::SparseSeedingStatistics   sparseSeedingStatistics;
+  align::Aligner::TargetedMappingStatistics targetedMappingStatistics;
   // let all threads do the job have twice the hardware to make sure there are threads to
   // align while others are stuck in the save queue by one that takes
   // unexpectedly long time
@@ -261,6 +282,10 @@ void parseSingleInput(
                 options.alignerMapqMinLen_,
                 options.alignerSampleMapq0_);
 
+            // per-fragment scratch memory for the alignments of this thread
+            common::Arena        arena;
+            common::Arena::Scope arenaScope(arena);
+
             align::Aligner aligner(
                 refSeq,
                 htConfig,
@@ -275,19 +300,23 @@ void parseSingleInput(
                 options.alignerMapqMinLen_,
                 options.alignerUnpairedPen_,
                 options.mapperFilterLenRatio_,
-                !options.methodSmithWaterman_.compare("mengyao"));
+                !options.methodSmithWaterman_.compare("mengyao"),
+                options.mapperHotSeedCacheSize_,
+                options.mapperHotSeedCacheMinBuckets_,
+                options.mapperSparseSeeding_,
+                targetIndex,
+                methylationCaller.get());
 
             static const std::size_t BUFFER_SIZE = 1024 * 256;
 
             // records in output format
             std::vector<char> tmpBuffer;
             tmpBuffer.reserve(BUFFER_SIZE * 2);
-            boost::iostreams::filtering_ostream ostrm;
-            ostrm.push(boost::iostreams::back_insert_device<std::vector<char>>(tmpBuffer));
 
             //    char              inBuffer[BUFFER_SIZE];
             std::vector<char> inBuffer(BUFFER_SIZE);
-            std::vector<char> outBuffer;
+            // what the insert size statistics need from each record in tmpBuffer
+            std::vector<align::RecordSummary> summaries;
 
             //    auto                      lock                = common::CPU_THREADS().lock();
             ReadGroupAlignmentCounts& mappingMetricsLocal = mappingMetricsVector[threadID];
@@ -330,7 +359,7 @@ void parseSingleInput(
                 //    std::cerr << "read n:" << n << " end: " << std::string(buffer, buffer + n) << std::endl;
                 boost::iostreams::filtering_istream istrm;
                 istrm.push(boost::iostreams::basic_array_source<char>{&inBuffer[0], &inBuffer[0] + n});
-                outBuffer.clear();
+                summaries.clear();
                 tmpBuffer.clear();
 
                 alignSingleInput<ReadTransformer, Tokenizer>(
@@ -341,30 +370,28 @@ void parseSingleInput(
                     singlePicker,
                     pairBuilder,
                     [&](const sequences::Read& r, const align::Alignment& a) {
-                      sam.generateRecord(ostrm, r, a, options.rgid_) << "\n";
-
-                      const auto before = outBuffer.size();
-                      outBuffer.resize(before + sequences::SerializedRead::getByteSize(r));
-                      const auto before2 = outBuffer.size();
-                      outBuffer.resize(before2 + align::SerializedAlignment::getByteSize(a));
-
-                      // resize can invalidate references...
-                      sequences::SerializedRead& sr =
-                          *reinterpret_cast<sequences::SerializedRead*>(&outBuffer.front() + before);
-                      sr << r;
-
-                      align::SerializedAlignment& sa =
-                          *reinterpret_cast<align::SerializedAlignment*>(&outBuffer.front() + before2);
-                      sa << a;
-
-                      mappingMetricsLocal.addRecord(sa, sr);
+                      sam.appendRecord(tmpBuffer, r, a, readGroup.readGroupId_);
+                      summaries.emplace_back(a, r);
+                      mappingMetricsLocal.addRecord(a, r);
                     });
-                ostrm.flush();
               }
 
               --cpuThreads;
               common::CPU_THREADS().notify_all();
 
+              // insert size statistics in block order, independently of the order of the output
+              while (blockToAddInsertSizes != ourBlock) {
+                common::CPU_THREADS().waitForChange(lock);
+              }
+              {
+                common::unlock_guard<common::ThreadPool::lock_type> unlock(lock);
+                for (const auto& summary : summaries) {
+                  insertSizeDistribution.add(summary);
+                }
+              }
+              ++blockToAddInsertSizes;
+              common::CPU_THREADS().notify_all();
+
               if (options.preserveMapAlignOrder_) {
                 while (blockToStore != ourBlock) {
                   common::CPU_THREADS().waitForChange(lock);
@@ -378,18 +405,6 @@ void parseSingleInput(
 
               {
                 common::unlock_guard<common::ThreadPool::lock_type> unlock(lock);
-                for (auto it = outBuffer.begin(); outBuffer.end() != it;) {
-                  char*                            p = &*it;
-                  const sequences::SerializedRead* pRead =
-                      reinterpret_cast<const sequences::SerializedRead*>(p);
-                  it += pRead->getByteSize();
-                  p = &*it;
-                  const align::SerializedAlignment* pAlignment =
-                      reinterpret_cast<const align::SerializedAlignment*>(p);
-                  it += pAlignment->getByteSize();
-                  // sam.generateRecord(os, *pRead, *pAlignment, options.rgid_) << "\n";
-                  insertSizeDistribution.add(*pAlignment, *pRead);
-                }
                 if (!os.write(&tmpBuffer.front(), tmpBuffer.size())) {
                   throw std::logic_error(
                       std::string("Error writing output stream. Error: ") + strerror(errno));
@@ -404,15 +419,26 @@ void parseSingleInput(
               }
               common::CPU_THREADS().notify_all();
             }
+            hotSeedCacheStatistics.add(aligner.getMapper().getHotSeedCacheStatistics());
+            sparseSeedingStatistics.add(aligner.getSparseSeedingStatistics());
+            targetedMappingStatistics.add(aligner.getTargetedMappingStatistics());
           },
           options.mapperNumThreads_);
 
-  // aggregate and print mapping metrics
+  // aggregate mapping metrics
   for (std::size_t ii = 0; ii < mappingMetricsVector.size(); ii++) {
-    mappingMetricsGlobal.add(mappingMetricsVector[ii]);
+    mappingMetrics.add(mappingMetricsVector[ii]);
   }
 
-  mappingMetricsGlobal.printStats(std::chrono::system_clock::now() - timeStart);
+  if (options.mapperHotSeedCacheSize_) {
+    std::cerr << "Hot seed cache: " << hotSeedCacheStatistics << std::endl;
+  }
+  if (options.mapperSparseSeeding_) {
+    std::cerr << "Sparse seeding: " << sparseSeedingStatistics << std::endl;
+  }
+  if (targetIndex) {
+    std::cerr << "Targeted mapping: " << targetedMappingStatistics << std::endl;
+  }
 
   insertSizeDistribution.forceInitDoneSending();
   if (options.interleaved_) {
@@ -431,31 +457,31 @@ bool isGzip(const std::string& fileName)
 }
 
 void parseSingleInput(
+    std::istream&                       input,
     std::ostream&                       os,
     const options::DragenOsOptions&     options,
+    const options::FastqListEntry&      readGroup,
+    const uint16_t                      readGroupIndex,
     const reference::ReferenceSequence& refSeq,
     const reference::HashtableConfig&   htConfig,
     const reference::Hashtable&         hashtable,
-    std::ostream&                       mappingMetricsLogStream)
+    const reference::TargetIndex*       targetIndex,
+    ReadGroupAlignmentCounts&           mappingMetrics)
 {
   std::cerr << "Running fastq workflow on " << options.mapperNumThreads_ << " threads. System supports "
             << std::thread::hardware_concurrency() << " threads." << std::endl;
 
-  std::ifstream                       file(options.inputFile1_, std::ios_base::in | std::ios_base::binary);
-  boost::iostreams::filtering_istream input;
-  if (isGzip(options.inputFile1_) || isBam(options.inputFile1_)) {
-    input.push(boost::iostreams::gzip_decompressor());
-  }
-
-  input.push(file);
-  input.exceptions(std::ios_base::badbit);
   try {
-    if (isBam(options.inputFile1_)) {
+    if (isBam(readGroup.read1File_)) {
+      if (options.isMethylated()) {
+        BOOST_THROW_EXCEPTION(
+            common::InvalidOptionException("ERROR: methylation-protocol requires FASTQ input files"));
+      }
       parseSingleInput<io::BamToReadTransformer, bam::Tokenizer, bam::BamBlockReader>(
-          input, os, options, refSeq, htConfig, hashtable, mappingMetricsLogStream);
+          input, os, options, readGroup, readGroupIndex, refSeq, htConfig, hashtable, targetIndex, mappingMetrics);
     } else {
       parseSingleInput<io::FastqToReadTransformer, fastq::Tokenizer, fastq::FastqBlockReader>(
-          input, os, options, refSeq, htConfig, hashtable, mappingMetricsLogStream);
+          input, os, options, readGroup, readGroupIndex, refSeq, htConfig, hashtable, targetIndex, mappingMetrics);
     }
   } catch (boost::iostreams::gzip_error& e) {
     BOOST_THROW_EXCEPTION(std::runtime_error(
@@ -466,6 +492,459 @@ void parseSingleInput(
   }
 }
 
+/// true for the paired-end reads in uncompressed FASTQ files that can be memory mapped
+bool isMappable(const options::FastqListEntry& readGroup)
+{
+  namespace bfs = boost::filesystem;
+  return !readGroup.read2File_.empty() && !isBam(readGroup.read1File_) && !isGzip(readGroup.read1File_) &&
+         !isGzip(readGroup.read2File_) && bfs::is_regular_file(readGroup.read1File_) &&
+         bfs::is_regular_file(readGroup.read2File_);
+}
+
+/**
+ ** \brief inputs of a read group, read and decompressed in the background from construction, or memory
+ **        mapped with mmap-fastq when possible
+ **/
+struct ReadGroupInputs {
+  ReadGroupInputs(const options::FastqListEntry& readGroup, const bool mmapFastq)
+  {
+    if (mmapFastq && isMappable(readGroup)) {
+      mapped1_.reset(new fastq::MappedFastqReader(readGroup.read1File_));
+      mapped2_.reset(new fastq::MappedFastqReader(readGroup.read2File_));
+    } else {
+      read1_.reset(new io::PrefetchedInput(
+          readGroup.read1File_, isGzip(readGroup.read1File_) || isBam(readGroup.read1File_)));
+      if (!readGroup.read2File_.empty()) {
+        read2_.reset(new io::PrefetchedInput(readGroup.read2File_, isGzip(readGroup.read2File_)));
+      }
+    }
+  }
+  std::unique_ptr<io::PrefetchedInput>      read1_;
+  std::unique_ptr<io::PrefetchedInput>      read2_;
+  std::unique_ptr<fastq::MappedFastqReader> mapped1_;
+  std::unique_ptr<fastq::MappedFastqReader> mapped2_;
+};
+
+/// creates the output file, failing with an explicit message
+void openOutputFile(
+    std::ofstream& os, const boost::filesystem::path& path, const std::string& description, const bool verbose)
+{
+  os.open(path.c_str());
+  if (!os) {
+    BOOST_THROW_EXCEPTION(common::IoException(
+        errno, std::string("Failed to create ") + description + ": " + path.string() + ": " + strerror(errno)));
+  }
+  if (verbose) {
+    std::cerr << "INFO: writing " << description << " to " << path << std::endl;
+  }
+}
+
+/// reopens an output file of an interrupted run, truncated to the size it had at the checkpoint
+void reopenOutputFile(
+    std::ofstream&                 os,
+    const boost::filesystem::path& path,
+    const uint64_t                 size,
+    const std::string&             description,
+    const bool                     verbose)
+{
+  namespace bfs = boost::filesystem;
+  if (!bfs::exists(path) || bfs::file_size(path) < size) {
+    BOOST_THROW_EXCEPTION(common::IoException(
+        ENOENT, std::string("Cannot resume: ") + description + " shorter than the checkpoint: " + path.string()));
+  }
+  bfs::resize_file(path, size);
+  os.open(path.c_str(), std::ios_base::in | std::ios_base::out);
+  if (!os || !os.seekp(0, std::ios_base::end)) {
+    BOOST_THROW_EXCEPTION(common::IoException(
+        errno, std::string("Failed to reopen ") + description + ": " + path.string() + ": " + strerror(errno)));
+  }
+  if (verbose) {
+    std::cerr << "INFO: appending " << description << " to " << path << " from offset " << size << std::endl;
+  }
+}
+
+/// moves the inputs of the read group past the records already aligned before the checkpoint
+void skipAlignedInputs(ReadGroupInputs& inputs, const Checkpoint& checkpoint)
+{
+  bool skipped = false;
+  if (inputs.mapped1_) {
+    skipped = inputs.mapped1_->skip(checkpoint.r1Offset_) && inputs.mapped2_->skip(checkpoint.r2Offset_);
+  } else if (inputs.read2_) {
+    skipped = fastq::FastqNRecordReader::skip(*inputs.read1_, checkpoint.r1Offset_) &&
+              fastq::FastqNRecordReader::skip(*inputs.read2_, checkpoint.r2Offset_);
+  }
+  if (!skipped) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+        "Cannot resume: the inputs of read group " + checkpoint.readGroupId_ + " are shorter than the checkpoint"));
+  }
+}
+
+/**
+ ** \brief aligns the given read groups of the FASTQ list, one after the other, into a single set of output
+ **        files named after outputFilePrefix. The insert size statistics are detected on the first line of
+ **        the list of each read group, and apply to its other lines. They are logged once, under the position
+ **        of the read group in the @RG lines of the output.
+ **
+ ** With checkpoint-interval or resume, the progress is saved into <outputFilePrefix>.checkpoint, at the
+ ** requested interval within the paired-end read groups, and after each read group. With resume, the
+ ** alignment continues from the checkpoint, if any.
+ **/
+void alignReadGroups(
+    const options::DragenOsOptions&             options,
+    const std::vector<options::FastqListEntry>& fastqList,
+    const std::vector<std::size_t>&             readGroupIndexes,
+    const std::string&                          outputFilePrefix,
+    const reference::ReferenceDir7&             referenceDir,
+    const reference::Hashtable&                 hashtable,
+    const reference::TargetIndex*               targetIndex)
+{
+  const auto timeStart = std::chrono::system_clock::now();
+
+  namespace bfs = boost::filesystem;
+  const bfs::path outputDirectory(options.outputDirectory_);
+  if (!outputDirectory.empty() && !exists(outputDirectory)) {
+    BOOST_THROW_EXCEPTION(common::IoException(
+        ENOENT, std::string("Output directory does not exist: ") + options.outputDirectory_));
+  }
+
+  const bool      checkpoints    = !outputDirectory.empty() && (options.checkpointInterval_ || options.resume_);
+  const bfs::path checkpointPath = outputDirectory / (outputFilePrefix + ".checkpoint");
+  Checkpoint      checkpoint;
+  const bool      resume = checkpoints && options.resume_ && loadCheckpoint(checkpointPath, checkpoint);
+  if (resume && checkpoint.complete_) {
+    std::cerr << "INFO: nothing to resume, " << outputFilePrefix << " is complete according to " << checkpointPath
+              << std::endl;
+    return;
+  }
+  if (resume && ((readGroupIndexes.size() <= checkpoint.readGroup_) ||
+                 (fastqList.at(readGroupIndexes[checkpoint.readGroup_]).readGroupId_ != checkpoint.readGroupId_))) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+        "Cannot resume: the read groups of the inputs do not match the checkpoint " + checkpointPath.string()));
+  }
+  if (options.resume_ && !resume) {
+    std::cerr << "INFO: no checkpoint to resume " << outputFilePrefix << ", starting from the beginning" << std::endl;
+  }
+
+  std::ofstream os;
+  if (resume) {
+    reopenOutputFile(
+        os, outputDirectory / (outputFilePrefix + ".sam"), checkpoint.samOffset_, "SAM file", options.verbose_);
+  } else if (!outputDirectory.empty()) {
+    openOutputFile(os, outputDirectory / (outputFilePrefix + ".sam"), "SAM file", options.verbose_);
+  }
+  std::ostream& samFile = os.is_open() ? os : std::cout;
+
+  // one @RG line for all the lanes of a read group, with its position in the RG column of the insert stats
+  const std::vector<std::size_t> readGroupPositions = options::getReadGroupPositions(fastqList, readGroupIndexes);
+  std::vector<sam::SamGenerator::ReadGroup> readGroups;
+  for (std::size_t i = 0; readGroupIndexes.size() > i; ++i) {
+    const auto& entry = fastqList.at(readGroupIndexes[i]);
+    if (readGroups.size() == readGroupPositions[i]) {
+      readGroups.push_back({entry.readGroupId_, entry.readGroupSample_, entry.readGroupLibrary_});
+    }
+  }
+  if (!resume) {
+    sam::SamGenerator::generateHeader(
+        samFile, referenceDir.getHashtableConfig(), options.getCommandLine(), readGroups, options.isMethylated());
+  }
+
+  std::ofstream mappingMetricsLogStream;
+  std::ofstream insertSizeDistributionLogStream;
+  if (!outputDirectory.empty()) {
+    openOutputFile(
+        mappingMetricsLogStream,
+        outputDirectory / (outputFilePrefix + ".mapping_metrics.csv"),
+        "mapping metrics file",
+        options.verbose_);
+    if (std::any_of(readGroupIndexes.begin(), readGroupIndexes.end(), [&fastqList](const std::size_t index) {
+          return !fastqList.at(index).read2File_.empty();
+        })) {
+      if (resume) {
+        reopenOutputFile(
+            insertSizeDistributionLogStream,
+            outputDirectory / (outputFilePrefix + ".insert-stats.tab"),
+            checkpoint.insertStatsOffset_,
+            "insert-stats file",
+            options.verbose_);
+      } else {
+        openOutputFile(
+            insertSizeDistributionLogStream,
+            outputDirectory / (outputFilePrefix + ".insert-stats.tab"),
+            "insert-stats file",
+            options.verbose_);
+        insertSizeDistributionLogStream
+            << "RG\tID\tQ25\tQ50\tQ75\tMEAN\tSTD\tMIN-INS\tMAX-INS\tRESCUE-MIN-INS\tRESCUE-MAX-INS\tNPAIRS\tINTSIZE\tSTALLS\tDELAY"
+            << std::endl;
+      }
+    }
+  }
+  // all the read groups of the output are summarized together
+  ReadGroupAlignmentCounts mappingMetrics(
+      mappingMetricsLogStream.is_open() ? mappingMetricsLogStream : std::cerr);
+  if (resume) {
+    std::istringstream is(checkpoint.mappingMetrics_);
+    if (!mappingMetrics.load(is)) {
+      BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+          "Cannot resume: invalid mapping metrics in the checkpoint " + checkpointPath.string()));
+    }
+  }
+
+  // fixed insert size statistics of the read groups, by position of their @RG line
+  std::map<std::size_t, std::string> readGroupInsertStats;
+  if (resume) {
+    readGroupInsertStats = checkpoint.readGroupInsertStats_;
+  }
+
+  // saves the progress of the read group at the given position, with the output files flushed up to it
+  auto lastCheckpoint = std::chrono::steady_clock::now();
+  const auto saveProgress =
+      [&](const std::size_t position, const DualFastq2SamWorkflow::Progress& progress, const bool complete) {
+        if (!samFile.flush() ||
+            (insertSizeDistributionLogStream.is_open() && !insertSizeDistributionLogStream.flush())) {
+          BOOST_THROW_EXCEPTION(
+              common::IoException(errno, std::string("Failed to flush the output files: ") + strerror(errno)));
+        }
+        Checkpoint current;
+        current.complete_  = complete;
+        current.readGroup_ = position;
+        if (readGroupIndexes.size() > position) {
+          current.readGroupId_ = fastqList.at(readGroupIndexes[position]).readGroupId_;
+        }
+        current.records_           = progress.records_;
+        current.r1Offset_          = progress.r1Offset_;
+        current.r2Offset_          = progress.r2Offset_;
+        current.samOffset_         = os.tellp();
+        current.insertStatsOffset_ =
+            insertSizeDistributionLogStream.is_open() ? uint64_t(insertSizeDistributionLogStream.tellp()) : 0;
+        current.insertStats_          = progress.insertStats_;
+        current.readGroupInsertStats_ = readGroupInsertStats;
+        std::ostringstream metrics;
+        mappingMetrics.save(metrics);
+        current.mappingMetrics_ = metrics.str();
+        saveCheckpoint(current, checkpointPath);
+        lastCheckpoint = std::chrono::steady_clock::now();
+      };
+
+#ifdef DRAGEN_OS_COUNT_ALLOCATIONS
+  const std::size_t allocationCount = common::getAllocationCount();
+  const std::size_t allocationBytes = common::getAllocationBytes();
+#endif  // #ifdef DRAGEN_OS_COUNT_ALLOCATIONS
+  // the read groups are aligned one after the other, with the inputs of the next one read in the background
+  const std::size_t                first = resume ? checkpoint.readGroup_ : 0;
+  std::unique_ptr<ReadGroupInputs> nextInputs(
+      new ReadGroupInputs(fastqList.at(readGroupIndexes[first]), options.mmapFastq_));
+  for (std::size_t i = first; readGroupIndexes.size() > i; ++i) {
+    const auto&                            readGroup = fastqList.at(readGroupIndexes[i]);
+    const std::unique_ptr<ReadGroupInputs> inputs(std::move(nextInputs));
+    if (readGroupIndexes.size() > i + 1) {
+      nextInputs.reset(new ReadGroupInputs(fastqList.at(readGroupIndexes[i + 1]), options.mmapFastq_));
+    }
+    if (1 < fastqList.size()) {
+      std::cerr << "INFO: aligning read group " << readGroup.readGroupId_ << " of sample "
+                << readGroup.readGroupSample_ << ", lane " << readGroup.lane_ << std::endl;
+    }
+    if (readGroup.read2File_.empty()) {
+      parseSingleInput(
+          *inputs->read1_,
+          samFile,
+          options,
+          readGroup,
+          readGroupPositions[i],
+          referenceDir.getReferenceSequence(),
+          referenceDir.getHashtableConfig(),
+          hashtable,
+          targetIndex,
+          mappingMetrics);
+    } else {
+      DualFastq2SamWorkflow workflow(
+          options,
+          readGroup,
+          readGroupPositions[i],
+          referenceDir.getReferenceSequence(),
+          referenceDir.getHashtableConfig(),
+          hashtable,
+          targetIndex);
+      if (resume && (first == i) && checkpoint.records_) {
+        skipAlignedInputs(*inputs, checkpoint);
+        DualFastq2SamWorkflow::Progress progress;
+        progress.records_          = checkpoint.records_;
+        progress.r1Offset_         = checkpoint.r1Offset_;
+        progress.r2Offset_         = checkpoint.r2Offset_;
+        progress.insertSizesFixed_ = true;
+        progress.insertStats_      = checkpoint.insertStats_;
+        workflow.resume(progress);
+        std::cerr << "INFO: resuming read group " << readGroup.readGroupId_ << " after " << checkpoint.records_
+                  << " records" << std::endl;
+      } else if (readGroupInsertStats.count(readGroupPositions[i])) {
+        DualFastq2SamWorkflow::Progress progress;
+        progress.insertSizesFixed_ = true;
+        progress.insertStats_      = readGroupInsertStats.at(readGroupPositions[i]);
+        workflow.resume(progress);
+      }
+      if (checkpoints && options.checkpointInterval_) {
+        const std::chrono::seconds interval(options.checkpointInterval_);
+        workflow.setStoredBlockCallback([&](const DualFastq2SamWorkflow::Progress& progress) {
+          // the progress can't be resumed while the insert size statistics are still being detected
+          if (progress.insertSizesFixed_ && (std::chrono::steady_clock::now() - lastCheckpoint >= interval)) {
+            saveProgress(i, progress, false);
+          }
+        });
+      }
+      std::ostream& insertSizeDistributionLog =
+          insertSizeDistributionLogStream.is_open() ? insertSizeDistributionLogStream : std::cerr;
+      if (inputs->mapped1_) {
+        workflow.parseDualFastq(
+            *inputs->mapped1_, *inputs->mapped2_, samFile, insertSizeDistributionLog, mappingMetrics);
+      } else {
+        workflow.parseDualFastq(
+            *inputs->read1_, *inputs->read2_, samFile, insertSizeDistributionLog, mappingMetrics);
+      }
+      if (workflow.getProgress().insertSizesFixed_) {
+        readGroupInsertStats.emplace(readGroupPositions[i], workflow.getProgress().insertStats_);
+      }
+    }
+    if (checkpoints) {
+      saveProgress(i + 1, DualFastq2SamWorkflow::Progress(), false);
+    }
+  }
+#ifdef DRAGEN_OS_COUNT_ALLOCATIONS
+  DRAGEN_OS_THREAD_CERR << "Heap allocations: " << common::getAllocationCount() - allocationCount << " ("
+                        << common::getAllocationBytes() - allocationBytes << " bytes) while mapping, "
+                        << common::getAllocationCount() << " in total" << std::endl;
+#endif  // #ifdef DRAGEN_OS_COUNT_ALLOCATIONS
+  mappingMetrics.printStats(std::chrono::system_clock::now() - timeStart);
+  if (checkpoints) {
+    saveProgress(readGroupIndexes.size(), DualFastq2SamWorkflow::Progress(), true);
+  }
+}
+
+std::unique_ptr<reference::TargetIndex> loadTargetIndex(
+    const options::DragenOsOptions& options, const reference::ReferenceDir7& referenceDir)
+{
+  if (options.mapperTargetBed_.empty()) {
+    return nullptr;
+  }
+  std::ifstream bed(options.mapperTargetBed_);
+  if (!bed) {
+    BOOST_THROW_EXCEPTION(common::IoException(
+        errno, std::string("Failed to open target BED file: ") + options.mapperTargetBed_ + ": " + strerror(errno)));
+  }
+  const reference::HashtableConfig&       config = referenceDir.getHashtableConfig();
+  std::unique_ptr<reference::TargetIndex> targetIndex(new reference::TargetIndex(
+      reference::TargetIndex::parseBed(bed, config, options.mapperTargetPadding_),
+      referenceDir.getReferenceSequence(),
+      std::min(config.getPrimarySeedBases(), reference::TargetIndex::MAX_KMER_LENGTH)));
+  std::cerr << "INFO: target index of " << targetIndex->getRegions().size() << " regions, "
+            << targetIndex->getTargetLength() << " bases, " << targetIndex->getKmerCount() << " "
+            << targetIndex->getKmerLength() << "-mers, " << targetIndex->getMemoryBytes() / (1024 * 1024) << " MB"
+            << std::endl;
+  return targetIndex;
+}
+
+/**
+ ** \brief aligns the input of the options with the reference and hashtable already loaded
+ **
+ ** The read groups of a FASTQ list go to one set of output files per sample, named after the output prefix
+ ** and the sample, or all to the files of the output prefix with fastq-list-all-samples.
+ **/
+void alignInput(
+    const options::DragenOsOptions& options,
+    const reference::ReferenceDir7& referenceDir,
+    const reference::Hashtable&     hashtable)
+{
+  const std::unique_ptr<reference::TargetIndex> targetIndex = loadTargetIndex(options, referenceDir);
+  if (options.fastqList_.empty()) {
+    const std::vector<options::FastqListEntry> lanes =
+        options::makeLaneList(options.rgid_, options.rgsm_, options.inputFiles1_, options.inputFiles2_);
+    std::vector<std::size_t> readGroupIndexes(lanes.size());
+    std::iota(readGroupIndexes.begin(), readGroupIndexes.end(), 0);
+    alignReadGroups(
+        options, lanes, readGroupIndexes, options.outputFilePrefix_, referenceDir, hashtable, targetIndex.get());
+    return;
+  }
+
+  const std::vector<options::FastqListEntry> fastqList = options::loadFastqList(options.fastqList_);
+  if (std::numeric_limits<uint16_t>::max() < fastqList.size()) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException("ERROR: too many read groups in the FASTQ list"));
+  }
+  // samples in the order of their first read group in the list
+  std::vector<std::pair<std::string, std::vector<std::size_t>>> samples;
+  for (std::size_t index = 0; fastqList.size() > index; ++index) {
+    const std::string sample = options.fastqListAllSamples_ ? "" : fastqList[index].readGroupSample_;
+    auto              found  = std::find_if(samples.begin(), samples.end(), [&sample](const auto& s) {
+      return sample == s.first;
+    });
+    if (samples.end() == found) {
+      found = samples.emplace(samples.end(), sample, std::vector<std::size_t>());
+    }
+    found->second.push_back(index);
+  }
+  for (const auto& sample : samples) {
+    const std::string outputFilePrefix =
+        (sample.first.empty() || options.outputFilePrefix_.empty())
+            ? options.outputFilePrefix_ + sample.first
+            : options.outputFilePrefix_ + "." + sample.first;
+    alignReadGroups(
+        options, fastqList, sample.second, outputFilePrefix, referenceDir, hashtable, targetIndex.get());
+  }
+}
+
+/**
+ ** \brief runs a job submitted to the server, with the paths of its command line relative to its working
+ **        directory. The SAM, mapping metrics and insert stats files go to the output directory of the job.
+ **/
+void runJob(
+    const options::DragenOsOptions& serverOptions,
+    const reference::ReferenceDir7& referenceDir,
+    const reference::Hashtable&     hashtable,
+    const std::string&              workingDirectory,
+    const std::vector<std::string>& arguments)
+{
+  // the options keep pointers to the arguments
+  std::vector<const char*> argv;
+  for (const auto& argument : arguments) {
+    argv.push_back(argument.c_str());
+  }
+  options::DragenOsOptions options;
+  if (options::DragenOsOptions::RUN != options.parse(int(argv.size()), argv.data())) {
+    BOOST_THROW_EXCEPTION(common::InvalidOptionException("ERROR: invalid job command line"));
+  }
+  if (options.buildHashTable_ || options.htUncompress_ || !options.daemonSocket_.empty()) {
+    BOOST_THROW_EXCEPTION(common::InvalidOptionException("ERROR: only alignment jobs can be submitted"));
+  }
+  if (options.outputDirectory_.empty()) {
+    BOOST_THROW_EXCEPTION(common::InvalidOptionException("ERROR: jobs require an output directory"));
+  }
+
+  namespace bfs = boost::filesystem;
+  const bfs::path directory(workingDirectory);
+  for (std::string* path : {&options.fastqList_, &options.outputDirectory_, &options.mapperTargetBed_}) {
+    if (!path->empty()) {
+      *path = bfs::absolute(*path, directory).string();
+    }
+  }
+  for (std::vector<std::string>* paths : {&options.inputFiles1_, &options.inputFiles2_}) {
+    for (auto& path : *paths) {
+      path = bfs::absolute(path, directory).string();
+    }
+  }
+  boost::system::error_code error;
+  if (!bfs::equivalent(bfs::absolute(options.refDir_, directory), serverOptions.refDir_, error)) {
+    BOOST_THROW_EXCEPTION(common::InvalidOptionException(
+        "ERROR: the job reference directory is not the one loaded by the server: " +
+        serverOptions.refDir_.string()));
+  }
+
+  // the thread pool is sized once for the lifetime of the server
+  if (options.mapperNumThreads_ != serverOptions.mapperNumThreads_) {
+    std::cerr << "WARNING: running the job on the " << serverOptions.mapperNumThreads_
+              << " threads of the server instead of " << options.mapperNumThreads_ << std::endl;
+    options.mapperNumThreads_ = serverOptions.mapperNumThreads_;
+  }
+
+  alignInput(options, referenceDir, hashtable);
+}
+
 void input2Sam(const dragenos::options::DragenOsOptions& options)
 {
   if (options.buildHashTable_ || options.htUncompress_) {
@@ -475,8 +954,30 @@ void input2Sam(const dragenos::options::DragenOsOptions& options)
   DRAGEN_OS_THREAD_CERR << "Version: " << common::Version::string() << std::endl;
   DRAGEN_OS_THREAD_CERR << "argc: " << options.argc() << " argv: " << options.getCommandLine() << std::endl;
 
+  if (!options.submitSocket_.empty()) {
+    if (options.daemonShutdown_) {
+      shutdownServer(options.submitSocket_, std::cerr);
+    } else {
+      submitJob(
+          options.submitSocket_,
+          std::vector<std::string>(options.argv(), options.argv() + options.argc()),
+          std::cerr);
+    }
+    return;
+  }
+
   const reference::ReferenceDir7 referenceDir(
-      options.refDir_, options.mmapReference_, options.loadReference_);
+      options.refDir_,
+      options.mmapReference_,
+      options.loadReference_,
+      options.packReference_,
+      options.htCacheDirectory_);
+  // page in the mapped data for the whole run, in the background once the requested fraction is reached
+  std::unique_ptr<reference::PageWarmup> warmup;
+  if (options.refWarmupThreads_ && !referenceDir.getMappedRanges().empty()) {
+    warmup.reset(new reference::PageWarmup(referenceDir.getMappedRanges(), options.refWarmupThreads_));
+    warmup->wait(options.refWarmupFraction_, std::cerr);
+  }
 
   /**
    ** \brief memory mapped hashtable data
@@ -493,91 +994,15 @@ void input2Sam(const dragenos::options::DragenOsOptions& options)
   const reference::Hashtable hashtable(
       &referenceDir.getHashtableConfig(), referenceDir.getHashtableData(), referenceDir.getExtendTableData());
 
-  std::ofstream os;
-  namespace bfs = boost::filesystem;
-  if (!options.outputDirectory_.empty()) {
-    if (!exists(bfs::path(options.outputDirectory_))) {
-      BOOST_THROW_EXCEPTION(common::IoException(
-          ENOENT, std::string("Output directory does not exist: ") + options.outputDirectory_));
-    }
-    const auto filePath = bfs::path(options.outputDirectory_) / (options.outputFilePrefix_ + ".sam");
-    os.open(filePath.c_str());
-    if (!os) {
-      BOOST_THROW_EXCEPTION(common::IoException(
-          errno, std::string("Failed to create SAM file: ") + filePath.string() + ": " + strerror(errno)));
-    }
-    if (options.verbose_) {
-      std::cerr << "INFO: writing SAM file to " << filePath << std::endl;
-    }
-  }
-  std::ostream& samFile = os.is_open() ? os : std::cout;
-  sam::SamGenerator::generateHeader(
-      samFile, referenceDir.getHashtableConfig(), options.getCommandLine(), options.rgid_, options.rgsm_);
-
-  std::ofstream mappingMetricsLogStream;
-
-  if (!options.outputDirectory_.empty()) {
-    namespace bfs = boost::filesystem;
-    if (!exists(bfs::path(options.outputDirectory_))) {
-      BOOST_THROW_EXCEPTION(common::IoException(
-          ENOENT, std::string("Output directory does not exist: ") + options.outputDirectory_));
-    }
-
-    const auto filePathMetrics =
-        bfs::path(options.outputDirectory_) / (options.outputFilePrefix_ + ".mapping_metrics.csv");
-    mappingMetricsLogStream.open(filePathMetrics.c_str());
-    if (!mappingMetricsLogStream) {
-      BOOST_THROW_EXCEPTION(common::IoException(
-          errno,
-          std::string("Failed to create mapping metrics file: ") + filePathMetrics.string() + ": " +
-              strerror(errno)));
-    }
-
-    if (options.verbose_) {
-      std::cerr << "INFO: writing mapping metrics stats into " << filePathMetrics << std::endl;
-    }
-  }
-
-  if (options.inputFile2_.empty()) {
-    parseSingleInput(
-        samFile,
-        options,
-        referenceDir.getReferenceSequence(),
-        referenceDir.getHashtableConfig(),
-        hashtable,
-        mappingMetricsLogStream.is_open() ? mappingMetricsLogStream : std::cerr);
+  if (options.daemonSocket_.empty()) {
+    alignInput(options, referenceDir, hashtable);
   } else {
-    DualFastq2SamWorkflow workflow(
-        options, referenceDir.getReferenceSequence(), referenceDir.getHashtableConfig(), hashtable);
-    std::ofstream insertSizeDistributionLogStream;
-
-    if (!options.outputDirectory_.empty()) {
-      namespace bfs = boost::filesystem;
-      if (!exists(bfs::path(options.outputDirectory_))) {
-        BOOST_THROW_EXCEPTION(common::IoException(
-            ENOENT, std::string("Output directory does not exist: ") + options.outputDirectory_));
-      }
-      const auto filePath =
-          bfs::path(options.outputDirectory_) / (options.outputFilePrefix_ + ".insert-stats.tab");
-      insertSizeDistributionLogStream.open(filePath.c_str());
-      if (!insertSizeDistributionLogStream) {
-        BOOST_THROW_EXCEPTION(common::IoException(
-            errno,
-            std::string("Failed to create insert-stats file: ") + filePath.string() + ": " +
-                strerror(errno)));
-      }
-
-      if (options.verbose_) {
-        std::cerr << "INFO: writing insert stats into " << filePath << std::endl;
-      }
-      insertSizeDistributionLogStream
-          << "RG\tID\tQ25\tQ50\tQ75\tMEAN\tSTD\tMIN-INS\tMAX-INS\tRESCUE-MIN-INS\tRESCUE-MAX-INS\tNPAIRS\tINTSIZE\tSTALLS\tDELAY"
-          << std::endl;
-    }
-    workflow.parseDualFastq(
-        samFile,
-        insertSizeDistributionLogStream.is_open() ? insertSizeDistributionLogStream : std::cerr,
-        mappingMetricsLogStream.is_open() ? mappingMetricsLogStream : std::cerr);
+    serveJobs(
+        options.daemonSocket_,
+        [&](const std::string& workingDirectory, const std::vector<std::string>& arguments) {
+          runJob(options, referenceDir, hashtable, workingDirectory, arguments);
+        },
+        std::cerr);
   }
 }
 
@@ -0,0 +1,322 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include "workflow/JobServer.hpp"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/filesystem.hpp>
+
+#include "common/Exceptions.hpp"
+#include "common/Threads.hpp"
+
+namespace dragenos {
+namespace workflow {
+
+namespace {
+
+const std::string RUN_REQUEST      = "run";
+const std::string SHUTDOWN_REQUEST = "shutdown";
+
+/// closes the socket when going out of scope
+class Socket {
+public:
+  Socket() : fd_(socket(AF_UNIX, SOCK_STREAM, 0))
+  {
+    if (-1 == fd_) {
+      BOOST_THROW_EXCEPTION(common::IoException(errno, "ERROR: failed to create a Unix domain socket"));
+    }
+  }
+  explicit Socket(const int fd) : fd_(fd) {}
+  ~Socket() { close(fd_); }
+  Socket(const Socket&) = delete;
+  Socket& operator=(const Socket&) = delete;
+
+  int get() const { return fd_; }
+
+private:
+  const int fd_;
+};
+
+sockaddr_un makeAddress(const std::string& socketPath)
+{
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socketPath.empty() || sizeof(address.sun_path) <= socketPath.size()) {
+    BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+        "ERROR: socket path must be between 1 and " + std::to_string(sizeof(address.sun_path) - 1) +
+        " characters: " + socketPath));
+  }
+  std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+  return address;
+}
+
+/**
+ ** \brief reads until the peer shuts down its side of the connection
+ **
+ ** \param timeout bound on the whole read, not on each chunk, or no bound if zero
+ ** \throw common::IoException with ETIMEDOUT if the peer is still connected after the timeout
+ **/
+std::string readAll(const int fd, const std::chrono::milliseconds timeout = std::chrono::milliseconds(0))
+{
+  const auto  deadline = std::chrono::steady_clock::now() + timeout;
+  std::string ret;
+  char        buffer[4096];
+  for (;;) {
+    if (0 != timeout.count()) {
+      const auto remaining =
+          std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+      pollfd    input = {fd, POLLIN, 0};
+      const int ready = (0 < remaining.count()) ? poll(&input, 1, remaining.count()) : 0;
+      if (0 == ready) {
+        BOOST_THROW_EXCEPTION(common::IoException(ETIMEDOUT, "ERROR: timed out reading from socket"));
+      } else if (-1 == ready) {
+        if (EINTR == errno) {
+          continue;
+        }
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "ERROR: failed to wait for socket"));
+      }
+    }
+    const ssize_t count = read(fd, buffer, sizeof(buffer));
+    if (0 < count) {
+      ret.append(buffer, count);
+    } else if (0 == count) {
+      return ret;
+    } else if (EINTR != errno) {
+      BOOST_THROW_EXCEPTION(common::IoException(errno, "ERROR: failed to read from socket"));
+    }
+  }
+}
+
+/// \return false if the peer is gone
+bool writeAll(const int fd, const std::string& data)
+{
+  for (std::size_t written = 0; data.size() > written;) {
+    const ssize_t count = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+    if (0 <= count) {
+      written += count;
+    } else if (EINTR != errno) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<std::string> splitRequest(const std::string& request)
+{
+  std::vector<std::string> ret;
+  for (std::size_t begin = 0; request.size() > begin;) {
+    const std::size_t end = request.find('\0', begin);
+    if (std::string::npos == end) {
+      // unterminated last string means a truncated request
+      return std::vector<std::string>();
+    }
+    ret.push_back(request.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return ret;
+}
+
+/// runs the job and returns the reply line for the client
+std::string runJob(const JobFunction& job, const std::vector<std::string>& request, std::ostream& log)
+{
+  const auto start = std::chrono::steady_clock::now();
+  std::string error;
+  try {
+    job(request.at(1), std::vector<std::string>(request.begin() + 2, request.end()));
+  } catch (const common::ExceptionData& exception) {
+    error = exception.getMessage();
+  } catch (const boost::exception& e) {
+    error = boost::diagnostic_information(e);
+  } catch (const std::exception& e) {
+    error = e.what();
+  }
+  const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+  if (error.empty()) {
+    log << "INFO: job completed in " << seconds.count() << " seconds" << std::endl;
+    return "OK " + std::to_string(seconds.count()) + "\n";
+  }
+  // the workers are idle again, the failure belongs to this job only
+  common::CPU_THREADS().clearFailure();
+  std::replace(error.begin(), error.end(), '\n', ' ');
+  log << "ERROR: job failed after " << seconds.count() << " seconds: " << error << std::endl;
+  return "ERROR " + error + "\n";
+}
+
+/// true if the reply is a complete line starting with the prefix, stored without the prefix into message
+bool parseReply(const std::string& reply, const std::string& prefix, std::string& message)
+{
+  const std::size_t end = reply.find('\n');
+  if ((std::string::npos == end) || (prefix.size() > end) || (0 != reply.compare(0, prefix.size(), prefix))) {
+    return false;
+  }
+  message = reply.substr(prefix.size(), end - prefix.size());
+  return true;
+}
+
+/// true if the peer runs as the same user as this process
+bool isSameUser(const int fd)
+{
+  ucred     credentials;
+  socklen_t length = sizeof(credentials);
+  return (0 == getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length)) &&
+         (sizeof(credentials) == length) && (geteuid() == credentials.uid);
+}
+
+/// sends the request and returns the message of the "OK" reply of the server, once the request is complete
+std::string sendRequest(const std::string& socketPath, const std::vector<std::string>& request)
+{
+  const sockaddr_un address = makeAddress(socketPath);
+  Socket            client;
+  if (connect(client.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address))) {
+    BOOST_THROW_EXCEPTION(
+        common::IoException(errno, "ERROR: failed to connect to the server on " + socketPath));
+  }
+  std::string data;
+  for (const auto& s : request) {
+    data.append(s.c_str(), s.size() + 1);
+  }
+  if (!writeAll(client.get(), data) || shutdown(client.get(), SHUT_WR)) {
+    BOOST_THROW_EXCEPTION(common::IoException(errno, "ERROR: failed to send the request to " + socketPath));
+  }
+  const std::string reply = readAll(client.get());
+  if (reply.empty()) {
+    BOOST_THROW_EXCEPTION(common::DragenOsException("ERROR: no reply from the server on " + socketPath));
+  }
+  std::string message;
+  if (parseReply(reply, "OK ", message)) {
+    return message;
+  }
+  if (parseReply(reply, "ERROR ", message)) {
+    BOOST_THROW_EXCEPTION(common::DragenOsException("ERROR: job failed on the server: " + message));
+  }
+  BOOST_THROW_EXCEPTION(common::DragenOsException("ERROR: invalid reply from the server on " + socketPath));
+}
+
+}  // namespace
+
+void serveJobs(
+    const std::string&              socketPath,
+    const JobFunction&              job,
+    std::ostream&                   log,
+    const std::chrono::milliseconds requestTimeout)
+{
+  const sockaddr_un address = makeAddress(socketPath);
+  struct stat       status;
+  if (0 == lstat(socketPath.c_str(), &status)) {
+    if (!S_ISSOCK(status.st_mode)) {
+      BOOST_THROW_EXCEPTION(
+          common::InvalidParameterException("ERROR: file exists and is not a socket: " + socketPath));
+    }
+    // left behind by a server that did not shut down
+    unlink(socketPath.c_str());
+  }
+
+  Socket server;
+  // the jobs read and write files with the privileges of the server: only its user can connect
+  const mode_t mask      = umask(0077);
+  const int    bound     = bind(server.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+  const int    bindError = errno;
+  umask(mask);
+  if (bound) {
+    BOOST_THROW_EXCEPTION(common::IoException(bindError, "ERROR: failed to bind socket " + socketPath));
+  }
+  if (chmod(socketPath.c_str(), S_IRUSR | S_IWUSR)) {
+    const int error = errno;
+    unlink(socketPath.c_str());
+    BOOST_THROW_EXCEPTION(common::IoException(error, "ERROR: failed to restrict the access to " + socketPath));
+  }
+  if (listen(server.get(), SOMAXCONN)) {
+    const int error = errno;
+    unlink(socketPath.c_str());
+    BOOST_THROW_EXCEPTION(common::IoException(error, "ERROR: failed to listen on socket " + socketPath));
+  }
+  log << "INFO: waiting for jobs on " << socketPath << std::endl;
+
+  for (bool stop = false; !stop;) {
+    const int fd = accept(server.get(), nullptr, nullptr);
+    if (-1 == fd) {
+      if ((EINTR == errno) || (ECONNABORTED == errno)) {
+        continue;
+      }
+      const int error = errno;
+      unlink(socketPath.c_str());
+      BOOST_THROW_EXCEPTION(common::IoException(error, "ERROR: failed to accept on socket " + socketPath));
+    }
+    const Socket client(fd);
+    if (!isSameUser(client.get())) {
+      log << "WARNING: rejected a connection from another user" << std::endl;
+      writeAll(client.get(), "ERROR permission denied\n");
+      continue;
+    }
+
+    std::vector<std::string> request;
+    try {
+      // a client that never completes its request must not block the server
+      request = splitRequest(readAll(client.get(), requestTimeout));
+    } catch (const common::IoException& e) {
+      log << "WARNING: failed to read request: " << e.getMessage() << std::endl;
+      continue;
+    }
+
+    std::string reply;
+    if ((1 == request.size()) && (SHUTDOWN_REQUEST == request.front())) {
+      log << "INFO: shutdown requested" << std::endl;
+      reply = "OK 0\n";
+      stop  = true;
+    } else if ((3 <= request.size()) && (RUN_REQUEST == request.front())) {
+      log << "INFO: running job in " << request[1] << ":";
+      for (auto argument = request.begin() + 2; request.end() != argument; ++argument) {
+        log << " " << *argument;
+      }
+      log << std::endl;
+      reply = runJob(job, request, log);
+    } else {
+      reply = "ERROR invalid request\n";
+    }
+    if (!writeAll(client.get(), reply)) {
+      log << "WARNING: client disconnected before the reply" << std::endl;
+    }
+  }
+  unlink(socketPath.c_str());
+}
+
+void submitJob(const std::string& socketPath, const std::vector<std::string>& arguments, std::ostream& log)
+{
+  std::vector<std::string> request{RUN_REQUEST, boost::filesystem::current_path().string()};
+  request.insert(request.end(), arguments.begin(), arguments.end());
+  log << "INFO: submitting job to " << socketPath << std::endl;
+  const std::string seconds = sendRequest(socketPath, request);
+  log << "INFO: job completed on the server in " << seconds << " seconds" << std::endl;
+}
+
+void shutdownServer(const std::string& socketPath, std::ostream& log)
+{
+  sendRequest(socketPath, {SHUTDOWN_REQUEST});
+  log << "INFO: server on " << socketPath << " shut down" << std::endl;
+}
+
+}  // namespace workflow
+}  // namespace dragenos
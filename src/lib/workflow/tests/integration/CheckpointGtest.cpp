@@ -0,0 +1,218 @@
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "common/Exceptions.hpp"
+#include "host/dragen_api/sampling/stats_interval.hpp"
+#include "mapping_stats.hpp"
+#include "workflow/Checkpoint.hpp"
+
+using dragenos::workflow::Checkpoint;
+using dragenos::workflow::loadCheckpoint;
+using dragenos::workflow::saveCheckpoint;
+
+/// inspects the statistics restored by StatsInterval::load
+class StatsIntervalTest {
+public:
+  static double   getMean(const StatsInterval& stats) { return stats.m_mean; }
+  static double   getStddev(const StatsInterval& stats) { return stats.m_stddev; }
+  static double   getRescueCeilFactor(const StatsInterval& stats) { return stats.m_rescueCeilFactor; }
+  static uint32_t getQ50(const StatsInterval& stats) { return stats.m_q50; }
+  static uint32_t getMinInsert(const StatsInterval& stats) { return stats.getMinInsert(); }
+  static uint32_t getMaxInsert(const StatsInterval& stats) { return stats.getMaxInsert(); }
+};
+
+namespace {
+
+struct TemporaryFile {
+  TemporaryFile() : path_("/tmp/CheckpointGtest." + std::to_string(getpid()) + "." + std::to_string(++count_))
+  {
+  }
+  ~TemporaryFile()
+  {
+    boost::system::error_code error;
+    boost::filesystem::remove(path_, error);
+    boost::filesystem::remove(path_.string() + ".tmp", error);
+  }
+  const boost::filesystem::path path_;
+  static unsigned               count_;
+};
+unsigned TemporaryFile::count_ = 0;
+
+Checkpoint makeCheckpoint()
+{
+  Checkpoint checkpoint;
+  checkpoint.complete_          = false;
+  checkpoint.readGroup_         = 2;
+  checkpoint.readGroupId_       = "HVLJ7.3";
+  checkpoint.records_           = 123456789012ULL;
+  checkpoint.r1Offset_          = 9876543210ULL;
+  checkpoint.r2Offset_          = 9876543211ULL;
+  checkpoint.samOffset_         = 5000000000ULL;
+  checkpoint.insertStatsOffset_ = 42;
+  checkpoint.insertStats_       = "1 370 400 430 30 220 580 99 400.33333333333331 50.5 1 1000";
+  checkpoint.mappingMetrics_    = "10 5 5 0 0";
+
+  checkpoint.readGroupInsertStats_[0] = "1 370 400 430 30 220 580 99 400.5 50.5 1 1000";
+  checkpoint.readGroupInsertStats_[1] = "";
+  return checkpoint;
+}
+
+/// writes a checkpoint file with one line replaced, or removed when replacement is empty
+void writeModified(
+    const Checkpoint& checkpoint, const TemporaryFile& file, const std::string& key, const std::string& replacement)
+{
+  saveCheckpoint(checkpoint, file.path_);
+  std::ifstream      is(file.path_.c_str());
+  std::ostringstream modified;
+  std::string        line;
+  while (std::getline(is, line)) {
+    if (0 == line.compare(0, key.size() + 1, key + " ")) {
+      line = replacement;
+    }
+    if (!line.empty()) {
+      modified << line << "\n";
+    }
+  }
+  is.close();
+  std::ofstream(file.path_.c_str()) << modified.str();
+}
+
+StatsInterval makeStats(const double mean, const double stddev)
+{
+  return StatsInterval(mean, stddev, 370, 400, 430, 0, 2.5, 3.0, 0, 0, 151.5f, false);
+}
+
+}  // namespace
+
+TEST(Checkpoint, roundTrip)
+{
+  const TemporaryFile file;
+  const Checkpoint    saved = makeCheckpoint();
+  saveCheckpoint(saved, file.path_);
+  EXPECT_FALSE(boost::filesystem::exists(file.path_.string() + ".tmp"));
+
+  Checkpoint loaded;
+  ASSERT_TRUE(loadCheckpoint(file.path_, loaded));
+  EXPECT_EQ(saved.complete_, loaded.complete_);
+  EXPECT_EQ(saved.readGroup_, loaded.readGroup_);
+  EXPECT_EQ(saved.readGroupId_, loaded.readGroupId_);
+  EXPECT_EQ(saved.records_, loaded.records_);
+  EXPECT_EQ(saved.r1Offset_, loaded.r1Offset_);
+  EXPECT_EQ(saved.r2Offset_, loaded.r2Offset_);
+  EXPECT_EQ(saved.samOffset_, loaded.samOffset_);
+  EXPECT_EQ(saved.insertStatsOffset_, loaded.insertStatsOffset_);
+  EXPECT_EQ(saved.insertStats_, loaded.insertStats_);
+  EXPECT_EQ(saved.mappingMetrics_, loaded.mappingMetrics_);
+  EXPECT_EQ(saved.readGroupInsertStats_, loaded.readGroupInsertStats_);
+
+  // empty values, as for a complete run without insert size statistics
+  Checkpoint complete;
+  complete.complete_ = true;
+  saveCheckpoint(complete, file.path_);
+  ASSERT_TRUE(loadCheckpoint(file.path_, loaded));
+  EXPECT_TRUE(loaded.complete_);
+  EXPECT_EQ("", loaded.readGroupId_);
+  EXPECT_EQ("", loaded.insertStats_);
+  EXPECT_TRUE(loaded.readGroupInsertStats_.empty());
+}
+
+TEST(Checkpoint, missingFile)
+{
+  const TemporaryFile file;
+  Checkpoint          checkpoint;
+  EXPECT_FALSE(loadCheckpoint(file.path_, checkpoint));
+}
+
+TEST(Checkpoint, malformed)
+{
+  const TemporaryFile file;
+  const Checkpoint    saved = makeCheckpoint();
+  Checkpoint          loaded;
+
+  std::ofstream(file.path_.c_str()) << "DRAGMAP checkpoint 0\ncomplete 0\n";
+  EXPECT_THROW(loadCheckpoint(file.path_, loaded), dragenos::common::InvalidParameterException);
+  std::ofstream(file.path_.c_str()).flush();
+  EXPECT_THROW(loadCheckpoint(file.path_, loaded), dragenos::common::InvalidParameterException);
+
+  for (const std::string key : {"complete", "r2-offset", "read-group-id", "mapping-metrics"}) {
+    writeModified(saved, file, key, "");
+    EXPECT_THROW(loadCheckpoint(file.path_, loaded), dragenos::common::InvalidParameterException) << key;
+  }
+  for (const std::string value : {"r1-offset", "r1-offset -1", "r1-offset 12x", "r1-offset 99999999999999999999"}) {
+    writeModified(saved, file, "r1-offset", value);
+    EXPECT_THROW(loadCheckpoint(file.path_, loaded), dragenos::common::InvalidParameterException) << value;
+  }
+  // the statistics of the read groups are optional, but each must have a distinct position
+  writeModified(saved, file, "read-group-insert-stats", "");
+  ASSERT_TRUE(loadCheckpoint(file.path_, loaded));
+  EXPECT_TRUE(loaded.readGroupInsertStats_.empty());
+  for (const std::string value :
+       {"read-group-insert-stats", "read-group-insert-stats x 1", "read-group-insert-stats 0 1"}) {
+    writeModified(saved, file, "read-group-insert-stats", value);
+    EXPECT_THROW(loadCheckpoint(file.path_, loaded), dragenos::common::InvalidParameterException) << value;
+  }
+}
+
+TEST(StatsInterval, saveLoad)
+{
+  const StatsInterval saved = makeStats(400.0 / 3.0, std::sqrt(2.0) * 10.0);
+  std::ostringstream  os;
+  os.precision(3);
+  saved.save(os);
+  // the precision of the stream is restored
+  EXPECT_EQ(3, os.precision());
+
+  StatsInterval      loaded = makeStats(1.0, 1.0);
+  std::istringstream is(os.str());
+  ASSERT_TRUE(loaded.load(is));
+  // bit for bit, so that a resumed run aligns the same as the uninterrupted one
+  EXPECT_EQ(StatsIntervalTest::getMean(saved), StatsIntervalTest::getMean(loaded));
+  EXPECT_EQ(StatsIntervalTest::getStddev(saved), StatsIntervalTest::getStddev(loaded));
+  EXPECT_EQ(StatsIntervalTest::getRescueCeilFactor(saved), StatsIntervalTest::getRescueCeilFactor(loaded));
+  EXPECT_EQ(StatsIntervalTest::getQ50(saved), StatsIntervalTest::getQ50(loaded));
+  EXPECT_EQ(StatsIntervalTest::getMinInsert(saved), StatsIntervalTest::getMinInsert(loaded));
+  EXPECT_EQ(StatsIntervalTest::getMaxInsert(saved), StatsIntervalTest::getMaxInsert(loaded));
+  std::ostringstream again;
+  loaded.save(again);
+  EXPECT_EQ(os.str(), again.str());
+
+  std::istringstream truncated(os.str().substr(0, os.str().size() / 2));
+  EXPECT_FALSE(loaded.load(truncated));
+}
+
+TEST(ReadGroupAlignmentCounts, saveLoad)
+{
+  std::ostringstream       log;
+  ReadGroupAlignmentCounts saved(log);
+  saved.m_numRecords                       = 1000000000123ULL;
+  saved.m_numRecordsR1                     = 500000000061ULL;
+  saved.m_unmappedR2                       = 7;
+  saved.m_suppressed                       = 3;
+  saved.m_mapq_hist[0]                     = 11;
+  saved.m_mapq_hist[MAPQ_HIST_NR_BINS - 1] = 13;
+  std::ostringstream os;
+  saved.save(os);
+
+  ReadGroupAlignmentCounts loaded(log);
+  std::istringstream       is(os.str());
+  ASSERT_TRUE(loaded.load(is));
+  EXPECT_EQ(saved.m_numRecords, loaded.m_numRecords);
+  EXPECT_EQ(saved.m_numRecordsR1, loaded.m_numRecordsR1);
+  EXPECT_EQ(saved.m_unmappedR2, loaded.m_unmappedR2);
+  EXPECT_EQ(saved.m_suppressed, loaded.m_suppressed);
+  EXPECT_EQ(saved.m_mapq_hist[0], loaded.m_mapq_hist[0]);
+  EXPECT_EQ(saved.m_mapq_hist[MAPQ_HIST_NR_BINS - 1], loaded.m_mapq_hist[MAPQ_HIST_NR_BINS - 1]);
+  std::ostringstream again;
+  loaded.save(again);
+  EXPECT_EQ(os.str(), again.str());
+
+  std::istringstream truncated("1 2 3");
+  EXPECT_FALSE(loaded.load(truncated));
+}
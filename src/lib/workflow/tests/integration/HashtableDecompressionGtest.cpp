@@ -0,0 +1,212 @@
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "common/Exceptions.hpp"
+#include "common/hash_generation/hash_table_compress.h"
+#include "options/DragenOsOptions.hpp"
+#include "reference/ChunkedFileReader.hpp"
+#include "reference/HashtableConfig.hpp"
+#include "workflow/GenHashTableWorkflow.hpp"
+
+using dragenos::reference::ChunkedFileReader;
+
+namespace {
+
+std::vector<uint8_t> readFile(const boost::filesystem::path& path)
+{
+  std::ifstream        is(path.string(), std::ios::binary);
+  std::vector<uint8_t> ret(boost::filesystem::file_size(path));
+  is.read(reinterpret_cast<char*>(ret.data()), ret.size());
+  EXPECT_TRUE(is) << path;
+  return ret;
+}
+
+/**
+ ** \brief hashtable built once from a small random reference with repeats, and its decompression
+ ** into memory with decompHashTable as the expected result of the streaming decompression
+ **/
+class HashtableDecompressionTest : public ::testing::Test {
+protected:
+  static void SetUpTestCase()
+  {
+    directory_ = new boost::filesystem::path(
+        boost::filesystem::temp_directory_path() / ("HashtableDecompressionGtest." + std::to_string(getpid())));
+    boost::filesystem::create_directories(*directory_ / "ht");
+    writeReference(*directory_ / "ref.fa");
+
+    const std::vector<std::string> arguments{"dragen-os",
+                                             "--build-hash-table",
+                                             "true",
+                                             "--ht-reference",
+                                             (*directory_ / "ref.fa").string(),
+                                             "--output-directory",
+                                             (*directory_ / "ht").string(),
+                                             "--ht-num-threads",
+                                             "1"};
+    std::vector<const char*>       argv;
+    for (const auto& argument : arguments) {
+      argv.push_back(argument.c_str());
+    }
+    dragenos::options::DragenOsOptions options(false);
+    ASSERT_EQ(dragenos::options::DragenOsOptions::RUN, options.parse(int(argv.size()), argv.data()));
+    dragenos::workflow::buildHashTable(options);
+
+    const std::vector<uint8_t> config = readFile(*directory_ / "ht" / "hash_table.cfg.bin");
+    const dragenos::reference::HashtableConfig hashtableConfig(
+        reinterpret_cast<const char*>(config.data()), config.size());
+    hashtable_   = new std::vector<uint8_t>(hashtableConfig.getHashtableBytes());
+    extendTable_ = new std::vector<uint8_t>(hashtableConfig.getExtendTableBytes());
+    reference_   = new std::vector<uint8_t>(readFile(*directory_ / "ht" / "reference.bin"));
+
+    std::vector<uint8_t> compressed = readFile(*directory_ / "ht" / "hash_table.cmp");
+    uint8_t*             hashtable  = hashtable_->data();
+    uint64_t             hashtableBytes   = hashtable_->size();
+    uint8_t*             extendTable      = extendTable_->data();
+    uint64_t             extendTableBytes = extendTable_->size();
+    const char*          error            = decompHashTable(
+        2,
+        compressed.data(),
+        compressed.size(),
+        reference_->data(),
+        reference_->size(),
+        &hashtable,
+        &hashtableBytes,
+        &extendTable,
+        &extendTableBytes,
+        &hashtableDigest_,
+        &extendTableDigest_);
+    ASSERT_EQ(nullptr, error) << error;
+    ASSERT_EQ(hashtable_->data(), hashtable);
+    ASSERT_EQ(extendTable_->data(), extendTable);
+  }
+
+  static void TearDownTestCase()
+  {
+    boost::system::error_code error;
+    boost::filesystem::remove_all(*directory_, error);
+    delete directory_;
+    delete hashtable_;
+    delete extendTable_;
+    delete reference_;
+  }
+
+  /// two contigs, the second one with copies of a segment of the first one, for the extend table
+  static void writeReference(const boost::filesystem::path& path)
+  {
+    std::mt19937                    random(37);
+    std::uniform_int_distribution<> base(0, 3);
+    std::string                     contig1;
+    for (int i = 0; 60000 > i; ++i) {
+      contig1.push_back("ACGT"[base(random)]);
+    }
+    std::string contig2;
+    for (int copy = 0; 40 > copy; ++copy) {
+      contig2 += contig1.substr(1000, 300);
+      for (int i = 0; 500 > i; ++i) {
+        contig2.push_back("ACGT"[base(random)]);
+      }
+    }
+    std::ofstream os(path.string());
+    for (const auto& contig : {std::make_pair("chr1", contig1), std::make_pair("chr2", contig2)}) {
+      os << ">" << contig.first << "\n";
+      for (std::size_t i = 0; contig.second.size() > i; i += 70) {
+        os << contig.second.substr(i, 70) << "\n";
+      }
+    }
+  }
+
+  /// decompresses hash_table.cmp while it is being read in chunks of the given size
+  void decompressStream(const uint64_t chunkBytes, const int threads)
+  {
+    std::vector<uint8_t> hashtable(hashtable_->size(), 0xff);
+    std::vector<uint8_t> extendTable(extendTable_->size(), 0xff);
+    uint32_t             hashtableDigest   = 0;
+    uint32_t             extendTableDigest = 0;
+    ChunkedFileReader    compressed(*directory_ / "ht" / "hash_table.cmp", chunkBytes);
+    const char*          error = decompHashTableStream(
+        threads,
+        compressed.data(),
+        compressed.size(),
+        &ChunkedFileReader::waitBytes,
+        &compressed,
+        reference_->data(),
+        reference_->size(),
+        hashtable.data(),
+        hashtable.size(),
+        extendTable.data(),
+        extendTable.size(),
+        &hashtableDigest,
+        &extendTableDigest,
+        nullptr);
+    compressed.finish();
+    ASSERT_EQ(nullptr, error) << error;
+    EXPECT_TRUE(*hashtable_ == hashtable);
+    EXPECT_TRUE(*extendTable_ == extendTable);
+    EXPECT_EQ(hashtableDigest_, hashtableDigest);
+    EXPECT_EQ(extendTableDigest_, extendTableDigest);
+  }
+
+  static boost::filesystem::path* directory_;
+  static std::vector<uint8_t>*    hashtable_;
+  static std::vector<uint8_t>*    extendTable_;
+  static std::vector<uint8_t>*    reference_;
+  static uint32_t                 hashtableDigest_;
+  static uint32_t                 extendTableDigest_;
+};
+
+boost::filesystem::path* HashtableDecompressionTest::directory_         = nullptr;
+std::vector<uint8_t>*    HashtableDecompressionTest::hashtable_         = nullptr;
+std::vector<uint8_t>*    HashtableDecompressionTest::extendTable_       = nullptr;
+std::vector<uint8_t>*    HashtableDecompressionTest::reference_         = nullptr;
+uint32_t                 HashtableDecompressionTest::hashtableDigest_   = 0;
+uint32_t                 HashtableDecompressionTest::extendTableDigest_ = 0;
+
+}  // namespace
+
+TEST_F(HashtableDecompressionTest, wholeFile)
+{
+  ASSERT_FALSE(extendTable_->empty());
+  decompressStream(ChunkedFileReader::CHUNK_BYTES, 4);
+}
+
+TEST_F(HashtableDecompressionTest, oddChunks)
+{
+  // a single byte at a time, then chunk boundaries in the middle of the blocks handed to the threads
+  for (const uint64_t chunkBytes : {1, 7, 4093, 65537}) {
+    for (const int threads : {1, 3}) {
+      SCOPED_TRACE(std::to_string(chunkBytes) + " bytes per chunk, " + std::to_string(threads) + " threads");
+      decompressStream(chunkBytes, threads);
+    }
+  }
+}
+
+TEST(ChunkedFileReader, read)
+{
+  const boost::filesystem::path path =
+      boost::filesystem::temp_directory_path() / ("ChunkedFileReader." + std::to_string(getpid()));
+  std::string content;
+  for (int i = 0; 10000 > i; ++i) {
+    content.push_back(char(i * 7));
+  }
+  std::ofstream(path.string(), std::ios::binary) << content;
+  for (const uint64_t chunkBytes : {0, 1, 333, 10000, 10001}) {
+    ChunkedFileReader reader(path, chunkBytes);
+    ASSERT_EQ(content.size(), reader.size());
+    // in order, then beyond the bytes already available
+    for (const uint64_t bytes : {uint64_t(0), uint64_t(1), uint64_t(5000), uint64_t(10000)}) {
+      ChunkedFileReader::waitBytes(&reader, bytes);
+      EXPECT_EQ(content.substr(0, bytes), std::string(reinterpret_cast<const char*>(reader.data()), bytes));
+    }
+    reader.finish();
+  }
+  boost::filesystem::remove(path);
+  EXPECT_THROW(ChunkedFileReader reader(path), dragenos::common::IoException);
+}
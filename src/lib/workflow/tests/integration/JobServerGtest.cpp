@@ -0,0 +1,140 @@
+#include "gtest/gtest.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "common/Exceptions.hpp"
+#include "workflow/JobServer.hpp"
+
+using dragenos::workflow::serveJobs;
+using dragenos::workflow::shutdownServer;
+using dragenos::workflow::submitJob;
+
+namespace {
+
+/// runs the server on a socket of a temporary directory, until shut down
+class JobServerTest : public ::testing::Test {
+protected:
+  JobServerTest()
+    : directory_(boost::filesystem::temp_directory_path() / ("JobServerGtest." + std::to_string(getpid()))),
+      socketPath_((directory_ / "socket").string())
+  {
+    boost::filesystem::create_directories(directory_);
+  }
+  ~JobServerTest()
+  {
+    if (server_.joinable()) {
+      shutdownServer(socketPath_, log_);
+      server_.join();
+    }
+    boost::system::error_code error;
+    boost::filesystem::remove_all(directory_, error);
+  }
+
+  void start(const std::chrono::milliseconds requestTimeout)
+  {
+    server_ = std::thread([this, requestTimeout]() {
+      serveJobs(
+          socketPath_,
+          [this](const std::string& workingDirectory, const std::vector<std::string>& arguments) {
+            workingDirectory_ = workingDirectory;
+            arguments_        = arguments;
+            if ((1 < arguments.size()) && ("fail" == arguments[1])) {
+              throw std::runtime_error("failed\non purpose");
+            }
+          },
+          serverLog_,
+          requestTimeout);
+    });
+    for (int i = 0; (1000 > i) && !boost::filesystem::exists(socketPath_); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(boost::filesystem::exists(socketPath_));
+  }
+
+  /// sends the raw request, half-closed unless keepOpen, and returns the raw reply
+  std::string sendRaw(const std::string& request, const bool keepOpen = false)
+  {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    EXPECT_NE(-1, fd);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath_.c_str(), sizeof(address.sun_path) - 1);
+    EXPECT_EQ(0, connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)));
+    EXPECT_EQ(static_cast<ssize_t>(request.size()), write(fd, request.data(), request.size()));
+    if (!keepOpen) {
+      shutdown(fd, SHUT_WR);
+    }
+    std::string reply;
+    char        buffer[256];
+    for (ssize_t count = 0; 0 < (count = read(fd, buffer, sizeof(buffer)));) {
+      reply.append(buffer, count);
+    }
+    close(fd);
+    return reply;
+  }
+
+  const boost::filesystem::path directory_;
+  const std::string             socketPath_;
+  std::ostringstream            log_;
+  std::ostringstream            serverLog_;
+  std::thread                   server_;
+  std::string                   workingDirectory_;
+  std::vector<std::string>      arguments_;
+};
+
+}  // namespace
+
+TEST_F(JobServerTest, roundTrip)
+{
+  start(std::chrono::seconds(10));
+  submitJob(socketPath_, {"dragen-os", "-r", "reference"}, log_);
+  EXPECT_EQ(boost::filesystem::current_path().string(), workingDirectory_);
+  EXPECT_EQ(std::vector<std::string>({"dragen-os", "-r", "reference"}), arguments_);
+
+  // the failure of a job is reported to its client, and the server keeps serving
+  EXPECT_THROW(submitJob(socketPath_, {"dragen-os", "fail"}, log_), dragenos::common::DragenOsException);
+  EXPECT_EQ(0, sendRaw(std::string("run\0/\0dragen-os\0", 16)).compare(0, 3, "OK "));
+  EXPECT_EQ(std::vector<std::string>({"dragen-os"}), arguments_);
+
+  shutdownServer(socketPath_, log_);
+  server_.join();
+  EXPECT_FALSE(boost::filesystem::exists(socketPath_));
+}
+
+TEST_F(JobServerTest, malformedRequest)
+{
+  start(std::chrono::seconds(10));
+  EXPECT_EQ("ERROR invalid request\n", sendRaw(std::string("bogus\0", 6)));
+  // unterminated last string
+  EXPECT_EQ("ERROR invalid request\n", sendRaw(std::string("run\0/\0dragen-os", 15)));
+  // no arguments
+  EXPECT_EQ("ERROR invalid request\n", sendRaw(std::string("run\0/\0", 6)));
+  EXPECT_EQ("ERROR invalid request\n", sendRaw(std::string("shutdown\0extra\0", 15)));
+  EXPECT_EQ("ERROR invalid request\n", sendRaw(""));
+  EXPECT_TRUE(arguments_.empty());
+}
+
+TEST_F(JobServerTest, incompleteRequest)
+{
+  start(std::chrono::milliseconds(200));
+  const auto begin = std::chrono::steady_clock::now();
+  // the client never shuts down its side: the server gives up and closes the connection
+  EXPECT_EQ("", sendRaw(std::string("run\0/\0", 6), true));
+  EXPECT_GT(std::chrono::seconds(5), std::chrono::steady_clock::now() - begin);
+  EXPECT_NE(std::string::npos, serverLog_.str().find("timed out")) << serverLog_.str();
+  // and serves the next client
+  submitJob(socketPath_, {"dragen-os"}, log_);
+  EXPECT_EQ(std::vector<std::string>({"dragen-os"}), arguments_);
+}
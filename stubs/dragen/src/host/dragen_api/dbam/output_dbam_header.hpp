@@ -13,91 +13,109 @@
 #ifndef __OUTPUT_DBAM_HEADER_HPP__
 #define __OUTPUT_DBAM_HEADER_HPP__
 
+#include <cassert>
+
 #include "api/BamConstants.h"
 
-#include "align/Alignment.hpp"
 #include "align/Cigar.hpp"
+#include "align/RecordSummary.hpp"
 
 class DbamHeader {
-  const dragenos::align::SerializedAlignment &alignment_;
+  typedef dragenos::align::AlignmentHeader AlignmentHeader;
+
+  const dragenos::align::RecordSummary &record_;
+  const dragenos::align::Cigar *cigar_;
+  const uint8_t *qualities_;
   uint8_t peStatsInterval_ = 0;
 
-  const dragenos::sequences::SerializedRead &read_;
+  bool hasFlags(const dragenos::align::FlagType flags) const {
+    return flags == (record_.flags_ & flags);
+  }
 
 public:
   enum { ALIGNMENT_FLAG_SUPPLEMENTARY = 0x800 };
   enum { SUPPRESS_OUTPUT = 0x1000 };
 
-  DbamHeader(const dragenos::align::SerializedAlignment &alignment,
-             const dragenos::sequences::SerializedRead &read)
-      : alignment_(alignment), read_(read) {}
+  // insert size statistics: no cigar nor qualities
+  explicit DbamHeader(const dragenos::align::RecordSummary &record)
+      : record_(record), cigar_(nullptr), qualities_(nullptr) {}
 
-  int32_t getTemplateLen() const { return alignment_.getTemplateLength(); }
+  // mapping metrics
+  DbamHeader(const dragenos::align::RecordSummary &record,
+             const dragenos::align::Cigar &cigar, const uint8_t *qualities)
+      : record_(record), cigar_(&cigar), qualities_(qualities) {}
+
+  int32_t getTemplateLen() const { return record_.templateLength_; }
   int64_t getUnclippedAlignmentCoordinate() const {
-    const int64_t offset =
-        (alignment_.isReverseComplement())
-            ? (alignment_.getCigar().getReferenceLengthPlusEndClips() - 1)
-            : -int64_t(alignment_.getCigar().countStartClips());
-    int64_t result = static_cast<int64_t>(alignment_.getPosition()) + offset;
-    return result;
+    return record_.unclippedPosition_;
   }
 
-  const dragenos::align::SerializedCigar &getCigar() const {
-    return alignment_.getCigar();
+  const dragenos::align::Cigar &getCigar() const {
+    assert(cigar_);
+    return *cigar_;
   }
 
-  int32_t getMateCoordinate() const { return alignment_.getMateCoordinate(); }
+  int32_t getMateCoordinate() const { return record_.mateCoordinate_; }
 
   // GR  what is called mismatch in Alignment class seems to be the edit
   // distance
-  int getEditDistance() const { return alignment_.getMismatchCount(); }
+  int getEditDistance() const { return record_.mismatches_; }
 
-  bool isSecondary() const { return alignment_.isSecondaryAlignment(); }
+  bool isSecondary() const {
+    return hasFlags(AlignmentHeader::SECONDARY_ALIGNMENT);
+  }
 
-  bool isSupplementary() const { return alignment_.isSupplementaryAlignment(); }
+  bool isSupplementary() const {
+    return hasFlags(AlignmentHeader::SUPPLEMENTARY_ALIGNMENT);
+  }
 
   bool isPrimary() const { return (not(isSupplementary() or isSecondary())); }
 
   bool isFirstInPair() const {
-    return alignment_.hasMultipleSegments() && alignment_.isFirstInTemplate();
+    return hasFlags(AlignmentHeader::MULTIPLE_SEGMENTS |
+                    AlignmentHeader::FIRST_IN_TEMPLATE);
   }
 
-  uint8_t getMapQuality() const { return alignment_.getMapq(); }
+  uint8_t getMapQuality() const { return record_.mapq_; }
 
-  bool hasMate() const { return alignment_.hasMultipleSegments(); }
+  bool hasMate() const { return hasFlags(AlignmentHeader::MULTIPLE_SEGMENTS); }
 
-  bool isMateUnmapped() const { return alignment_.isUnmappedNextSegment(); }
+  bool isMateUnmapped() const {
+    return hasFlags(AlignmentHeader::UNMAPPD_NEXT_SEGMENT);
+  }
 
-  bool isProperlyPaired() const { return alignment_.areAllProperlyAligned(); }
+  bool isProperlyPaired() const {
+    return hasFlags(AlignmentHeader::ALL_PROPERLY_ALIGNED);
+  }
 
-  uint16_t getFlag() const { return alignment_.getFlags(); }
+  uint16_t getFlag() const { return record_.flags_; }
 
-  bool suppressOutput() const {
-    return (alignment_.getFlags() & SUPPRESS_OUTPUT);
-  }
+  bool suppressOutput() const { return (record_.flags_ & SUPPRESS_OUTPUT); }
 
   bool isPairMapped() const {
-    int flag = alignment_.getFlags();
-    return (flag & dragenos::align::AlignmentHeader::MULTIPLE_SEGMENTS) &&
-           (0 ==
-            (flag & dragenos::align::AlignmentHeader::UNMAPPD_NEXT_SEGMENT)) &&
-           (0 == (flag & dragenos::align::AlignmentHeader::UNMAPPED));
+    int flag = record_.flags_;
+    return (flag & AlignmentHeader::MULTIPLE_SEGMENTS) &&
+           (0 == (flag & AlignmentHeader::UNMAPPD_NEXT_SEGMENT)) &&
+           (0 == (flag & AlignmentHeader::UNMAPPED));
   }
 
-  short getSequenceLen() const { return read_.getReadLen(); }
+  short getSequenceLen() const { return record_.readLength_; }
 
   bool isMateOnSameContig() const {
-    return alignment_.getReference() == alignment_.getNextReference();
+    return record_.reference_ == record_.nextReference_;
   }
 
-  bool isDisqualified() const { return (alignment_.hasFailedFilters()); }
+  bool isDisqualified() const {
+    return hasFlags(AlignmentHeader::FAILED_FILTERS);
+  }
 
-  bool isUnmapped() const { return (alignment_.isUnmapped()); }
+  bool isUnmapped() const { return hasFlags(AlignmentHeader::UNMAPPED); }
 
-  bool isDuplicate() const { return (alignment_.isDuplicate()); }
+  bool isDuplicate() const { return hasFlags(AlignmentHeader::DUPLICATE); }
 
   const uint8_t *getConstQualities() const {
-    return reinterpret_cast<const uint8_t *>(read_.getQualities().first);
+    assert(qualities_);
+    return qualities_;
   }
 
   uint8_t getPeStatsInterval() const { return peStatsInterval_; }
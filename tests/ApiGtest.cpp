@@ -0,0 +1,243 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+#include "api/AlignerContext.hpp"
+#include "api/Reference.hpp"
+#include "common/Exceptions.hpp"
+
+using dragenos::api::AlignerContext;
+using dragenos::api::AlignmentRecord;
+using dragenos::api::ReadRecord;
+using dragenos::api::Reference;
+
+/**
+ ** System tests of the embedded aligner on the reference directory given on the command
+ ** line or in the environment variable REFDIR.
+ **/
+class ApiFixture : public ::testing::Test {
+public:
+  static void SetUpTestCase();
+  static void TearDownTestCase() { reference.reset(); }
+
+protected:
+  static constexpr unsigned READ_LENGTH = 150;
+  static std::unique_ptr<Reference> reference;
+
+  /// origin of a read generated from the reference
+  struct Origin {
+    int     sequence;
+    int64_t position;
+  };
+  /// single ended reads copied from random positions of the reference, skipping the Ns
+  static void generateReads(
+      unsigned count, std::mt19937& gen, std::vector<ReadRecord>& reads, std::vector<Origin>& origins);
+};
+
+std::unique_ptr<Reference> ApiFixture::reference;
+
+void ApiFixture::SetUpTestCase()
+{
+  const auto argv = testing::internal::GetArgvs();
+  ASSERT_TRUE(argv.size() > 1 || (nullptr != getenv("REFDIR")))
+      << "Checking for reference-directory on the command line or in the environment variable REFDIR";
+  const std::string referenceDir(argv.size() > 1 ? argv[1] : getenv("REFDIR"));
+  std::cerr << "\n" << argv[0] << ": using reference directory: " << referenceDir << "\n" << std::endl;
+  reference.reset(new Reference({"-r", referenceDir}));
+}
+
+void ApiFixture::generateReads(
+    const unsigned count, std::mt19937& gen, std::vector<ReadRecord>& reads, std::vector<Origin>& origins)
+{
+  static const std::string BASES = "NACNGNNNTNNNNNNN";
+  const auto& sequences         = reference->getHashtableConfig().getSequences();
+  const auto& referenceSequence = reference->getReferenceDir().getReferenceSequence();
+  while (reads.size() < count) {
+    const auto& sequence = sequences[gen() % sequences.size()];
+    if (READ_LENGTH > sequence.seqLen) {
+      continue;
+    }
+    const int64_t position = gen() % (sequence.seqLen - READ_LENGTH);
+    ReadRecord    read{"read" + std::to_string(reads.size()), "", std::string(READ_LENGTH, 'I')};
+    for (unsigned i = 0; READ_LENGTH > i; ++i) {
+      read.bases_.push_back(BASES[referenceSequence.getBase(sequence.seqStart + position + i) & 0xF]);
+    }
+    if (std::string::npos == read.bases_.find('N')) {
+      reads.push_back(read);
+      origins.push_back(Origin{int(sequence.id_), position});
+    }
+  }
+}
+
+TEST_F(ApiFixture, alignsReadsToTheirOrigin)
+{
+  std::mt19937            gen(44);
+  std::vector<ReadRecord> reads;
+  std::vector<Origin>     origins;
+  generateReads(1000, gen, reads, origins);
+
+  AlignerContext               context(*reference);
+  std::vector<AlignmentRecord> records;
+  context.alignSingle(reads, records);
+  ASSERT_LE(reads.size(), records.size());
+  unsigned found = 0;
+  for (const auto& record : records) {
+    ASSERT_GT(reads.size(), record.read_);
+    const Origin& origin = origins[record.read_];
+    if (!(record.flags_ & 0x900) && (origin.sequence == record.reference_) &&
+        (origin.position == record.position_)) {
+      ++found;
+    }
+  }
+  // repeats can place a few reads elsewhere
+  EXPECT_LE(reads.size() * 9 / 10, found);
+
+  // the SAM records are the same alignments
+  std::vector<char> sam;
+  context.alignSingle(reads, sam);
+  EXPECT_EQ(records.size(), std::size_t(std::count(sam.begin(), sam.end(), '\n')));
+}
+
+// two instances loaded from the same reference directory: the contexts of each align the same, so
+// nothing is shared between the instances. Aligning on different references needs a second directory
+TEST_F(ApiFixture, sameRecordsOnTwoReferenceInstances)
+{
+  std::mt19937            gen(45);
+  std::vector<ReadRecord> reads;
+  std::vector<Origin>     origins;
+  generateReads(200, gen, reads, origins);
+
+  const Reference other({"-r", reference->getOptions().refDir_.string()});
+  AlignerContext  context1(*reference);
+  AlignerContext  context2(other);
+  // pairs made of the reads and the reverse complement of the following read
+  std::vector<ReadRecord> reads2(reads.begin() + 1, reads.end());
+  reads2.push_back(reads.front());
+  for (auto& read : reads2) {
+    std::reverse(read.bases_.begin(), read.bases_.end());
+    for (auto& base : read.bases_) {
+      base = "TGCA"[std::string("ACGT").find(base)];
+    }
+  }
+  std::vector<char> sam1;
+  std::vector<char> sam2;
+  context1.alignPairs(reads, reads2, sam1);
+  context2.alignPairs(reads, reads2, sam2);
+  EXPECT_EQ(std::string(sam1.begin(), sam1.end()), std::string(sam2.begin(), sam2.end()));
+  EXPECT_LE(2 * reads.size(), std::size_t(std::count(sam1.begin(), sam1.end(), '\n')));
+}
+
+TEST_F(ApiFixture, rejectsUnsupportedOptions)
+{
+  const std::string referenceDir = reference->getOptions().refDir_.string();
+  EXPECT_THROW(
+      Reference({"-r", referenceDir, "--methylation-protocol", "directional"}),
+      dragenos::common::InvalidOptionException);
+  EXPECT_THROW(Reference({"-r", referenceDir, "--fastq-list", "list.csv"}), dragenos::common::InvalidOptionException);
+}
+
+TEST_F(ApiFixture, targetBed)
+{
+  std::mt19937            gen(47);
+  std::vector<ReadRecord> reads;
+  std::vector<Origin>     origins;
+  generateReads(400, gen, reads, origins);
+
+  // the first half of the first sequence
+  const auto&       sequence = reference->getHashtableConfig().getSequences().front();
+  const int         targeted = sequence.id_;
+  const int64_t     end      = sequence.seqLen / 2;
+  const std::string bedPath  = "/tmp/ApiGtest." + std::to_string(getpid()) + ".bed";
+  std::ofstream(bedPath) << reference->getSequenceNames().at(targeted) << "\t0\t" << end << "\n";
+  const Reference targetedReference(
+      {"-r", reference->getOptions().refDir_.string(), "--Mapper.target-bed", bedPath, "--Mapper.target-padding", "0"});
+  std::remove(bedPath.c_str());
+  ASSERT_NE(nullptr, targetedReference.getTargetIndex());
+
+  AlignerContext               context(targetedReference);
+  std::vector<AlignmentRecord> records;
+  context.alignSingle(reads, records);
+  // the reads away from the end of the target are mapped if they come from it, and unmapped otherwise
+  unsigned onTarget  = 0;
+  unsigned mapped    = 0;
+  unsigned offTarget = 0;
+  unsigned unmapped  = 0;
+  for (const auto& record : records) {
+    const Origin& origin = origins.at(record.read_);
+    if (record.flags_ & 0x900) {
+      continue;
+    }
+    if ((targeted == origin.sequence) && (end - 1000 > origin.position)) {
+      ++onTarget;
+      mapped += !(record.flags_ & 0x4);
+    } else if ((targeted != origin.sequence) || (end + 1000 < origin.position)) {
+      ++offTarget;
+      unmapped += bool(record.flags_ & 0x4);
+    }
+  }
+  EXPECT_LT(0u, onTarget);
+  EXPECT_LE(onTarget * 9 / 10, mapped);
+  EXPECT_LT(0u, offTarget);
+  EXPECT_LE(offTarget * 9 / 10, unmapped);
+}
+
+TEST_F(ApiFixture, throughput)
+{
+  static const unsigned   BATCH_SIZE  = 1000;
+  static const unsigned   BATCH_COUNT = 20;
+  const unsigned          threadCount = std::max(1u, std::thread::hardware_concurrency());
+  std::mt19937            gen(46);
+  std::vector<ReadRecord> reads;
+  std::vector<Origin>     origins;
+  generateReads(BATCH_SIZE, gen, reads, origins);
+
+  const auto               start = std::chrono::steady_clock::now();
+  std::vector<std::size_t> recordCounts(threadCount, 0);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; threadCount > t; ++t) {
+    threads.emplace_back([&, t]() {
+      AlignerContext               context(*reference);
+      std::vector<AlignmentRecord> records;
+      for (unsigned batch = t; BATCH_COUNT > batch; batch += threadCount) {
+        records.clear();
+        context.alignSingle(reads, records);
+        recordCounts[t] += records.size();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+  std::cerr << "aligned " << BATCH_SIZE * BATCH_COUNT << " reads of " << READ_LENGTH << " bases on "
+            << threadCount << " threads in " << seconds.count() << " seconds: "
+            << BATCH_SIZE * BATCH_COUNT / seconds.count() << " reads/s" << std::endl;
+  EXPECT_LE(BATCH_SIZE * BATCH_COUNT, std::accumulate(recordCounts.begin(), recordCounts.end(), 0ul));
+}
@@ -237,7 +237,7 @@ TEST_F(MapperFixture, explore) {
                 addressSegment |
                 hashtable->getSecondaryHasher()->getHash64(extendedKey);
             hashtable->getHits(extendedHash, true, hashRecords,
-                               extendTableIntervals, true);
+                               extendTableIntervals);
             std::cerr << "             extendedKey: " << std::hex << extendedKey
                       << ": extendedHash: " << std::hex << extendedHash
                       << std::dec << ": Found " << hashRecords.size()
@@ -0,0 +1,123 @@
+/**
+ ** DRAGEN Open Source Software
+ ** Copyright (c) 2019-2020 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ **/
+
+/**
+ ** Example of the embedded aligner: aligns a FASTQ file, or a pair of FASTQ files, on several
+ ** threads and writes the SAM records to the standard output, in no particular order.
+ **
+ ** usage: api-example <threads> <fastq1> [<fastq2>] -- <dragen-os options>
+ ** e.g.:  api-example 8 r1.fq r2.fq -- -r /data/hg38 --Aligner.sec-aligns 2
+ **/
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "api/AlignerContext.hpp"
+#include "api/Reference.hpp"
+
+namespace {
+
+const std::size_t BATCH_SIZE = 10000;
+
+bool readFastq(std::istream& is, dragenos::api::ReadRecord& read)
+{
+  std::string separator;
+  if (!std::getline(is, read.name_) || !std::getline(is, read.bases_) || !std::getline(is, separator) ||
+      !std::getline(is, read.qualities_)) {
+    return false;
+  }
+  // the names come without the leading '@'
+  read.name_.erase(0, 1);
+  return true;
+}
+
+/// next batch of reads, empty at the end of the input
+bool readBatch(
+    std::istream&                           is,
+    std::vector<dragenos::api::ReadRecord>& reads,
+    const std::size_t                       maxSize = BATCH_SIZE)
+{
+  reads.resize(maxSize);
+  std::size_t size = 0;
+  while ((maxSize > size) && readFastq(is, reads[size])) {
+    ++size;
+  }
+  reads.resize(size);
+  return !reads.empty();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::vector<std::string> arguments(argv + 1, argv + argc);
+  const auto               separator = std::find(arguments.begin(), arguments.end(), "--");
+  if ((arguments.end() == separator) || (2 > separator - arguments.begin()) ||
+      (3 < separator - arguments.begin())) {
+    std::cerr << "usage: " << argv[0] << " <threads> <fastq1> [<fastq2>] -- <dragen-os options>" << std::endl;
+    return 1;
+  }
+  const unsigned threadCount = std::stoul(arguments[0]);
+  std::ifstream  fastq1(arguments[1]);
+  std::ifstream  fastq2;
+  const bool     paired = (3 == separator - arguments.begin());
+  if (paired) {
+    fastq2.open(arguments[2]);
+  }
+  if (!fastq1 || (paired && !fastq2)) {
+    std::cerr << "failed to open the input files" << std::endl;
+    return 1;
+  }
+
+  // loaded once and shared by all the threads
+  const dragenos::api::Reference reference(std::vector<std::string>(separator + 1, arguments.end()));
+  reference.writeSamHeader(std::cout);
+
+  std::mutex               inputMutex;
+  std::mutex               outputMutex;
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; threadCount > t; ++t) {
+    threads.emplace_back([&]() {
+      dragenos::api::AlignerContext          context(reference);
+      std::vector<dragenos::api::ReadRecord> reads1;
+      std::vector<dragenos::api::ReadRecord> reads2;
+      std::vector<char>                      sam;
+      for (;;) {
+        {
+          std::lock_guard<std::mutex> lock(inputMutex);
+          if (!readBatch(fastq1, reads1) || (paired && !readBatch(fastq2, reads2, reads1.size()))) {
+            return;
+          }
+        }
+        sam.clear();
+        if (paired) {
+          context.alignPairs(reads1, reads2, sam);
+        } else {
+          context.alignSingle(reads1, sam);
+        }
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout.write(sam.data(), sam.size());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return 0;
+}
@@ -657,6 +657,41 @@ void* strScanThreadMultBase(void* ctxPtr)
   }
 }
 
+// Seed hashes counted at once by strScanThread
+#define SAVED_SEED_HASHES 16
+
+// Count seed hashes in the shared counters, to estimate how many seeds will be extended.  The final counts
+// and the estimate don't depend on the order the hashes are counted in.
+static void countSeedHashes(strScanCtx_t* ctx, const uint64_t* hashes, int num)
+{
+  int      minFreqToExtend = ctx->cfghdr->minFreqToExtend;
+  int      i;
+  uint8_t *lockPtr, *countPtr;
+  for (i = 0; i < num; i++) {
+    // Obtain a lock corresponding to a 20-bit segment of the hash
+    lockPtr  = &ctx->seedHashLocks[hashes[i] & 0xFFFFF];
+    countPtr = &ctx->seedHashCounts[hashes[i] & 0xFFFFFFFF];
+    while (!__sync_bool_compare_and_swap(lockPtr, 0, 1))
+      ;
+    // Increment count for this hash
+    if (*countPtr < minFreqToExtend) {
+      // When count reaches the extension threshold, count them all as extended
+      if (++*countPtr == minFreqToExtend) {
+        ctx->extendedSeeds += minFreqToExtend;
+      }
+    }
+    // And count further seeds with this hash as extended
+    else {
+      ctx->extendedSeeds++;
+    }
+    // Release the lock
+#if defined(_TARGET_PPC_)
+    __asm__ __volatile__("sync" ::: "memory");
+#endif
+    *lockPtr = 0;
+  }
+}
+
 // Thread function to scan reference sequences for short tandem repeats (STRs)
 // TODO If (maxMultBaseSeeds > 0), call the multi base version. Remove this version and make the multi base
 // the only version of this function for the next HT version.
@@ -692,9 +727,8 @@ void* strScanThread(void* ctxPtr)
     int num                = 0;
     // Pre-hash seed k-mers to count extended seeds and size the seed extension table
     uint8_t*  seedHashCounts = ctx->seedHashCounts;
-    uint8_t*  seedHashLocks  = ctx->seedHashLocks;
-    uint8_t*  lockPtr;
-    uint8_t*  countPtr;
+    uint64_t  savedHashes[SAVED_SEED_HASHES];
+    int       savedCount     = 0;
     uint32_t  seedLength      = ctx->cfghdr->priSeedBases;
     uint32_t  anchorBinBits   = ctx->cfghdr->anchorBinBits ? ctx->cfghdr->anchorBinBits : 31;
     double    refSeedInterval = ctx->cfghdr->refSeedInterval;
@@ -704,7 +738,6 @@ void* strScanThread(void* ctxPtr)
     uint32_t  anchorRefSeq = ctx->cfghdr->anchorBinBits ? refSeq : 0;
     uint32_t  invl, seedIn = 0xFFFFFFFF, invlMask = (1 << seedLength) - 1;
     uint64_t* seedPtr         = &seed;
-    int       minFreqToExtend = ctx->cfghdr->minFreqToExtend;
     int       anchorShift     = seedLength * 2;
     int       compShift       = (seedLength - 1) * 2;
     int*      charToBase      = r->charToBase;
@@ -735,30 +768,17 @@ void* strScanThread(void* ctxPtr)
 #endif
           // Add reference sequence ID in anchored mode, to separate difference sequences
           hash += anchorRefSeq;
-          // Obtain a lock corresponding to a 20-bit segment of the hash
-          lockPtr  = &seedHashLocks[hash & 0xFFFFF];
-          countPtr = &seedHashCounts[hash & 0xFFFFFFFF];
-          while (!__sync_bool_compare_and_swap(lockPtr, 0, 1))
-            ;
-          // Increment count for this hash
-          if (*countPtr < minFreqToExtend) {
-            // When count reaches the extension threshold, count them all as extended
-            if (++*countPtr == minFreqToExtend) {
-              ctx->extendedSeeds += minFreqToExtend;
-            }
+          // Count in batches, prefetching the counters to overlap their cache misses
+          savedHashes[savedCount++] = hash;
+          __builtin_prefetch(&seedHashCounts[hash & 0xFFFFFFFF]);
+          if (savedCount == SAVED_SEED_HASHES) {
+            countSeedHashes(ctx, savedHashes, savedCount);
+            savedCount = 0;
           }
-          // And count further seeds with this hash as extended
-          else {
-            ctx->extendedSeeds++;
-          }
-          // Release the lock
-#if defined(_TARGET_PPC_)
-          __asm__ __volatile__("sync" ::: "memory");
-#endif
-          *lockPtr = 0;
         }
       }
     }
+    countSeedHashes(ctx, savedHashes, savedCount);
     // skip decoy and population alt contigs
     if (r->isDecoy || r->isPopAlt) continue;
 
@@ -1094,6 +1114,7 @@ char* generateHashTable(hashTableConfig_t* config, int argc, char* argv[])
   uint64_t refCodeHist[16] = {0};
   uint32_t refDigest = 0, refIndexDigest = 0, hashDigest = 0, extTabDigest = 0, popSnpsDigest = 0;
   char     nullPaddingBlock[REF_SEQ_END_PAD_BASES] = {0};
+  double   startSeconds                            = wallSeconds();
 
   // Get the maximum number of threads in system if it is greater than 48 use 48 if it is less than 32 use 32
   uint32_t maxThreadsInSystem = ((sysconf(_SC_NPROCESSORS_ONLN) > 48) ? 48 : sysconf(_SC_NPROCESSORS_ONLN));
@@ -1751,8 +1772,8 @@ char* generateHashTable(hashTableConfig_t* config, int argc, char* argv[])
   uint8_t*        seedHashCounts = NULL;
   uint8_t*        seedHashLocks  = NULL;
   if (useStrThreads) {
-    // Allocate seed hash counters
-    seedHashCounts = calloc(1ULL << 32, 1);
+    // Allocate seed hash counters, randomly accessed all over their 4GB
+    seedHashCounts = hugePageAlloc(1ULL << 32);
     seedHashLocks  = calloc(1ULL << 20, 1);
     if (!seedHashCounts || !seedHashLocks) {
       snprintf(ERR_MSG, sizeof(ERR_MSG), "Cannot allocate 4GB for seed hash counters\n");
@@ -2047,7 +2068,7 @@ char* generateHashTable(hashTableConfig_t* config, int argc, char* argv[])
       extendedSeeds    = 0;
       nonExtendedSeeds = validSeeds;
     }
-    free(seedHashCounts);
+    hugePageFree(seedHashCounts, 1ULL << 32);
     free(seedHashLocks);
     seedHashCounts = NULL;
     seedHashLocks  = NULL;
@@ -2374,6 +2395,7 @@ char* generateHashTable(hashTableConfig_t* config, int argc, char* argv[])
   free(inpSeq);
   inpSeq = NULL;
 
+  config->phaseSeconds[HT_PHASE_REFERENCE] = wallSeconds() - startSeconds;
   char* errStr = buildHashTable(
       config,
       refSeq,
@@ -2421,6 +2443,13 @@ char* generateHashTable(hashTableConfig_t* config, int argc, char* argv[])
 
   printf("Wrote configuration to '%s'\n", config->configFname);
 
+  static const char* phaseNames[HT_PHASE_NUM_MAX] = {
+      "Reference encoding", "Seed hashing", "Chunk building", "Chunk output", "Compression", "Statistics"};
+  printf("\nPhase timing:\n");
+  for (i = 0; i < HT_PHASE_NUM_MAX; i++) printf("  %-19s: %.2f s\n", phaseNames[i], config->phaseSeconds[i]);
+  printf("  %-19s: %.2f s\n", "Total", wallSeconds() - startSeconds);
+  printf("Peak memory: %s\n", bytesReadable(peakMemoryBytes()));
+
 generateHashTableCleanup:
 
   free(inpSeq);
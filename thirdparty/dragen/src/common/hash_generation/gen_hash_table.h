@@ -91,6 +91,17 @@ typedef enum {
   DIGEST_CRC32C = 1,
 } DigestType;
 
+// Phases of hash table generation, timed in hashTableConfig_t.phaseSeconds
+typedef enum {
+  HT_PHASE_REFERENCE = 0,  // Reading, encoding and pre-hashing the reference
+  HT_PHASE_HASH,           // Hashing reference seeds into buckets
+  HT_PHASE_BUILD,          // Building hash table chunks
+  HT_PHASE_OUTPUT,         // Digesting and writing finished chunks
+  HT_PHASE_COMPRESS,       // Compressing the extension table index and automatic hits
+  HT_PHASE_STATS,          // Writing the statistics file
+  HT_PHASE_NUM_MAX,
+} HashTablePhase;
+
 #define DEFAULT_MEM_SIZE_STR "32GB"
 #define MAX_MEM_SIZE_STR "64GB"
 #define REF_BASES_PER_IDX_RESERVE_BYTE 64
@@ -207,6 +218,8 @@ typedef struct {
   char* popAltLiftoverFname;  // Name of population based SAM format liftover of alternate contigs
   char* popSnpsInput;         // Name of population based SNPs VCF input file
   char* popSnpsOutput;        // Name of population based SNPs binary output file
+
+  double phaseSeconds[HT_PHASE_NUM_MAX];  // Wall clock seconds spent in each phase of generation
 } hashTableConfig_t;
 
 void setDefaultHashParams(hashTableConfig_t* defConfig, const char* dir, HashTableType hashTableType);
@@ -18,7 +18,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <time.h>
 #include "crc_hash.h"
 #include "hash_table_compress.h"
 #ifndef LOCAL_BUILD
@@ -203,6 +206,38 @@ char* bytesReadable(uint64_t bytes)
   return s[index];
 }
 
+double wallSeconds(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+uint64_t peakMemoryBytes(void)
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) return 0;
+  // Linux reports kilobytes
+  return (uint64_t)usage.ru_maxrss << 10;
+}
+
+void* hugePageAlloc(uint64_t bytes)
+{
+  // Anonymous mappings are zeroed, and only the pages actually touched become resident
+  void* p = mmap(NULL, bytes ? bytes : 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+  // Only a hint - the mapping is still usable with normal pages
+  madvise(p, bytes ? bytes : 1, MADV_HUGEPAGE);
+#endif
+  return p;
+}
+
+void hugePageFree(void* p, uint64_t bytes)
+{
+  if (p) munmap(p, bytes ? bytes : 1);
+}
+
 // clang-format off
 const uint8_t rcTable[256] = {
   0xFF,0xBF,0x7F,0x3F,0xEF,0xAF,0x6F,0x2F,0xDF,0x9F,0x5F,0x1F,0xCF,0x8F,0x4F,0x0F,
@@ -257,6 +292,16 @@ void revComp(void* dst, void* src, int len)
   }
 }
 
+// Reverse-complement up to 32 2-bit bases held in a qword, with the same result as revComp
+static inline uint64_t revCompQword(uint64_t seed, int len)
+{
+  // Complement, then reverse the order of the 2-bit bases within each byte, then the bytes
+  uint64_t x = ~seed;
+  x          = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+  x          = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+  return __builtin_bswap64(x) >> (64 - 2 * len);
+}
+
 uint64_t qwordExtractBits(uint64_t qword, int start, int len)
 {
   uint64_t val;
@@ -314,6 +359,42 @@ int hashRecCompareCustom(const void* a, const void* b)
   // clang-format on
 }
 
+// Buckets are sorted by insertion up to this many records, which is most of them, and by qsort above.
+// Both comparison functions are total orders on distinct records, so the results are the same either way.
+#define INSERTION_SORT_MAX_RECS 32
+
+// Sort hash records with hashRecCompareHash
+static void sortHashRecs(hashrec_t* recs, uint32_t num)
+{
+  uint32_t i, j;
+  if (num > INSERTION_SORT_MAX_RECS) {
+    qsort(recs, num, sizeof(hashrec_t), &hashRecCompareHash);
+    return;
+  }
+  for (i = 1; i < num; i++) {
+    hashrec_t rec = recs[i];
+    for (j = i; j > 0 && hashRecCompareHash(&recs[j - 1], &rec) > 0; j--) recs[j] = recs[j - 1];
+    recs[j] = rec;
+  }
+}
+
+// Sort hash records with their 3 custom sort key qwords, with hashRecCompareCustom
+static void sortHashRecsCustom(uint64_t* recs, uint32_t num)
+{
+  uint32_t i, j;
+  uint64_t rec[4];
+  if (num > INSERTION_SORT_MAX_RECS) {
+    qsort(recs, num, sizeof(rec), &hashRecCompareCustom);
+    return;
+  }
+  for (i = 1; i < num; i++) {
+    memcpy(rec, &recs[i * 4], sizeof(rec));
+    for (j = i; j > 0 && hashRecCompareCustom(&recs[(j - 1) * 4], rec) > 0; j--)
+      memcpy(&recs[j * 4], &recs[(j - 1) * 4], sizeof(rec));
+    memcpy(&recs[j * 4], rec, sizeof(rec));
+  }
+}
+
 // Simple qword comparison function
 int qwordCompare(const void* a, const void* b)
 {
@@ -615,7 +696,6 @@ void* buildHashTableThread(void* ctxPtr)
   if (configHeader->anchorBinBits) refAltSeed = 0xFFFFFFFF;
 
   // Derive hash record layout parameters
-  int      REC_BYTES    = HASH_RECORD_BYTES;
   double   squeezeRatio = (float)configHeader->tableSize64ths / 64;  // This floating point value is exact
   uint32_t wrapBytes    = MAX_WRAP_BYTES * squeezeRatio;
   uint32_t wrapRecords  = wrapBytes >> HASH_RECORD_BYTES_LOG2;
@@ -701,7 +781,7 @@ void* buildHashTableThread(void* ctxPtr)
     stats.bucketLevelRawHist[bucketCount[n] > 63 ? 63 : bucketCount[n]]++;
     stats.countRawKmer += priRecs;
     // Sort the primary portion of the bucket by hash, to group records from identical k-mers
-    qsort(bucket[n], priRecs, REC_BYTES, &hashRecCompareHash);
+    sortHashRecs(bucket[n], priRecs);
     // Scan for groups of matching hashBits
     for (beg = 0; beg < bucketCount[n]; beg = end) {
       // Quit if we struck an extended record
@@ -1550,7 +1630,7 @@ void* buildHashTableThread(void* ctxPtr)
                         (uint64_t)myRec.match_bits.match_bits;
     }
     // Re-sort the buckets using the sort keys we attached
-    qsort(tempBucket, bucketCount[n], 32, hashRecCompareCustom);
+    sortHashRecsCustom(tempBucket, bucketCount[n]);
     // Replace records in original bucket
     for (i = j = 0; i < bucketCount[n]; i++, j += 4) bucket[n][i].qword = tempBucket[j];
     COUNT_CYCLES(cyclesBucketSort);
@@ -2344,7 +2424,7 @@ void* hashThread(void* arg)
     if (SEQ_MASK_FAIL(pos, seedLen)) continue;
     // Grab the k-mer, and its reverse complement
     fwSeed = GET_SEQ_BITS(pos) & priSeedMask;
-    revComp(&rcSeed, &fwSeed, seedLen);
+    rcSeed = revCompQword(fwSeed, seedLen);
     // Use whichever is numerically smaller as the seed
     int useRc = (rcSeed < fwSeed);
     hashKey   = useRc ? rcSeed : fwSeed;
@@ -2432,6 +2512,11 @@ void* hashThread(void* arg)
 }
 
 // Returns NULL on success, or error message
+// TODO The seed hashing adds each record to its bucket under a spin lock, reallocating the buckets past
+// HASH_RECORDS_PER_BUCKET records. Up to maxGB table chunks stay in memory, and maxGB defaults to maxThreads
+// above 32 threads. The chunks are compressed on this thread only. Still open is a rewrite with byte-identical
+// output: radix partitioning of the records by bucket block into per-thread buffers without locks,
+// writeCompHashTable* on the chunks in parallel, and a memory bound independent of maxThreads.
 char* buildHashTable(
     hashTableConfig_t* config,
     uint8_t*           refSeq,
@@ -2455,8 +2540,9 @@ char* buildHashTable(
   // Statistics
   uint64_t           bytesWritten = 0, totExtTabRecs = 0;
   uint32_t           countKmer = 0, countPal = 0, totalRecs = 0, countMultBasePos = 0, countMultBaseSeeds = 0;
-  buildThreadStats_t stats     = {0};
-  FILE*              statsFile = NULL;
+  buildThreadStats_t stats      = {0};
+  FILE*              statsFile  = NULL;
+  double             phaseStart = wallSeconds(), phaseEnd;
 
   // Some global or table-specific stuff
   int seedLen = config->hdr->priSeedBases;
@@ -2514,13 +2600,14 @@ char* buildHashTable(
   uint8_t*    chunkLitFlags[hashChunks];
   hashrec_t** bucket[hashChunks];
   hashrec_t*  physRecords[hashChunks];
+  // Seed hashing scatters records all over these, so back them with huge pages
   for (i = 0; i < hashChunks; i++) {
-    bucketAlloc[i] = malloc(4 * chunkBuckets);
-    bucketCount[i] = malloc(4 * chunkBuckets);
-    bucketLocks[i] = calloc(1, chunkBuckets);
-    bucket[i]      = malloc(sizeof(hashrec_t*) * chunkBuckets);
-    physRecords[i] = malloc(chunkBytes);
-    if (!bucketAlloc[i] || !bucketCount[i] || !bucket[i] || !physRecords[i]) {
+    bucketAlloc[i] = hugePageAlloc(4 * chunkBuckets);
+    bucketCount[i] = hugePageAlloc(4 * chunkBuckets);
+    bucketLocks[i] = hugePageAlloc(chunkBuckets);
+    bucket[i]      = hugePageAlloc(sizeof(hashrec_t*) * chunkBuckets);
+    physRecords[i] = hugePageAlloc(chunkBytes);
+    if (!bucketAlloc[i] || !bucketCount[i] || !bucketLocks[i] || !bucket[i] || !physRecords[i]) {
       sprintf(errMsg, "Failed to allocate empty buckets");
       goto mainBuildHashTableError;
     }
@@ -2673,6 +2760,9 @@ char* buildHashTable(
           countKmer,
           countRecs);
       fflush(stdout);
+      phaseEnd = wallSeconds();
+      config->phaseSeconds[HT_PHASE_HASH] += phaseEnd - phaseStart;
+      phaseStart = phaseEnd;
     }
 
     // Reduce the number of build threads if not enough chunks remain
@@ -2720,6 +2810,10 @@ char* buildHashTable(
     for (i = 0; i < numBuildThreads; i++) {
       char* errorMsg;
       pthread_join(buildThreads[i], (void**)&errorMsg);
+      // Time waiting for the build threads apart from processing their output
+      phaseEnd = wallSeconds();
+      config->phaseSeconds[HT_PHASE_BUILD] += phaseEnd - phaseStart;
+      phaseStart = phaseEnd;
       // Aggregate stats from this thread
       chunksComplete++;
       uint64_t *srcQword = (uint64_t*)&buildCtx[i].stats, *dstQword = (uint64_t*)&stats;
@@ -2847,6 +2941,9 @@ char* buildHashTable(
     buildThreadCleanup:
       free(buildCtx[i].extendHitRecs);
       buildCtx[i].extendHitRecs = NULL;
+      phaseEnd                  = wallSeconds();
+      config->phaseSeconds[HT_PHASE_OUTPUT] += phaseEnd - phaseStart;
+      phaseStart = phaseEnd;
     }
 
 #ifndef LOCAL_BUILD
@@ -2900,6 +2997,9 @@ char* buildHashTable(
           100.0 * (compCtx.bitLen >> 3) / bytesWritten);
     fflush(stdout);
   }
+  phaseEnd = wallSeconds();
+  config->phaseSeconds[HT_PHASE_COMPRESS] += phaseEnd - phaseStart;
+  phaseStart = phaseEnd;
 
 mainBuildHashTableError:
 
@@ -3239,6 +3339,7 @@ mainBuildHashTableError:
   }
   fclose(statsFile);
   printf("Wrote statistics to '%s'\n", statsFname);
+  config->phaseSeconds[HT_PHASE_STATS] += wallSeconds() - phaseStart;
 
 mainBuildHashTableCleanup:
 
@@ -3254,12 +3355,12 @@ mainBuildHashTableCleanup:
   for (i = 0; i < hashChunks; i++) {
     for (n = 0; n < chunkBuckets; n++)
       if (bucketAlloc[i][n] > HASH_RECORDS_PER_BUCKET) free(bucket[i][n]);
-    free(bucketAlloc[i]);
-    free(bucketCount[i]);
-    free(bucketLocks[i]);
+    hugePageFree(bucketAlloc[i], 4 * chunkBuckets);
+    hugePageFree(bucketCount[i], 4 * chunkBuckets);
+    hugePageFree(bucketLocks[i], chunkBuckets);
     free(chunkLitFlags[i]);
-    free(bucket[i]);
-    free(physRecords[i]);
+    hugePageFree(bucket[i], sizeof(hashrec_t*) * chunkBuckets);
+    hugePageFree(physRecords[i], chunkBytes);
   }
   free(seedPopRecs);
   free(extIndexRecs);
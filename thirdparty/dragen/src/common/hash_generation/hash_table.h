@@ -288,4 +288,16 @@ uint64_t hashRecExtractHashBits(hashrec_t rec, int start, int len);
 // No need to free this string; the function manages a pool of them.
 char* bytesReadable(uint64_t bytes);
 
+// Monotonic wall clock time in seconds, for timing the phases of the build
+double wallSeconds(void);
+
+// Peak resident memory of the process so far, in bytes
+uint64_t peakMemoryBytes(void);
+
+// Allocate zeroed memory for a large randomly accessed table, backed by transparent huge pages
+// where available to cut page faults and TLB misses.  Returns NULL on failure.
+void* hugePageAlloc(uint64_t bytes);
+// Free memory from hugePageAlloc, with the same byte count.  NULL is ignored.
+void hugePageFree(void* p, uint64_t bytes);
+
 #endif
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include "crc_hash.h"
 #include "gen_hash_table.h"
 #include "hash_table.h"
@@ -809,6 +810,16 @@ uint64_t lclGetBits(decompHashTableCtx_t* ctx, int len)
 #define GET_ALIGN (lclGetBits(ctx, (8 - (ctx->bitPos & 7)) & 7))
 #define GET_ERROR (ctx->bitPos > ctx->bufBits)
 
+// Wait until the next len bits are in a compressed buffer being streamed, including the qword read ahead by
+// lclGetBits
+void lclWaitBits(decompHashTableCtx_t* ctx, int64_t len)
+{
+  if (!ctx->waitBytes) return;
+  uint64_t bytes = ((ctx->bitPos + len + 7) >> 3) + 8;
+  ctx->waitBytes(ctx->waitArg, bytes < ctx->bufBytes ? bytes : ctx->bufBytes);
+}
+#define WAIT_BITS(len) (lclWaitBits(ctx, len))
+
 // Routine to initialize the context record for decompressing a hash table
 char* decompHashTableCtxInit(
     decompHashTableCtx_t* ctx,
@@ -861,6 +872,7 @@ char* decompHashTableHeader(decompHashTableCtx_t* ctx)
 {
   uint8_t* p = (uint8_t*)&ctx->cfgHdr;
   int      i;
+  WAIT_BITS(96 + 8 * sizeof(hashTableHeader_t));
   // Magic number for this file type
   if (GET_BITS(32) != MAGIC_FILE_START) return "Compressed hash table format wrong at start";
   // Compressed format version
@@ -1260,6 +1272,7 @@ char* decompHashTableBlocks(decompHashTableCtx_t* ctx, int blockType)
     totalRecs      = (uint32_t)ceil(ctx->cfgHdr.refSeqLen / ctx->cfgHdr.refSeedInterval);
     blockMagic     = MAGIC_AUTO_BLOCK;
     endMagic       = MAGIC_AUTO_END;
+    WAIT_BITS(64);
     // Magic number to verify synchronization
     if (GET_BITS(32) != MAGIC_AUTO_START) return "Compressed hash table format wrong at automatic section";
     // Extension ID bits from the archive
@@ -1281,6 +1294,7 @@ char* decompHashTableBlocks(decompHashTableCtx_t* ctx, int blockType)
       goto decompHashTableBlocksError;
     }
     // Magic number to verify synchronization of each block
+    WAIT_BITS(32 + 3 * 64);
     magic = GET_BITS(32);
     // Done marker
     if (magic == endMagic) break;
@@ -1310,6 +1324,8 @@ char* decompHashTableBlocks(decompHashTableCtx_t* ctx, int blockType)
       err = "Compressed block end position too high";
       goto decompHashTableBlocksError;
     }
+    // The whole block must be available to the worker thread
+    WAIT_BITS(bitLen);
     // Skip over the rest of the block
     ctx->bitPos += bitLen;
     // Submit work batch
@@ -1321,6 +1337,7 @@ char* decompHashTableBlocks(decompHashTableCtx_t* ctx, int blockType)
   share = NULL;
   if (err) goto decompHashTableBlocksError;
   // Advance to byte boundary
+  WAIT_BITS(8);
   GET_ALIGN;
   if (GET_ERROR) {
     err = "Unexpected end of compressed hash table inside automatic section";
@@ -1341,11 +1358,13 @@ char* decompHashTableLiterals(decompHashTableCtx_t* ctx)
 char* decompHashTableExtIndex(decompHashTableCtx_t* ctx)
 {
   size_t i;
+  WAIT_BITS(64);
   // Magic number to verify synchronization
   if (GET_BITS(32) != MAGIC_EXT_IDX_START)
     return "Compressed hash table format wrong at extend table index start";
   // Length of extend table index
   uint64_t numExtIndexRecs = GET_BITS(32);
+  WAIT_BITS(32 * (numExtIndexRecs + 1));
   if ((numExtIndexRecs << (HASH_BUCKET_BYTES_LOG2 + EXTTAB_INDEX_BUCKET_BITS)) != ctx->cfgHdr.hashTableBytes)
     return "Compressed extend table index doesn't match hash table size";
   // Allocate extend table index
@@ -1746,6 +1765,81 @@ decompHashTableErr:
   return errMsg;
 }
 
+// Monotonic time in seconds, for the phases of decompHashTableStream
+double lclSeconds()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
+
+char* decompHashTableStream(
+    int               threads,
+    uint8_t*          compBuf,
+    uint64_t          compLen,
+    decompWaitBytes_t waitBytes,
+    void*             waitArg,
+    uint8_t*          refBuf,
+    uint64_t          refLen,
+    uint8_t*          decompBuf,
+    uint64_t          decompLen,
+    uint8_t*          extendTableBuf,
+    uint64_t          extendTableLen,
+    uint32_t*         hashDigest,
+    uint32_t*         extTabDigest,
+    double*           phaseSeconds)
+{
+  char*                errMsg = NULL;
+  double               times[DECOMP_PHASES + 1];
+  int                  phase = 0, i;
+  decompHashTableCtx_t ctx;
+
+  times[phase++] = lclSeconds();
+  if ((errMsg = decompHashTableCtxInit(
+           &ctx,
+           threads,
+           compBuf,
+           compLen,
+           refBuf,
+           refLen,
+           decompBuf,
+           decompLen,
+           extendTableBuf,
+           extendTableLen)))
+    goto decompHashTableStreamErr;
+  if (!decompBuf || !extendTableBuf) {
+    errMsg = "Streaming decompress called without output buffers";
+    goto decompHashTableStreamErr;
+  }
+  ctx.waitBytes  = waitBytes;
+  ctx.waitArg    = waitArg;
+  times[phase++] = lclSeconds();
+  if ((errMsg = decompHashTableHeader(&ctx))) goto decompHashTableStreamErr;
+  times[phase++] = lclSeconds();
+  if ((errMsg = decompHashTableLiterals(&ctx))) goto decompHashTableStreamErr;
+  times[phase++] = lclSeconds();
+  if ((errMsg = decompHashTableExtIndex(&ctx))) goto decompHashTableStreamErr;
+  if ((errMsg = decompHashTableAutoHits(&ctx))) goto decompHashTableStreamErr;
+  if (ctx.bitPos != ctx.bufBits) {
+    errMsg = "Unexpected additional bytes after end of compressed hash table";
+    goto decompHashTableStreamErr;
+  }
+  times[phase++] = lclSeconds();
+  if ((errMsg = decompHashTableSetFlags(&ctx))) goto decompHashTableStreamErr;
+  times[phase++] = lclSeconds();
+  if (hashDigest) *hashDigest = decompHashTableDigest(&ctx);
+  if (extTabDigest) *extTabDigest = decompExtendTableDigest(&ctx);
+  times[phase++] = lclSeconds();
+  if (phaseSeconds)
+    for (i = 0; i < DECOMP_PHASES; i++) phaseSeconds[i] = times[i + 1] - times[i];
+decompHashTableStreamErr:
+  free(ctx.extIndexRecs);
+  free(ctx.refBuf2Bit);
+  free(ctx.priCrcInit);
+  free(ctx.secCrcInit);
+  return errMsg;
+}
+
 void slurpFile(const char* name, uint8_t** buffer, uint64_t* bufLen)
 {
   printf("Slurping file %s...\n", name);
@@ -105,6 +105,34 @@ char* decompHashTable(
     uint32_t* hashDigest,
     uint32_t* extTabDigest);
 
+// Callback blocking until the first "bytes" bytes of a compressed buffer being filled are available
+typedef void (*decompWaitBytes_t)(void* waitArg, uint64_t bytes);
+
+// Phases timed by decompHashTableStream: init, header, literals, automatic hits (with extend index), flags,
+// digests
+#define DECOMP_PHASES 6
+
+// Streaming decompress function, into pre-allocated buffers, while the compressed buffer is being filled.
+// Each block is handed to the worker threads as soon as waitBytes returns for its last byte.
+// Digests are calculated unless the digest pointers are NULL.
+// Nothing is printed. The elapsed seconds of each phase are returned unless phaseSeconds is NULL.
+// Returns NULL on success, or error message.
+char* decompHashTableStream(
+    int               threads,
+    uint8_t*          compBuf,
+    uint64_t          compLen,
+    decompWaitBytes_t waitBytes,
+    void*             waitArg,
+    uint8_t*          refBuf,
+    uint64_t          refLen,
+    uint8_t*          decompBuf,
+    uint64_t          decompLen,
+    uint8_t*          extendTableBuf,
+    uint64_t          extendTableLen,
+    uint32_t*         hashDigest,
+    uint32_t*         extTabDigest,
+    double*           phaseSeconds);
+
 // Context structure for decompressing a hash table
 typedef struct {
   int               threads;
@@ -124,6 +152,8 @@ typedef struct {
   uint32_t          extendIdBits;
   void*             priCrcInit;
   void*             secCrcInit;
+  decompWaitBytes_t waitBytes;
+  void*             waitArg;
 } decompHashTableCtx_t;
 
 // For testing
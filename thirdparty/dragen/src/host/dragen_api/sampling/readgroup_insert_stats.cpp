@@ -300,6 +300,19 @@ void ReadGroupInsertStats::setInitDoneSending()
 //-------------------------------------------------------------------------------swhitmore/adamb
 // Returns true if the read #dbam# should be used in calculating sample stats
 //
+bool ReadGroupInsertStats::restoreFixedStats(std::istream& is)
+{
+  assert(!m_fixedStats);
+  m_fixedStats = new StatsInterval(*m_intervals[0]);
+  if (!m_fixedStats->load(is)) return false;
+
+  // the stats were printed when they were detected
+  m_printedFirstDetectedStats = true;
+  boost::unique_lock<boost::mutex> lock(m_init_mutex);
+  m_initState = DONE;
+  return true;
+}
+
 bool ReadGroupInsertStats::shouldUseRead(const DbamHeader* dbam)
 {
   // Filter out any reads that don't match the correct flags
@@ -126,6 +126,16 @@ public:
 
   void setInitDoneSending();
 
+  //--------------------------------------------------------------------------------
+  // Once the stats detected on the initial reads are used for all the remaining
+  // reads, they are the whole state that matters to the alignments. They can be
+  // saved and restored into a new object to resume the alignment of a read group.
+  bool hasFixedStats() const { return m_fixedStats && !m_updateLogOnly; }
+
+  void saveFixedStats(std::ostream& os) const { m_fixedStats->save(os); }
+
+  bool restoreFixedStats(std::istream& is);
+
 private:
   void completeInitialization();
 
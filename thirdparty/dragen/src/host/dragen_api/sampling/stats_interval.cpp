@@ -17,6 +17,8 @@
 #include "output_dbam_header.hpp"
 #include "run_stats.hpp"
 
+#include <limits>
+
 //--------------------------------------------------------------------------------adamb
 // Instantiation/initializations of static constant members:
 const int      StatsInterval::DEFAULT_STDDEV            = 10000;
@@ -211,6 +213,34 @@ void StatsInterval::copyStats(const StatsInterval& other)
   m_rescueMaxInsert        = other.m_rescueMaxInsert;
 }
 
+//--------------------------------------------------------------------------------
+// The stats copied by copyStats, with the doubles at full precision, so that an
+// interval restored from a checkpoint gives exactly the same insert stats to the
+// reads.
+//
+void StatsInterval::save(std::ostream& os) const
+{
+  const std::streamsize precision = os.precision(std::numeric_limits<double>::max_digits10);
+  os << m_valid << ' ' << m_q25 << ' ' << m_q50 << ' ' << m_q75 << ' ' << m_s50 << ' ' << m_low << ' '
+     << m_high << ' ' << m_numInsertsInMean << ' ' << m_mean << ' ' << m_stddev << ' ' << m_minInsert << ' '
+     << m_maxInsert << ' ' << m_insertSigmaFactor << ' ' << m_rescueSigmasOverridden << ' ' << m_rescueSigmas
+     << ' ' << m_rescueCeilFactor << ' ' << m_rescueRadius << ' ' << m_rescueMinOverridden << ' '
+     << m_rescueMinInsert << ' ' << m_rescueMaxOverridden << ' ' << m_rescueMaxInsert << ' '
+     << m_enableRescueAlignments << ' ' << static_cast<int>(m_warningMode);
+  os.precision(precision);
+}
+
+bool StatsInterval::load(std::istream& is)
+{
+  int warningMode = WARN_OK;
+  is >> m_valid >> m_q25 >> m_q50 >> m_q75 >> m_s50 >> m_low >> m_high >> m_numInsertsInMean >> m_mean >>
+      m_stddev >> m_minInsert >> m_maxInsert >> m_insertSigmaFactor >> m_rescueSigmasOverridden >>
+      m_rescueSigmas >> m_rescueCeilFactor >> m_rescueRadius >> m_rescueMinOverridden >> m_rescueMinInsert >>
+      m_rescueMaxOverridden >> m_rescueMaxInsert >> m_enableRescueAlignments >> warningMode;
+  m_warningMode = static_cast<WarningMode>(warningMode);
+  return !is.fail();
+}
+
 //--------------------------------------------------------------------------------swhitmore/adamb
 // For an interval that doesn't include any inserts that fall between the outlier bounds,
 // we need to just set default values.  In version 1.0, this led to an error message about
@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include <algorithm>
 #include <cmath>
+#include <istream>
 #include <ostream>
 #include <vector>
 
@@ -92,6 +93,10 @@ public:
 
   void copyStats(const StatsInterval& other);
 
+  void save(std::ostream& os) const;  // the stats on one line, to restore them with load
+
+  bool load(std::istream& is);  // false if the stats can't be read
+
   void reset();
 
   bool receivedAll() const { return (m_doneSending && (m_numReceived == m_numSent)); }
@@ -4,6 +4,8 @@
 #ifndef __MA_STATS__
 #define __MA_STATS__
 
+#include <istream>
+#include <ostream>
 #include <string>
 
 #define _TARGET_X86_
@@ -141,9 +143,10 @@ public:
   // ;
 
   //bridge function for dragmap
-  void addRecord(const dragenos::align::SerializedAlignment& alignment, const dragenos::sequences::SerializedRead& read)
+  void addRecord(const dragenos::align::Alignment& alignment, const dragenos::sequences::Read& read)
   {
-    const DbamHeader dbh(alignment,read);
+    const dragenos::align::RecordSummary record(alignment, read);
+    const DbamHeader dbh(record, alignment.getCigar(), read.getQualities().data());
     this->update(&dbh,COUNT_ALL,true);
   }
 
@@ -222,7 +225,7 @@ public:
     m_unpairedMultiple           = 0;
     m_unpairedOnce               = 0;
     m_QCfailed                   = 0;
-    for (int i = 1; i < MAPQ_HIST_NR_BINS; i++) {
+    for (int i = 0; i < MAPQ_HIST_NR_BINS; i++) {
       m_mapq_hist[i] = 0;
     }
     m_singleton                   = 0;
@@ -249,6 +252,19 @@ public:
     m_suppressed = 0;
   }
 
+  //--------------------------------------------------------------------------------
+  // all the counts on one line, to restore them with load when resuming a run
+  void save(std::ostream& os) const
+  {
+    forEachCount(*this, [&os](const uint64_t& count) { os << count << ' '; });
+  }
+
+  bool load(std::istream& is)
+  {
+    forEachCount(*this, [&is](uint64_t& count) { is >> count; });
+    return !is.fail();
+  }
+
   uint64_t totalNumPaired() const
   {
     return (m_pairedDiscordant + m_concordantMultiple + m_concordantOnce) / 2;
@@ -315,6 +331,60 @@ void printStats(std::chrono::duration<float>  mapDuration);
 
 private:
 
+  // applies f to all the counts summed by add, in a fixed order
+  template <typename Self, typename F>
+  static void forEachCount(Self& self, F f)
+  {
+    for (auto count : {&self.m_numRecords,
+                       &self.m_numRecordsR1,
+                       &self.m_numRecordsR2,
+                       &self.m_total_mapq_gt_0,
+                       &self.m_numDuplicatesMarked,
+                       &self.m_numDuplicatesRemoved,
+                       &self.m_dup_mapq_gt_0,
+                       &self.m_numSecondary,
+                       &self.m_numSupplementary,
+                       &self.m_unmapped,
+                       &self.m_filteredContig,
+                       &self.m_nonrefDecoy,
+                       &self.m_unmappedR1,
+                       &self.m_unmappedR2,
+                       &self.m_pairedReadDiffContig,
+                       &self.m_pairedReadDiffContigMapq10,
+                       &self.m_pairedDiscordant,
+                       &self.m_concordantMultiple,
+                       &self.m_concordantOnce,
+                       &self.m_unpairedMultiple,
+                       &self.m_unpairedOnce,
+                       &self.m_QCfailed,
+                       &self.m_singleton,
+                       &self.m_numValidRecords,
+                       &self.m_sumSeqLength,
+                       &self.m_sumSeqLengthR1,
+                       &self.m_sumSeqLengthR2,
+                       &self.m_sumUnmappedSeqLengthR1,
+                       &self.m_sumUnmappedSeqLengthR2,
+                       &self.m_numSoftClippedR1,
+                       &self.m_numSoftClippedR2,
+                       &self.m_numIndelReadsR1,
+                       &self.m_numIndelReadsR2,
+                       &self.m_splicedReads,
+                       &self.m_numIndelBasesR1,
+                       &self.m_numIndelBasesR2,
+                       &self.m_numMismatchesR1,
+                       &self.m_numMismatchesR2,
+                       &self.m_numAllQ30BasesR1,
+                       &self.m_numAllQ30BasesR2,
+                       &self.m_numNonDupNonClippedQ30Bases,
+                       &self.m_hasMate,
+                       &self.m_suppressed}) {
+      f(*count);
+    }
+    for (int i = 0; i < MAPQ_HIST_NR_BINS; i++) {
+      f(self.m_mapq_hist[i]);
+    }
+  }
+
   void updateUsingCigar(const DbamHeader* dbh, const bool hasMate, const bool isFirstInPair)
   {
     uint16_t n_softclipped  = 0;      // number of soft-clipped bases